@@ -0,0 +1,51 @@
+// actuation/actuation.h
+#pragma once
+
+#include <stdint.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Zet ControlData om naar hardware:
+// - pwm_duty (16 bit)   -> LEDC op maximale resolutie voor de draaggolf + sigma-delta dither
+// - desired_rpot_code   -> digitale potmeter (I2C), alleen bij wijziging, rate-limited
+// - desired_mode        -> relais op de MCP23008 (I2C), alleen bij wijziging, rate-limited
+// Resultaat staat in ApplyStatus. De task loopt op de notify van ControlTask.
+void actuationTask(void* pvParameters);
+
+// MCP23008 relaisbits (de overige bits komen uit IOShared.mcp08_output_bits)
+#define ACT_MCP08_RELAY_SOURCE (1u << 0)
+#define ACT_MCP08_RELAY_SINK   (1u << 1)
+#define ACT_MCP08_RELAY_MASK   (ACT_MCP08_RELAY_SOURCE | ACT_MCP08_RELAY_SINK)
+
+// Relaisstand per mode; emulatie levert via de source-trap.
+static inline uint32_t actuation_relay_bits(PowerMode mode)
+{
+    return (mode == POWER_MODE_SINK) ? ACT_MCP08_RELAY_SINK : ACT_MCP08_RELAY_SOURCE;
+}
+
+typedef struct
+{
+    uint8_t  pwm_bits;            // LEDC resolutie
+    uint32_t pwm_freq_hz;
+
+    uint32_t cycles;              // actuatie-cycli (1 per regelstap)
+    uint32_t pwm_latency_us_min;  // meting (t_us) -> PWM geschreven
+    uint32_t pwm_latency_us_max;
+    uint32_t pwm_latency_us_avg;
+
+    uint32_t i2c_writes;          // werkelijk verstuurd (rpot + MCP23008)
+    uint32_t i2c_saved;           // t.o.v. elke cyclus beide schrijven
+    uint32_t i2c_coalesced;       // waarden vervangen terwijl rate-limited
+    uint32_t i2c_errors;
+} ActuationStats;
+
+// Statistiek van het laatst afgesloten venster (elke 10 s, ook naar Serial).
+void actuation_get_stats(ActuationStats* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,104 @@
+// control/autotune.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Relay-feedback autotune (Åström-Hägglund)
+// =========================
+//
+// Portable logica (geen Arduino/FreeRTOS): wordt in ControlTask op de meetstroom
+// gedraaid en in tools/autotune_sim tegen het plant model getest.
+//
+// De relay zet de duty op bias ± d afhankelijk van het teken van de fout (met
+// hysterese). De lus gaat dan in een limit cycle; uit amplitude a en periode Pu
+// volgt de ultimate gain Ku = 4d / (pi * sqrt(a^2 - h^2)).
+//
+// Pu is maar een paar samples lang (snelle trap, 1 kHz meting). De schakelmomenten
+// worden daarom lineair tussen twee samples geïnterpoleerd (kruising van de
+// hysteresegrens) in plaats van op hele samples geteld.
+
+#ifndef AT_GAIN_POINTS
+#define AT_GAIN_POINTS 3
+#endif
+
+typedef enum
+{
+    AT_IDLE = 0,
+    AT_RUNNING,
+    AT_DONE,
+    AT_FAILED
+} AutotuneStatus;
+
+typedef struct
+{
+    float setpoint;       // werkpunt in meeteenheid (V of A)
+    float u_bias;         // duty rond het werkpunt (0..1)
+    float relay_d;        // relay amplitude (duty)
+    float hysteresis;     // hysterese in meeteenheid
+    uint8_t settle_cycles;// eerste periodes negeren (inslingeren)
+    uint8_t cycles;       // aantal periodes om te middelen (max 16)
+    float timeout_s;
+} AutotuneConfig;
+
+typedef struct
+{
+    float ku;
+    float pu_s;
+    float kp;
+    float ki;
+} AutotuneResult;
+
+typedef struct
+{
+    AutotuneConfig cfg;
+    AutotuneStatus status;
+
+    bool  relay_high;
+    float t_s;
+    float t_last_rise_s;   // geïnterpoleerd kruispunt
+    float e_prev;          // fout van het vorige sample (interpolatie)
+    float peak_max;
+    float peak_min;
+
+    uint8_t n_rise;        // aantal opgaande schakelmomenten
+    uint8_t n_used;
+    float   periods[16];
+    float   amps[16];
+
+    AutotuneResult result;
+} AutotuneState;
+
+// Eén punt in de gain schedule (per loop, per werkpunt).
+typedef struct
+{
+    float op;     // werkpunt (V voor source, A voor sink)
+    float kp;
+    float ki;
+    float ku;
+    float pu_s;
+    bool  valid;
+} CtrlGainPoint;
+
+void  autotune_start(AutotuneState* s, const AutotuneConfig* cfg);
+
+// Eén stap op de meetfrequentie; geeft de duty (0..1) terug.
+float autotune_step(AutotuneState* s, float meas, float dt_s);
+
+// PI gains: Ti = 2.2 Pu (Tyreus-Luyben), kp = Ku / 10. regulate() in control.cpp
+// heeft al een feedforward sp / full die de trap op het werkpunt zet; de P-term komt
+// daar bij een setpointsprong bovenop. Met TL-kp (Ku / 3.2) gaf dat 40-48% overshoot
+// in tools/autotune_sim, met Ku / 10 blijft het onder de 20%.
+void  autotune_pi_from_ultimate(float ku, float pu_s, float* kp, float* ki);
+
+// Lineaire interpolatie in een (op-gesorteerde) schedule; false als geen enkel punt geldig is.
+bool  ctrl_gains_lookup(const CtrlGainPoint* pts, uint8_t n, float op, float* kp, float* ki);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
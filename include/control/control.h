@@ -0,0 +1,76 @@
+// control/control.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "control/autotune.h"
+#include "control/modeswitch.h"
+#include "emulate/aging.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Volle schaal van de vermogenstrap (duty 1.0)
+#define CTRL_SOURCE_V_FULL 15.0f
+#define CTRL_SINK_I_FULL   10.0f
+
+typedef struct
+{
+    uint32_t      version;
+    CtrlGainPoint source[AT_GAIN_POINTS]; // spanningslus, op in V
+    CtrlGainPoint sink[AT_GAIN_POINTS];   // stroomlus, op in A
+} CtrlGainTable;
+
+void ControlTask(void* pvParameters);
+
+// Task die na elke nieuwe ControlData een notify krijgt (bv. actuationTask); nullptr = geen.
+void control_set_notify_task(TaskHandle_t task);
+
+// Start de relay-feedback autotune. Alleen geaccepteerd in SYS_STATE_CONFIG;
+// verlaat het systeem CONFIG tijdens de autotune, dan wordt hij afgebroken.
+bool control_request_autotune(void);
+bool control_autotune_active(void);
+
+// Load-profiel afspelen (zie control/sequencer.h). Het profiel moet blijven bestaan
+// (const array in flash). Het start bij de eerstvolgende regelstap in SYS_STATE_ACTIVE
+// met een passende mode; false als het profiel ongeldig is.
+bool control_start_profile(const uint8_t* blob, size_t len);
+void control_stop_profile(void);
+bool control_profile_running(void);
+
+// Ingebouwde profielen (control/profiles/*.h)
+typedef enum
+{
+    CTRL_PROFILE_GSM_BURST = 0,
+    CTRL_PROFILE_MOTOR_START,
+    CTRL_PROFILE_COUNT
+} CtrlBuiltinProfile;
+
+bool control_start_builtin_profile(CtrlBuiltinProfile id);
+
+// Aging van de geëmuleerde cel (zie emulate/aging.h); checkpoint staat in NVS ctrl/aging.
+void control_reset_aging(void);
+void control_get_aging(AgingState* out);
+
+// Gefit celmodel (EmuModelBlob uit tools/model_fit) voor de emulatie; wordt
+// gevalideerd (magic/versie/CRC), in NVS ctrl/model bewaard en gaat in bij de
+// volgende emulatiestart. Zonder model gelden de UI-curve en -instellingen.
+bool control_set_emu_model(const void* blob, size_t len);
+void control_clear_emu_model(void);
+
+// Laatst afgeronde modewissel (fasetijden + resultaat). Wissels worden gevraagd via
+// system_request_mode(); ControlTask voert ze uit met control/modeswitch.h.
+void control_get_last_mode_switch(ModeSwitch* out);
+
+// Kopie van de huidige gain schedule (uit NVS of laatste autotune).
+void control_get_gains(CtrlGainTable* out);
+
+#ifdef __cplusplus
+}
+#endif
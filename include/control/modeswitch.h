@@ -0,0 +1,110 @@
+// control/modeswitch.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Mode-switch sequencer (source / sink / emulate)
+// =========================
+//
+// Portable logica (geen Arduino/FreeRTOS): draait in ControlTask op de meetstroom
+// en in tools/modeswitch_sim tegen het plant model.
+//
+// Verloop bij een relaiswissel:
+//   RAMP_DOWN  duty lineair naar 0
+//   SETTLE     wachten tot |i| < i_zero_a gedurende settle_samples metingen
+//   SWITCH     relais naar de nieuwe mode; wachten tot actuation het bevestigt
+//              (ApplyStatus.applied_mode), daarna relay_bounce_s contacttijd
+//   REINIT     regelaar/integrator/emulatie opnieuw (één stap)
+//   RAMP_UP    setpoint van 0 naar doel; de ramp loopt alleen door zolang de
+//              uitgang volgt (fout < track_band), klaar als hij settle_samples
+//              metingen binnen de band blijft
+// Wisselt de relaisstand niet (emulate <-> source), dan meteen REINIT en
+// RAMP_UP vanaf de huidige waarde.
+// Behalve de contacttijd uit de datasheet zijn er geen vaste wachttijden.
+
+typedef enum
+{
+    MS_IDLE = 0,
+    MS_RAMP_DOWN,
+    MS_SETTLE,
+    MS_SWITCH,
+    MS_REINIT,
+    MS_RAMP_UP,
+    MS_PHASE_COUNT
+} ModeSwitchPhase;
+
+typedef enum
+{
+    MS_RESULT_NONE = 0,
+    MS_RESULT_OK,
+    MS_RESULT_SETTLE_TIMEOUT,   // stroom zakt niet: relais niet geschakeld
+    MS_RESULT_SWITCH_TIMEOUT,   // relaiswissel niet bevestigd (I2C)
+    MS_RESULT_RAMP_TIMEOUT,     // uitgang haalt het setpoint niet
+} ModeSwitchResult;
+
+typedef struct
+{
+    float    ramp_down_s;      // duty 1.0 -> 0 in deze tijd (kortere ramp bij lagere duty)
+    float    i_zero_a;         // "geen stroom" drempel
+    uint16_t settle_samples;   // opeenvolgende metingen onder i_zero_a / binnen track_band
+    float    relay_bounce_s;   // contacttijd na bevestigde relaiswissel
+    float    ramp_up_per_s;    // max. ramp-snelheid (fractie van doel per s)
+    float    track_band;       // toegestane volgfout, fractie van volle schaal
+    float    timeout_s;        // per fase
+} ModeSwitchConfig;
+
+typedef struct
+{
+    float       dt_s;
+    float       i_abs;          // max(|i_source|, |i_sink|)
+    PowerMode   applied_mode;   // ApplyStatus.applied_mode
+    float       track_err;      // |setpoint - meting| / volle schaal (RAMP_UP)
+} ModeSwitchInput;
+
+typedef struct
+{
+    ModeSwitchPhase  phase;
+    ModeSwitchResult result;
+    PowerMode from;
+    PowerMode to;
+    bool      relays_change;
+
+    // Uitgangen voor ControlTask
+    float     duty_scale;       // RAMP_DOWN: vermenigvuldiger op de duty van 'from'
+    PowerMode relay_mode;       // ControlData.desired_mode
+    float     ramp;             // RAMP_UP: 0..1 tussen startwaarde en setpoint
+    bool      reinit;           // één stap true: regelaar resetten
+
+    // Timing
+    float     ramp_down_rate;   // duty_scale per s
+    float     t_phase_s;
+    float     t_confirm_s;      // SWITCH: moment van bevestiging (-1 = nog niet)
+    float     t_total_s;
+    float     phase_time_s[MS_PHASE_COUNT];
+    uint16_t  settled;
+} ModeSwitch;
+
+void ms_config_default(ModeSwitchConfig* cfg);
+
+// duty0: huidige duty (0..1); bepaalt de duur van RAMP_DOWN.
+void ms_start(ModeSwitch* ms, const ModeSwitchConfig* cfg, PowerMode from, PowerMode to,
+              bool relays_change, float duty0);
+
+// Eén stap per meting. Geeft de fase na de stap; MS_IDLE = klaar (zie result).
+ModeSwitchPhase ms_step(ModeSwitch* ms, const ModeSwitchConfig* cfg, const ModeSwitchInput* in);
+
+bool ms_active(const ModeSwitch* ms);
+
+const char* ms_phase_name(ModeSwitchPhase phase);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+// control/profiles/gsm_burst.h - gegenereerd door tools/profile_compile uit tools/profiles/gsm_burst.csv
+#pragma once
+#include <stdint.h>
+
+alignas(4) static const uint8_t PROFILE_GSM_BURST[64] = {
+  0x53,0x42,0x4C,0x50,0x01,0x01,0x04,0x00,0x4B,0xF6,0x04,0x57,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x27,0x00,0x00,
+  0x64,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xE8,0x03,0x00,0x00,
+  0xD0,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0xA0,0x0F,0x00,0x00,
+  0x64,0x00,0x00,0x00,0x03,0x00,0x01,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00
+};
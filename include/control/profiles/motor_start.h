@@ -0,0 +1,13 @@
+// control/profiles/motor_start.h - gegenereerd door tools/profile_compile uit tools/profiles/motor_start.csv
+#pragma once
+#include <stdint.h>
+
+alignas(4) static const uint8_t PROFILE_MOTOR_START[76] = {
+  0x53,0x42,0x4C,0x50,0x01,0x01,0x05,0x00,0x13,0xFF,0x7E,0x6E,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x4E,0x00,0x00,
+  0x88,0x13,0x00,0x00,0x01,0x00,0x00,0x00,0x40,0x0D,0x03,0x00,
+  0xDC,0x05,0x00,0x00,0x02,0x00,0x00,0x00,0x80,0x84,0x1E,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x40,0x42,0x0F,0x00,
+  0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x03,0x00,0x00,0x00
+};
@@ -0,0 +1,109 @@
+// control/sequencer.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Load-profile sequencer
+// =========================
+//
+// Speelt een binair profiel (meestal een const array in flash) af als
+// tijd-geïndexeerde setpoint-segmenten. Geen allocatie: het profiel wordt
+// in-place gelezen, de runtime-state is een vaste struct.
+//
+// Binair formaat (little endian), gemaakt door tools/profile_compile:
+//
+//   SeqHeader  (16 bytes)
+//   SeqSegment (12 bytes) x n_segments
+//
+// Segment types:
+//   STEP  setpoint springt naar value en blijft duration_us staan
+//   RAMP  lineair van het huidige setpoint naar value in duration_us
+//   HOLD  huidig setpoint vasthouden gedurende duration_us
+//   LOOP  spring terug naar segment aux; value = totaal aantal doorlopen (0 = eindeloos)
+//
+// Waarden zijn milli-eenheden: mV voor source, mA voor sink.
+
+#define SEQ_MAGIC       0x504C4253u  // "SBLP"
+#define SEQ_VERSION     1
+#define SEQ_MAX_LOOPS   8
+
+// seq_eval loopt mee met de regelstap van ControlTask (1 kHz). Segmentgrenzen
+// zijn exact in us, maar het setpoint wordt maar eens per tick bemonsterd: een
+// segment korter dan een tick valt (deels) tussen twee samples en wordt gealiast.
+// tools/profile_compile weigert zulke segmenten.
+#define SEQ_TICK_US     1000u
+
+typedef enum
+{
+    SEQ_SEG_STEP = 0,
+    SEQ_SEG_RAMP = 1,
+    SEQ_SEG_HOLD = 2,
+    SEQ_SEG_LOOP = 3,
+} SeqSegType;
+
+typedef enum
+{
+    SEQ_MODE_SOURCE = 0,  // setpoint = spanning
+    SEQ_MODE_SINK   = 1,  // setpoint = stroom
+} SeqMode;
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  mode;         // SeqMode
+    uint16_t n_segments;
+    uint32_t crc32;        // over de segmenten
+    uint32_t reserved;
+} SeqHeader;
+
+typedef struct
+{
+    uint8_t  type;         // SeqSegType
+    uint8_t  loop_id;      // LOOP: teller-slot 0..SEQ_MAX_LOOPS-1
+    uint16_t aux;          // LOOP: doelsegment
+    uint32_t duration_us;
+    int32_t  value;        // milli-eenheden, LOOP: aantal doorlopen
+} SeqSegment;
+
+typedef struct
+{
+    const SeqHeader*  hdr;
+    const SeqSegment* seg;
+
+    uint16_t idx;              // huidig segment
+    bool     running;
+    uint32_t seg_start_us;     // starttijd huidig segment
+    int32_t  seg_start_value;  // setpoint aan het begin van het segment
+    int32_t  value;            // laatst berekend setpoint
+    uint32_t loop_left[SEQ_MAX_LOOPS];
+} Sequencer;
+
+uint32_t seq_crc32(const void* data, size_t len);
+
+// Valideert een profiel (magic, versie, lengte, crc, loop-doelen).
+bool seq_validate(const uint8_t* blob, size_t len);
+
+// Koppelt een gevalideerd profiel; het profiel moet blijven bestaan (flash).
+bool seq_load(Sequencer* s, const uint8_t* blob, size_t len);
+
+void seq_start(Sequencer* s, uint32_t t_us, int32_t initial_value);
+void seq_stop(Sequencer* s);
+
+// Setpoint (milli-eenheden) op tijdstip t_us. Meerdere segmenten kunnen in één
+// aanroep worden afgerond; de segmentgrenzen blijven exact (geen drift).
+int32_t seq_eval(Sequencer* s, uint32_t t_us);
+
+static inline bool seq_running(const Sequencer* s) { return s && s->running; }
+static inline SeqMode seq_mode(const Sequencer* s) { return (SeqMode)s->hdr->mode; }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,60 @@
+// display/frame_prof.h - frame-tijd profiler voor displayTask
+#pragma once
+#include <stdint.h>
+
+// Per ronde van de displayTask-loop: tijd per stage (CPU-cyclusteller), plus wat
+// LVGL die ronde rendert en flusht. De laatste FP_WINDOW rondes staan in een
+// venster; elke FP_REPORT_MS gaan p50/p90/p99/max naar Serial en (optioneel) naar
+// een overlay op het scherm.
+//
+// DISPLAY_PROFILE=0 (standaard): alle FP_*-macro's zijn leeg en frame_prof.cpp
+// compileert tot niets. Aanzetten met -DDISPLAY_PROFILE=1, overlay erbij met
+// -DDISPLAY_PROFILE_OVERLAY=1.
+#ifndef DISPLAY_PROFILE
+#define DISPLAY_PROFILE 0
+#endif
+#ifndef DISPLAY_PROFILE_OVERLAY
+#define DISPLAY_PROFILE_OVERLAY 0
+#endif
+
+#define FP_WINDOW     128u     // rondes (6.4 s bij 20 Hz)
+#define FP_REPORT_MS  5000u
+
+enum FpMetric : uint8_t
+{
+  // us per ronde
+  FP_SNAPSHOT = 0,    // system_read_snapshot
+  FP_INPUTS,          // UI-wissel, handle_inputs, fout-overlay
+  FP_MODEL,           // model_from_system
+  FP_UPDATE,          // ui*_update
+  FP_LVGL,            // lv_timer_handler (render + flush)
+  FP_RENDER,          // FP_LVGL - flush-CPU - flush-wacht
+  FP_FLUSH_CPU,       // omzetten + transfers starten
+  FP_FLUSH_WAIT,      // LVGL wacht op de bus
+  FP_FLUSH_BUS,       // DMA-tijd van de transfers
+  FP_LOOP,            // hele ronde (zonder de slaap)
+  // aantallen per ronde
+  FP_PIXELS,          // geflushte pixels
+  FP_AREAS,           // flush-aanroepen
+  FP_COUNT
+};
+
+#if DISPLAY_PROFILE
+void fp_init();
+void fp_frame_begin();
+void fp_mark(FpMetric m);              // tijd sinds de vorige mark naar m
+void fp_flush_area(uint32_t pixels);   // vanuit de flush-callback
+void fp_frame_end();                   // venster bijwerken, rapport als het tijd is
+
+#define FP_INIT()            fp_init()
+#define FP_FRAME_BEGIN()     fp_frame_begin()
+#define FP_MARK(m)           fp_mark(m)
+#define FP_FLUSH_AREA(px)    fp_flush_area(px)
+#define FP_FRAME_END()       fp_frame_end()
+#else
+#define FP_INIT()            do {} while (0)
+#define FP_FRAME_BEGIN()     do {} while (0)
+#define FP_MARK(m)           do {} while (0)
+#define FP_FLUSH_AREA(px)    do {} while (0)
+#define FP_FRAME_END()       do {} while (0)
+#endif
@@ -1,6 +1,6 @@
-// ili9488_driver.hpp - simpele, stabiele driver voor ILI9488 + LVGL
+// ili9488_driver.hpp - ILI9488 (8-bit parallel) + LVGL
 #pragma once
-#include <Arduino.h>
+#include <stdint.h>
 
 // ==== PIN DEFINITIES (pas aan als jouw PCB anders is) ====
 #define LCD_D0   10
@@ -14,194 +14,82 @@
 
 #define LCD_CS   2     // CS van het LCD
 #define LCD_RS   45    // RS / DC
-#define LCD_WR   20    // WR
+#define LCD_WR   18    // WR (niet 20: USB D+, zie system/pins.h)
 #define LCD_RST  -1    // zet op GPIO als je RST aan een pin hebt, anders -1 (aan 3V3)
 
 constexpr uint16_t ILI9488_WIDTH  = 320;
 constexpr uint16_t ILI9488_HEIGHT = 480;
 
-
-static const int lcd_data_pins[8] = {
-  LCD_D0, LCD_D1, LCD_D2, LCD_D3,
-  LCD_D4, LCD_D5, LCD_D6, LCD_D7
-};
-
-inline void lcd_busWrite(uint8_t v)
-{
-  for (int i = 0; i < 8; i++) {
-    digitalWrite(lcd_data_pins[i], (v >> i) & 0x01);
-  }
-}
-
-inline void lcd_pulseWR()
-{
-  digitalWrite(LCD_WR, LOW);
-  __asm__ __volatile__("nop\nnop\nnop\nnop\nnop\n");
-  digitalWrite(LCD_WR, HIGH);
-}
-
-inline void lcd_writeCommand(uint8_t cmd)
-{
-  digitalWrite(LCD_RS, LOW);
-  digitalWrite(LCD_CS, LOW);
-  lcd_busWrite(cmd);
-  lcd_pulseWR();
-  digitalWrite(LCD_CS, HIGH);
-}
-
-inline void lcd_writeData(uint8_t data)
-{
-  digitalWrite(LCD_RS, HIGH);
-  digitalWrite(LCD_CS, LOW);
-  lcd_busWrite(data);
-  lcd_pulseWR();
-  digitalWrite(LCD_CS, HIGH);
-}
-
-inline void lcd_writeColor(uint16_t c)
-{
-  // GEEN inversie meer hier
-  lcd_writeData(c >> 8);
-  lcd_writeData(c & 0xFF);
-}
-
-inline void ili9488_set_rotation(uint8_t r) {
-  uint8_t madctl = 0;
-
-  switch (r & 3) {
-    case 0: // portret
-      madctl = 0x48;  // MX | BGR
-      break;
-    case 1: // landscape (90°)
-      madctl = 0x28;  // MV | BGR
-      break;
-    case 2: // portret 180°
-      madctl = 0x88;  // MY | BGR
-      break;
-    case 3: // landscape 180°
-      madctl = 0xE8;  // MX | MY | MV | BGR
-      break;
-  }
-
-  lcd_writeCommand(0x36);
-  lcd_writeData(madctl);
-}
-
-inline void ili9488_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
-{
-  uint16_t x2 = x + w - 1;
-  uint16_t y2 = y + h - 1;
-
-  // Column address set
-  lcd_writeCommand(0x2A);
-  lcd_writeData(x >> 8);
-  lcd_writeData(x & 0xFF);
-  lcd_writeData(x2 >> 8);
-  lcd_writeData(x2 & 0xFF);
-
-  // Page address set
-  lcd_writeCommand(0x2B);
-  lcd_writeData(y >> 8);
-  lcd_writeData(y & 0xFF);
-  lcd_writeData(y2 >> 8);
-  lcd_writeData(y2 & 0xFF);
-
-  // RAMWR
-  lcd_writeCommand(0x2C);
-}
-
-inline void ili9488_init()
-{
-  // Datapinnen + control-pinnen als output
-  for (int i = 0; i < 8; i++) {
-    pinMode(lcd_data_pins[i], OUTPUT);
-    digitalWrite(lcd_data_pins[i], LOW);
-  }
-  pinMode(LCD_CS, OUTPUT);
-  pinMode(LCD_RS, OUTPUT);
-  pinMode(LCD_WR, OUTPUT);
-  digitalWrite(LCD_CS, HIGH);
-  digitalWrite(LCD_RS, HIGH);
-  digitalWrite(LCD_WR, HIGH);
-
-#if (LCD_RST >= 0)
-  pinMode(LCD_RST, OUTPUT);
-  digitalWrite(LCD_RST, LOW);
-  delay(10);
-  digitalWrite(LCD_RST, HIGH);
-  delay(120);
-#else
-  // RST hard aan 3V3
-  delay(120);
+// ==== BUS ====
+// Standaard drijft de LCD_CAM-periferie van de S3 de 8-bit bus (i80-mode, esp_lcd):
+// CS blijft laag over een hele burst (commando + pixels), pixels gaan met DMA.
+// ILI9488_BUS_GPIO=1 (build flag) zet de oude digitalWrite-bus terug, voor
+// vergelijkingsmetingen.
+#ifndef ILI9488_BUS_GPIO
+#define ILI9488_BUS_GPIO 0
 #endif
 
-  // Software reset
-  lcd_writeCommand(0x01);
-  delay(120);
-
-  // Sleep out
-  lcd_writeCommand(0x11);
-  delay(120);
-
-  // 16-bit pixel formaat RGB565
-  lcd_writeCommand(0x3A);
-  lcd_writeData(0x55);
-
-  // Memory Access Control: portret, geen spiegeling, RGB (BGR=0, MV=0)
-  // lcd_writeCommand(0x36);
-  // lcd_writeData(0x48);
-
-  // Display inversion OFF (heel belangrijk om zwart/wit omkering uit te zetten)
-  lcd_writeCommand(0x20);  // of 0x21, afhankelijk van jouw werkende situatie
-
-  // Display on
-  lcd_writeCommand(0x29);
-  delay(20);
+// WR-klok. Datasheet: schrijfcyclus min. 30 ns (33 MHz); 20 MHz laat marge voor
+// lange draden/flatcable.
+#define ILI9488_PCLK_HZ      (20 * 1000 * 1000)   // <-- AANPASSEN
 
-  ili9488_set_rotation(1);
-}
+// Grootste enkele DMA-transfer (bytes): een volledig frame RGB565.
+#define ILI9488_MAX_TRANSFER ((uint32_t)ILI9488_WIDTH * ILI9488_HEIGHT * 2u)
 
-inline void ili9488_fill_screen(uint16_t color)
+// Tellers van de pixel-pushes (sinds boot). busy_us wordt in de DMA-ISR opgeteld;
+// voor diagnose, een uitlezing kan één transfer achterlopen.
+struct Ili9488Stats
 {
-  // compenseer paneel-inversie
-  uint16_t c = ~color;
-
-  ili9488_set_window(0, 0, 320, 480);
-  uint32_t total = 320UL * 480UL;
-  for (uint32_t i = 0; i < total; i++) {
-    lcd_writeColor(c);
-  }
-}
+  uint32_t n_push;
+  uint64_t bytes;
+  uint64_t cpu_us;         // omzetten + transfer starten (CPU)
+  uint64_t busy_us;        // transfer start -> DMA klaar (bus)
+  uint64_t wait_us;        // CPU geblokkeerd in ili9488_wait_idle
+  uint32_t max_us;         // langste transfer
+};
 
+// Aangeroepen als een async push klaar is; vanuit de DMA-ISR (i80) of direct
+// (GPIO-bus). Kort houden.
+typedef void (*Ili9488DoneCb)(void* ctx);
 
-// LVGL buffer schrijven: px_map zijn bytes in RGB565 (little endian)
-inline void ili9488_push_pixels(uint16_t x, uint16_t y,
-                                uint16_t w, uint16_t h,
-                                const uint8_t *px_map)
+// Hoe een LVGL-buffer op de bus komt (zie ili9488_driver.cpp). NATIVE vraagt
+// LV_COLOR_FORMAT_RGB565_SWAPPED en zet het paneel op INVON: geen transformatie.
+// De andere paden zijn de woordbrede fallback voor RGB565 (little endian).
+enum Ili9488PixelPath : uint8_t
 {
-  ili9488_set_window(x, y, w, h);
-
-  uint32_t total = (uint32_t)w * h;
-  for (uint32_t i = 0; i < total; i++) {
-    uint8_t lo = px_map[2 * i + 0];
-    uint8_t hi = px_map[2 * i + 1];
-
-    // maak 16-bit kleur uit LVGL
-    uint16_t c = (static_cast<uint16_t>(hi) << 8) | lo;
-
-    // compenseer paneel-inversie
-    c = ~c;
-
-    lcd_writeColor(c);
-  }
-}
-
-
-
-
-
-
-
-
-
+  ILI9488_PX_NATIVE = 0,
+  ILI9488_PX_SWAP,
+  ILI9488_PX_SWAP_INVERT,
+};
 
+void ili9488_init();
+void ili9488_set_rotation(uint8_t r);
+void ili9488_set_pixel_path(Ili9488PixelPath path);
+Ili9488PixelPath ili9488_get_pixel_path();
+void ili9488_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+void ili9488_fill_screen(uint16_t color);
+
+// LVGL buffer schrijven in het formaat van het pixelpad. Zo nodig wordt de buffer
+// in-place naar busvolgorde gezet; daarna gaat hij in één DMA-transfer weg.
+//   ili9488_push_pixels        keert terug als de transfer klaar is
+//   ili9488_push_pixels_async  keert terug zodra de transfer loopt; px_map blijft
+//                              van de driver tot de done-callback
+void ili9488_push_pixels(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* px_map);
+void ili9488_push_pixels_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* px_map);
+void ili9488_set_done_cb(Ili9488DoneCb cb, void* ctx);
+
+// Rechthoek uit een grotere buffer (regelafstand stride_px pixels), bv. een
+// full-frame buffer in direct mode. Niet aaneengesloten: één transfer per regel
+// (RAMWR + RAMWRC). Alleen met ILI9488_PX_NATIVE voor buffers die LVGL bewaart:
+// de andere paden zetten de pixels in-place om.
+void ili9488_push_rect_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                             uint8_t* px, uint32_t stride_px);
+
+// Blokkeren (niet spinnen) tot alle transfers klaar zijn; telt in wait_us.
+void ili9488_wait_idle();
+
+void ili9488_get_stats(Ili9488Stats* out);
+
+// Volledig scherm vullen en de tijd + MB/s op Serial zetten, plus per pixelpad de
+// kernel- en push-doorvoer in bytes/us (eenmalig na init).
+void ili9488_bench();
@@ -0,0 +1,43 @@
+// display/ui_fmt.h - allocatievrije getalnotatie voor UI-labels
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Meetwaarden gaan als gehele milli-eenheden (mV, mA, mmAh, ...) de UI in. Het
+// formaat ligt vast in een constexpr UiFmt: tekst ervoor, aantal decimalen (0..3)
+// en eenheid erachter. Geen float/double, geen newlib-printf, geen heap: er wordt
+// direct in de buffer van de aanroeper geschreven (bv. de statische tekst van een
+// label), met '\0' en afgekapt op cap. Afronden half van nul af, zoals printf;
+// alleen "-0.00" wordt "0.00".
+//
+// Host-benchmark + vergelijking met snprintf: tools/fmt_bench.cpp. Op het target
+// met -DDISPLAY_FMT_BENCH=1 (eenmalig bij het opstarten, Serial).
+#ifndef DISPLAY_FMT_BENCH
+#define DISPLAY_FMT_BENCH 0
+#endif
+
+struct UiFmt
+{
+  const char* prefix;      // mag nullptr zijn
+  uint8_t     decimals;    // 0..3
+  const char* unit;        // mag nullptr zijn, incl. spatie (" V")
+};
+
+#define UI_FMT_MAX 48      // grootste labeltekst incl. '\0'
+
+// float -> milli-eenheden, afgerond (single precision, verzadigt op int32)
+int32_t ui_milli(float v);
+
+// Waarde op de weergaveresolutie (eenheden van het laatste cijfer). Gelijke key
+// = gelijke tekst: daarmee kan een label overslaan zonder te formatteren.
+int32_t ui_fmt_key(const UiFmt& f, int32_t milli);
+
+// Geven de lengte zonder '\0' terug
+size_t ui_fmt_fixed(char* out, size_t cap, const UiFmt& f, int32_t milli);
+size_t ui_fmt_mmss(char* out, size_t cap, const char* prefix, uint32_t sec);   // mm:ss, mm >= 2 cijfers
+size_t ui_fmt_uint(char* out, size_t cap, const char* prefix, uint32_t v);
+
+#if DISPLAY_FMT_BENCH
+// ns per conversie, ui_fmt_* tegen snprintf, op Serial
+void ui_fmt_bench();
+#endif
@@ -7,31 +7,33 @@
 // Display model structs (data die displayTask aan de UI geeft)
 // =========================
 
+// Meetwaarden in gehele milli-eenheden (mV, mA, capaciteit x 1000), zie
+// display/ui_fmt.h
 struct UI1Model {
   int16_t curve[32];
   int     curve_len;
   int     progress_index;
 
-  float voltage_val;
-  float current_val;
-  float capacity_val;
+  int32_t voltage_mv;
+  int32_t current_ma;
+  int32_t capacity_m;
   uint32_t runtime_sec;
   bool state_load;
 
-  float nominal_v_val;
-  float btn_capacity_val;
+  int32_t nominal_mv;
+  int32_t btn_capacity_m;
 };
 
 struct UI2Model {
-  float set_voltage;
-  float meas_ampere;
-  float vmax;
+  int32_t set_mv;
+  int32_t meas_ma;
+  int32_t vmax_mv;
 };
 
 struct UI3Model {
-  float set_ampere;
-  float meas_voltage;
-  float imax;
+  int32_t set_ma;
+  int32_t meas_mv;
+  int32_t imax_ma;
 };
 
 struct DisplayModel {
@@ -44,10 +46,19 @@ struct DisplayModel {
 // Screens
 // =========================
 
+// ui*_create bouwt een scherm één keer (volgende aanroepen doen niets) zonder het
+// te tonen; ui*_load toont het (en bouwt het zo nodig eerst). ui_screens_init
+// bouwt ze alle drie vooraf, inclusief layout.
+void ui_screens_init();
+
 void ui1_create();
 void ui2_create();
 void ui3_create();
 
+void ui1_load();
+void ui2_load();
+void ui3_load();
+
 void ui1_update(const DisplayModel& m);
 void ui2_update(const DisplayModel& m);
 void ui3_update(const DisplayModel& m);
@@ -0,0 +1,85 @@
+// emulate/aging.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "emulate/emulate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Cell-aging model
+// =========================
+//
+// Bovenop de emulatie-engine: houdt equivalente volle cycli (EFC) en de tijd per
+// SOC/temperatuur-bin bij, en past capaciteit en weerstand aan via fade-wetten:
+//
+//   Q_loss = a_cyc * EFC^z_cyc + a_cal * sqrt(t_eff_dagen)
+//   R_gain = r_cyc * EFC       + r_cal * sqrt(t_eff_dagen)
+//
+// t_eff is kalendertijd gewogen met een stressfactor:
+//   Arrhenius in temperatuur (ea_k = Ea/R) en exponentieel in SOC (b_soc).
+
+#define AGING_SOC_BINS  10   // 0-10%, ..., 90-100%
+#define AGING_T_BINS     6   // <0, 0-15, 15-25, 25-35, 35-45, >45 °C
+#define AGING_VERSION    2   // 2: integratoren in double
+
+typedef struct
+{
+    float a_cyc;        // capaciteitsverlies (fractie) bij 1 EFC
+    float z_cyc;        // exponent cyclische fade
+    float a_cal;        // capaciteitsverlies per sqrt(dag) bij 25 °C / 50% SOC
+    float r_cyc;        // relatieve R-toename per EFC
+    float r_cal;        // relatieve R-toename per sqrt(dag)
+    float ea_k;         // activatie-energie / R (K)
+    float b_soc;        // SOC-stress exponent
+    float q_loss_max;   // ondergrens capaciteit (1 - q_loss_max)
+} AgingParams;
+
+typedef struct
+{
+    uint32_t version;
+    // Double: aging_update loopt op 1 kHz en een float-som van ms-stappen loopt
+    // vast (t_total_s blijft op 32768 s staan, EFC op een paar cycli)
+    double   efc;             // equivalente volle cycli
+    double   ah_throughput;   // |I| geïntegreerd (Ah)
+    double   t_total_s;       // totale emulatietijd
+    double   t_eff_s;         // stress-gewogen kalendertijd
+    uint32_t t_bins_s[AGING_SOC_BINS][AGING_T_BINS];
+
+    // afgeleid (door aging_update bijgewerkt)
+    float    capacity_factor; // 1.0 = nieuw
+    float    resistance_factor;
+
+    float    t_bin_frac_s;    // sub-seconde rest voor de bins
+    uint32_t crc32;           // alleen geldig in een checkpoint
+} AgingState;
+
+// Defaults per curve_id (0 Li-ion, 1 LiFePO4, 2 lood-zuur); ~20% fade bij het
+// typische cycle-life van de chemie.
+void aging_default_params(AgingParams* p, uint8_t curve_id);
+
+void aging_init(AgingState* s);
+
+// Eén stap; i_a > 0 = ontladen. capacity_ah = nominale (nieuwe) capaciteit.
+void aging_update(AgingState* s, const AgingParams* p, float soc, float i_a,
+                  float temp_c, float dt_s, float capacity_ah);
+
+// Past capaciteit/weerstand van base toe op out (out mag base zijn).
+void aging_apply(const AgingState* s, const EmuParams* base, EmuParams* out);
+
+// Checkpoint: crc over de struct zetten / controleren.
+void aging_seal(AgingState* s);
+bool aging_verify(const AgingState* s);
+
+// True als een nieuw checkpoint zin heeft t.o.v. het laatst opgeslagen:
+// na min_efc extra cycli of max_interval_s emulatietijd.
+bool aging_checkpoint_due(const AgingState* s, const AgingState* last,
+                          float min_efc, float max_interval_s);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,104 @@
+// emulate/emulate.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Battery emulation engine
+// =========================
+//
+// Portable (geen Arduino/FreeRTOS), zodat dezelfde code op de ESP32 en in de
+// host tools (tools/) draait.
+//
+// Model: OCV(SOC) uit een CurveData-curve (% van nominale spanning, index 0 =
+// SOC 100%, laatste index = SOC 0%) + serieweerstand R0 + één RC-tak (R1/C1).
+// Stroomconventie: i_load > 0 = ontladen (DUT trekt stroom uit de "batterij").
+
+typedef struct
+{
+    const int16_t* curve;     // curve_len punten, in eenheden van curve_unit x nominal_voltage
+    uint16_t curve_len;
+    float    curve_unit;      // 0.01 = procent (CurveData), 0.0001 = 0.01% (model blob)
+
+    float nominal_voltage;    // V bij 100%
+    float capacity_mAh;       // nominale capaciteit
+
+    float r0_ohm;             // serieweerstand
+    float r1_ohm;             // RC-tak weerstand (0 = geen RC-tak)
+    float c1_f;               // RC-tak capaciteit
+
+    float v_cutoff;           // terminal spanning waarop "leeg" wordt gemeld
+} EmuParams;
+
+typedef struct
+{
+    float soc;                // 0..1
+    float v_rc;               // spanning over de RC-tak
+    float v_term;             // laatst berekende klemspanning
+    float ah_out;             // netto ontladen lading (Ah)
+    float wh_out;             // netto ontladen energie (Wh)
+    bool  empty;              // v_term < v_cutoff of soc == 0
+
+    // Integratoren; soc/ah_out/wh_out hierboven zijn er een float-kopie van.
+    // Double omdat bij dt = 1 ms de stap per sample kleiner is dan een half ulp
+    // van een float rond 1.0 (0.1 A op 3000 mAh: 9e-9 per stap).
+    double soc_acc;
+    double ah_acc;
+    double wh_acc;
+} EmuState;
+
+// =========================
+// Model blob (door tools/model_fit gemaakt uit gelogde ontlaaddata)
+// =========================
+#define EMU_MODEL_MAGIC   0x4D454253u  // "SBEM"
+#define EMU_MODEL_VERSION 1
+#define EMU_MODEL_CURVE_UNIT 0.0001f  // curve in 0.01% van nominal_voltage
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t curve_len;        // == CURVE_LEN
+    float    nominal_voltage;  // V bij 100%
+    float    capacity_mAh;
+    float    r0_ohm;
+    float    r1_ohm;
+    float    c1_f;
+    int16_t  curve[CURVE_LEN]; // 0..10000 (0.01% van nominal_voltage), SOC 100% -> 0%
+    uint32_t crc32;            // over alles hiervoor
+} EmuModelBlob;
+
+bool emu_model_validate(const EmuModelBlob* m);
+void emu_model_seal(EmuModelBlob* m);
+
+// Vult params uit een (gevalideerde) blob; params wijzen naar m->curve.
+bool emu_params_from_model(EmuParams* p, const EmuModelBlob* m);
+
+// Standaard ontlaadcurves (Li-ion, LiFePO4, lood-zuur).
+void emu_default_curves(CurveData* c);
+
+// Vult params met defaults voor een curve uit CurveData (curve_id 0..2).
+void emu_params_from_curves(EmuParams* p, const CurveData* curves, uint8_t curve_id,
+                            float nominal_voltage, float capacity_mAh);
+
+// SOC bij een UI start_index (0 = vol).
+float emu_soc_from_start_index(uint8_t start_index, uint16_t curve_len);
+
+void  emu_init(EmuState* s, const EmuParams* p, float soc0);
+
+// Open-klemspanning bij gegeven SOC (lineaire interpolatie tussen curvepunten).
+float emu_ocv(const EmuParams* p, float soc);
+
+// Eén tijdstap; geeft de nieuwe klemspanning terug.
+float emu_step(EmuState* s, const EmuParams* p, float i_load_a, float dt_s);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
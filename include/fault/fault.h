@@ -0,0 +1,186 @@
+// fault/fault.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Fault manager
+// =========================
+//
+// Elke fault heeft een klasse, een debounce (opeenvolgende samples) en
+// persistentievensters (aan/uit). Het evalueren (fm_update) is portable en
+// draait in ControlTask op elke meting (1 kHz), direct voor de regelstap, zodat
+// de reactie in dezelfde stap op de uitgang staat. tools/fault_sim draait het op
+// de host en toetst de gemeten tijden aan fm_worst_case_us.
+//
+// Klassen:
+//   SHUTDOWN  uitgang direct uit (duty 0 in dezelfde regelstap), bit wordt
+//             gelatcht, state machine naar SYS_STATE_ERROR + UI_SCREEN_ERROR;
+//             terug naar CONFIG pas na bevestiging (STOP) zonder actieve fault
+//   DERATE    duty begrensd op FAULT_DERATE_DUTY zolang de fault actief is
+//   WARN      alleen de current-bit + melding op Serial
+//
+// Worst-case reactietijd (fault ontstaat -> PWM aangepast), met
+//   Ts    = meetperiode (1 ms)
+//   k     = max(on_count - 1, ceil(on_ms / Ts))   extra samples tot assert
+//   Tctrl = ControlTask na de meting tot control_publish (< 0.2 ms gemeten)
+//   Tact  = actuationTask notify -> ledcWrite (ActuationStats.pwm_latency_us_max)
+// is  T = Ts + k * Ts + Tctrl + Tact
+// (de eerste Ts: de fault kan net na een sample ontstaan; gemeld via
+// fault_report geldt hetzelfde, die wordt op de volgende regelstap gelezen).
+// Vult ControlTask geen metingen (measureTask staat stil), dan is Ts de
+// notify-timeout van 10 ms. Met de standaardtabel en Tctrl + Tact = 0.5 ms:
+//
+//   fault        klasse    on_count on_ms off_ms   worst case
+//   OV           SHUTDOWN     2        0    100      2.5 ms
+//   OC           SHUTDOWN     2        0    100      2.5 ms
+//   OT           SHUTDOWN     1      200   5000    201.5 ms
+//   OT_DERATE    DERATE       1      500   5000    501.5 ms
+//   HW           SHUTDOWN     1        0      0      1.5 ms   (gemeld)
+//   COMM         SHUTDOWN     1      100    500    101.5 ms   (gemeld / I2C)
+//   SD           WARN         1     1000   1000   1001.5 ms   (gemeld)
+//
+// fault_print_worst_case() print deze tabel met de gemeten Tact (max PWM-latency
+// uit het eerste afgesloten actuation-venster, ~10 s na de start).
+// De relais (I2C, MCP23008) volgen na de PWM binnen MCP08_MIN_INTERVAL_MS.
+//
+// De ring buffer bewaart per assert: detectie (eerste raw sample / melding),
+// assert (na debounce/persistentie) en reactie (ControlData gepubliceerd).
+// Detectie -> reactie is daarmee hoogstens k*Ts + Tctrl voor meetfaults en
+// Ts + k*Ts + Tctrl voor gemelde faults (Tact en de eerste Ts vallen erbuiten).
+
+typedef enum
+{
+    FAULT_CLASS_SHUTDOWN = 0,
+    FAULT_CLASS_DERATE,
+    FAULT_CLASS_WARN,
+    FAULT_CLASS_COUNT
+} FaultClass;
+
+typedef enum
+{
+    FID_OV = 0,
+    FID_OC,
+    FID_OT,
+    FID_OT_DERATE,
+    FID_HW,
+    FID_COMM,
+    FID_SD,
+    FID_COUNT
+} FaultId;
+
+// SystemStatus-bits van de SHUTDOWN-klasse (gecontroleerd tegen de tabel)
+#define FAULT_SHUTDOWN_BITS (FAULT_OV | FAULT_OC | FAULT_OT | FAULT_HW | FAULT_COMM)
+
+#define FAULT_DERATE_DUTY   0.5f
+#define FAULT_RING_LEN      32
+
+typedef struct
+{
+    uint32_t    bit;        // FAULT_* in SystemStatus
+    FaultClass  cls;
+    uint8_t     on_count;   // opeenvolgende raw samples (debounce)
+    uint16_t    on_ms;      // raw aaneengesloten zo lang voor assert (persistentie)
+    uint16_t    off_ms;     // raw weg zo lang voor de current-bit weg gaat
+    const char* name;
+} FaultDef;
+
+// Meetgrenzen voor de raw condities
+typedef struct
+{
+    float v_ov;        // V
+    float i_oc;        // A (source en sink)
+    float t_derate;    // °C
+    float t_shutdown;  // °C
+} FaultLimits;
+
+typedef struct
+{
+    uint8_t  id;          // FaultId
+    uint8_t  cls;         // FaultClass
+    uint16_t reserved;
+    uint32_t t_detect_us;
+    uint32_t t_assert_us;
+    uint32_t t_react_us;
+} FaultRecord;
+
+typedef struct
+{
+    uint8_t  count[FID_COUNT];
+    uint32_t t_raw_us[FID_COUNT];     // begin raw-periode (0 = niet raw)
+    uint32_t t_clear_us[FID_COUNT];   // begin raw-weg terwijl asserted (0 = n.v.t.)
+    uint32_t t_detect_us[FID_COUNT];  // van de lopende assert
+    uint32_t t_assert_us[FID_COUNT];
+    uint32_t asserted;                // FaultId-mask
+    uint32_t react_pending;           // FaultId-mask: assert zonder vastgelegde reactie
+
+    FaultRecord ring[FAULT_RING_LEN];
+    uint32_t    n_records;
+    uint32_t    n_class[FAULT_CLASS_COUNT];
+    uint32_t    max_react_us[FAULT_CLASS_COUNT];   // detectie -> reactie
+} FaultManager;
+
+typedef struct
+{
+    uint32_t set_bits;     // FAULT_* nieuw actief
+    uint32_t latch_bits;   // FAULT_* te latchen (SHUTDOWN)
+    uint32_t clear_bits;   // FAULT_* niet meer actief
+    bool     shutdown;     // een SHUTDOWN-fault is actief
+    float    duty_cap;     // 1.0 of FAULT_DERATE_DUTY
+} FaultOutput;
+
+typedef struct
+{
+    uint32_t sample_period_us;
+    uint32_t ctrl_latency_us;
+    uint32_t act_latency_us;
+} FaultTiming;
+
+const FaultDef* fm_def(FaultId id);
+void fm_limits_default(FaultLimits* lim);
+
+void fm_init(FaultManager* fm);
+
+// Raw condities (FaultId-mask, 1u << id) uit een meting
+uint32_t fm_measure_raw(const FaultLimits* lim, const MeasurementData* m);
+
+// Eén evaluatie. raw: FaultId-mask; t_first_us (optioneel, per id): tijdstip waarop
+// de producer de fault zag (fault_report), anders geldt t_us.
+// events: eenmalige meldingen (fault_report_event, deel van raw of niet). Die
+// staan maar één evaluatie aan en slaan on_count/on_ms over: meteen assert (en
+// latch bij SHUTDOWN), daarna off_ms aanhouden zoals elke fault.
+void fm_update(FaultManager* fm, uint32_t raw, uint32_t events, const uint32_t* t_first_us,
+               uint32_t t_us, FaultOutput* out);
+
+// Reactie staat op de uitgang (ControlData gepubliceerd): open asserts vastleggen.
+void fm_reacted(FaultManager* fm, uint32_t t_us);
+
+uint32_t fm_worst_case_us(FaultId id, const FaultTiming* timing);
+
+// =========================
+// Firmware (fault_runtime.cpp)
+// =========================
+// Melden vanuit andere tasks; gelezen op de volgende regelstap.
+void fault_report(FaultId id, bool active);
+void fault_report_event(FaultId id);   // eenmalig (bv. mislukte modewissel): direct actief, off_ms lang
+
+// ControlTask: evalueren + SystemStatus/state machine bijwerken; na control_publish
+// fault_reacted() aanroepen.
+void fault_tick(const SystemSnapshot* s, FaultOutput* out);
+void fault_reacted(void);
+
+// Kopie van de laatste records (nieuwste eerst); geeft het aantal.
+int  fault_get_records(FaultRecord* out, int max);
+// false (en niets geprint) zolang er nog geen actuation-venster is
+bool fault_print_worst_case(void);
+
+#ifdef __cplusplus
+}
+#endif
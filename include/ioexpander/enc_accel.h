@@ -0,0 +1,56 @@
+// ioexpander/enc_accel.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Encoder-versnelling
+// =========================
+//
+// Portable logica (geen Arduino/FreeRTOS): de display-task roept hem aan met de
+// detent-teller van de PCNT; tools/enc_accel_sim test hem met synthetische
+// pulstreinen.
+//
+// Snelheid v (detents/s) komt uit de tijd tussen detents (tijdstempels uit de
+// PCNT-interrupt, dus onafhankelijk van hoe vaak de consument leest).
+// Vermenigvuldiger: 1 tot v_lo, daarboven 1 + ((v - v_lo) / v_scale)^2, begrensd
+// per veld. Na idle_s stilstand of een richtingswissel begint hij weer op 1, zodat
+// losse detents altijd precies één stap zijn. Fractionele stappen worden
+// meegenomen naar de volgende aanroep.
+
+typedef struct
+{
+    float v_lo;       // detents/s zonder versnelling
+    float v_scale;    // detents/s per "kwadratische" eenheid
+    float idle_s;     // pauze waarna de snelheid weer 0 is
+} EncAccelConfig;
+
+typedef struct
+{
+    int32_t  last_detents;
+    uint32_t last_t_us;   // tijdstip van de laatst verwerkte detent
+    float    v;           // geschatte snelheid (detents/s)
+    float    frac;        // rest-stappen
+    int8_t   dir;
+    bool     valid;
+} EncAccel;
+
+void enc_accel_default(EncAccelConfig* cfg);
+void enc_accel_reset(EncAccel* a, int32_t detents, uint32_t t_us);
+
+// detents: totale teller; t_detent_us: tijd van de laatste detent.
+// Geeft het aantal (geschaalde) stappen sinds de vorige aanroep.
+int32_t enc_accel_update(EncAccel* a, const EncAccelConfig* cfg,
+                         int32_t detents, uint32_t t_detent_us, uint32_t max_mult);
+
+// Huidige vermenigvuldiger (diagnostiek)
+float enc_accel_multiplier(const EncAccel* a, const EncAccelConfig* cfg, uint32_t max_mult);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+// ioexpander/encoder.h
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rotary encoder op de PCNT: kwadratuur x4 in hardware met glitchfilter. De
+// PCNT-interrupt komt alleen per detent (ENC_COUNTS_PER_DETENT tellen), telt de
+// detent en noteert het tijdstip; daarna krijgen de io_event-abonnees een notify.
+#define ENC_COUNTS_PER_DETENT 4
+
+void encoder_init(void);
+
+// Lock-free: totaal aantal detents sinds boot (+ tijd van de laatste detent).
+// Iedere consument houdt zijn eigen vorige waarde bij (zie enc_accel.h).
+int32_t encoder_detents(uint32_t* t_last_us);
+
+// Testharnas: detents toevoegen alsof er gedraaid is.
+void encoder_inject(int32_t detents);
+
+#ifdef __cplusplus
+}
+#endif
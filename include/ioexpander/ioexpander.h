@@ -0,0 +1,64 @@
+// ioexpander/ioexpander.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Knoppen op de AW9523 (INT-lijn naar de ESP32). ioExpanderTask leest de expander
+// alleen na een interrupt, debounced per knop en zet gebeurtenissen met het
+// tijdstip van de flank in een lock-free event queue.
+// Bitnummers zijn die van IOShared.buttons_raw_bits (zie display.cpp).
+void ioExpanderTask(void* pvParameters);
+
+typedef enum
+{
+    IO_EVT_PRESS = 1,   // ingedrukt (meteen op de eerste flank)
+    IO_EVT_RELEASE,     // losgelaten
+    IO_EVT_CLICK,       // kort ingedrukt en losgelaten (alleen knoppen met long-press)
+    IO_EVT_LONG,        // IO_LONG_PRESS_MS ingedrukt gehouden
+} IoEventType;
+
+#define IO_DEBOUNCE_MS   15
+#define IO_LONG_PRESS_MS 500
+
+typedef struct
+{
+    uint32_t t_us;      // esp_timer tijd van de flank (interrupt)
+    uint8_t  button;    // bitnummer in buttons_raw_bits
+    uint8_t  type;      // IoEventType
+    uint16_t reserved;
+} IoEvent;
+
+// Eén cursor per consument: iedere consument ziet alle events. Loopt een
+// consument meer dan de queue-grootte achter, dan worden de oudste overgeslagen
+// en geteld in lost.
+typedef struct
+{
+    uint32_t next;
+    uint32_t lost;
+} IoEventCursor;
+
+void io_event_cursor_init(IoEventCursor* c);         // vanaf nu (geen oude events)
+bool io_event_pop(IoEventCursor* c, IoEvent* out);
+bool io_event_pending(const IoEventCursor* c);       // staat er iets klaar (zonder te poppen)
+
+// Producer: alleen ioExpanderTask (of een testharnas zonder ioExpanderTask).
+void io_event_push(const IoEvent* ev);
+
+// Tasks die bij elk nieuw event een notify krijgen (max 4). Thread-safe.
+bool io_event_subscribe(TaskHandle_t task);
+
+// Notify aan alle abonnees zonder event (encoder: zie encoder.h).
+void io_event_notify(void);
+void io_event_notify_from_isr(void);
+
+#ifdef __cplusplus
+}
+#endif
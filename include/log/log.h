@@ -0,0 +1,255 @@
+// log/log.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Binaire log-pijplijn
+// =========================
+//
+//   measureTask --log_ring_push--> LogRing --log_batch_drain--> LogBatcher --> sdWriterTask --> SD
+//   (producer, 1 kHz)              (SPSC, lock-free)  (logTask)  (2 buffers)   (File.write)
+//
+// - measureTask schrijft één LogRecord per meting in de ring: geen allocatie, geen
+//   lock, geen wachten. Is de ring vol, dan wordt het record gedropt (geteld).
+// - logTask haalt records uit de ring en codeert ze in blokken van LOG_BLOCK_SIZE
+//   (header + delta-gecodeerde records, sector-aligned). LOG_BATCH_BLOCKS blokken vormen één
+//   buffer; een volle buffer gaat naar sdWriterTask en logTask vult de andere.
+// - Hangt de kaart (schrijven duurt lang), dan is de andere buffer nog niet vrij:
+//   logTask stopt met legen, de ring loopt vol. Boven LOG_RING_HIGH zet de
+//   producer backpressure (STATUS_LOG_BACKPRESSURE) en past de policy toe:
+//     LOG_POLICY_DROP      alles houden tot de ring vol is, dan nieuwste droppen
+//     LOG_POLICY_DECIMATE  1 op 2/4/8 records houden naarmate de ring voller wordt
+//   Backpressure gaat weg onder LOG_RING_LOW.
+// - Schrijffouten / geen kaart: fault_report(FID_SD) (klasse WARN).
+//
+// Elk blok draagt de cumulatieve drop- en decimatie-tellers, zodat een lezer
+// gaten kan verklaren. tools/log_bench draait deze code met een bestand als kaart,
+// tools/log_decode zet een log om naar CSV of kolommen (.sbc).
+//
+// Datablok (LOG_BLOCK_VERSION 2)
+// ------------------------------
+// Waarden worden gekwantiseerd op LOG_Q_* (onder de ADC-resolutie) en per blok
+// delta-gecodeerd. Het eerste record van elk blok is een keyframe: elk blok is los
+// te decoderen, een beschadigd blok kost alleen dat blok (resync op het volgende).
+//   keyframe:  t_us (4 bytes LE), varint(flags), decim (1), 4x varint(zigzag(q))
+//   daarna:    varint(zigzag(dt - dt_vorig) << 1 | extra), [varint(flags), decim (1)],
+//              4x varint(zigzag(q - q_vorig))
+// extra = flags of decim veranderd. Bij 1 kHz en ADC-ruis van een paar LSB is een
+// record 5-6 bytes in plaats van 24. Een blok wordt gesloten zodra er geen
+// LOG_REC_MAX_BYTES meer in past (rest nul).
+//
+// Indexblok
+// ---------
+// Blok seq (offset seq * LOG_BLOCK_SIZE) met seq % LOG_INDEX_STRIDE == STRIDE - 1
+// is een indexblok met een LogIndexEntry per datablok uit dezelfde stride. Een
+// lezer zoekt een tijdstip met een binary search over de indexblokken (vaste
+// offsets) en leest daarna alleen de nodige datablokken.
+
+#define LOG_RING_LEN        1024u      // records, macht van 2 (~1 s bij 1 kHz)
+#define LOG_RING_HIGH       (LOG_RING_LEN / 2u)
+#define LOG_RING_LOW        (LOG_RING_LEN / 8u)
+
+#define LOG_BLOCK_SIZE      4096u      // veelvoud van de SD-sector (512)
+#define LOG_BATCH_BLOCKS    2u         // blokken per SD-write (8 KB)
+#define LOG_BATCH_BYTES     (LOG_BLOCK_SIZE * LOG_BATCH_BLOCKS)
+
+#define LOG_BLOCK_MAGIC     0x314C4253u   // "SBL1"
+#define LOG_BLOCK_VERSION   2u
+
+#define LOG_BLOCK_DATA      0u
+#define LOG_BLOCK_INDEX     1u
+
+#define LOG_INDEX_STRIDE    128u       // 1 indexblok per 128 blokken (0.8%)
+
+// Kwantisatie (waarde * LOG_Q_x, afgerond)
+#define LOG_Q_V             1000.0f    // 1 mV      (ADC-LSB op v_out ~1.7 mV)
+#define LOG_Q_I             10000.0f   // 0.1 mA    (ADC-LSB op i_* ~0.26 mA)
+#define LOG_Q_T             100.0f     // 0.01 °C
+
+#define LOG_REC_MAX_BYTES   30u        // worst case één record (5 + 3 + 1 + 4 * 5)
+
+typedef enum
+{
+    LOG_POLICY_DROP = 0,
+    LOG_POLICY_DECIMATE,
+} LogPolicy;
+
+// Eén meting (24 bytes)
+typedef struct
+{
+    uint32_t t_us;
+    float    v_out;
+    float    i_sink;
+    float    i_source;
+    float    temp_sink_c;
+    uint16_t meas_flags;   // MEAS_*
+    uint8_t  decim;        // samples sinds het vorige record (1 = niet gedecimeerd)
+    uint8_t  reserved;
+} LogRecord;
+
+// Blokheader (32 bytes), daarna payload_bytes payload, rest van het blok nul
+typedef struct
+{
+    uint32_t magic;         // LOG_BLOCK_MAGIC
+    uint32_t seq;           // blok-index in het bestand (offset = seq * LOG_BLOCK_SIZE)
+    uint16_t n_records;     // data: records, index: entries
+    uint16_t payload_bytes;
+    uint8_t  type;          // LOG_BLOCK_DATA / LOG_BLOCK_INDEX
+    uint8_t  version;       // LOG_BLOCK_VERSION
+    uint16_t reserved;
+    uint32_t n_dropped;     // cumulatief bij het sluiten van het blok
+    uint32_t n_decimated;   // idem
+    uint32_t t_first_us;
+    uint32_t crc32;         // over de payload
+} LogBlockHeader;
+
+#define LOG_BLOCK_PAYLOAD   (LOG_BLOCK_SIZE - sizeof(LogBlockHeader))
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t t_first_us;
+    uint32_t t_last_us;
+    uint32_t first_record;  // records voor dit blok (sinds de start van het bestand)
+} LogIndexEntry;
+
+// SPSC-ring. head: alleen de producer, tail: alleen de consumer (aparte cachelijnen).
+typedef struct
+{
+    LogRecord* buf;         // LOG_RING_LEN records
+    uint8_t    policy;      // LogPolicy
+    uint8_t    backpressure;
+    uint8_t    decim;       // huidige factor (producer)
+    uint8_t    reserved;
+    uint32_t   decim_phase; // overgeslagen sinds het laatste record
+
+    uint32_t   head __attribute__((aligned(32)));
+    uint32_t   n_pushed;    // aangeboden, incl. gedropt/gedecimeerd
+    uint32_t   n_dropped;
+    uint32_t   n_decimated;
+    uint32_t   fill_max;
+
+    uint32_t   tail __attribute__((aligned(32)));
+} LogRing;
+
+// Delta-encoder, per blok gereset (keyframe)
+typedef struct
+{
+    uint32_t t_us;
+    int32_t  dt_us;
+    int32_t  q[4];          // v_out, i_sink, i_source, temp_sink_c
+    uint16_t flags;
+    uint8_t  decim;
+    uint8_t  keyframe;      // volgende record is een keyframe
+} LogEncoder;
+
+// Twee buffers van LOG_BATCH_BYTES; busy[i] = bij de schrijver.
+typedef struct
+{
+    uint8_t*  buf[2];        // LOG_BATCH_BYTES, aligned (DMA / O_DIRECT)
+    uint8_t   busy[2];
+    uint8_t   fill_idx;      // buffer die gevuld wordt
+    uint8_t   stalled;       // vulbuffer vol, andere nog bij de schrijver
+    uint32_t  n_blocks;      // gesloten blokken in de vulbuffer
+    uint16_t  n_rec;         // records in het open blok
+    uint16_t  enc_off;       // bytes in het open blok (incl. header)
+    uint32_t  block_seq;
+    uint32_t  n_stalled;     // keren dat de andere buffer nog bezet was
+
+    LogEncoder enc;
+    uint32_t   t_first_us;   // open blok
+    uint32_t   t_last_us;
+    uint32_t   n_records;    // records in gesloten datablokken (bestand)
+
+    LogIndexEntry index[LOG_INDEX_STRIDE - 1u];   // datablokken sinds het laatste indexblok
+    uint32_t      n_index;
+} LogBatcher;
+
+// =========================
+// Portable kern (log.cpp)
+// =========================
+void log_ring_init(LogRing* r, LogRecord* storage, LogPolicy policy);
+uint32_t log_ring_fill(const LogRing* r);
+
+// Producer. Nooit blokkerend; false = niet opgenomen (gedropt of gedecimeerd).
+bool log_ring_push(LogRing* r, const LogRecord* rec);
+
+// Consumer: maximaal max records kopiëren en vrijgeven.
+uint32_t log_ring_pop(LogRing* r, LogRecord* dst, uint32_t max);
+
+// Consumer zonder kopie: *n aaneengesloten records vanaf tail (tot de wrap),
+// daarna log_ring_consume met het aantal verwerkte.
+const LogRecord* log_ring_peek(const LogRing* r, uint32_t* n);
+void log_ring_consume(LogRing* r, uint32_t n);
+
+void log_batch_init(LogBatcher* b, uint8_t* buf0, uint8_t* buf1);
+
+// Nieuw bestand: open blok, vulbuffer en index weg, seq weer vanaf 0. Alleen als
+// geen buffer bij de schrijver is.
+void log_batch_reset(LogBatcher* b);
+
+// Ring legen in de vulbuffer. Is de buffer vol, dan wordt hij overgedragen (busy)
+// en geeft de functie zijn index terug; anders -1. Is de andere buffer nog bezet,
+// dan blijven de records in de ring staan (backpressure).
+int  log_batch_drain(LogBatcher* b, LogRing* r);
+
+// Open blok sluiten en de (deels gevulde) vulbuffer overdragen; *out_bytes =
+// aantal te schrijven bytes (veelvoud van LOG_BLOCK_SIZE). -1 = niets of bezet;
+// bij bezet blijft het open blok open en gaat het vullen gewoon door.
+int  log_batch_flush(LogBatcher* b, LogRing* r, uint32_t* out_bytes);
+
+// Schrijver klaar met buffer idx
+void log_batch_release(LogBatcher* b, int idx);
+
+void     log_enc_reset(LogEncoder* e);
+// Codeert één record naar dst (ruimte >= LOG_REC_MAX_BYTES); geeft het aantal bytes.
+uint32_t log_enc_record(LogEncoder* e, const LogRecord* rec, uint8_t* dst);
+
+// Blok controleren (magic, versie, type, grootte, crc); true = geldig.
+bool log_block_check(const uint8_t* block);
+
+// Datablok decoderen naar max records; geeft het aantal of -1 (ongeldig blok of
+// geen datablok). Waarden zijn op LOG_Q_* gekwantiseerd.
+int  log_block_decode(const uint8_t* block, LogRecord* out, uint32_t max);
+
+// Indexblok lezen; geeft het aantal entries of -1.
+int  log_block_index(const uint8_t* block, LogIndexEntry* out, uint32_t max);
+
+// =========================
+// Firmware (log_task.cpp)
+// =========================
+// Vanuit measureTask na system_write_measurement. O(1), nooit blokkerend.
+void log_measurement(const MeasurementData* m);
+
+void log_set_policy(LogPolicy policy);
+
+typedef struct
+{
+    uint32_t n_pushed;
+    uint32_t n_dropped;
+    uint32_t n_decimated;
+    uint32_t fill_max;
+    uint32_t n_blocks;       // geschreven blokken (incl. index)
+    uint32_t n_records;      // records in gesloten datablokken
+    uint32_t enc_cyc_per_rec;   // logTask: legen + coderen, CPU-cycli per record
+    uint32_t n_stalled;
+    uint32_t write_us_max;
+    uint32_t write_errors;
+    bool     card_ok;
+} LogStats;
+
+void log_get_stats(LogStats* out);
+
+void logTask(void* pvParameters);
+
+#ifdef __cplusplus
+}
+#endif
@@ -107,7 +107,7 @@
  * - LV_OS_MQX
  * - LV_OS_SDL2
  * - LV_OS_CUSTOM */
-#define LV_USE_OS   LV_OS_NONE
+#define LV_USE_OS   LV_OS_FREERTOS
 
 #if LV_USE_OS == LV_OS_CUSTOM
     #define LV_OS_CUSTOM_INCLUDE <stdint.h>
@@ -117,8 +117,11 @@
      * Unblocking an RTOS task with a direct notification is 45% faster and uses less RAM
      * than unblocking a task using an intermediary object such as a binary semaphore.
      * RTOS task notifications can only be used when there is only one task that can be the recipient of the event.
+     *
+     * Off here: displayTask already uses its notification value for io_event and
+     * system_subscribe_changes wakeups, LVGL's sync must not consume those.
      */
-    #define LV_USE_FREERTOS_TASK_NOTIFY 1
+    #define LV_USE_FREERTOS_TASK_NOTIFY 0
 #endif
 
 /*========================
@@ -163,7 +166,11 @@
  *  Make sure the priority value aligns with the OS-specific priority levels.
  *  On systems with limited priority levels (e.g., FreeRTOS), a higher value can improve
  *  rendering performance but might cause other tasks to starve. */
-#define LV_DRAW_THREAD_PRIO LV_THREAD_PRIO_HIGH
+/* LOW = FreeRTOS priority 1, same as displayTask and below every other task
+ * (measureTask 5, ControlTask 4 on core 1, statemachine/IO/actuation on core 0).
+ * The draw threads are not pinned: rendering fills idle time on both cores and
+ * never delays the 1 kHz measure/control loop. */
+#define LV_DRAW_THREAD_PRIO LV_THREAD_PRIO_LOW
 
 #define LV_USE_DRAW_SW 1
 #if LV_USE_DRAW_SW == 1
@@ -191,8 +198,12 @@
 
     /** Set number of draw units.
      *  - > 1 requires operating system to be enabled in `LV_USE_OS`.
-     *  - > 1 means multiple threads will render the screen in parallel. */
-    #define LV_DRAW_SW_DRAW_UNIT_CNT    1
+     *  - > 1 means multiple threads will render the screen in parallel.
+     *  One per ESP32-S3 core. Build with -DLV_DRAW_SW_DRAW_UNIT_CNT=1 to compare
+     *  (DISPLAY_RENDER_BENCH in display.cpp). */
+    #ifndef LV_DRAW_SW_DRAW_UNIT_CNT
+    #define LV_DRAW_SW_DRAW_UNIT_CNT    2
+    #endif
 
     /** Use Arm-2D to accelerate software (sw) rendering. */
     #define LV_USE_DRAW_ARM2D_SYNC      0
@@ -1,12 +1,18 @@
 // measurement/measurement.h
 #pragma once
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void measureTask(void* pvParameters);
 
+// Task die na elke nieuwe meting een notify krijgt (bv. ControlTask); nullptr = geen.
+void measure_set_notify_task(TaskHandle_t task);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,101 @@
+// statemachine/statemachine.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+#include "fault/fault.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Systeem-state machine (CONFIG / READY / ACTIVE / ERROR)
+// =========================
+//
+// De transitietabel staat als constexpr in statemachine.cpp: per (state, event)
+// maximaal SM_MAX_ALTS alternatieven {guard, doel, actie}; de eerste guard die
+// waar is wint, het laatste alternatief heeft altijd guard "always". Een
+// static_assert controleert dat elke combinatie zo afgehandeld is.
+//
+// sm_dispatch is portable (geen Arduino/FreeRTOS): hij leest alleen SmInputs en
+// schrijft SmEffects, zodat tools/sm_fuzz hem op de host kan draaien. Worst case
+// per event: SM_MAX_ALTS guards + exit + actie + entry, geen lussen of blokkeren.
+//
+//   CONFIG  --RUN [geen fault, niet editten]--------> READY
+//   READY   --RUN [geen fault, modewissel klaar]----> ACTIVE
+//   ACTIVE  --RUN-----------------------------------> READY   (pauze)
+//   READY/ACTIVE --STOP-----------------------------> CONFIG
+//   *       --FAULT [shutdown-bit actief/latched]---> ERROR
+//   ERROR   --STOP [geen actieve faults]------------> CONFIG  (latched bits wissen)
+
+typedef enum
+{
+    SM_EV_RUN = 0,   // knop 0: armeren / starten / pauzeren
+    SM_EV_STOP,      // knop 1: terug naar CONFIG; in ERROR: fault bevestigen
+    SM_EV_FAULT,     // fault bits gewijzigd (system_*_fault_bits)
+    SM_EV_COUNT
+} SmEvent;
+
+#define SM_STATE_COUNT 4   // SYS_STATE_CONFIG .. SYS_STATE_ERROR
+
+// Faults die de uitgang uitschakelen (SHUTDOWN-klasse van de fault manager)
+#define SM_FAULT_SHUTDOWN_MASK FAULT_SHUTDOWN_BITS
+
+// Snapshot-velden waar de guards op beslissen
+typedef struct
+{
+    uint32_t  fault_current_bits;
+    uint32_t  fault_latched_bits;
+    uint32_t  status_flags;
+    uint32_t  ui_event_flags;   // UIEvents.flags
+    PowerMode mode_current;
+    PowerMode mode_pending;
+} SmInputs;
+
+// Wat de task na een dispatch op SystemData toepast
+typedef struct
+{
+    uint32_t set_status_flags;
+    uint32_t clear_status_flags;
+    uint32_t latch_fault_bits;
+    uint32_t clear_latched_bits;
+    int8_t   ui_error;          // +1: UI_SCREEN_ERROR tonen, -1: vorig scherm terug
+    bool     rejected;          // event geweigerd door een guard
+} SmEffects;
+
+typedef struct
+{
+    SystemState state;
+    uint32_t    n_dispatch;
+    uint32_t    n_transitions;
+    uint32_t    n_rejected;
+} SmMachine;
+
+void sm_init(SmMachine* m, SystemState initial);
+
+// Verwerkt één event. Geeft true als de state gewijzigd is; effects worden altijd
+// eerst gewist.
+bool sm_dispatch(SmMachine* m, SmEvent ev, const SmInputs* in, SmEffects* out);
+
+// Inputs uit een snapshot
+void sm_inputs_from_snapshot(SmInputs* in, const SystemSnapshot* s);
+
+const char* sm_state_name(SystemState st);
+const char* sm_event_name(SmEvent ev);
+
+// =========================
+// Task
+// =========================
+// Event-gedreven: de task blokkeert tot sm_post of een knop-event hem wekt.
+void statemachineTask(void* pvParameters);
+
+// Zet een event in de queue (niet blokkerend); false als de queue vol is of de
+// task nog niet draait.
+bool sm_post(SmEvent ev);
+
+#ifdef __cplusplus
+}
+#endif
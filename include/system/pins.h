@@ -0,0 +1,90 @@
+// system/pins.h - GPIO-toewijzing van het bord (ESP32-S3), op één plek
+#pragma once
+
+#include "display/ili9488_driver.hpp"   // LCD_* (8-bit i80-bus)
+
+// Elke GPIO die de firmware gebruikt staat in BOARD_PINS hieronder; een pin die
+// twee keer voorkomt geeft een compileerfout. Bij het aanpassen aan een ander
+// bord dus hier (en voor het LCD in ili9488_driver.hpp) wijzigen, niet los in de
+// modules.
+//
+// Niet vrij op de S3 (module met octal flash/PSRAM):
+//   GPIO26..37  flash / PSRAM
+//   GPIO43/44   UART0 (Serial, tekst-diagnose)
+//   GPIO19/20   native USB D-/D+ (USBSerial, telemetrie); vast in silicium.
+//               Daarvoor zijn I2C SCL (was 19) en LCD_WR (was 20) verhuisd.
+//   GPIO0/3/45/46 strapping (45 = LCD_RS is als uitgang na boot in orde)
+
+// I2C (AW9523, MCP23008, digipot)
+static constexpr int PIN_I2C_SDA   = 21;
+static constexpr int PIN_I2C_SCL   = 9;    // niet 19: USB D-
+
+// Powerstage
+static constexpr int PIN_PWM_OUT   = 4;    // <-- AANPASSEN (gate driver powerstage)
+
+// ADS8684 (FSPI, uit het schema)
+static constexpr int PIN_ADS_SCLK  = 38;
+static constexpr int PIN_ADS_MISO  = 39;
+static constexpr int PIN_ADS_MOSI  = 40;
+static constexpr int PIN_ADS_CS    = 41;
+// ADS_RESET: in het schema is er een netlabel "ADS_RESET" naar de ESP32.
+// Vul hier de juiste GPIO in zodra je hem zeker weet.
+static constexpr int PIN_ADS_RESET = -1;   // <-- AANPASSEN indien nodig
+
+// AW9523 INTN (open drain, pull-up in de ESP)
+static constexpr int PIN_IOX_INT   = 1;    // <-- AANPASSEN
+
+// Encoder A/B (PCNT)
+static constexpr int PIN_ENC_A     = 42;   // <-- AANPASSEN
+static constexpr int PIN_ENC_B     = 47;   // <-- AANPASSEN
+
+// SD-kaart (HSPI)
+static constexpr int PIN_SD_SCLK   = 5;    // <-- AANPASSEN
+static constexpr int PIN_SD_MOSI   = 6;    // <-- AANPASSEN
+static constexpr int PIN_SD_MISO   = 7;    // <-- AANPASSEN
+static constexpr int PIN_SD_CS     = 8;    // <-- AANPASSEN
+
+// =========================
+// Controle op dubbele toewijzing
+// =========================
+static constexpr int UART0_TX = 43;
+static constexpr int UART0_RX = 44;
+static constexpr int USB_DM   = 19;
+static constexpr int USB_DP   = 20;
+
+static constexpr int BOARD_PINS[] = {
+    LCD_D0, LCD_D1, LCD_D2, LCD_D3, LCD_D4, LCD_D5, LCD_D6, LCD_D7,
+    LCD_CS, LCD_RS, LCD_WR, LCD_RST,
+    PIN_I2C_SDA, PIN_I2C_SCL,
+    PIN_PWM_OUT,
+    PIN_ADS_SCLK, PIN_ADS_MISO, PIN_ADS_MOSI, PIN_ADS_CS, PIN_ADS_RESET,
+    PIN_SD_SCLK, PIN_SD_MOSI, PIN_SD_MISO, PIN_SD_CS,
+    PIN_IOX_INT, PIN_ENC_A, PIN_ENC_B,
+    UART0_TX, UART0_RX, USB_DM, USB_DP,
+};
+static constexpr int BOARD_PIN_COUNT = (int)(sizeof(BOARD_PINS) / sizeof(BOARD_PINS[0]));
+
+// C++11 constexpr: recursie in plaats van lussen (diepte ~2x het aantal pinnen)
+constexpr int board_pin_uses(int pin, int i)
+{
+    return i >= BOARD_PIN_COUNT ? 0 : (BOARD_PINS[i] == pin) + board_pin_uses(pin, i + 1);
+}
+
+constexpr bool board_pins_unique(int i)
+{
+    return i >= BOARD_PIN_COUNT ? true
+         : (BOARD_PINS[i] < 0 || board_pin_uses(BOARD_PINS[i], 0) == 1) && board_pins_unique(i + 1);
+}
+
+constexpr bool board_pin_reserved(int pin)
+{
+    return pin >= 26 && pin <= 37;
+}
+
+constexpr bool board_pins_free(int i)
+{
+    return i >= BOARD_PIN_COUNT ? true : !board_pin_reserved(BOARD_PINS[i]) && board_pins_free(i + 1);
+}
+
+static_assert(board_pins_unique(0), "pins.h: een GPIO is twee keer toegewezen");
+static_assert(board_pins_free(0), "pins.h: GPIO26..37 horen bij flash/PSRAM");
@@ -75,6 +75,7 @@ enum
     FAULT_HW   = (1u << 3),
     FAULT_COMM = (1u << 4),
     FAULT_SD   = (1u << 5),
+    FAULT_OT_DERATE = (1u << 6),   // temperatuur: vermogen begrensd
 };
 
 enum
@@ -83,6 +84,7 @@ enum
     STATUS_MODE_SWITCH_PENDING = (1u << 1),
     STATUS_ACTUATION_DIRTY     = (1u << 2),
     STATUS_LOG_BACKPRESSURE    = (1u << 3),
+    STATUS_AUTOTUNE_ACTIVE     = (1u << 4),
 };
 
 enum
@@ -136,6 +138,7 @@ typedef struct
     uint16_t desired_rpot_code; // slow output (I2C)
     PowerMode desired_mode;     // slow output (via MCP23008 over I2C)
     uint32_t control_flags;
+    float    setpoint;          // actief setpoint (V bij source, A bij sink)
 } ControlData;
 
 typedef struct
@@ -250,20 +253,55 @@ void system_write_io_shared(const IOShared* io);
 void system_write_curves(const CurveData* curves);
 void system_write_ui_shared(const UIShared* ui);
 void system_write_ui_events(const UIEvents* ev);
+void system_set_ui_screen(UiScreen screen);
+
+// Alleen stateMachineTask (statemachine/statemachine.h) zet de state
+void system_set_state(SystemState state);
 
 void system_set_status_flag(uint32_t flag_bits);
 void system_clear_status_flag(uint32_t flag_bits);
 
+// Modewissel: request zet mode_pending + STATUS_MODE_SWITCH_PENDING (niets als de
+// mode al actief is); ControlTask voert de wissel uit en rondt af met complete
+// (mode_current = mode; flag weg als er niets nieuws pending is). Een mislukte
+// wissel wordt geannuleerd met system_request_mode(mode_current).
+void system_request_mode(PowerMode mode);
+void system_complete_mode_switch(PowerMode mode);
+
 void system_set_fault_bits(uint32_t fault_bits);
 void system_latch_fault_bits(uint32_t fault_bits);
+void system_clear_fault_bits(uint32_t fault_bits);   // alleen current; latched blijft tot bevestiging
 void system_clear_latched_fault_bits(uint32_t fault_bits);
 
+void system_io_set_buttons(uint32_t raw_bits, uint32_t changed_bits);
 void system_io_clear_buttons_changed(uint32_t mask);
 void system_io_clear_enc_delta(void);
 
 void system_lock_data(void);
 void system_unlock_data(void);
 
+// =========================
+// Wijzigingsnotificatie
+// =========================
+// Een task abonneert zich op delen van SystemData. De eerste schrijfactie in een
+// deel uit het masker geeft de task een xTaskNotifyGive; volgende wijzigingen
+// worden alleen opgeteld in het pending-masker, tot de task system_take_changes
+// aanroept. Een 1 kHz-producer (measureTask) geeft een trage consument zo hooguit
+// één notify per ronde, en er gaat geen wijziging verloren.
+#define SYS_CHG_MEAS     (1u << 0)   // system_write_measurement
+#define SYS_CHG_CONTROL  (1u << 1)   // control + apply status
+#define SYS_CHG_CONFIG   (1u << 2)
+#define SYS_CHG_STATUS   (1u << 3)   // state, mode, status flags, faults
+#define SYS_CHG_IO       (1u << 4)
+#define SYS_CHG_CURVES   (1u << 5)
+#define SYS_CHG_UI       (1u << 6)   // UIShared, active_screen, UI events
+#define SYS_CHG_ALL      0x7Fu
+
+// task = TaskHandle_t (max 4 abonnees, bij het opstarten). Geeft een id, -1 bij fout.
+int      system_subscribe_changes(void* task, uint32_t mask);
+uint32_t system_peek_changes(int id);   // pending-masker, blijft staan
+uint32_t system_take_changes(int id);   // pending-masker ophalen en wissen (weer "scherp")
+
 void system_lock_i2c(void);
 void system_unlock_i2c(void);
 
@@ -0,0 +1,217 @@
+// telemetry/telemetry.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system/system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =========================
+// Binaire telemetrie over USB-CDC
+// =========================
+//
+//   measureTask --tlm_push--> TlmSampleRing --tlm_pump--> TlmByteRing --> USBSerial (native USB)
+//   (1 kHz, decimatie)        (SPSC, samples)  (telemetryTask: frames,    (TX-ring, in stukken
+//                                               CRC, COBS)                 van availableForWrite)
+//
+// - measureTask kopieert alleen een sample in de ring (of telt een drop): geen
+//   framing, geen USB-aanroep, nooit wachten.
+// - telemetryTask bouwt frames van tot TLM_MAX_PER_FRAME samples met de gekozen
+//   kanalen, zet er een CRC-32 achter, COBS-codeert en schrijft het frame in zijn
+//   geheel in de TX-ring. De TX-ring wordt niet-blokkerend naar de USB-CDC
+//   geschreven. Leest de host niet bij, dan begint tlm_pump geen nieuw frame
+//   (geen CRC/COBS voor niets), de samplering loopt vol en de producer dropt
+//   samples (n_ring_drops, zichtbaar als gat in t_us). Nooit tijd in een producer.
+// - De host kiest kanalen, decimatie en samples per frame met een CONFIG-frame.
+//   Elke seconde volgt een STATUS-frame met de tellers (verlies is zichtbaar).
+//
+// Frame (vóór COBS, little endian):
+//   TlmFrameHeader (4)  type, version, seq (+1 per frame, ook gedropte)
+//   payload
+//   uint32 crc32        CRC-32 IEEE over header + payload
+// Op de lijn: COBS(frame) gevolgd door 0x00. Een lezer synchroniseert op 0x00;
+// een kapot frame kost alleen dat frame.
+//
+// SAMPLES-payload: ch_mask (1), n (1), decim (2), dan n x { t_us (4),
+// per kanaal in bitvolgorde 4 bytes (float, TLM_CH_FLAGS: uint32) }.
+
+#define TLM_VERSION           1u
+
+#define TLM_SAMPLE_RING_LEN   256u       // samples, macht van 2 (256 ms bij 1 kHz)
+#define TLM_TX_LEN            8192u      // bytes, macht van 2
+#define TLM_MAX_PER_FRAME     32u
+
+#define TLM_FRAME_SAMPLES     0x01u      // device -> host
+#define TLM_FRAME_STATUS      0x02u      // device -> host
+#define TLM_FRAME_CONFIG      0x10u      // host -> device
+
+enum
+{
+    TLM_CH_V_OUT    = (1u << 0),
+    TLM_CH_I_SINK   = (1u << 1),
+    TLM_CH_I_SOURCE = (1u << 2),
+    TLM_CH_TEMP     = (1u << 3),
+    TLM_CH_FLAGS    = (1u << 4),   // meas_flags
+    TLM_CH_ALL      = 0x1Fu,
+};
+#define TLM_N_CH              5u
+
+#define TLM_FRAME_MAX     (4u + 4u + TLM_MAX_PER_FRAME * (4u + 4u * TLM_N_CH) + 4u)
+// COBS: 1 byte per 254 + 1, plus de 0x00-afsluiter
+#define TLM_WIRE_MAX      (TLM_FRAME_MAX + TLM_FRAME_MAX / 254u + 2u)
+
+typedef struct
+{
+    uint8_t  type;
+    uint8_t  version;
+    uint16_t seq;
+} TlmFrameHeader;
+
+typedef struct
+{
+    uint32_t t_us;
+    float    v_out;
+    float    i_sink;
+    float    i_source;
+    float    temp_sink_c;
+    uint32_t meas_flags;
+} TlmSample;
+
+// CONFIG-payload (host -> device)
+typedef struct
+{
+    uint8_t  ch_mask;       // TLM_CH_*; 0 = stream uit
+    uint8_t  per_frame;     // 1..TLM_MAX_PER_FRAME
+    uint16_t decim;         // 1 = elke meting
+} TlmConfig;
+
+// STATUS-payload (device -> host), cumulatief
+typedef struct
+{
+    uint32_t n_offered;     // metingen aangeboden
+    uint32_t n_decimated;
+    uint32_t n_ring_drops;  // sample-ring vol (telemetryTask te laat)
+    uint32_t n_samples;     // in frames gezet
+    uint32_t n_frames;
+    uint32_t n_frame_drops; // frame paste niet meer in de TX-ring
+    uint32_t tx_bytes;      // naar de TX-ring
+    TlmConfig cfg;
+} TlmStatus;
+
+// SPSC samplering (producer: measureTask, consumer: telemetryTask)
+typedef struct
+{
+    TlmSample* buf;         // TLM_SAMPLE_RING_LEN
+    uint32_t   cfg;         // TlmConfig gepakt in één woord (atomisch te wisselen)
+    uint32_t   decim_phase;
+
+    uint32_t   head __attribute__((aligned(32)));
+    uint32_t   n_offered;
+    uint32_t   n_decimated;
+    uint32_t   n_drops;
+
+    uint32_t   tail __attribute__((aligned(32)));
+} TlmSampleRing;
+
+// SPSC bytering voor gecodeerde frames (producer: tlm_pump, consumer: de USB-schrijver)
+typedef struct
+{
+    uint8_t* buf;           // TLM_TX_LEN
+    uint32_t head __attribute__((aligned(32)));
+    uint32_t tail __attribute__((aligned(32)));
+} TlmByteRing;
+
+// Zender: samplering -> frames -> TX-ring
+typedef struct
+{
+    TlmSampleRing samples;
+    TlmByteRing   tx;
+
+    uint8_t   frame[TLM_FRAME_MAX];   // frame in opbouw
+    uint32_t  frame_len;
+    uint8_t   frame_n;
+    uint8_t   frame_mask;             // kanalen van het frame in opbouw
+    uint8_t   frame_per;
+    uint16_t  frame_decim;
+    uint32_t  frame_t0_ms;
+    uint16_t  seq;
+
+    uint32_t  n_samples;
+    uint32_t  n_frames;
+    uint32_t  n_frame_drops;
+    uint32_t  tx_bytes;
+} TlmTx;
+
+// Ontvanger: bytes -> frames (host, en device voor CONFIG)
+typedef struct
+{
+    uint8_t  wire[TLM_WIRE_MAX];
+    uint32_t wire_len;
+    bool     overflow;              // te lang frame: weggooien tot de volgende 0x00
+    uint8_t  frame[TLM_FRAME_MAX];
+    uint32_t frame_len;
+
+    bool     have_seq;
+    uint16_t last_seq;
+    uint32_t n_frames;              // geldige frames
+    uint32_t n_bad;                 // COBS-, lengte- of CRC-fout
+    uint32_t n_lost;                // ontbrekende seq's
+} TlmParser;
+
+// =========================
+// Portable kern (telemetry.cpp)
+// =========================
+// COBS; dst moet len + len/254 + 1 bytes hebben. Geen 0x00-afsluiter.
+uint32_t tlm_cobs_encode(const uint8_t* src, uint32_t len, uint8_t* dst);
+// Geeft de gedecodeerde lengte of -1 (ongeldig).
+int      tlm_cobs_decode(const uint8_t* src, uint32_t len, uint8_t* dst, uint32_t max);
+
+// Volledig frame (header + payload + crc) -> COBS + 0x00 in wire; geeft de lengte.
+uint32_t tlm_frame_wire(uint8_t type, uint16_t seq, const void* payload, uint32_t len, uint8_t* wire);
+
+void     tlm_tx_init(TlmTx* t, TlmSample* samples, uint8_t* tx_buf, const TlmConfig* cfg);
+void     tlm_set_config(TlmTx* t, const TlmConfig* cfg);
+void     tlm_get_config(const TlmTx* t, TlmConfig* out);
+
+// Producer (measureTask). Nooit blokkerend; false = niet opgenomen.
+bool     tlm_push(TlmTx* t, const TlmSample* s);
+
+// telemetryTask: samples framen tot de ring leeg is of de TX-ring geen frame meer
+// kan hebben; een deels gevuld frame gaat weg na flush_ms. Geeft het aantal bytes
+// in de TX-ring.
+uint32_t tlm_pump(TlmTx* t, uint32_t now_ms, uint32_t flush_ms);
+
+// STATUS-frame in de TX-ring; false = geen ruimte.
+bool     tlm_send_status(TlmTx* t);
+void     tlm_get_status(const TlmTx* t, TlmStatus* out);
+
+// USB-schrijver: aaneengesloten bytes vanaf tail, daarna consume.
+const uint8_t* tlm_tx_peek(const TlmTx* t, uint32_t* n);
+void     tlm_tx_consume(TlmTx* t, uint32_t n);
+
+void     tlm_parser_init(TlmParser* p);
+// Eén byte; true = p->frame / p->frame_len bevat een geldig frame.
+bool     tlm_parser_feed(TlmParser* p, uint8_t b);
+
+// SAMPLES-frame uitpakken: maximaal max samples (niet-gekozen kanalen 0);
+// geeft het aantal of -1.
+int      tlm_frame_samples(const uint8_t* frame, uint32_t len, TlmSample* out, uint32_t max,
+                           uint8_t* ch_mask, uint16_t* decim);
+
+// =========================
+// Firmware (telemetry_task.cpp)
+// =========================
+// Vanuit measureTask na system_write_measurement. O(1), nooit blokkerend.
+void telemetry_measurement(const MeasurementData* m);
+
+void telemetry_get_status(TlmStatus* out);
+
+void telemetryTask(void* pvParameters);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,286 @@
+// actuation/actuation.cpp
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "system/system.h"
+#include "control/control.h"
+#include "actuation/actuation.h"
+#include "system/pins.h"
+
+// =========================
+// PWM (LEDC)
+// =========================
+static constexpr uint8_t  PWM_CHANNEL  = 0;
+static constexpr uint32_t PWM_FREQ_HZ  = 20000;   // draaggolf
+static constexpr uint32_t LEDC_CLK_HZ  = 80000000; // APB
+static constexpr uint8_t  LEDC_MAX_BITS = 14;     // ESP32-S3 LEDC timer
+
+// Grootste resolutie waarbij LEDC_CLK_HZ / 2^bits >= PWM_FREQ_HZ
+static constexpr uint8_t pwm_max_bits(uint32_t div, uint8_t bits)
+{
+    return (bits >= LEDC_MAX_BITS || (div >> (bits + 1)) == 0) ? bits : pwm_max_bits(div, (uint8_t)(bits + 1));
+}
+static constexpr uint8_t  PWM_BITS  = pwm_max_bits(LEDC_CLK_HZ / PWM_FREQ_HZ, 1);
+static constexpr uint32_t PWM_SHIFT = 16u - PWM_BITS;  // pwm_duty is 16 bit
+static constexpr uint32_t PWM_FULL  = 1u << PWM_BITS;  // LEDC: duty == 2^bits is continu hoog
+
+static_assert(PWM_BITS >= 8 && PWM_BITS <= 16, "PWM resolutie buiten bereik");
+
+// =========================
+// I2C slaves
+// =========================
+// Digitale potmeter: MCP45x1-familie (257 standen, 9-bit code). AANPASSEN bij ander type.
+static constexpr uint8_t  RPOT_ADDR     = 0x2E;
+static constexpr uint16_t RPOT_CODE_MAX = 256;
+
+static constexpr uint8_t  MCP08_ADDR      = 0x20;
+static constexpr uint8_t  MCP08_REG_IODIR = 0x00;
+static constexpr uint8_t  MCP08_REG_OLAT  = 0x0A;
+
+// Minimale tijd tussen twee writes per slave; tussenliggende waarden worden samengevoegd.
+// Relais: ook bescherming tegen klapperen.
+static constexpr uint32_t RPOT_MIN_INTERVAL_MS  = 5;
+static constexpr uint32_t MCP08_MIN_INTERVAL_MS = 20;
+
+static constexpr uint32_t ACT_STATS_PERIOD_MS = 10000;
+
+// =========================
+// Helpers
+// =========================
+static bool i2c_write2(uint8_t addr, uint8_t b0, uint8_t b1)
+{
+    system_lock_i2c();
+    Wire.beginTransmission(addr);
+    Wire.write(b0);
+    Wire.write(b1);
+    const bool ok = (Wire.endTransmission() == 0);
+    system_unlock_i2c();
+    return ok;
+}
+
+static bool rpot_write(uint32_t code)
+{
+    if (code > RPOT_CODE_MAX) code = RPOT_CODE_MAX;
+    // Commandobyte: adres 0 (wiper 0), cmd 00 (write), D8 in bit 0
+    return i2c_write2(RPOT_ADDR, (uint8_t)((code >> 8) & 0x01), (uint8_t)(code & 0xFF));
+}
+
+static bool mcp08_write(uint32_t bits)
+{
+    return i2c_write2(MCP08_ADDR, MCP08_REG_OLAT, (uint8_t)bits);
+}
+
+// Trage uitgang: schrijft alleen bij wijziging en hooguit 1x per min_interval_ms.
+// Een mislukte write blijft pending en wordt na het interval opnieuw geprobeerd.
+struct SlowOutput
+{
+    uint32_t desired;
+    uint32_t applied;
+    bool     applied_valid;   // false: hardwarestand onbekend (boot of na fout)
+    bool     pending;         // desired != applied, nog niet geschreven
+    uint32_t last_write_ms;
+    uint32_t min_interval_ms;
+    bool   (*write)(uint32_t);
+    uint32_t err_flag;
+};
+
+static ActuationStats g_win;      // lopend venster (alleen actuationTask)
+static ActuationStats g_stats;    // laatst afgesloten venster
+static portMUX_TYPE   g_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t       g_lat_sum_us = 0;
+
+// Geeft true als er iets aan de hardwarestand veranderd is.
+static bool slow_service(SlowOutput& o, uint32_t want, uint32_t now_ms, uint32_t* err_flags)
+{
+    if (o.applied_valid && want == o.applied) {
+        o.pending = false;
+        o.desired = want;
+        return false;
+    }
+    if (o.pending && want != o.desired) g_win.i2c_coalesced++;
+    o.desired = want;
+    o.pending = true;
+
+    if ((uint32_t)(now_ms - o.last_write_ms) < o.min_interval_ms) return false;
+
+    o.last_write_ms = now_ms;
+    g_win.i2c_writes++;
+    if (!o.write(want)) {
+        g_win.i2c_errors++;
+        o.applied_valid = false;
+        *err_flags |= o.err_flag;
+        return false;
+    }
+    o.applied = want;
+    o.applied_valid = true;
+    o.pending = false;
+    *err_flags &= ~o.err_flag;
+    return true;
+}
+
+// Eerste-orde sigma-delta: het deel onder de LEDC-resolutie wordt over opeenvolgende
+// updates verdeeld, zodat het gemiddelde de volle 16 bit van pwm_duty volgt.
+// De ditherfrequentie is de regelfrequentie (1 kHz); de ruis ligt ruim boven de
+// bandbreedte van het uitgangsfilter en wordt door de PI-lus niet gezien.
+static uint32_t g_sd_acc = 0;
+
+static uint32_t pwm_dither(uint16_t duty16)
+{
+    if (duty16 == 0) { g_sd_acc = 0; return 0; }
+    if (duty16 == 0xFFFF) { g_sd_acc = 0; return PWM_FULL; }
+
+    uint32_t d = (uint32_t)duty16 >> PWM_SHIFT;
+    g_sd_acc += (uint32_t)duty16 & ((1u << PWM_SHIFT) - 1u);
+    if (g_sd_acc >= (1u << PWM_SHIFT)) {
+        g_sd_acc -= (1u << PWM_SHIFT);
+        d++;
+    }
+    return d;
+}
+
+static void stats_close_window(uint32_t freq_hz)
+{
+    g_win.pwm_bits = PWM_BITS;
+    g_win.pwm_freq_hz = freq_hz;
+    g_win.pwm_latency_us_avg = g_win.cycles ? (uint32_t)(g_lat_sum_us / g_win.cycles) : 0;
+    // Naïef: elke cyclus zowel rpot als MCP23008 schrijven
+    const uint32_t naive = 2u * g_win.cycles;
+    g_win.i2c_saved = (naive > g_win.i2c_writes) ? naive - g_win.i2c_writes : 0;
+
+    portENTER_CRITICAL(&g_stats_mux);
+    g_stats = g_win;
+    portEXIT_CRITICAL(&g_stats_mux);
+
+    Serial.printf("actuation: %u cycli, PWM %u bit @ %u Hz, latency %u/%u/%u us (min/gem/max), "
+                  "I2C %u writes, %u bespaard, %u samengevoegd, %u fouten\n",
+                  (unsigned)g_win.cycles, (unsigned)PWM_BITS, (unsigned)freq_hz,
+                  (unsigned)g_win.pwm_latency_us_min, (unsigned)g_win.pwm_latency_us_avg,
+                  (unsigned)g_win.pwm_latency_us_max, (unsigned)g_win.i2c_writes,
+                  (unsigned)g_win.i2c_saved, (unsigned)g_win.i2c_coalesced, (unsigned)g_win.i2c_errors);
+
+    memset(&g_win, 0, sizeof(g_win));
+    g_win.pwm_latency_us_min = UINT32_MAX;
+    g_lat_sum_us = 0;
+}
+
+extern "C" void actuation_get_stats(ActuationStats* out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&g_stats_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_stats_mux);
+}
+
+// =========================
+// Task
+// =========================
+extern "C" void actuationTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    const uint32_t freq = ledcSetup(PWM_CHANNEL, PWM_FREQ_HZ, PWM_BITS);
+    ledcAttachPin(PIN_PWM_OUT, PWM_CHANNEL);
+    ledcWrite(PWM_CHANNEL, 0);
+    Serial.printf("actuation: PWM %u Hz, %u bit (+%u bit dither)\n",
+                  (unsigned)freq, (unsigned)PWM_BITS, (unsigned)PWM_SHIFT);
+
+    // MCP23008: alle pinnen output, alles uit
+    bool mcp_ok = i2c_write2(MCP08_ADDR, MCP08_REG_IODIR, 0x00);
+    if (!mcp_ok) Serial.println("actuation: MCP23008 niet gevonden");
+
+    SlowOutput rpot = {};
+    rpot.min_interval_ms = RPOT_MIN_INTERVAL_MS;
+    rpot.write = rpot_write;
+    rpot.err_flag = APPLY_I2C_ERR_RPOT;
+
+    SlowOutput mcp = {};
+    mcp.min_interval_ms = MCP08_MIN_INTERVAL_MS;
+    mcp.write = mcp08_write;
+    mcp.err_flag = APPLY_I2C_ERR_MODE_SW;
+
+    ApplyStatus applied = {};
+    applied.applied_mode = POWER_MODE_EMULATE;
+    uint32_t last_pwm = UINT32_MAX;
+    uint32_t last_meas_t_us = 0;
+    uint32_t stats_t0_ms = millis();
+
+    memset(&g_win, 0, sizeof(g_win));
+    g_win.pwm_latency_us_min = UINT32_MAX;
+
+    control_set_notify_task(xTaskGetCurrentTaskHandle());
+
+    for (;;)
+    {
+        // Op elke nieuwe ControlData; de timeout houdt de I2C-uitgangen en de
+        // veilige PWM-stand bij als ControlTask stilvalt.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+
+        SystemSnapshot s;
+        system_read_snapshot(&s);
+
+        // Uitgang alleen vrij tijdens regelen (ACTIVE) of autotune; anders PWM 0 en relais af
+        const bool enabled = (s.status.state == SYS_STATE_ACTIVE) ||
+                             (s.status.status_flags & STATUS_AUTOTUNE_ACTIVE);
+
+        // ===== Snel: PWM =====
+        const uint32_t duty = enabled ? pwm_dither(s.control.pwm_duty) : pwm_dither(0);
+        if (duty != last_pwm) {
+            ledcWrite(PWM_CHANNEL, duty);
+            last_pwm = duty;
+        }
+        if (s.meas.t_us != last_meas_t_us) {
+            // Latency: tijdstempel van de meting waar deze duty uit volgt -> nu
+            last_meas_t_us = s.meas.t_us;
+            const uint32_t lat = (uint32_t)esp_timer_get_time() - s.meas.t_us;
+            if (lat < g_win.pwm_latency_us_min) g_win.pwm_latency_us_min = lat;
+            if (lat > g_win.pwm_latency_us_max) g_win.pwm_latency_us_max = lat;
+            g_lat_sum_us += lat;
+            g_win.cycles++;
+        }
+
+        // ===== Traag: I2C =====
+        const uint32_t now_ms = millis();
+        uint32_t err = applied.apply_error_flags;
+
+        if (!mcp_ok) {
+            // Pas na een geslaagde IODIR-write mogen de relais bediend worden
+            if ((uint32_t)(now_ms - mcp.last_write_ms) >= MCP08_MIN_INTERVAL_MS * 50u) {
+                mcp.last_write_ms = now_ms;
+                mcp_ok = i2c_write2(MCP08_ADDR, MCP08_REG_IODIR, 0x00);
+            }
+            err |= APPLY_I2C_ERR_MODE_SW;
+        }
+
+        bool changed = slow_service(rpot, s.control.desired_rpot_code, now_ms, &err);
+
+        const uint32_t relays = enabled ? actuation_relay_bits(s.control.desired_mode) : 0u;
+        const uint32_t mcp_bits = (s.io.mcp08_output_bits & ~ACT_MCP08_RELAY_MASK & 0xFFu) | relays;
+        if (mcp_ok && slow_service(mcp, mcp_bits, now_ms, &err)) changed = true;
+
+        // applied_mode volgt zodra de relaisstand erop staat (ook als er niets te
+        // schakelen viel, bv. emulate <-> source)
+        if (enabled && mcp.applied_valid && mcp.applied == mcp_bits &&
+            applied.applied_mode != s.control.desired_mode) {
+            applied.applied_mode = s.control.desired_mode;
+            changed = true;
+        }
+
+        if (changed) {
+            applied.applied_rpot_code = (uint16_t)rpot.applied;
+            applied.last_apply_t_ms = now_ms;
+        }
+        if (changed || err != applied.apply_error_flags) {
+            applied.apply_error_flags = err;
+            system_write_apply_status(&applied);
+        }
+
+        if ((uint32_t)(now_ms - stats_t0_ms) >= ACT_STATS_PERIOD_MS) {
+            stats_t0_ms = now_ms;
+            stats_close_window(freq);
+        }
+    }
+}
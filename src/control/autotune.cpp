@@ -0,0 +1,133 @@
+// control/autotune.cpp
+#include "control/autotune.h"
+
+#include <math.h>
+#include <string.h>
+
+static float clamp_duty(float u)
+{
+    if (u < 0.0f) return 0.0f;
+    if (u > 1.0f) return 1.0f;
+    return u;
+}
+
+void autotune_start(AutotuneState* s, const AutotuneConfig* cfg)
+{
+    if (!s || !cfg) return;
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (s->cfg.cycles == 0) s->cfg.cycles = 4;
+    if (s->cfg.cycles > 16) s->cfg.cycles = 16;
+
+    s->status     = AT_RUNNING;
+    s->relay_high = true;
+    s->peak_max   = -1e30f;
+    s->peak_min   =  1e30f;
+    s->t_last_rise_s = -1.0f;
+}
+
+static void finish(AutotuneState* s)
+{
+    float p_sum = 0.0f, a_sum = 0.0f;
+    float p_min = 1e30f, p_max = 0.0f;
+    for (uint8_t i = 0; i < s->n_used; ++i) {
+        p_sum += s->periods[i];
+        a_sum += s->amps[i];
+        if (s->periods[i] < p_min) p_min = s->periods[i];
+        if (s->periods[i] > p_max) p_max = s->periods[i];
+    }
+    const float pu = p_sum / (float)s->n_used;
+    const float a  = a_sum / (float)s->n_used;
+    const float h  = s->cfg.hysteresis;
+
+    // Geen nette limit cycle: periodes spreiden > 20% of amplitude binnen de hysterese
+    if (pu <= 0.0f || (p_max - p_min) > 0.2f * pu || a <= h) {
+        s->status = AT_FAILED;
+        return;
+    }
+
+    const float a_eff = sqrtf(a * a - h * h);
+    s->result.pu_s = pu;
+    s->result.ku   = 4.0f * s->cfg.relay_d / (3.14159265f * a_eff);
+    autotune_pi_from_ultimate(s->result.ku, pu, &s->result.kp, &s->result.ki);
+    s->status = AT_DONE;
+}
+
+float autotune_step(AutotuneState* s, float meas, float dt_s)
+{
+    if (!s) return 0.0f;
+    if (s->status != AT_RUNNING) return clamp_duty(s->cfg.u_bias);
+
+    s->t_s += dt_s;
+    if (s->t_s > s->cfg.timeout_s) {
+        s->status = AT_FAILED;
+        return clamp_duty(s->cfg.u_bias);
+    }
+
+    if (meas > s->peak_max) s->peak_max = meas;
+    if (meas < s->peak_min) s->peak_min = meas;
+
+    const float e = s->cfg.setpoint - meas;
+    const float e_prev = s->e_prev;
+    s->e_prev = e;
+
+    if (s->relay_high && e < -s->cfg.hysteresis) {
+        s->relay_high = false;
+    } else if (!s->relay_high && e > s->cfg.hysteresis) {
+        // Opgaande schakeling: één volledige periode afgerond. Het kruispunt met
+        // +h ligt tussen het vorige en dit sample; lineair interpoleren.
+        s->relay_high = true;
+
+        float t_cross = s->t_s;
+        if (e > e_prev && e_prev <= s->cfg.hysteresis)
+            t_cross -= dt_s * (e - s->cfg.hysteresis) / (e - e_prev);
+
+        if (s->t_last_rise_s >= 0.0f && s->n_rise > s->cfg.settle_cycles) {
+            s->periods[s->n_used] = t_cross - s->t_last_rise_s;
+            s->amps[s->n_used]    = 0.5f * (s->peak_max - s->peak_min);
+            s->n_used++;
+        }
+        s->n_rise++;
+        s->t_last_rise_s = t_cross;
+        s->peak_max = -1e30f;
+        s->peak_min =  1e30f;
+
+        if (s->n_used >= s->cfg.cycles) {
+            finish(s);
+            return clamp_duty(s->cfg.u_bias);
+        }
+    }
+
+    return clamp_duty(s->cfg.u_bias + (s->relay_high ? s->cfg.relay_d : -s->cfg.relay_d));
+}
+
+void autotune_pi_from_ultimate(float ku, float pu_s, float* kp, float* ki)
+{
+    const float p = ku / 10.0f;
+    const float ti = 2.2f * pu_s;
+    if (kp) *kp = p;
+    if (ki) *ki = (ti > 0.0f) ? p / ti : 0.0f;
+}
+
+bool ctrl_gains_lookup(const CtrlGainPoint* pts, uint8_t n, float op, float* kp, float* ki)
+{
+    if (!pts || n == 0) return false;
+
+    const CtrlGainPoint* lo = nullptr;
+    const CtrlGainPoint* hi = nullptr;
+    for (uint8_t i = 0; i < n; ++i) {
+        if (!pts[i].valid) continue;
+        if (pts[i].op <= op) lo = &pts[i];
+        if (pts[i].op >= op && !hi) hi = &pts[i];
+    }
+    if (!lo && !hi) return false;
+    if (!lo) lo = hi;
+    if (!hi) hi = lo;
+
+    float f = 0.0f;
+    if (hi->op > lo->op) f = (op - lo->op) / (hi->op - lo->op);
+
+    if (kp) *kp = lo->kp + f * (hi->kp - lo->kp);
+    if (ki) *ki = lo->ki + f * (hi->ki - lo->ki);
+    return true;
+}
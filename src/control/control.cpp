@@ -1,16 +1,925 @@
+// control/control.cpp
 #include <Arduino.h>
+#include <Preferences.h>
+#include <string.h>
+#include <math.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "system/system.h"
+#include "measure/measure.h"
+#include "control/control.h"
+#include "control/autotune.h"
+#include "control/sequencer.h"
+#include "control/modeswitch.h"
+#include "actuation/actuation.h"
+#include "fault/fault.h"
+#include "control/profiles/gsm_burst.h"
+#include "control/profiles/motor_start.h"
+#include "emulate/emulate.h"
+#include "emulate/aging.h"
+
+// =========================
+// Gain schedule (NVS)
+// =========================
+static constexpr uint32_t GAINS_VERSION = 1;
+static const char* NVS_NS   = "ctrl";
+static const char* NVS_KEY  = "gains";
+static const char* NVS_KEY_AGING = "aging";
+static const char* NVS_KEY_MODEL = "model";
+
+static CtrlGainTable g_gains;
+static portMUX_TYPE  g_gains_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Werkpunten voor de autotune (moeten overeenkomen met tools/autotune_sim.cpp)
+static const float SOURCE_OPS_V[AT_GAIN_POINTS] = {2.0f, 5.0f, 10.0f};
+static const float SINK_OPS_A[AT_GAIN_POINTS]   = {0.5f, 2.0f, 5.0f};
+
+static void gains_set_defaults(CtrlGainTable* g)
+{
+    memset(g, 0, sizeof(*g));
+    g->version = GAINS_VERSION;
+    for (int i = 0; i < AT_GAIN_POINTS; ++i) {
+        g->source[i].op = SOURCE_OPS_V[i];
+        g->sink[i].op   = SINK_OPS_A[i];
+    }
+}
+
+static void gains_load()
+{
+    CtrlGainTable g;
+    Preferences prefs;
+    bool ok = false;
+
+    if (prefs.begin(NVS_NS, true)) {
+        ok = prefs.getBytesLength(NVS_KEY) == sizeof(g) &&
+             prefs.getBytes(NVS_KEY, &g, sizeof(g)) == sizeof(g) &&
+             g.version == GAINS_VERSION;
+        prefs.end();
+    }
+    if (!ok) gains_set_defaults(&g);
+
+    portENTER_CRITICAL(&g_gains_mux);
+    g_gains = g;
+    portEXIT_CRITICAL(&g_gains_mux);
+
+    Serial.printf("control: gains %s\n", ok ? "uit NVS geladen" : "defaults (geen NVS)");
+}
+
+static bool nvs_put(const char* key, const void* data, size_t len)
+{
+    Preferences prefs;
+    if (!prefs.begin(NVS_NS, false)) return false;
+    const bool ok = prefs.putBytes(key, data, len) == len;
+    prefs.end();
+    return ok;
+}
+
+// =========================
+// NVS writer
+// =========================
+// Een flash write kan tientallen ms blokkeren; ControlTask (1 kHz) zet alleen een
+// kopie klaar en deze task (lage prioriteit) schrijft hem weg.
+enum : uint32_t
+{
+    NVS_PEND_GAINS = (1u << 0),
+    NVS_PEND_AGING = (1u << 1),
+    NVS_PEND_MODEL = (1u << 2),
+};
+
+static TaskHandle_t  g_nvs_task = nullptr;
+static portMUX_TYPE  g_nvs_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t      g_nvs_pending = 0;
+static CtrlGainTable g_nvs_gains;
+static AgingState    g_nvs_aging;
+static EmuModelBlob  g_nvs_model;
+static bool          g_nvs_model_valid = false;
+
+static void nvs_request_gains(const CtrlGainTable* g)
+{
+    portENTER_CRITICAL(&g_nvs_mux);
+    g_nvs_gains = *g;
+    g_nvs_pending |= NVS_PEND_GAINS;
+    portEXIT_CRITICAL(&g_nvs_mux);
+    if (g_nvs_task) xTaskNotifyGive(g_nvs_task);
+}
+
+static void nvs_request_aging(const AgingState* a)
+{
+    portENTER_CRITICAL(&g_nvs_mux);
+    g_nvs_aging = *a;
+    g_nvs_pending |= NVS_PEND_AGING;
+    portEXIT_CRITICAL(&g_nvs_mux);
+    if (g_nvs_task) xTaskNotifyGive(g_nvs_task);
+}
+
+static void nvsWriterTask(void* pv)
+{
+    (void)pv;
+    // Ook de worst-case faulttabel: die wacht op de eerste gemeten actuation-latency
+    // en hoort niet in de 1 kHz-loop van ControlTask
+    bool fault_table_done = false;
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, fault_table_done ? portMAX_DELAY : pdMS_TO_TICKS(1000));
+        if (!fault_table_done) fault_table_done = fault_print_worst_case();
+
+        CtrlGainTable gains;
+        AgingState aging;
+        EmuModelBlob model;
+        bool model_valid;
+        portENTER_CRITICAL(&g_nvs_mux);
+        const uint32_t pending = g_nvs_pending;
+        g_nvs_pending = 0;
+        gains = g_nvs_gains;
+        aging = g_nvs_aging;
+        model = g_nvs_model;
+        model_valid = g_nvs_model_valid;
+        portEXIT_CRITICAL(&g_nvs_mux);
+
+        if (pending & NVS_PEND_GAINS) {
+            const bool ok = nvs_put(NVS_KEY, &gains, sizeof(gains));
+            Serial.printf("control: gains naar NVS %s\n", ok ? "OK" : "FOUT");
+        }
+        if (pending & NVS_PEND_AGING) {
+            aging_seal(&aging);
+            if (!nvs_put(NVS_KEY_AGING, &aging, sizeof(aging)))
+                Serial.println("control: aging checkpoint FOUT");
+        }
+        if (pending & NVS_PEND_MODEL) {
+            bool ok;
+            if (model_valid) {
+                ok = nvs_put(NVS_KEY_MODEL, &model, sizeof(model));
+            } else {
+                Preferences prefs;
+                ok = prefs.begin(NVS_NS, false);
+                if (ok) {
+                    prefs.remove(NVS_KEY_MODEL);
+                    prefs.end();
+                }
+            }
+            Serial.printf("control: celmodel %s NVS %s\n", model_valid ? "naar" : "uit", ok ? "OK" : "FOUT");
+        }
+    }
+}
+
+void control_get_gains(CtrlGainTable* out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&g_gains_mux);
+    *out = g_gains;
+    portEXIT_CRITICAL(&g_gains_mux);
+}
+
+// =========================
+// Autotune runner
+// =========================
+// Loopt alle werkpunten af: eerst source (spanningslus), dan sink (stroomlus).
+// Per werkpunt: AT_PRESETTLE_S op de bias-duty, daarna de relay-test.
+// Relais gaan alleen om via de mode-switch sequencer (duty naar 0, stroom weg,
+// relais om en bevestigd + contacttijd), ook bij het sluiten aan het begin; aan
+// het eind gaat de duty op dezelfde manier naar 0 voordat de run stopt.
+static constexpr float AT_PRESETTLE_S = 0.2f;
+static constexpr int   AT_STEPS = 2 * AT_GAIN_POINTS;
+
+static volatile bool g_at_request = false;
+static volatile bool g_at_active  = false;
+
+struct AutotuneRun
+{
+    int   step;        // 0..AT_STEPS-1, AT_STEPS = uitloop
+    float presettle_s;
+    PowerMode relay;   // relaisstand waarop nu gemeten wordt
+    ModeSwitch ms;     // relaiswissel / uitloop; REINIT = klaar (presettle neemt het over)
+    bool  closing;     // eerste wissel: relais stonden los
+    uint32_t apply_t0_ms;
+    float duty;        // laatst uitgestuurde duty (start RAMP_DOWN)
+    AutotuneState at;
+    CtrlGainTable result;
+};
+static AutotuneRun      g_run;
+static ModeSwitchConfig g_run_ms_cfg;
+
+static bool run_is_sink(int step) { return step >= AT_GAIN_POINTS; }
+
+static PowerMode run_step_mode(int step)
+{
+    return run_is_sink(step) ? POWER_MODE_SINK : POWER_MODE_SOURCE;
+}
+
+static void run_start_step(AutotuneRun& r)
+{
+    const bool sink = run_is_sink(r.step);
+    const int  i    = sink ? r.step - AT_GAIN_POINTS : r.step;
+    const float full = sink ? CTRL_SINK_I_FULL : CTRL_SOURCE_V_FULL;
+
+    AutotuneConfig cfg;
+    cfg.setpoint      = sink ? SINK_OPS_A[i] : SOURCE_OPS_V[i];
+    cfg.u_bias        = cfg.setpoint / full;
+    cfg.relay_d       = 0.05f;
+    cfg.hysteresis    = 0.002f * full;
+    cfg.settle_cycles = 2;
+    cfg.cycles        = 6;
+    cfg.timeout_s     = 3.0f;
+
+    autotune_start(&r.at, &cfg);
+    r.presettle_s = 0.0f;
+}
+
+static void run_begin(const SystemSnapshot& s)
+{
+    memset(&g_run, 0, sizeof(g_run));
+    gains_set_defaults(&g_run.result);
+    ms_config_default(&g_run_ms_cfg);
+    run_start_step(g_run);
+
+    // Relais sluiten op duty 0. applied_mode is nog de stand van voor het
+    // uitschakelen; alleen een nieuwe apply na deze start bevestigt de wissel.
+    g_run.relay = run_step_mode(0);
+    g_run.closing = true;
+    g_run.apply_t0_ms = s.apply.last_apply_t_ms;
+    ms_start(&g_run.ms, &g_run_ms_cfg, g_run.relay, g_run.relay, true, 0.0f);
+
+    g_at_active = true;
+    system_set_status_flag(STATUS_AUTOTUNE_ACTIVE);
+    Serial.println("control: autotune gestart");
+}
+
+static void run_end(bool store)
+{
+    g_at_active = false;
+    system_clear_status_flag(STATUS_AUTOTUNE_ACTIVE);
+
+    if (!store) {
+        Serial.println("control: autotune afgebroken");
+        return;
+    }
+
+    portENTER_CRITICAL(&g_gains_mux);
+    g_gains = g_run.result;
+    portEXIT_CRITICAL(&g_gains_mux);
+
+    nvs_request_gains(&g_run.result);
+    Serial.println("control: autotune klaar");
+}
+
+// Eén stap van de relaiswissel. Geeft de fase; MS_REINIT = relais om en
+// bevestigd, MS_IDLE = mislukt (r.ms.result).
+static ModeSwitchPhase run_switch_step(AutotuneRun& r, const SystemSnapshot& s, float dt_s)
+{
+    ModeSwitchInput in;
+    in.dt_s         = dt_s;
+    in.i_abs        = fmaxf(fabsf(s.meas.i_source), fabsf(s.meas.i_sink));
+    in.applied_mode = s.apply.applied_mode;
+    in.track_err    = 0.0f;
+    if (r.closing && s.apply.last_apply_t_ms == r.apply_t0_ms)
+        in.applied_mode = (r.ms.to == POWER_MODE_SINK) ? POWER_MODE_SOURCE : POWER_MODE_SINK;
+    return ms_step(&r.ms, &g_run_ms_cfg, &in);
+}
+
+// Geeft de duty voor deze sample; schrijft resultaten weg bij elk afgerond werkpunt.
+static float run_step(const SystemSnapshot& s, float dt_s, PowerMode* mode)
+{
+    AutotuneRun& r = g_run;
+
+    if (ms_active(&r.ms)) {
+        *mode = r.ms.relay_mode;
+        const ModeSwitchPhase ph = run_switch_step(r, s, dt_s);
+        if (ph == MS_RAMP_DOWN) return r.duty * r.ms.duty_scale;
+        if (ph == MS_IDLE) {
+            Serial.printf("control: autotune relaiswissel naar %s mislukt (%d)\n",
+                          r.ms.to == POWER_MODE_SINK ? "sink" : "source", (int)r.ms.result);
+            fault_report_event(r.ms.result == MS_RESULT_SWITCH_TIMEOUT ? FID_COMM : FID_HW);
+            run_end(false);
+            return 0.0f;
+        }
+        if (ph != MS_REINIT) return 0.0f;
+
+        r.ms.phase = MS_IDLE;
+        r.relay = r.ms.to;
+        r.closing = false;
+        if (r.step >= AT_STEPS) {
+            run_end(true);
+            return 0.0f;
+        }
+        r.presettle_s = 0.0f;
+    }
+
+    const bool sink = run_is_sink(r.step);
+    *mode = r.relay;
+
+    const float meas = sink ? s.meas.i_sink : s.meas.v_out;
+
+    if (r.presettle_s < AT_PRESETTLE_S) {
+        r.presettle_s += dt_s;
+        return r.at.cfg.u_bias;
+    }
+
+    const float u = autotune_step(&r.at, meas, dt_s);
+    if (r.at.status == AT_RUNNING) return u;
+
+    CtrlGainPoint& gp = sink ? r.result.sink[r.step - AT_GAIN_POINTS] : r.result.source[r.step];
+    gp.op    = r.at.cfg.setpoint;
+    gp.valid = (r.at.status == AT_DONE);
+    if (gp.valid) {
+        gp.kp   = r.at.result.kp;
+        gp.ki   = r.at.result.ki;
+        gp.ku   = r.at.result.ku;
+        gp.pu_s = r.at.result.pu_s;
+    }
+
+    Serial.printf("control: autotune %s op=%.2f %s Ku=%.4f Pu=%.2fms t=%.2fs\n",
+                  sink ? "sink" : "source", (double)gp.op, gp.valid ? "OK" : "FAIL",
+                  (double)gp.ku, (double)(gp.pu_s * 1e3f), (double)r.at.t_s);
+
+    r.step++;
+    if (r.step >= AT_STEPS) {
+        // Uitloop: duty naar 0 en wachten tot de stroom weg is, relais blijven staan
+        ms_start(&r.ms, &g_run_ms_cfg, r.relay, r.relay, true, r.duty);
+        return r.duty;
+    }
+    run_start_step(r);
+    const PowerMode next = run_step_mode(r.step);
+    if (actuation_relay_bits(next) != actuation_relay_bits(r.relay)) {
+        ms_start(&r.ms, &g_run_ms_cfg, r.relay, next, true, r.duty);
+        return r.duty;
+    }
+    r.relay = next;
+    return r.at.cfg.u_bias;
+}
+
+static float run_tick(const SystemSnapshot& s, float dt_s, PowerMode* mode)
+{
+    const float u = run_step(s, dt_s, mode);
+    g_run.duty = u;
+    return u;
+}
+
+bool control_request_autotune(void)
+{
+    SystemSnapshot s;
+    system_read_snapshot(&s);
+    if (s.status.state != SYS_STATE_CONFIG) return false;
+
+    g_at_request = true;
+    return true;
+}
+
+bool control_autotune_active(void)
+{
+    return g_at_active;
+}
+
+// =========================
+// Load-profiel sequencer
+// =========================
+// Aanvragen komen uit andere tasks; alleen ControlTask raakt de Sequencer zelf aan.
+static const uint8_t* volatile g_profile_req = nullptr;
+static volatile size_t g_profile_req_len = 0;
+static volatile bool g_profile_stop_req = false;
+
+static Sequencer g_seq;
+static bool g_seq_loaded  = false;  // profiel gekoppeld, wacht op ACTIVE
+static volatile bool g_seq_running = false;
+
+bool control_start_profile(const uint8_t* blob, size_t len)
+{
+    if (!seq_validate(blob, len)) return false;
+    g_profile_req_len = len;
+    g_profile_req = blob;
+    return true;
+}
+
+void control_stop_profile(void)
+{
+    g_profile_stop_req = true;
+}
+
+bool control_profile_running(void)
+{
+    return g_seq_running;
+}
+
+bool control_start_builtin_profile(CtrlBuiltinProfile id)
+{
+    switch (id)
+    {
+        case CTRL_PROFILE_GSM_BURST:   return control_start_profile(PROFILE_GSM_BURST, sizeof(PROFILE_GSM_BURST));
+        case CTRL_PROFILE_MOTOR_START: return control_start_profile(PROFILE_MOTOR_START, sizeof(PROFILE_MOTOR_START));
+        default: return false;
+    }
+}
+
+static void profile_poll_requests()
+{
+    if (g_profile_stop_req) {
+        g_profile_stop_req = false;
+        seq_stop(&g_seq);
+        g_seq_loaded = false;
+    }
+
+    const uint8_t* req = g_profile_req;
+    if (req) {
+        g_profile_req = nullptr;
+        g_seq_loaded = seq_load(&g_seq, req, g_profile_req_len);
+    }
+}
+
+// =========================
+// Batterij-emulatie + aging
+// =========================
+// De geëmuleerde cel staat op omgevingstemperatuur; temp_sink_c is de koelplaat.
+static constexpr float EMU_AMBIENT_C        = 25.0f;
+static constexpr float AGING_CKPT_MIN_EFC   = 0.01f;   // ~1% van een cyclus
+static constexpr float AGING_CKPT_MAX_S     = 600.0f;  // of elke 10 min emulatietijd
+
+// Gefit celmodel (tools/model_fit). Vervangt curve/nominaal/capaciteit/RC uit de UI;
+// een nieuw model gaat pas in bij de volgende emulatiestart.
+static EmuModelBlob g_model_req;
+static bool         g_model_req_valid = false;
+static portMUX_TYPE g_model_mux = portMUX_INITIALIZER_UNLOCKED;
+static EmuModelBlob g_emu_model;    // alleen ControlTask; g_emu_base.curve wijst hierin
+
+static EmuParams   g_emu_base;
+static EmuParams   g_emu_params;
+static EmuState    g_emu;
+static bool        g_emu_running = false;
+
+static AgingParams g_aging_params;
+static AgingState  g_aging;
+static AgingState  g_aging_saved;
+static volatile bool g_aging_reset_req = false;
+
+static void aging_load()
+{
+    AgingState a;
+    Preferences prefs;
+    bool ok = false;
 
+    if (prefs.begin(NVS_NS, true)) {
+        ok = prefs.getBytesLength(NVS_KEY_AGING) == sizeof(a) &&
+             prefs.getBytes(NVS_KEY_AGING, &a, sizeof(a)) == sizeof(a) &&
+             aging_verify(&a);
+        prefs.end();
+    }
+    if (!ok) aging_init(&a);
+
+    g_aging = a;
+    g_aging_saved = a;
+    Serial.printf("control: aging EFC=%.2f Q=%.3f R=%.3f (%s)\n", (double)a.efc,
+                  (double)a.capacity_factor, (double)a.resistance_factor, ok ? "NVS" : "nieuw");
+}
+
+static void model_load()
+{
+    EmuModelBlob m;
+    Preferences prefs;
+    bool ok = false;
+
+    if (prefs.begin(NVS_NS, true)) {
+        ok = prefs.getBytesLength(NVS_KEY_MODEL) == sizeof(m) &&
+             prefs.getBytes(NVS_KEY_MODEL, &m, sizeof(m)) == sizeof(m) &&
+             emu_model_validate(&m);
+        prefs.end();
+    }
+
+    portENTER_CRITICAL(&g_model_mux);
+    if (ok) g_model_req = m;
+    g_model_req_valid = ok;
+    portEXIT_CRITICAL(&g_model_mux);
+
+    if (ok) {
+        Serial.printf("control: celmodel %.0f mAh R0=%.3f R1=%.3f C1=%.0f\n", (double)m.capacity_mAh,
+                      (double)m.r0_ohm, (double)m.r1_ohm, (double)m.c1_f);
+    }
+}
+
+bool control_set_emu_model(const void* blob, size_t len)
+{
+    if (!blob || len != sizeof(EmuModelBlob)) return false;
+
+    EmuModelBlob m;
+    memcpy(&m, blob, sizeof(m));
+    if (!emu_model_validate(&m)) return false;
+
+    portENTER_CRITICAL(&g_model_mux);
+    g_model_req = m;
+    g_model_req_valid = true;
+    portEXIT_CRITICAL(&g_model_mux);
+
+    portENTER_CRITICAL(&g_nvs_mux);
+    g_nvs_model = m;
+    g_nvs_model_valid = true;
+    g_nvs_pending |= NVS_PEND_MODEL;
+    portEXIT_CRITICAL(&g_nvs_mux);
+    if (g_nvs_task) xTaskNotifyGive(g_nvs_task);
+    return true;
+}
+
+void control_clear_emu_model(void)
+{
+    portENTER_CRITICAL(&g_model_mux);
+    g_model_req_valid = false;
+    portEXIT_CRITICAL(&g_model_mux);
+
+    portENTER_CRITICAL(&g_nvs_mux);
+    g_nvs_model_valid = false;
+    g_nvs_pending |= NVS_PEND_MODEL;
+    portEXIT_CRITICAL(&g_nvs_mux);
+    if (g_nvs_task) xTaskNotifyGive(g_nvs_task);
+}
+
+void control_reset_aging(void)
+{
+    g_aging_reset_req = true;
+}
+
+void control_get_aging(AgingState* out)
+{
+    // Alleen diagnostiek: kan een half bijgewerkte kopie zijn
+    if (out) *out = g_aging;
+}
+
+static void emu_begin(const SystemSnapshot& s)
+{
+    portENTER_CRITICAL(&g_model_mux);
+    const bool have_model = g_model_req_valid;
+    if (have_model) g_emu_model = g_model_req;
+    portEXIT_CRITICAL(&g_model_mux);
+
+    if (!have_model || !emu_params_from_model(&g_emu_base, &g_emu_model)) {
+        emu_params_from_curves(&g_emu_base, &s.curves, s.ui.selected_curve_id,
+                               s.ui.nominal_voltage, s.ui.capacity_mAh);
+    }
+    g_emu_base.v_cutoff = 0.0f; // ontladen tot de curve op is; cutoff regelt de DUT zelf
+
+    aging_default_params(&g_aging_params, s.ui.selected_curve_id);
+    aging_apply(&g_aging, &g_emu_base, &g_emu_params);
+
+    emu_init(&g_emu, &g_emu_params,
+             emu_soc_from_start_index(s.ui.start_index, g_emu_params.curve_len));
+    g_emu_running = true;
+}
+
+// Geeft de klemspanning die de source-loop moet neerzetten.
+static float emu_tick(const MeasurementData& m, float dt_s)
+{
+    const float i_load = m.i_source;
+    const float v = emu_step(&g_emu, &g_emu_params, i_load, dt_s);
+
+    aging_update(&g_aging, &g_aging_params, g_emu.soc, i_load, EMU_AMBIENT_C, dt_s,
+                 g_emu_base.capacity_mAh * 0.001f);
+    aging_apply(&g_aging, &g_emu_base, &g_emu_params);
+
+    if (aging_checkpoint_due(&g_aging, &g_aging_saved, AGING_CKPT_MIN_EFC, AGING_CKPT_MAX_S)) {
+        g_aging_saved = g_aging;
+        nvs_request_aging(&g_aging);
+    }
+    return v;
+}
+
+// =========================
+// Uitgang naar actuationTask
+// =========================
+static volatile TaskHandle_t g_notify_task = nullptr;
+
+void control_set_notify_task(TaskHandle_t task)
+{
+    g_notify_task = task;
+}
+
+// Fault manager: SHUTDOWN -> duty 0, DERATE -> duty begrensd (zie fault/fault.h).
+// Elke publicatie sluit openstaande fault-reacties af (reactietijd).
+static uint16_t g_fault_duty_max = 0xFFFF;
+
+static void control_publish(const ControlData* c)
+{
+    ControlData out = *c;
+    if (out.pwm_duty > g_fault_duty_max) out.pwm_duty = g_fault_duty_max;
+    system_write_control(&out);
+
+    TaskHandle_t consumer = g_notify_task;
+    if (consumer) xTaskNotifyGive(consumer);
+
+    fault_reacted();
+}
+
+// =========================
+// Regeling (source: spanning, sink: stroom)
+// =========================
+static constexpr float PI_DEFAULT_KP = 0.03f;
+static constexpr float PI_DEFAULT_KI = 3.0f;
+
+static float g_pi_integ = 0.0f;
+static PowerMode g_pi_mode = POWER_MODE_EMULATE;
+
+static float regulate(PowerMode mode, float sp, float meas, float dt_s)
+{
+    const bool sink = (mode == POWER_MODE_SINK);
+    const float full = sink ? CTRL_SINK_I_FULL : CTRL_SOURCE_V_FULL;
+
+    // Bij modewissel de integrator opnieuw voorladen op de feedforward
+    if (mode != g_pi_mode) {
+        g_pi_mode = mode;
+        g_pi_integ = 0.0f;
+    }
+
+    float kp = PI_DEFAULT_KP, ki = PI_DEFAULT_KI;
+    CtrlGainTable g;
+    control_get_gains(&g);
+    ctrl_gains_lookup(sink ? g.sink : g.source, AT_GAIN_POINTS, sp, &kp, &ki);
+
+    const float e = sp - meas;
+    float u = sp / full + kp * e + g_pi_integ + ki * e * dt_s;
+    if (u > 1.0f) u = 1.0f;
+    else if (u < 0.0f) u = 0.0f;
+    else g_pi_integ += ki * e * dt_s;   // anti-windup: alleen integreren als niet verzadigd
+    return u;
+}
+
+// =========================
+// Setpoint per mode
+// =========================
+static float mode_measurement(const MeasurementData& m, PowerMode mode)
+{
+    return (mode == POWER_MODE_SINK) ? m.i_sink : m.v_out;
+}
+
+static float mode_full_scale(PowerMode mode)
+{
+    return (mode == POWER_MODE_SINK) ? CTRL_SINK_I_FULL : CTRL_SOURCE_V_FULL;
+}
+
+// Emulatie: klemspanning uit het celmodel; source/sink: UI-waarde of lopend profiel.
+static float mode_setpoint(const SystemSnapshot& s, PowerMode mode, uint32_t t_us, float dt_s)
+{
+    if (mode == POWER_MODE_EMULATE) {
+        if (!g_emu_running) emu_begin(s);
+        return emu_tick(s.meas, dt_s);
+    }
+    g_emu_running = false;
+
+    float sp = (mode == POWER_MODE_SINK) ? s.ui.ui3_set_current : s.ui.ui2_set_voltage;
+
+    // Profiel starten zodra mode past; t = 0 op deze meting (µs resolutie)
+    const SeqMode want = (mode == POWER_MODE_SINK) ? SEQ_MODE_SINK : SEQ_MODE_SOURCE;
+    if (g_seq_loaded && !g_seq_running && seq_mode(&g_seq) == want) {
+        seq_start(&g_seq, t_us, (int32_t)(sp * 1000.0f));
+        g_seq_loaded = false;
+    }
+    g_seq_running = seq_running(&g_seq);
+    if (g_seq_running) sp = (float)seq_eval(&g_seq, t_us) * 0.001f;
+    return sp;
+}
+
+// =========================
+// Modewissel (zie control/modeswitch.h)
+// =========================
+static ModeSwitchConfig g_ms_cfg;
+static ModeSwitch       g_ms;
+static ModeSwitch       g_ms_last;          // laatst afgeronde wissel (diagnostiek)
+static portMUX_TYPE     g_ms_mux = portMUX_INITIALIZER_UNLOCKED;
+static float            g_ms_duty0 = 0.0f;  // duty bij start RAMP_DOWN
+static float            g_ms_sp0 = 0.0f;    // startwaarde RAMP_UP
+static float            g_ms_sp_cmd = 0.0f; // laatst gecommandeerd setpoint
+
+static const char* mode_name(PowerMode m)
+{
+    return (m == POWER_MODE_SINK) ? "sink" : (m == POWER_MODE_SOURCE) ? "source" : "emulate";
+}
+
+static void ms_report(const ModeSwitch& ms)
+{
+    portENTER_CRITICAL(&g_ms_mux);
+    g_ms_last = ms;
+    portEXIT_CRITICAL(&g_ms_mux);
+
+    Serial.printf("control: mode %s -> %s %s in %.1f ms (down %.1f, settle %.1f, switch %.1f, up %.1f)\n",
+                  mode_name(ms.from), mode_name(ms.to),
+                  ms.result == MS_RESULT_OK ? "OK" : "MISLUKT", (double)(ms.t_total_s * 1e3f),
+                  (double)(ms.phase_time_s[MS_RAMP_DOWN] * 1e3f), (double)(ms.phase_time_s[MS_SETTLE] * 1e3f),
+                  (double)(ms.phase_time_s[MS_SWITCH] * 1e3f),
+                  (double)((ms.phase_time_s[MS_REINIT] + ms.phase_time_s[MS_RAMP_UP]) * 1e3f));
+}
+
+void control_get_last_mode_switch(ModeSwitch* out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&g_ms_mux);
+    *out = g_ms_last;
+    portEXIT_CRITICAL(&g_ms_mux);
+}
+
+// Geeft true als de wissel deze stap de uitgang bepaalt (c is dan ingevuld).
+static bool mode_switch_tick(const SystemSnapshot& s, uint32_t t_us, float dt_s, ControlData* c)
+{
+    const PowerMode cur  = s.status.mode_current;
+    const PowerMode pend = s.status.mode_pending;
+
+    const bool retarget = (g_ms.phase == MS_RAMP_DOWN || g_ms.phase == MS_SETTLE) && pend != g_ms.to;
+    if ((!ms_active(&g_ms) && pend != cur) || retarget) {
+        const bool relays = actuation_relay_bits(cur) != actuation_relay_bits(pend);
+        if (!ms_active(&g_ms)) {
+            g_ms_duty0 = (float)s.control.pwm_duty * (1.0f / 65535.0f);
+            g_ms_sp0 = 0.0f;
+        }
+        // Zonder relaiswissel bumpless verder vanaf de huidige uitgang
+        if (!relays) g_ms_sp0 = mode_measurement(s.meas, pend);
+        ms_start(&g_ms, &g_ms_cfg, cur, pend, relays, g_ms_duty0);
+    }
+    if (!ms_active(&g_ms)) return false;
+
+    const PowerMode to = g_ms.to;
+    ModeSwitchInput in;
+    in.dt_s         = dt_s;
+    in.i_abs        = fmaxf(fabsf(s.meas.i_source), fabsf(s.meas.i_sink));
+    in.applied_mode = s.apply.applied_mode;
+    in.track_err    = fabsf(g_ms_sp_cmd - mode_measurement(s.meas, to)) / mode_full_scale(to);
+
+    if (ms_step(&g_ms, &g_ms_cfg, &in) == MS_IDLE) {
+        ms_report(g_ms);
+        if (g_ms.result == MS_RESULT_OK) {
+            // Deze stap al op het volle setpoint van de nieuwe mode
+            system_complete_mode_switch(to);
+            const float sp = mode_setpoint(s, to, t_us, dt_s);
+            const float u = regulate(to, sp, mode_measurement(s.meas, to), dt_s);
+            c->pwm_duty = (uint16_t)(u * 65535.0f + 0.5f);
+            c->desired_mode = to;
+            c->setpoint = sp;
+            return true;
+        }
+        // Mislukt: wissel annuleren, uitgang uit; fault afhandeling beslist verder
+        system_request_mode(cur);
+        // Eenmalige fout; de fault manager latcht en stuurt de state machine
+        fault_report_event(g_ms.result == MS_RESULT_SWITCH_TIMEOUT ? FID_COMM : FID_HW);
+        c->pwm_duty = 0;
+        c->desired_mode = cur;
+        return true;
+    }
+
+    c->desired_mode = g_ms.relay_mode;
+    switch (g_ms.phase)
+    {
+        case MS_RAMP_DOWN:
+            c->pwm_duty = (uint16_t)(g_ms_duty0 * g_ms.duty_scale * 65535.0f + 0.5f);
+            break;
+
+        case MS_SETTLE:
+        case MS_SWITCH:
+            c->pwm_duty = 0;
+            break;
+
+        case MS_REINIT:
+        case MS_RAMP_UP:
+        default:
+            if (g_ms.reinit) {
+                // Regelaar en profiel horen bij de oude mode
+                g_pi_integ = 0.0f;
+                g_pi_mode = to;
+                if (g_seq_running) seq_stop(&g_seq);
+                g_seq_running = false;
+            }
+            {
+                const float target = mode_setpoint(s, to, t_us, dt_s);
+                const float ramp = (g_ms.phase == MS_RAMP_UP) ? g_ms.ramp : 0.0f;
+                const float sp = g_ms_sp0 + (target - g_ms_sp0) * ramp;
+                const float u = regulate(to, sp, mode_measurement(s.meas, to), dt_s);
+                c->pwm_duty = (uint16_t)(u * 65535.0f + 0.5f);
+                c->setpoint = sp;
+                g_ms_sp_cmd = sp;
+            }
+            break;
+    }
+    return true;
+}
+
+// =========================
+// Task
+// =========================
 void ControlTask(void *pvParameters)
 {
-    
+    (void)pvParameters;
+
+    gains_load();
+    aging_load();
+    model_load();
+    ms_config_default(&g_ms_cfg);
+
+    xTaskCreatePinnedToCore(nvsWriterTask, "CTRL_NVS", 3072, nullptr, 1, &g_nvs_task, 0);
+
+    // Draai op de meetstroom (1 kHz); zonder metingen valt de timeout terug op 10 ms
+    measure_set_notify_task(xTaskGetCurrentTaskHandle());
+
+    uint32_t last_t_us = 0;
 
     for (;;)
     {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10)); // sampletijd state machine
+
+        SystemSnapshot s;
+        system_read_snapshot(&s);
+
+        const uint32_t t_us = s.meas.t_us;
+        const float dt_s = (last_t_us != 0 && t_us != last_t_us) ? (float)(t_us - last_t_us) * 1e-6f : 0.001f;
+        last_t_us = t_us;
+
+        // Faults eerst: een shutdown staat in deze stap al op de uitgang
+        FaultOutput fo;
+        fault_tick(&s, &fo);
+        g_fault_duty_max = fo.shutdown ? 0 : (uint16_t)(fo.duty_cap * 65535.0f + 0.5f);
+
+        const bool driving = (s.status.state == SYS_STATE_ACTIVE) || g_at_active;
+        if (!driving) {
+            fault_reacted();   // uitgang staat al uit
+        } else if (fo.shutdown) {
+            if (g_at_active) run_end(false);
+            ControlData off = s.control;
+            off.pwm_duty = 0;
+            control_publish(&off);
+            continue;
+        }
+
+        if (g_at_request) {
+            g_at_request = false;
+            if (!g_at_active && s.status.state == SYS_STATE_CONFIG) run_begin(s);
+        }
+
+        profile_poll_requests();
+
+        if (g_aging_reset_req) {
+            g_aging_reset_req = false;
+            aging_init(&g_aging);
+            g_aging_saved = g_aging;
+            nvs_request_aging(&g_aging);
+        }
+
+        if (!g_at_active) {
+            const bool regulating = (s.status.state == SYS_STATE_ACTIVE);
+
+            if (!regulating) {
+                if (g_seq_running) seq_stop(&g_seq);
+                g_seq_running = false;
+                g_pi_mode = POWER_MODE_EMULATE;
+
+                // Uitgang staat uit (relais los): een modewissel is meteen klaar
+                g_ms.phase = MS_IDLE;
+                if (s.status.mode_pending != s.status.mode_current)
+                    system_complete_mode_switch(s.status.mode_pending);
+
+                // Uit publiceren (bij het verlaten van ACTIVE of na een wissel): anders
+                // blijven pwm_duty en desired_mode van de laatste regelstap staan en
+                // past actuationTask die bij de volgende CONFIG -> ACTIVE weer toe.
+                const PowerMode mode_now = s.status.mode_pending;
+                if (s.control.pwm_duty != 0 || s.control.desired_mode != mode_now) {
+                    ControlData off = s.control;
+                    off.pwm_duty     = 0;
+                    off.desired_mode = mode_now;
+                    off.setpoint     = 0.0f;
+                    control_publish(&off);
+                }
+
+                // Bij stoppen de aging-stand meteen vastleggen
+                if (g_emu_running) {
+                    g_emu_running = false;
+                    g_aging_saved = g_aging;
+                    nvs_request_aging(&g_aging);
+                }
+                continue;
+            }
+
+            ControlData c = s.control;
+            if (mode_switch_tick(s, t_us, dt_s, &c)) {
+                control_publish(&c);
+                continue;
+            }
+
+            const PowerMode mode = s.status.mode_current;
+            const float sp = mode_setpoint(s, mode, t_us, dt_s);
+            const float u  = regulate(mode, sp, mode_measurement(s.meas, mode), dt_s);
+
+            c.pwm_duty     = (uint16_t)(u * 65535.0f + 0.5f);
+            c.desired_mode = mode;
+            c.setpoint     = sp;
+            control_publish(&c);
+            continue;
+        }
+
+        if (s.status.state != SYS_STATE_CONFIG) {
+            run_end(false);
+            ControlData off = s.control;
+            off.pwm_duty = 0;
+            control_publish(&off);
+            continue;
+        }
 
+        PowerMode mode = POWER_MODE_SOURCE;
+        const float u = run_tick(s, dt_s, &mode);
 
-        vTaskDelay(pdMS_TO_TICKS(10)); // sampletijd state machine
+        ControlData c = s.control;
+        c.pwm_duty     = (uint16_t)(u * 65535.0f + 0.5f);
+        c.desired_mode = mode;
+        c.setpoint     = g_run.at.cfg.setpoint;
+        control_publish(&c);
     }
-}
\ No newline at end of file
+}
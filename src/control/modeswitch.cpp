@@ -0,0 +1,154 @@
+// control/modeswitch.cpp
+#include "control/modeswitch.h"
+
+#include <string.h>
+
+void ms_config_default(ModeSwitchConfig* cfg)
+{
+    if (!cfg) return;
+    cfg->ramp_down_s    = 0.005f;   // 5 ms van volle duty naar 0
+    cfg->i_zero_a       = 0.05f;
+    cfg->settle_samples = 3;        // 3 ms bij 1 kHz
+    cfg->relay_bounce_s = 0.005f;   // AANPASSEN: operate + bounce uit datasheet relais
+    cfg->ramp_up_per_s  = 100.0f;   // 10 ms van 0 naar doel als de uitgang volgt
+    cfg->track_band     = 0.02f;
+    cfg->timeout_s      = 0.5f;
+}
+
+static void enter(ModeSwitch* ms, ModeSwitchPhase phase)
+{
+    ms->phase_time_s[ms->phase] += ms->t_phase_s;
+    ms->phase = phase;
+    ms->t_phase_s = 0.0f;
+    ms->t_confirm_s = -1.0f;
+    ms->settled = 0;
+}
+
+static void finish(ModeSwitch* ms, ModeSwitchResult result)
+{
+    enter(ms, MS_IDLE);
+    ms->result = result;
+    ms->reinit = false;
+}
+
+void ms_start(ModeSwitch* ms, const ModeSwitchConfig* cfg, PowerMode from, PowerMode to,
+              bool relays_change, float duty0)
+{
+    if (!ms || !cfg) return;
+
+    // Nieuwe wissel tijdens de uitloop (relais nog niet om): alleen het doel aanpassen
+    if ((ms->phase == MS_RAMP_DOWN || ms->phase == MS_SETTLE) && relays_change) {
+        ms->to = to;
+        return;
+    }
+
+    memset(ms, 0, sizeof(*ms));
+    ms->from = from;
+    ms->to = to;
+    ms->relays_change = relays_change;
+    ms->relay_mode = from;
+    ms->duty_scale = 1.0f;
+
+    if (!relays_change) {
+        // Zelfde relaisstand: bumpless overnemen
+        ms->phase = MS_REINIT;
+        ms->relay_mode = to;
+        ms->reinit = true;
+        return;
+    }
+
+    // Duty daalt met 1/ramp_down_s per seconde, ongeacht waar hij begint
+    if (duty0 < 0.01f) duty0 = 0.01f;
+    ms->ramp_down_rate = (cfg->ramp_down_s > 0.0f) ? 1.0f / (cfg->ramp_down_s * duty0) : 1e9f;
+    ms->phase = MS_RAMP_DOWN;
+}
+
+ModeSwitchPhase ms_step(ModeSwitch* ms, const ModeSwitchConfig* cfg, const ModeSwitchInput* in)
+{
+    if (!ms || !cfg || !in || ms->phase == MS_IDLE) return MS_IDLE;
+
+    ms->t_phase_s += in->dt_s;
+    ms->t_total_s += in->dt_s;
+
+    switch (ms->phase)
+    {
+        case MS_RAMP_DOWN:
+            ms->duty_scale -= ms->ramp_down_rate * in->dt_s;
+            if (ms->duty_scale <= 0.0f) {
+                ms->duty_scale = 0.0f;
+                enter(ms, MS_SETTLE);
+            }
+            break;
+
+        case MS_SETTLE:
+            ms->duty_scale = 0.0f;
+            ms->settled = (in->i_abs < cfg->i_zero_a) ? (uint16_t)(ms->settled + 1) : 0;
+            if (ms->settled >= cfg->settle_samples) {
+                ms->relay_mode = ms->to;
+                enter(ms, MS_SWITCH);
+            } else if (ms->t_phase_s > cfg->timeout_s) {
+                finish(ms, MS_RESULT_SETTLE_TIMEOUT);
+            }
+            break;
+
+        case MS_SWITCH:
+            // Contacttijd pas vanaf het moment dat actuation de wissel bevestigt
+            if (ms->t_confirm_s < 0.0f && in->applied_mode == ms->to) ms->t_confirm_s = ms->t_phase_s;
+            if (ms->t_confirm_s >= 0.0f && ms->t_phase_s - ms->t_confirm_s >= cfg->relay_bounce_s) {
+                ms->reinit = true;
+                enter(ms, MS_REINIT);
+            } else if (ms->t_phase_s > cfg->timeout_s) {
+                ms->relay_mode = ms->from;
+                finish(ms, MS_RESULT_SWITCH_TIMEOUT);
+            }
+            break;
+
+        case MS_REINIT:
+            // ControlTask heeft de regelaar in de vorige stap gereset
+            ms->reinit = false;
+            ms->duty_scale = 1.0f;
+            ms->ramp = 0.0f;
+            enter(ms, MS_RAMP_UP);
+            break;
+
+        case MS_RAMP_UP:
+            if (ms->ramp < 1.0f) {
+                if (in->track_err <= cfg->track_band) {
+                    ms->ramp += cfg->ramp_up_per_s * in->dt_s;
+                    if (ms->ramp > 1.0f) ms->ramp = 1.0f;
+                }
+            } else {
+                // Klaar als de uitgang settle_samples metingen binnen de band blijft
+                ms->settled = (in->track_err <= cfg->track_band) ? (uint16_t)(ms->settled + 1) : 0;
+                if (ms->settled >= cfg->settle_samples) {
+                    finish(ms, MS_RESULT_OK);
+                    break;
+                }
+            }
+            if (ms->t_phase_s > cfg->timeout_s) finish(ms, MS_RESULT_RAMP_TIMEOUT);
+            break;
+
+        default:
+            break;
+    }
+    return ms->phase;
+}
+
+bool ms_active(const ModeSwitch* ms)
+{
+    return ms && ms->phase != MS_IDLE;
+}
+
+const char* ms_phase_name(ModeSwitchPhase phase)
+{
+    switch (phase)
+    {
+        case MS_IDLE:      return "idle";
+        case MS_RAMP_DOWN: return "ramp_down";
+        case MS_SETTLE:    return "settle";
+        case MS_SWITCH:    return "switch";
+        case MS_REINIT:    return "reinit";
+        case MS_RAMP_UP:   return "ramp_up";
+        default:           return "?";
+    }
+}
@@ -0,0 +1,119 @@
+// control/sequencer.cpp
+#include "control/sequencer.h"
+#include "system/crc.h"
+
+#include <string.h>
+
+uint32_t seq_crc32(const void* data, size_t len)
+{
+    return crc32_ieee(data, len);
+}
+
+bool seq_validate(const uint8_t* blob, size_t len)
+{
+    if (!blob || len < sizeof(SeqHeader)) return false;
+
+    const SeqHeader* h = (const SeqHeader*)blob;
+    if (h->magic != SEQ_MAGIC || h->version != SEQ_VERSION) return false;
+    if (h->mode > SEQ_MODE_SINK || h->n_segments == 0) return false;
+
+    const size_t seg_bytes = (size_t)h->n_segments * sizeof(SeqSegment);
+    if (len < sizeof(SeqHeader) + seg_bytes) return false;
+
+    const SeqSegment* seg = (const SeqSegment*)(blob + sizeof(SeqHeader));
+    if (seq_crc32(seg, seg_bytes) != h->crc32) return false;
+
+    for (uint16_t i = 0; i < h->n_segments; ++i) {
+        if (seg[i].type > SEQ_SEG_LOOP) return false;
+        if (seg[i].type == SEQ_SEG_LOOP) {
+            // Alleen terug-springen, en er moet een tijdsegment tussen zitten
+            if (seg[i].aux >= i || seg[i].loop_id >= SEQ_MAX_LOOPS) return false;
+            bool has_time = false;
+            for (uint16_t j = seg[i].aux; j < i; ++j)
+                if (seg[j].type != SEQ_SEG_LOOP && seg[j].duration_us > 0) has_time = true;
+            if (!has_time) return false;
+        }
+    }
+    return true;
+}
+
+bool seq_load(Sequencer* s, const uint8_t* blob, size_t len)
+{
+    if (!s) return false;
+    memset(s, 0, sizeof(*s));
+    if (!seq_validate(blob, len)) return false;
+
+    s->hdr = (const SeqHeader*)blob;
+    s->seg = (const SeqSegment*)(blob + sizeof(SeqHeader));
+    return true;
+}
+
+static void enter_segment(Sequencer* s)
+{
+    // LOOP segmenten kosten geen tijd: direct afhandelen
+    while (s->idx < s->hdr->n_segments && s->seg[s->idx].type == SEQ_SEG_LOOP) {
+        const SeqSegment& L = s->seg[s->idx];
+        uint32_t& left = s->loop_left[L.loop_id];
+
+        if (L.value <= 0) {                 // eindeloos
+            s->idx = L.aux;
+            continue;
+        }
+
+        // value = totaal aantal doorlopen van de body; teller staat op 0 als de loop vers is
+        if (left == 0) left = (uint32_t)L.value;
+        if (--left > 0) s->idx = L.aux;
+        else            s->idx++;           // klaar, door naar volgend segment
+    }
+
+    if (s->idx >= s->hdr->n_segments) {
+        s->running = false;
+        return;
+    }
+
+    s->seg_start_value = s->value;
+    if (s->seg[s->idx].type == SEQ_SEG_STEP) s->value = s->seg[s->idx].value;
+}
+
+void seq_start(Sequencer* s, uint32_t t_us, int32_t initial_value)
+{
+    if (!s || !s->hdr) return;
+    memset(s->loop_left, 0, sizeof(s->loop_left));
+    s->idx = 0;
+    s->value = initial_value;
+    s->seg_start_us = t_us;
+    s->running = true;
+    enter_segment(s);
+}
+
+void seq_stop(Sequencer* s)
+{
+    if (s) s->running = false;
+}
+
+int32_t seq_eval(Sequencer* s, uint32_t t_us)
+{
+    if (!s || !s->running) return s ? s->value : 0;
+
+    // Afgeronde segmenten overslaan; begrensd zodat een corrupt profiel de loop niet vasthoudt
+    for (uint32_t guard = 0; guard < 4u * s->hdr->n_segments + 4u; ++guard) {
+        const SeqSegment& g = s->seg[s->idx];
+        const uint32_t elapsed = t_us - s->seg_start_us;
+
+        if (elapsed < g.duration_us) {
+            if (g.type == SEQ_SEG_RAMP) {
+                const int64_t span = (int64_t)g.value - s->seg_start_value;
+                s->value = s->seg_start_value + (int32_t)(span * (int64_t)elapsed / (int64_t)g.duration_us);
+            }
+            return s->value;
+        }
+
+        // Segment afgelopen: eindwaarde vastzetten en door
+        if (g.type == SEQ_SEG_RAMP || g.type == SEQ_SEG_STEP) s->value = g.value;
+        s->seg_start_us += g.duration_us;
+        s->idx++;
+        enter_segment(s);
+        if (!s->running) return s->value;
+    }
+    return s->value;
+}
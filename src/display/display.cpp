@@ -4,16 +4,24 @@
 #include <Adafruit_AW9523.h>
 #include <lvgl.h>
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include <esp_heap_caps.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #include "system/system.h"
+#include "control/control.h"
+#include "ioexpander/ioexpander.h"
+#include "ioexpander/encoder.h"
+#include "ioexpander/enc_accel.h"
+#include "fault/fault.h"
 
 #include "display/ili9488_driver.hpp"
 #include "display/display.h"
 #include "display/ui_screens.hpp"
+#include "display/frame_prof.h"
+#include "display/ui_fmt.h"
 
 // ---------------- BACKLIGHT ----------------
 static Adafruit_AW9523 aw;
@@ -67,63 +75,299 @@ static void backlight_init_and_on()
 }
 
 // ---------------- LVGL DISPLAY PORT ----------------
+static constexpr uint16_t LCD_HOR_RES = 480;
+static constexpr uint16_t LCD_VER_RES = 320;
+
+// Draw-buffer strategieën (RGB565 => 2 bytes/pixel, altijd twee buffers):
+//   INTERNAL  N regels in interne DMA-RAM, partial mode
+//   PSRAM     N regels in PSRAM, partial mode (minder flushes per redraw)
+//   DIRECT    twee full-frame buffers in PSRAM, direct mode: LVGL rendert op de
+//             schermpositie en alleen de ge-invalideerde gebieden gaan de bus op
+// DISPLAY_BUF_BENCH=1 (build flag) meet ze allemaal bij het opstarten.
+enum class DrawBufMode : uint8_t { INTERNAL, PSRAM, DIRECT };
+
+struct DrawBufConfig
+{
+  DrawBufMode mode;
+  uint16_t    lines;
+  const char* name;
+};
+
+static const DrawBufConfig DRAW_BUF_STRATEGIES[] = {
+  { DrawBufMode::INTERNAL, 10,          "intern 10 regels" },
+  { DrawBufMode::INTERNAL, 40,          "intern 40 regels" },
+  { DrawBufMode::PSRAM,    160,         "PSRAM 160 regels" },
+  { DrawBufMode::DIRECT,   LCD_VER_RES, "direct full-frame" },
+};
+static constexpr size_t DRAW_BUF_DEFAULT = 0;   // <-- AANPASSEN (index, zie DISPLAY_BUF_BENCH)
+
+#ifndef DISPLAY_BUF_BENCH
+#define DISPLAY_BUF_BENCH 0
+#endif
+
+// DISPLAY_SWITCH_BENCH=1 (build flag): schermwissels meten bij het opstarten
+#ifndef DISPLAY_SWITCH_BENCH
+#define DISPLAY_SWITCH_BENCH 0
+#endif
+
+// DISPLAY_RENDER_BENCH=1 (build flag): render-tijd per scherm bij het opstarten,
+// voor de vergelijking 1 tegen 2 draw units (LV_DRAW_SW_DRAW_UNIT_CNT, lv_conf.h)
+#ifndef DISPLAY_RENDER_BENCH
+#define DISPLAY_RENDER_BENCH 0
+#endif
+
+static uint8_t* g_draw_buf[2] = { nullptr, nullptr };
+static size_t   g_draw_buf_bytes = 0;
+static bool     g_draw_direct = false;
+
+// Flush start alleen de DMA-transfer; de DMA-ISR meldt flush_ready. LVGL rendert
+// intussen in de andere draw buffer en wacht pas (my_flush_wait_cb) als die vol
+// is terwijl de vorige transfer nog loopt.
+static uint32_t g_frames = 0;
+
+// Door widgets geïnvalideerde pixels (voor samenvoegen door LVGL); maat voor
+// hoeveel de ui*_update-functies laten hertekenen.
+static uint32_t g_inv_px = 0;
+
+static void invalidate_area_cb(lv_event_t* e)
+{
+  const lv_area_t* a = (const lv_area_t*)lv_event_get_param(e);
+  if (a) g_inv_px += (uint32_t)lv_area_get_size(a);
+}
+
+static void IRAM_ATTR flush_done_isr(void* ctx)
+{
+  lv_display_flush_ready((lv_display_t*)ctx);
+}
+
 static void my_flush_cb(lv_display_t* disp_drv, const lv_area_t* area, uint8_t* px_map)
 {
   int32_t w = area->x2 - area->x1 + 1;
   int32_t h = area->y2 - area->y1 + 1;
 
-  ili9488_push_pixels(area->x1, area->y1, w, h, (const uint8_t*)px_map);
-  lv_display_flush_ready(disp_drv);
+  if (lv_display_flush_is_last(disp_drv)) g_frames++;
+  FP_FLUSH_AREA((uint32_t)(w * h));
+  if (g_draw_direct) {
+    // px_map is het hele frame; het gebied staat op zijn schermpositie
+    uint8_t* px = px_map + ((size_t)area->y1 * LCD_HOR_RES + area->x1) * 2u;
+    ili9488_push_rect_async(area->x1, area->y1, w, h, px, LCD_HOR_RES);
+  } else {
+    ili9488_push_pixels_async(area->x1, area->y1, w, h, px_map);
+  }
+}
+
+// Blokkerend wachten (semaphore uit de ISR) i.p.v. LVGL's busy-wait
+static void my_flush_wait_cb(lv_display_t* disp_drv)
+{
+  (void)disp_drv;
+  ili9488_wait_idle();
+}
+
+static void draw_buffers_free()
+{
+  for (uint8_t*& b : g_draw_buf) {
+    if (b) heap_caps_free(b);
+    b = nullptr;
+  }
+  g_draw_buf_bytes = 0;
+}
+
+static bool draw_buffers_apply(const DrawBufConfig& c)
+{
+  // Geen transfer meer uit de oude buffers
+  ili9488_wait_idle();
+  draw_buffers_free();
+
+  const uint16_t lines = (c.mode == DrawBufMode::DIRECT) ? LCD_VER_RES : c.lines;
+  const size_t buf_bytes = (size_t)LCD_HOR_RES * lines * 2u;
+
+  // Intern: 32-byte aligned + DMA-capable. PSRAM: 64-byte aligned (GDMA-burst, cache-regel).
+  const bool psram = (c.mode != DrawBufMode::INTERNAL);
+  const uint32_t caps = psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  const size_t align = psram ? 64 : 32;
+  for (uint8_t*& b : g_draw_buf) b = (uint8_t*)heap_caps_aligned_alloc(align, buf_bytes, caps);
+
+  if (!g_draw_buf[0] || !g_draw_buf[1]) {
+    Serial.printf("draw buffers '%s': alloc van 2x %u bytes mislukt\n", c.name, (unsigned)buf_bytes);
+    draw_buffers_free();
+    return false;
+  }
+  g_draw_buf_bytes = buf_bytes;
+
+  // Direct mode: LVGL houdt de buffers als framebuffer, dus geen in-place omzetting
+  g_draw_direct = (c.mode == DrawBufMode::DIRECT);
+  if (g_draw_direct) ili9488_set_pixel_path(ILI9488_PX_NATIVE);
+
+  lv_display_set_buffers(disp, g_draw_buf[0], g_draw_buf[1], buf_bytes,
+                         g_draw_direct ? LV_DISPLAY_RENDER_MODE_DIRECT : LV_DISPLAY_RENDER_MODE_PARTIAL);
+  lv_obj_invalidate(lv_screen_active());
+
+  Serial.printf("draw buffers '%s': 2x %u bytes in %s, vrij intern %u, PSRAM %u\n",
+                c.name, (unsigned)buf_bytes, psram ? "PSRAM" : "interne RAM",
+                (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+  return true;
 }
 
 static void lvgl_port_init()
 {
   Serial.println("lvgl_port_init: start");
 
-  const uint16_t hor_res = 480;
-  const uint16_t ver_res = 320;
-
-  disp = lv_display_create(hor_res, ver_res);
+  disp = lv_display_create(LCD_HOR_RES, LCD_VER_RES);
   if (!disp) {
     Serial.println("ERROR: lv_display_create failed");
     return;
   }
 
-  lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+  // Big-endian RGB565 + INVON: de render buffer is byte voor byte wat op de bus gaat
+  lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565_SWAPPED);
+  ili9488_set_pixel_path(ILI9488_PX_NATIVE);
   lv_display_set_flush_cb(disp, my_flush_cb);
+  lv_display_set_flush_wait_cb(disp, my_flush_wait_cb);
+  ili9488_set_done_cb(flush_done_isr, disp);
+  lv_display_add_event_cb(disp, invalidate_area_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+
+  // ---- Draw buffers ----
+  if (!draw_buffers_apply(DRAW_BUF_STRATEGIES[DRAW_BUF_DEFAULT]) &&
+      !draw_buffers_apply(DRAW_BUF_STRATEGIES[0])) {
+    Serial.println("ERROR: draw buffer alloc failed");
+    return;
+  }
+
+  Serial.println("lvgl_port_init: done");
+}
+
+// LVGL-heap (LV_STDLIB_BUILTIN, LV_MEM_SIZE in lv_conf.h)
+static void print_lv_heap(const char* tag)
+{
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  Serial.printf("%s: LVGL heap %u/%u B gebruikt (max %u, grootste vrije blok %u, frag %u%%)\n", tag,
+                (unsigned)(mon.total_size - mon.free_size), (unsigned)mon.total_size,
+                (unsigned)mon.max_used, (unsigned)mon.free_biggest_size, (unsigned)mon.frag_pct);
+}
 
-  // ---- Draw buffers (RGB565 => 2 bytes/pixel) ----
-  static const uint16_t DRAW_BUF_LINES = 10;
-  const size_t buf_pixels = (size_t)hor_res * (size_t)DRAW_BUF_LINES;
-  const size_t buf_bytes  = buf_pixels * 2; // RGB565
+#if DISPLAY_BUF_BENCH || DISPLAY_SWITCH_BENCH || DISPLAY_RENDER_BENCH
+// Frame-tijd = lv_refr_now tot en met de laatste DMA-transfer
+struct RefrResult { uint32_t us; uint32_t flushes; };
 
-  // 32-byte aligned + DMA-capable (veiligste keuze op ESP32 voor SPI flush)
-  uint16_t* buf1 = (uint16_t*)heap_caps_aligned_alloc(32, buf_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-  uint16_t* buf2 = (uint16_t*)heap_caps_aligned_alloc(32, buf_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+static RefrResult bench_refresh()
+{
+  Ili9488Stats a, b;
+  ili9488_get_stats(&a);
+  const int64_t t0 = esp_timer_get_time();
+  lv_refr_now(disp);
+  ili9488_wait_idle();
+  const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  ili9488_get_stats(&b);
+  return RefrResult{ us, b.n_push - a.n_push };
+}
+#endif
 
-  Serial.printf("buf_bytes=%u heap=%lu buf1=%p buf2=%p\n",
-                (unsigned)buf_bytes, (unsigned long)ESP.getFreeHeap(), buf1, buf2);
+#if DISPLAY_BUF_BENCH
+// ---------------- Draw-buffer benchmark ----------------
+// Per strategie en per scherm: een schermwissel (volledige redraw) en een update
+// van de meetwaarden (kleine gebieden).
 
-  if (!buf1 || !buf2) {
-    Serial.println("ERROR: draw buffer alloc failed");
-    if (buf1) heap_caps_free(buf1);
-    if (buf2) heap_caps_free(buf2);
-    return;
+static void display_bench_buffers()
+{
+  static void (*const LOAD[3])() = { ui1_load, ui2_load, ui3_load };
+  static void (*const UPDATE[3])(const DisplayModel&) = { ui1_update, ui2_update, ui3_update };
+
+  Serial.println("draw buffer bench: strategie | scherm | wissel ms (flushes) | update ms (flushes)");
+  for (const DrawBufConfig& c : DRAW_BUF_STRATEGIES) {
+    if (!draw_buffers_apply(c)) continue;
+
+    for (int k = 0; k < 3; ++k) {
+      LOAD[k]();
+      const RefrResult sw = bench_refresh();
+
+      // Andere meetwaarden: alleen de labels/curve die veranderen worden ververst
+      g_model.ui1.voltage_mv += 1234; g_model.ui1.current_ma += 567; g_model.ui1.runtime_sec += 61;
+      g_model.ui2.set_mv += 1100;     g_model.ui2.meas_ma += 330;
+      g_model.ui3.set_ma += 700;      g_model.ui3.meas_mv += 2200;
+      UPDATE[k](g_model);
+      const RefrResult up = bench_refresh();
+
+      Serial.printf("  %-18s | UI%d | %7.2f (%3u) | %7.2f (%3u)\n", c.name, k + 1,
+                    sw.us * 1e-3, (unsigned)sw.flushes, up.us * 1e-3, (unsigned)up.flushes);
+    }
   }
 
-  Serial.println("lvgl_port_init: before set_buffers");
+  if (!draw_buffers_apply(DRAW_BUF_STRATEGIES[DRAW_BUF_DEFAULT])) draw_buffers_apply(DRAW_BUF_STRATEGIES[0]);
+}
+#endif
 
-  lv_display_set_buffers(
-      disp,
-      buf1,
-      buf2,
-      buf_bytes,                        // SIZE IN BYTES
-      LV_DISPLAY_RENDER_MODE_PARTIAL
-  );
+#if DISPLAY_SWITCH_BENCH
+// ---------------- Schermwissel-benchmark ----------------
+// Rondjes UI1 -> UI2 -> UI3: tijd van ui*_load alleen en van load + volledige
+// redraw, en de LVGL-heap voor en na (moet gelijk blijven: geen lek per wissel).
+static void display_bench_switch()
+{
+  static void (*const LOAD[3])() = { ui1_load, ui2_load, ui3_load };
+  static const int N = 60;
+
+  print_lv_heap("switch bench voor");
+  uint32_t load_sum = 0, load_max = 0, tot_sum = 0, tot_max = 0;
+  for (int i = 0; i < N; ++i) {
+    const int64_t t0 = esp_timer_get_time();
+    LOAD[(i + 1) % 3]();
+    const uint32_t load_us = (uint32_t)(esp_timer_get_time() - t0);
+    const uint32_t tot_us = load_us + bench_refresh().us;
+
+    load_sum += load_us;
+    tot_sum += tot_us;
+    if (load_us > load_max) load_max = load_us;
+    if (tot_us > tot_max) tot_max = tot_us;
+  }
+  Serial.printf("switch bench: %d wissels, load gem %u / max %u us, load+redraw gem %u / max %u us\n",
+                N, (unsigned)(load_sum / N), (unsigned)load_max, (unsigned)(tot_sum / N), (unsigned)tot_max);
+  print_lv_heap("switch bench na");
+}
+#endif
+
+#if DISPLAY_RENDER_BENCH
+// ---------------- Render-benchmark ----------------
+// Volledige redraw per scherm: eerst zonder bus (flush meldt meteen klaar, dus
+// pure render-tijd van LVGL en zijn draw units), dan met de echte flush (tot de
+// laatste DMA-transfer). Eén build met -DLV_DRAW_SW_DRAW_UNIT_CNT=1, één zonder.
+static void bench_null_flush(lv_display_t* d, const lv_area_t* area, uint8_t* px_map)
+{
+  (void)area;
+  (void)px_map;
+  lv_display_flush_ready(d);
+}
 
-  Serial.println("lvgl_port_init: after set_buffers");
-  Serial.println("lvgl_port_init: done");
+static void display_bench_render()
+{
+  static void (*const LOAD[3])() = { ui1_load, ui2_load, ui3_load };
+  static const int N = 10;
+
+  Serial.printf("render bench: %d draw unit(s), draw buffer 2x %u bytes%s\n", (int)LV_DRAW_SW_DRAW_UNIT_CNT,
+                (unsigned)g_draw_buf_bytes, g_draw_direct ? " (direct)" : "");
+  Serial.println("render bench: scherm | render ms min/gem | met flush ms gem");
+  for (int k = 0; k < 3; ++k) {
+    LOAD[k]();
+    (void)bench_refresh();   // opwarmen (glyph cache, layout)
+
+    uint32_t r_min = UINT32_MAX, r_sum = 0, f_sum = 0;
+    for (int i = 0; i < N; ++i) {
+      lv_display_set_flush_cb(disp, bench_null_flush);
+      lv_obj_invalidate(lv_screen_active());
+      const int64_t t0 = esp_timer_get_time();
+      lv_refr_now(disp);
+      const uint32_t r = (uint32_t)(esp_timer_get_time() - t0);
+      lv_display_set_flush_cb(disp, my_flush_cb);
+
+      lv_obj_invalidate(lv_screen_active());
+      f_sum += bench_refresh().us;
+      r_sum += r;
+      if (r < r_min) r_min = r;
+    }
+    Serial.printf("  UI%d | %6.2f / %6.2f | %6.2f\n", k + 1, r_min * 1e-3, r_sum * 1e-3 / N, f_sum * 1e-3 / N);
+  }
 }
+#endif
 
 // ---------------- Curve select -> model ----------------
 static void select_curve_into_model(UI1Model& ui1, const SystemSnapshot& s)
@@ -154,23 +398,23 @@ static void model_from_system(DisplayModel& m, const SystemSnapshot& s)
 
   // UI1 (Emulate)
   select_curve_into_model(m.ui1, s);
-  m.ui1.voltage_val      = vout;
-  m.ui1.current_val      = current;
-  m.ui1.runtime_sec      = (uint32_t)(millis() / 1000);
-  m.ui1.capacity_val     = s.ui.capacity_value;
-  m.ui1.state_load       = (s.status.mode_current == POWER_MODE_SINK);
-  m.ui1.nominal_v_val    = s.ui.nominal_voltage;
-  m.ui1.btn_capacity_val = s.ui.capacity_value;
+  m.ui1.voltage_mv     = ui_milli(vout);
+  m.ui1.current_ma     = ui_milli(current);
+  m.ui1.runtime_sec    = (uint32_t)(millis() / 1000);
+  m.ui1.capacity_m     = ui_milli(s.ui.capacity_value);
+  m.ui1.state_load     = (s.status.mode_current == POWER_MODE_SINK);
+  m.ui1.nominal_mv     = ui_milli(s.ui.nominal_voltage);
+  m.ui1.btn_capacity_m = ui_milli(s.ui.capacity_value);
 
   // UI2 (Const Source)
-  m.ui2.set_voltage = s.ui.ui2_set_voltage;
-  m.ui2.meas_ampere = current;
-  m.ui2.vmax        = 15.0f;
+  m.ui2.set_mv  = ui_milli(s.ui.ui2_set_voltage);
+  m.ui2.meas_ma = ui_milli(current);
+  m.ui2.vmax_mv = 15000;
 
   // UI3 (Const Sink)
-  m.ui3.set_ampere   = s.ui.ui3_set_current;
-  m.ui3.meas_voltage = vout;
-  m.ui3.imax         = 10.0f; // placeholder
+  m.ui3.set_ma  = ui_milli(s.ui.ui3_set_current);
+  m.ui3.meas_mv = ui_milli(vout);
+  m.ui3.imax_ma = 10000; // placeholder
 }
 
 // ---------------- UI create switch ----------------
@@ -183,6 +427,9 @@ static void clear_all_softkeys()
 
 static void switch_ui_if_needed(UiScreen requested)
 {
+  // Fout-scherm is een overlay over het huidige scherm (zie update_error_overlay)
+  if (requested == UI_SCREEN_ERROR) return;
+
   ActiveUI desired = current_ui;
 
   if (requested == UI_SCREEN_EMULATE) desired = ActiveUI::UI1;
@@ -194,13 +441,22 @@ static void switch_ui_if_needed(UiScreen requested)
 
   current_ui = desired;
   clear_all_softkeys();
+
+  // Scherm bepaalt de mode; ControlTask voert de wissel uit (ramp, relais, ramp)
+  system_request_mode(current_ui == ActiveUI::UI3 ? POWER_MODE_SINK :
+                      current_ui == ActiveUI::UI2 ? POWER_MODE_SOURCE : POWER_MODE_EMULATE);
   ui_overlay_hide();
 
+  // Schermen bestaan al (ui_screens_init): alleen laden, de redraw volgt in lv_timer_handler
+  const int64_t t0 = esp_timer_get_time();
   switch (current_ui) {
-    case ActiveUI::UI1: ui1_create(); break;
-    case ActiveUI::UI2: ui2_create(); break;
-    case ActiveUI::UI3: ui3_create(); break;
+    case ActiveUI::UI1: ui1_load(); break;
+    case ActiveUI::UI2: ui2_load(); break;
+    case ActiveUI::UI3: ui3_load(); break;
   }
+  Serial.printf("display: wissel naar UI%d, load %u us\n", (int)current_ui + 1,
+                (unsigned)(esp_timer_get_time() - t0));
+  print_lv_heap("display");
 }
 
 // ---------------- Edit context ----------------
@@ -240,6 +496,44 @@ static UiEditField map_edit_field(EditField f)
   }
 }
 
+// Titel + waarderegel van de edit-overlay; nullptr als er niets te editen valt
+static const UiFmt FMT_EDIT_V = { nullptr, 1, " V" };
+static const UiFmt FMT_EDIT_A = { nullptr, 1, " A" };
+static const UiFmt FMT_EDIT_F = { nullptr, 1, " F" };
+
+static const char* edit_field_text(EditField field, const UIShared& ui, char* value, size_t cap)
+{
+  switch (field)
+  {
+    case EditField::UI1_CURVE:
+      ui_fmt_uint(value, cap, "Curve: ", ui.selected_curve_id);
+      return "Choose Curve";
+    case EditField::UI1_START_INDEX:
+      ui_fmt_uint(value, cap, "Start index: ", ui.start_index);
+      return "Choose Setpoint";
+    case EditField::UI1_NOMINAL_V:
+      ui_fmt_fixed(value, cap, FMT_EDIT_V, ui_milli(ui.nominal_voltage));
+      return "Nominal voltage";
+    case EditField::UI1_CAPACITY:
+      ui_fmt_fixed(value, cap, FMT_EDIT_F, ui_milli(ui.capacity_value));
+      return "Capacity";
+    case EditField::UI2_SET_V:
+      ui_fmt_fixed(value, cap, FMT_EDIT_V, ui_milli(ui.ui2_set_voltage));
+      return "Voltage";
+    case EditField::UI2_I_LIMIT:
+      ui_fmt_fixed(value, cap, FMT_EDIT_A, ui_milli(ui.ui2_current_limit));
+      return "Current limit";
+    case EditField::UI3_SET_I:
+      ui_fmt_fixed(value, cap, FMT_EDIT_A, ui_milli(ui.ui3_set_current));
+      return "Ampere";
+    case EditField::UI3_V_LIMIT:
+      ui_fmt_fixed(value, cap, FMT_EDIT_V, ui_milli(ui.ui3_voltage_limit));
+      return "Voltage limit";
+    default:
+      return nullptr;
+  }
+}
+
 static void begin_edit(EditField field, int softkey_idx, const SystemSnapshot& s)
 {
   g_edit_field = field;
@@ -267,55 +561,19 @@ static void begin_edit(EditField field, int softkey_idx, const SystemSnapshot& s
 
   // Overlay
   const char* hint = "Draai: wijzig | Press: OK | Long: Cancel";
-  char title[32];
-  char value[48];
-  title[0] = 0; value[0] = 0;
-
-  switch (field)
-  {
-    case EditField::UI1_CURVE:
-      snprintf(title, sizeof(title), "Choose Curve");
-      snprintf(value, sizeof(value), "Curve: %u", (unsigned)s.ui.selected_curve_id);
-      break;
-    case EditField::UI1_START_INDEX:
-      snprintf(title, sizeof(title), "Choose Setpoint");
-      snprintf(value, sizeof(value), "Start index: %u", (unsigned)s.ui.start_index);
-      break;
-    case EditField::UI1_NOMINAL_V:
-      snprintf(title, sizeof(title), "Nominal voltage");
-      snprintf(value, sizeof(value), "%.1f V", (double)s.ui.nominal_voltage);
-      break;
-    case EditField::UI1_CAPACITY:
-      snprintf(title, sizeof(title), "Capacity");
-      snprintf(value, sizeof(value), "%.1f F", (double)s.ui.capacity_value);
-      break;
-    case EditField::UI2_SET_V:
-      snprintf(title, sizeof(title), "Voltage");
-      snprintf(value, sizeof(value), "%.1f V", (double)s.ui.ui2_set_voltage);
-      break;
-    case EditField::UI2_I_LIMIT:
-      snprintf(title, sizeof(title), "Current limit");
-      snprintf(value, sizeof(value), "%.1f A", (double)s.ui.ui2_current_limit);
-      break;
-    case EditField::UI3_SET_I:
-      snprintf(title, sizeof(title), "Ampere");
-      snprintf(value, sizeof(value), "%.1f A", (double)s.ui.ui3_set_current);
-      break;
-    case EditField::UI3_V_LIMIT:
-      snprintf(title, sizeof(title), "Voltage limit");
-      snprintf(value, sizeof(value), "%.1f V", (double)s.ui.ui3_voltage_limit);
-      break;
-    default:
-      snprintf(title, sizeof(title), "Edit");
-      snprintf(value, sizeof(value), "");
-      break;
+  char value[UI_FMT_MAX];
+  const char* title = edit_field_text(field, s.ui, value, sizeof(value));
+  if (!title) {
+    title = "Edit";
+    value[0] = 0;
   }
 
   ui_overlay_show(title, value, hint);
 
   // event naar ControlTask (later)
+  // Edit-flags sluiten elkaar uit: STARTED staat precies zolang er ge-edit wordt
   UIEvents ev = s.ui_events;
-  ev.flags |= UI_EVT_EDIT_STARTED;
+  ev.flags = (ev.flags & ~(UI_EVT_EDIT_CONFIRMED | UI_EVT_EDIT_CANCELLED)) | UI_EVT_EDIT_STARTED;
   ev.field = map_edit_field(field);
   ev.seq++;
   system_write_ui_events(&ev);
@@ -342,7 +600,7 @@ static void end_edit(bool keep_values, const SystemSnapshot& s)
     system_write_ui_shared(&ui);
 
     UIEvents ev = s.ui_events;
-    ev.flags |= UI_EVT_EDIT_CANCELLED;
+    ev.flags = (ev.flags & ~UI_EVT_EDIT_STARTED) | UI_EVT_EDIT_CANCELLED;
     ev.field = map_edit_field(g_edit_field);
     ev.seq++;
     system_write_ui_events(&ev);
@@ -350,7 +608,7 @@ static void end_edit(bool keep_values, const SystemSnapshot& s)
   else
   {
     UIEvents ev = s.ui_events;
-    ev.flags |= UI_EVT_EDIT_CONFIRMED;
+    ev.flags = (ev.flags & ~UI_EVT_EDIT_STARTED) | UI_EVT_EDIT_CONFIRMED;
     ev.field = map_edit_field(g_edit_field);
     ev.seq++;
     system_write_ui_events(&ev);
@@ -373,47 +631,9 @@ static float clampf(float v, float lo, float hi)
 static void update_overlay_value(EditField field, const UIShared& ui)
 {
   const char* hint = "Draai: wijzig | Press: OK | Long: Cancel";
-  char title[32];
-  char value[48];
-  title[0] = 0; value[0] = 0;
-
-  switch (field)
-  {
-    case EditField::UI1_CURVE:
-      snprintf(title, sizeof(title), "Choose Curve");
-      snprintf(value, sizeof(value), "Curve: %u", (unsigned)ui.selected_curve_id);
-      break;
-    case EditField::UI1_START_INDEX:
-      snprintf(title, sizeof(title), "Choose Setpoint");
-      snprintf(value, sizeof(value), "Start index: %u", (unsigned)ui.start_index);
-      break;
-    case EditField::UI1_NOMINAL_V:
-      snprintf(title, sizeof(title), "Nominal voltage");
-      snprintf(value, sizeof(value), "%.1f V", (double)ui.nominal_voltage);
-      break;
-    case EditField::UI1_CAPACITY:
-      snprintf(title, sizeof(title), "Capacity");
-      snprintf(value, sizeof(value), "%.1f F", (double)ui.capacity_value);
-      break;
-    case EditField::UI2_SET_V:
-      snprintf(title, sizeof(title), "Voltage");
-      snprintf(value, sizeof(value), "%.1f V", (double)ui.ui2_set_voltage);
-      break;
-    case EditField::UI2_I_LIMIT:
-      snprintf(title, sizeof(title), "Current limit");
-      snprintf(value, sizeof(value), "%.1f A", (double)ui.ui2_current_limit);
-      break;
-    case EditField::UI3_SET_I:
-      snprintf(title, sizeof(title), "Ampere");
-      snprintf(value, sizeof(value), "%.1f A", (double)ui.ui3_set_current);
-      break;
-    case EditField::UI3_V_LIMIT:
-      snprintf(title, sizeof(title), "Voltage limit");
-      snprintf(value, sizeof(value), "%.1f V", (double)ui.ui3_voltage_limit);
-      break;
-    default:
-      return;
-  }
+  char value[UI_FMT_MAX];
+  const char* title = edit_field_text(field, ui, value, sizeof(value));
+  if (!title) return;
 
   ui_overlay_update(title, value, hint);
 }
@@ -448,33 +668,61 @@ static void do_reset_for_current_ui(const SystemSnapshot& s)
   system_write_ui_events(&ev);
 }
 
-static bool pressed(uint32_t changed_bits, uint32_t raw_bits, uint32_t mask)
+// ---------------- Input events (ioexpander queue) ----------------
+static IoEventCursor g_io_cursor;
+
+// Latency knop -> foton: flanktijd van het eerste verwerkte event tot de laatste
+// DMA-transfer van de frame die het toont (paneel-GRAM bijgewerkt; de scan van
+// het paneel zelf, hooguit één beeld, is hier niet te meten)
+static uint32_t g_lat_pending_t_us = 0;
+static uint32_t g_lat_n = 0, g_lat_min_us = UINT32_MAX, g_lat_max_us = 0;
+static uint64_t g_lat_sum_us = 0;
+
+static void input_latency_rendered()
 {
-  return (changed_bits & mask) && (raw_bits & mask);
+  if (g_lat_pending_t_us == 0) return;
+  ili9488_wait_idle();   // alleen in rondes met input
+  const uint32_t lat = (uint32_t)esp_timer_get_time() - g_lat_pending_t_us;
+  g_lat_pending_t_us = 0;
+
+  g_lat_n++;
+  g_lat_sum_us += lat;
+  if (lat < g_lat_min_us) g_lat_min_us = lat;
+  if (lat > g_lat_max_us) g_lat_max_us = lat;
+
+  if (g_lat_n >= 16) {
+    Serial.printf("display: input->foton latency %.1f/%.1f/%.1f ms (min/gem/max, %u events, %u verloren)\n",
+                  g_lat_min_us * 1e-3, (double)g_lat_sum_us / g_lat_n * 1e-3, g_lat_max_us * 1e-3,
+                  (unsigned)g_lat_n, (unsigned)g_io_cursor.lost);
+    g_lat_n = 0;
+    g_lat_sum_us = 0;
+    g_lat_min_us = UINT32_MAX;
+    g_lat_max_us = 0;
+  }
 }
 
-static void handle_inputs(const SystemSnapshot& s)
+// Event -> display-knopbit (0 = niet voor de display)
+static uint32_t event_to_button(const IoEvent& ev)
 {
-  // Alleen in CONFIG nemen we UI-input over
-  if (s.status.state != SYS_STATE_CONFIG)
-  {
-    if (g_edit_field != EditField::NONE)
-      end_edit(true, s);
-    return;
+  const uint32_t bit = 1u << ev.button;
+  if (bit == BTN_ENC_PRESS) {
+    if (ev.type == IO_EVT_CLICK) return BTN_ENC_PRESS;
+    if (ev.type == IO_EVT_LONG)  return BTN_ENC_LONG;
+    return 0;
   }
+  return (ev.type == IO_EVT_PRESS) ? (bit & DISPLAY_BTN_MASK) : 0;
+}
 
-  const uint32_t changed = s.io.buttons_changed_bits & DISPLAY_BTN_MASK;
-  const uint32_t raw     = s.io.buttons_raw_bits & DISPLAY_BTN_MASK;
-  const int32_t  enc_delta = s.io.enc_delta_accum;
-
-  const bool soft1 = pressed(changed, raw, BTN_SOFT_1);
-  const bool soft2 = pressed(changed, raw, BTN_SOFT_2);
-  const bool soft3 = pressed(changed, raw, BTN_SOFT_3);
-  const bool soft4 = pressed(changed, raw, BTN_SOFT_4);
-  const bool soft5 = pressed(changed, raw, BTN_SOFT_5);
+static void handle_button(uint32_t button, const SystemSnapshot& s)
+{
+  const bool soft1 = (button == BTN_SOFT_1);
+  const bool soft2 = (button == BTN_SOFT_2);
+  const bool soft3 = (button == BTN_SOFT_3);
+  const bool soft4 = (button == BTN_SOFT_4);
+  const bool soft5 = (button == BTN_SOFT_5);
 
-  const bool enc_press = pressed(changed, raw, BTN_ENC_PRESS);
-  const bool enc_long  = pressed(changed, raw, BTN_ENC_LONG);
+  const bool enc_press = (button == BTN_ENC_PRESS);
+  const bool enc_long  = (button == BTN_ENC_LONG);
 
   // 1) Start edit als we nog niet editten
   if (g_edit_field == EditField::NONE)
@@ -492,11 +740,13 @@ static void handle_inputs(const SystemSnapshot& s)
     {
       if (soft1) begin_edit(EditField::UI2_SET_V, 0, s);
       else if (soft2) begin_edit(EditField::UI2_I_LIMIT, 1, s);
+      else if (soft3) control_request_autotune();
     }
     else if (current_ui == ActiveUI::UI3)
     {
       if (soft1) begin_edit(EditField::UI3_SET_I, 0, s);
       else if (soft2) begin_edit(EditField::UI3_V_LIMIT, 1, s);
+      else if (soft3) control_request_autotune();
     }
   }
   else
@@ -506,96 +756,208 @@ static void handle_inputs(const SystemSnapshot& s)
       end_edit(false, s);
     } else if (enc_press) {
       end_edit(true, s);
-    } else if (enc_delta != 0) {
-      // 3) Encoder adjust
-      UIShared ui = s.ui;
-      bool changed_any = false;
-
-      switch (g_edit_field)
-      {
-        case EditField::UI1_CURVE:
-        {
-          int v = (int)ui.selected_curve_id + (enc_delta > 0 ? 1 : -1);
-          if (v < 0) v = 2;
-          if (v > 2) v = 0;
-          ui.selected_curve_id = (uint8_t)v;
-          changed_any = true;
-        } break;
-
-        case EditField::UI1_START_INDEX:
-        {
-          int v = (int)ui.start_index + enc_delta;
-          if (v < 0) v = 0;
-          if (v > (CURVE_LEN - 1)) v = (CURVE_LEN - 1);
-          ui.start_index = (uint8_t)v;
-          changed_any = true;
-        } break;
-
-        case EditField::UI1_NOMINAL_V:
-        {
-          float v = ui.nominal_voltage + 0.1f * (float)enc_delta;
-          ui.nominal_voltage = clampf(v, 0.0f, 15.0f);
-          changed_any = true;
-        } break;
-
-        case EditField::UI1_CAPACITY:
-        {
-          float v = ui.capacity_value + 0.1f * (float)enc_delta;
-          ui.capacity_value = clampf(v, 0.0f, 9999.9f);
-          changed_any = true;
-        } break;
-
-        case EditField::UI2_SET_V:
-        {
-          float v = ui.ui2_set_voltage + 0.1f * (float)enc_delta;
-          ui.ui2_set_voltage = clampf(v, 0.0f, 15.0f);
-          changed_any = true;
-        } break;
-
-        case EditField::UI2_I_LIMIT:
-        {
-          float v = ui.ui2_current_limit + 0.1f * (float)enc_delta;
-          ui.ui2_current_limit = clampf(v, 0.0f, 10.0f);
-          changed_any = true;
-        } break;
-
-        case EditField::UI3_SET_I:
-        {
-          float v = ui.ui3_set_current + 0.1f * (float)enc_delta;
-          ui.ui3_set_current = clampf(v, 0.0f, 10.0f);
-          changed_any = true;
-        } break;
-
-        case EditField::UI3_V_LIMIT:
-        {
-          float v = ui.ui3_voltage_limit + 0.1f * (float)enc_delta;
-          ui.ui3_voltage_limit = clampf(v, 0.0f, 15.0f);
-          changed_any = true;
-        } break;
-
-        default: break;
-      }
+    }
+  }
+}
 
-      if (changed_any)
-      {
-        system_write_ui_shared(&ui);
-        update_overlay_value(g_edit_field, ui);
+static void handle_encoder(int32_t enc_delta, const SystemSnapshot& s)
+{
+  if (g_edit_field == EditField::NONE || enc_delta == 0) return;
 
-        UIEvents ev = s.ui_events;
-        ev.flags |= UI_EVT_PARAM_CHANGED;
-        ev.field = map_edit_field(g_edit_field);
-        ev.seq++;
-        system_write_ui_events(&ev);
-      }
+  // 3) Encoder adjust
+  UIShared ui = s.ui;
+  bool changed_any = false;
+
+  switch (g_edit_field)
+  {
+    case EditField::UI1_CURVE:
+    {
+      int v = (int)ui.selected_curve_id + (enc_delta > 0 ? 1 : -1);
+      if (v < 0) v = 2;
+      if (v > 2) v = 0;
+      ui.selected_curve_id = (uint8_t)v;
+      changed_any = true;
+    } break;
+
+    case EditField::UI1_START_INDEX:
+    {
+      int v = (int)ui.start_index + enc_delta;
+      if (v < 0) v = 0;
+      if (v > (CURVE_LEN - 1)) v = (CURVE_LEN - 1);
+      ui.start_index = (uint8_t)v;
+      changed_any = true;
+    } break;
+
+    case EditField::UI1_NOMINAL_V:
+    {
+      float v = ui.nominal_voltage + 0.1f * (float)enc_delta;
+      ui.nominal_voltage = clampf(v, 0.0f, 15.0f);
+      changed_any = true;
+    } break;
+
+    case EditField::UI1_CAPACITY:
+    {
+      float v = ui.capacity_value + 0.1f * (float)enc_delta;
+      ui.capacity_value = clampf(v, 0.0f, 9999.9f);
+      changed_any = true;
+    } break;
+
+    case EditField::UI2_SET_V:
+    {
+      float v = ui.ui2_set_voltage + 0.1f * (float)enc_delta;
+      ui.ui2_set_voltage = clampf(v, 0.0f, 15.0f);
+      changed_any = true;
+    } break;
+
+    case EditField::UI2_I_LIMIT:
+    {
+      float v = ui.ui2_current_limit + 0.1f * (float)enc_delta;
+      ui.ui2_current_limit = clampf(v, 0.0f, 10.0f);
+      changed_any = true;
+    } break;
+
+    case EditField::UI3_SET_I:
+    {
+      float v = ui.ui3_set_current + 0.1f * (float)enc_delta;
+      ui.ui3_set_current = clampf(v, 0.0f, 10.0f);
+      changed_any = true;
+    } break;
+
+    case EditField::UI3_V_LIMIT:
+    {
+      float v = ui.ui3_voltage_limit + 0.1f * (float)enc_delta;
+      ui.ui3_voltage_limit = clampf(v, 0.0f, 15.0f);
+      changed_any = true;
+    } break;
+
+    default: break;
+  }
+
+  if (changed_any)
+  {
+    system_write_ui_shared(&ui);
+    update_overlay_value(g_edit_field, ui);
+
+    UIEvents ev = s.ui_events;
+    ev.flags |= UI_EVT_PARAM_CHANGED;
+    ev.field = map_edit_field(g_edit_field);
+    ev.seq++;
+    system_write_ui_events(&ev);
+  }
+}
+
+// ---------------- Encoder (PCNT + versnelling) ----------------
+static EncAccel       g_enc;
+static EncAccelConfig g_enc_cfg;
+
+// Max vermenigvuldiger per veld: grote bereiken versnellen, kleine niet
+static uint32_t enc_max_mult(EditField f)
+{
+  switch (f)
+  {
+    case EditField::UI1_CURVE:       return 1;
+    case EditField::UI1_START_INDEX: return 4;
+    case EditField::UI1_CAPACITY:    return 1000;
+    default:                         return 10;  // spanning/stroom in 0.1-stappen
+  }
+}
+
+static int32_t encoder_steps(void)
+{
+  uint32_t t_us = 0;
+  const int32_t detents = encoder_detents(&t_us);
+  return enc_accel_update(&g_enc, &g_enc_cfg, detents, t_us, enc_max_mult(g_edit_field));
+}
+
+// Input die nog verwerkt moet worden (knopevent of encoderdetent), zonder te consumeren
+static bool input_pending()
+{
+  return io_event_pending(&g_io_cursor) || encoder_detents(nullptr) != g_enc.last_detents;
+}
+
+static void handle_inputs(const SystemSnapshot& s)
+{
+  IoEvent ev;
+
+  // Alleen in CONFIG nemen we UI-input over
+  if (s.status.state != SYS_STATE_CONFIG)
+  {
+    while (io_event_pop(&g_io_cursor, &ev)) {}
+    (void)encoder_steps();   // detents buiten CONFIG weggooien
+    if (g_edit_field != EditField::NONE)
+      end_edit(true, s);
+    return;
+  }
+
+  // Elk event apart: twee drukken binnen één loop blijven twee drukken
+  while (io_event_pop(&g_io_cursor, &ev))
+  {
+    const uint32_t button = event_to_button(ev);
+    if (!button) continue;
+
+    SystemSnapshot cur;
+    system_read_snapshot(&cur);
+    handle_button(button, cur);
+    if (g_lat_pending_t_us == 0) g_lat_pending_t_us = ev.t_us ? ev.t_us : 1;
+  }
+
+  // Detents altijd consumeren, ook buiten een edit (geen sprong bij begin_edit)
+  const int32_t enc_steps = encoder_steps();
+  if (enc_steps != 0) {
+    SystemSnapshot cur;
+    system_read_snapshot(&cur);
+    handle_encoder(enc_steps, cur);
+  }
+
+  // Legacy bits: display gebruikt de event queue
+  if (s.io.buttons_changed_bits & DISPLAY_BTN_MASK) system_io_clear_buttons_changed(DISPLAY_BTN_MASK);
+}
+
+// ---------------- Fout-scherm (UI_SCREEN_ERROR) ----------------
+static bool     g_err_shown = false;
+static uint32_t g_err_key = 0;
+
+static void update_error_overlay(const SystemSnapshot& s)
+{
+  if (s.ui.active_screen != UI_SCREEN_ERROR) {
+    if (g_err_shown) {
+      ui_overlay_hide();
+      g_err_shown = false;
     }
+    return;
   }
 
-  // Consume inputs die display verwerkt
-  if (changed) system_io_clear_buttons_changed(DISPLAY_BTN_MASK);
-  if (enc_delta != 0) system_io_clear_enc_delta();
+  const uint32_t bits = s.status.fault_current_bits | s.status.fault_latched_bits;
+  const bool active = (s.status.fault_current_bits & FAULT_SHUTDOWN_BITS) != 0;
+  const uint32_t key = bits | (active ? 0x80000000u : 0u);
+  if (g_err_shown && key == g_err_key && ui_overlay_is_visible()) return;
+
+  char value[48];
+  size_t n = 0;
+  value[0] = 0;
+  for (int id = 0; id < FID_COUNT; ++id) {
+    const FaultDef* d = fm_def((FaultId)id);
+    if (!(bits & d->bit) || n >= sizeof(value)) continue;
+    n += snprintf(value + n, sizeof(value) - n, "%s%s", n ? " " : "", d->name);
+  }
+
+  ui_overlay_show("FAULT", value, active ? "Fout actief" : "Stop: bevestigen");
+  g_err_shown = true;
+  g_err_key = key;
 }
 
 // ---------------- Task ----------------
+// Geen vaste periode: de task slaapt tot er iets te tonen is (zie het einde van
+// de loop). Meetwaarden komen uit measureTask met 1 kHz; die worden hooguit
+// elke DISPLAY_DATA_MIN_MS getoond.
+#define DISPLAY_DATA_MIN_MS  50u      // <-- AANPASSEN (20 Hz voor meetwaarden)
+#define DISPLAY_IDLE_MAX_MS  1000u    // uiterlijk één ronde per seconde (watchdog, statusregel)
+
+// Actieve tijd van de task (wakker tot weer slapen) en aantallen, voor de statusregel
+static uint64_t g_active_us = 0;
+static uint32_t g_wakes = 0;
+static uint32_t g_rounds = 0;
+
 void displayTask(void* pvParameters)
 {
   (void)pvParameters;
@@ -603,6 +965,10 @@ void displayTask(void* pvParameters)
 
   backlight_init_and_on();
   ili9488_init();
+  ili9488_bench();
+#if DISPLAY_FMT_BENCH
+  ui_fmt_bench();
+#endif
 
   Serial.println("LVGL init start");
 
@@ -614,7 +980,8 @@ void displayTask(void* pvParameters)
 
   Serial.println("LVGL first screen");
 
-  lv_obj_t* scr = lv_screen_active();
+  lv_obj_t* boot_scr = lv_screen_active();
+  lv_obj_t* scr = boot_scr;
   lv_obj_set_style_bg_color(scr, lv_color_hex(0xFF0000), LV_PART_MAIN);
   lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, LV_PART_MAIN);
   lv_obj_t* t = lv_label_create(scr);
@@ -624,54 +991,170 @@ void displayTask(void* pvParameters)
 
   Serial.println("LVGL init done");
 
-  // Start UI1
+#if DISPLAY_BUF_BENCH
+  display_bench_buffers();
+#endif
+
+  // Alle schermen één keer bouwen; daarna is een wissel alleen lv_screen_load
+  ui_screens_init();
+  print_lv_heap("display: schermen gebouwd");
+#if DISPLAY_SWITCH_BENCH
+  display_bench_switch();
+#endif
+#if DISPLAY_RENDER_BENCH
+  display_bench_render();
+#endif
+
+  // Start UI1, het opstartscherm is daarna niet meer nodig
   current_ui = ActiveUI::UI1;
-  ui1_create();
+  ui1_load();
+  if (boot_scr != lv_screen_active()) lv_obj_delete(boot_scr);
 
-  const TickType_t period = pdMS_TO_TICKS(50); // 20 Hz
-  TickType_t lastWake = xTaskGetTickCount();
+  // Input events: notify bij elk event, zodat een druk niet op de volgende periode wacht
+  io_event_cursor_init(&g_io_cursor);
+  io_event_subscribe(xTaskGetCurrentTaskHandle());
 
-  uint32_t last_lv_tick_ms = millis();
-
-  while (true)
+  // Encoder: PCNT-ISR notified ook via io_event_notify
+  enc_accel_default(&g_enc_cfg);
   {
-    // LVGL tick
-    uint32_t now_ms = millis();
-    uint32_t dt = now_ms - last_lv_tick_ms;
-    last_lv_tick_ms = now_ms;
+    uint32_t t_us = 0;
+    const int32_t d = encoder_detents(&t_us);
+    enc_accel_reset(&g_enc, d, t_us);
+  }
 
-    lv_tick_inc(dt);
-    lv_timer_handler();
-    //vTaskDelay(1);
+  // Datawijzigingen: één notify bij de eerste wijziging na elke ronde (system.h)
+  const int chg_sub = system_subscribe_changes(xTaskGetCurrentTaskHandle(),
+                                               SYS_CHG_MEAS | SYS_CHG_STATUS | SYS_CHG_CURVES | SYS_CHG_UI);
 
+  uint32_t last_lv_tick_ms = millis();
+  uint32_t lv_deadline_ms = last_lv_tick_ms;   // eerste ronde meteen
+  int64_t active_t0 = esp_timer_get_time();
+  FP_INIT();
 
+  while (true)
+  {
     esp_task_wdt_reset();
+    FP_FRAME_BEGIN();
+    g_rounds++;
+    const uint32_t round_ms = millis();
+
+    // Weer scherp voor de volgende wijziging; de snapshot hieronder is nieuwer
+    (void)system_take_changes(chg_sub);
 
     // Snapshot
     SystemSnapshot sys;
     system_read_snapshot(&sys);
+    FP_MARK(FP_SNAPSHOT);
 
     // UI switch op basis van system.ui.active_screen
     switch_ui_if_needed(sys.ui.active_screen);
 
     // Inputs verwerken (alleen in CONFIG)
     handle_inputs(sys);
+    update_error_overlay(sys);
+    FP_MARK(FP_INPUTS);
+
+    // Input kan UI-waarden gewijzigd hebben: model uit een verse snapshot
+    if (g_lat_pending_t_us != 0) system_read_snapshot(&sys);
+    FP_MARK(FP_SNAPSHOT);
 
     // model vullen + UI updaten
     model_from_system(g_model, sys);
+    FP_MARK(FP_MODEL);
 
     switch (current_ui) {
       case ActiveUI::UI1: ui1_update(g_model); break;
       case ActiveUI::UI2: ui2_update(g_model); break;
       case ActiveUI::UI3: ui3_update(g_model); break;
     }
+    FP_MARK(FP_UPDATE);
+
+    // LVGL tick + render na de update, zodat een input nog deze ronde op het scherm staat
+    uint32_t now_ms = millis();
+    uint32_t dt = now_ms - last_lv_tick_ms;
+    last_lv_tick_ms = now_ms;
+
+    lv_tick_inc(dt);
+    const uint32_t lv_next_ms = lv_timer_handler();   // LV_NO_TIMER_READY als niets loopt
+    lv_deadline_ms = millis() + (lv_next_ms < DISPLAY_IDLE_MAX_MS ? lv_next_ms : DISPLAY_IDLE_MAX_MS);
+    FP_MARK(FP_LVGL);
+    input_latency_rendered();
+    FP_FRAME_END();
+
     static uint32_t lastPrint = 0;
-  if (millis() - lastPrint > 1000) {
-    lastPrint = millis();
-    Serial.println("display loop alive");
-  }
+    static Ili9488Stats lastStats = {};
+    if (millis() - lastPrint > 1000) {
+      const uint32_t span_ms = millis() - lastPrint;
+      lastPrint = millis();
+
+      // Flush-doorvoer over de afgelopen periode. Per frame: bus = DMA-tijd, wacht =
+      // tijd dat LVGL op een transfer stond te wachten; bus - wacht is CPU-tijd die
+      // (t.o.v. een synchrone flush) naar renderen ging.
+      Ili9488Stats st;
+      ili9488_get_stats(&st);
+      static uint32_t lastFrames = 0;
+      static uint32_t lastInv = 0;
+      const uint32_t frames = g_frames - lastFrames;
+      lastFrames = g_frames;
+      const uint32_t inv = g_inv_px - lastInv;
+      lastInv = g_inv_px;
+      const uint32_t n = st.n_push - lastStats.n_push;
+      const uint64_t bytes = st.bytes - lastStats.bytes;
+      const uint64_t busy = st.busy_us - lastStats.busy_us;
+      const uint64_t wait = st.wait_us - lastStats.wait_us;
+      const uint64_t cpu = st.cpu_us - lastStats.cpu_us;
+      static uint64_t lastActive = 0;
+      static uint32_t lastWakes = 0, lastRounds = 0;
+      const uint64_t active = g_active_us + (uint64_t)(esp_timer_get_time() - active_t0) - lastActive;
+      lastActive += active;
+      Serial.printf("display: CPU %.1f%%, %u wakes/s, %u rondes/s\n",
+                    span_ms ? active * 0.1 / span_ms : 0.0,
+                    span_ms ? (unsigned)((g_wakes - lastWakes) * 1000u / span_ms) : 0u,
+                    span_ms ? (unsigned)((g_rounds - lastRounds) * 1000u / span_ms) : 0u);
+      lastWakes = g_wakes;
+      lastRounds = g_rounds;
+      Serial.printf("display loop alive: %u flushes, %.1f kB, flush %.2f MB/s, bus %.1f%% van de tijd, max %u us, invalid %u px/s\n",
+                    (unsigned)n, bytes / 1024.0, busy ? (double)bytes / busy : 0.0,
+                    span_ms ? busy * 0.1 / span_ms : 0.0, (unsigned)st.max_us,
+                    span_ms ? (unsigned)((uint64_t)inv * 1000u / span_ms) : 0u);
+      if (frames) {
+        const double saved = busy > wait ? (double)(busy - wait) : 0.0;
+        Serial.printf("display: %u frames, per frame bus %.2f ms, flush-cpu %.2f ms, wacht %.2f ms, bespaard %.2f ms (%.0f%%)\n",
+                      (unsigned)frames, busy * 1e-3 / frames, cpu * 1e-3 / frames, wait * 1e-3 / frames,
+                      saved * 1e-3 / frames, busy ? saved * 100.0 / busy : 0.0);
+      }
+      lastStats = st;
+    }
 
+    // Slapen tot er iets te doen is:
+    //   input                        -> meteen (nog dezelfde frame op het scherm)
+    //   status/UI/curves gewijzigd   -> meteen
+    //   nieuwe meetwaarden           -> DISPLAY_DATA_MIN_MS na het begin van deze ronde
+    //   volgende LVGL-timer          -> lv_deadline_ms (animaties; niets = IDLE_MAX)
+    //   UI1                          -> volgende hele seconde (runtime-label)
+    // De notify komt van io_event (knoppen, encoder) of system_subscribe_changes.
+    for (;;) {
+      if (input_pending()) break;
+      const uint32_t chg = system_peek_changes(chg_sub);
+      if (chg & ~SYS_CHG_MEAS) break;
+
+      const uint32_t now = millis();
+      int32_t wait = (int32_t)(lv_deadline_ms - now);
+      if (chg & SYS_CHG_MEAS) {
+        const int32_t w = (int32_t)(round_ms + DISPLAY_DATA_MIN_MS - now);
+        if (w < wait) wait = w;
+      }
+      if (current_ui == ActiveUI::UI1) {
+        const int32_t w = (int32_t)(1000u - now % 1000u);
+        if (w < wait) wait = w;
+      }
+      if (wait <= 0) break;
 
-    vTaskDelayUntil(&lastWake, period);
+      g_active_us += (uint64_t)(esp_timer_get_time() - active_t0);
+      const TickType_t ticks = pdMS_TO_TICKS((uint32_t)wait);
+      ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+      active_t0 = esp_timer_get_time();
+      g_wakes++;
+    }
   }
 }
\ No newline at end of file
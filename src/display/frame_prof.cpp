@@ -0,0 +1,140 @@
+// display/frame_prof.cpp
+#include "display/frame_prof.h"
+
+#if DISPLAY_PROFILE
+#include <Arduino.h>
+#include <lvgl.h>
+#include <algorithm>
+
+#include "display/ili9488_driver.hpp"
+
+static const char* const FP_NAMES[FP_COUNT] = {
+  "snapshot", "inputs", "model", "ui_update", "lvgl", "render",
+  "flush_cpu", "flush_wacht", "flush_bus", "loop", "pixels", "areas",
+};
+
+// Stages in cycli (tot fp_frame_end), daarna alles in us / aantallen
+static uint32_t g_cpu_mhz = 240;
+static uint32_t g_frame_start = 0;
+static uint32_t g_mark = 0;
+static uint32_t g_acc[FP_COUNT];
+static uint32_t g_win[FP_COUNT][FP_WINDOW];
+static uint32_t g_n = 0;                   // rondes sinds boot
+static Ili9488Stats g_last_bus = {};
+static uint32_t g_last_report_ms = 0;
+
+#if DISPLAY_PROFILE_OVERLAY
+static lv_obj_t* g_label = nullptr;
+#endif
+
+static inline uint32_t ccount()
+{
+  return ESP.getCycleCount();
+}
+
+void fp_init()
+{
+  g_cpu_mhz = ESP.getCpuFreqMHz();
+  if (g_cpu_mhz == 0) g_cpu_mhz = 240;
+  memset(g_acc, 0, sizeof(g_acc));
+  ili9488_get_stats(&g_last_bus);
+  g_last_report_ms = millis();
+}
+
+void fp_frame_begin()
+{
+  g_frame_start = g_mark = ccount();
+}
+
+void fp_mark(FpMetric m)
+{
+  const uint32_t now = ccount();
+  g_acc[m] += now - g_mark;
+  g_mark = now;
+}
+
+void fp_flush_area(uint32_t pixels)
+{
+  g_acc[FP_PIXELS] += pixels;
+  g_acc[FP_AREAS]++;
+}
+
+// Percentiel p (0..100) uit een gesorteerd venster
+static uint32_t pct(const uint32_t* sorted, uint32_t n, uint32_t p)
+{
+  if (n == 0) return 0;
+  uint32_t k = (n * p + 99u) / 100u;
+  if (k > 0) k--;
+  return sorted[k < n ? k : n - 1];
+}
+
+static void report()
+{
+  static uint32_t sorted[FP_COUNT][FP_WINDOW];
+  const uint32_t n = g_n < FP_WINDOW ? g_n : FP_WINDOW;
+  if (n == 0) return;
+
+  for (int m = 0; m < FP_COUNT; ++m) {
+    memcpy(sorted[m], g_win[m], n * sizeof(uint32_t));
+    std::sort(sorted[m], sorted[m] + n);
+  }
+
+  Serial.printf("display prof (%u rondes): %-11s %7s %7s %7s %7s\n", (unsigned)n, "", "p50", "p90", "p99", "max");
+  for (int m = 0; m < FP_COUNT; ++m) {
+    Serial.printf("  %-11s %7u %7u %7u %7u %s\n", FP_NAMES[m],
+                  (unsigned)pct(sorted[m], n, 50), (unsigned)pct(sorted[m], n, 90),
+                  (unsigned)pct(sorted[m], n, 99), (unsigned)sorted[m][n - 1],
+                  m < FP_PIXELS ? "us" : "");
+  }
+
+#if DISPLAY_PROFILE_OVERLAY
+  // Op de systeemlaag, boven schermen en de edit-overlay. Het bijwerken kost zelf
+  // een kleine redraw per rapport.
+  if (!g_label) {
+    g_label = lv_label_create(lv_layer_sys());
+    lv_obj_set_style_text_font(g_label, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_color(g_label, lv_color_hex(0xFFFF00), 0);
+    lv_obj_set_style_bg_color(g_label, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(g_label, LV_OPA_70, 0);
+    lv_obj_align(g_label, LV_ALIGN_BOTTOM_LEFT, 2, -2);
+  }
+  lv_label_set_text_fmt(g_label, "loop %u/%u us  lvgl %u/%u  render %u  bus %u  px %u (p50/p99)",
+                        (unsigned)pct(sorted[FP_LOOP], n, 50), (unsigned)pct(sorted[FP_LOOP], n, 99),
+                        (unsigned)pct(sorted[FP_LVGL], n, 50), (unsigned)pct(sorted[FP_LVGL], n, 99),
+                        (unsigned)pct(sorted[FP_RENDER], n, 99), (unsigned)pct(sorted[FP_FLUSH_BUS], n, 99),
+                        (unsigned)pct(sorted[FP_PIXELS], n, 99));
+#endif
+}
+
+void fp_frame_end()
+{
+  const uint32_t loop_cyc = ccount() - g_frame_start;
+
+  uint32_t v[FP_COUNT];
+  for (int m = 0; m < FP_COUNT; ++m) v[m] = g_acc[m];
+  for (int m = FP_SNAPSHOT; m <= FP_LVGL; ++m) v[m] /= g_cpu_mhz;
+  v[FP_LOOP] = loop_cyc / g_cpu_mhz;
+
+  // Flush uit de drivertellers (de ISR telt de bus-tijd)
+  Ili9488Stats st;
+  ili9488_get_stats(&st);
+  v[FP_FLUSH_CPU] = (uint32_t)(st.cpu_us - g_last_bus.cpu_us);
+  v[FP_FLUSH_WAIT] = (uint32_t)(st.wait_us - g_last_bus.wait_us);
+  v[FP_FLUSH_BUS] = (uint32_t)(st.busy_us - g_last_bus.busy_us);
+  g_last_bus = st;
+  const uint32_t flush = v[FP_FLUSH_CPU] + v[FP_FLUSH_WAIT];
+  v[FP_RENDER] = v[FP_LVGL] > flush ? v[FP_LVGL] - flush : 0;
+
+  const uint32_t slot = g_n % FP_WINDOW;
+  for (int m = 0; m < FP_COUNT; ++m) g_win[m][slot] = v[m];
+  g_n++;
+  memset(g_acc, 0, sizeof(g_acc));
+
+  const uint32_t now_ms = millis();
+  if (now_ms - g_last_report_ms >= FP_REPORT_MS) {
+    g_last_report_ms = now_ms;
+    report();
+  }
+}
+
+#endif // DISPLAY_PROFILE
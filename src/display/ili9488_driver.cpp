@@ -0,0 +1,491 @@
+// ili9488_driver.cpp
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "display/ili9488_driver.hpp"
+
+#if !ILI9488_BUS_GPIO
+#include "esp_lcd_panel_io.h"
+#include "soc/soc_memory_layout.h"
+#include "esp32s3/rom/cache.h"
+#endif
+
+static uint8_t g_rotation = 0;
+static Ili9488Stats g_stats = {};
+
+// Async push: start van de lopende push (0 = geen), transfers die nog moeten
+// eindigen (één per push, of één per regel bij een strided rechthoek) en de
+// done-callback
+static volatile int64_t  g_async_t0 = 0;
+static volatile uint32_t g_async_left = 0;
+static Ili9488DoneCb     g_done_cb = nullptr;
+static void*             g_done_ctx = nullptr;
+
+static void IRAM_ATTR async_done()
+{
+  const int64_t t0 = g_async_t0;
+  if (!t0) return;
+  if (--g_async_left) return;
+  g_async_t0 = 0;
+
+  const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  g_stats.busy_us += us;
+  if (us > g_stats.max_us) g_stats.max_us = us;
+  if (g_done_cb) g_done_cb(g_done_ctx);
+}
+
+// =========================
+// Pixels -> paneelvolgorde
+// =========================
+// De bus stuurt bytes in geheugenvolgorde; het paneel wil RGB565 hoge byte eerst.
+// Het paneel toont zonder INVON geïnverteerde kleuren.
+//   NATIVE       LVGL rendert RGB565_SWAPPED, INVON: buffer gaat ongewijzigd de bus op
+//   SWAP         LVGL RGB565 (little endian), INVON: alleen bytes wisselen
+//   SWAP_INVERT  LVGL RGB565, INVOFF: wisselen + inverteren (oude software-pad)
+// Kernels woordbreed, vier pixels per slag; LVGL-buffers zijn 32-byte uitgelijnd.
+static Ili9488PixelPath g_px_path = ILI9488_PX_NATIVE;
+
+static void px_swap(uint8_t* px, uint32_t n_px)
+{
+  uint32_t* w = (uint32_t*)px;
+  const uint32_t n_w = n_px / 2u;
+  uint32_t i = 0;
+  for (; i + 2 <= n_w; i += 2) {
+    const uint32_t a = w[i], b = w[i + 1];
+    w[i]     = ((a >> 8) & 0x00FF00FFu) | ((a << 8) & 0xFF00FF00u);
+    w[i + 1] = ((b >> 8) & 0x00FF00FFu) | ((b << 8) & 0xFF00FF00u);
+  }
+  for (; i < n_w; ++i) {
+    const uint32_t v = w[i];
+    w[i] = ((v >> 8) & 0x00FF00FFu) | ((v << 8) & 0xFF00FF00u);
+  }
+  if (n_px & 1u) {
+    uint16_t* last = (uint16_t*)px + (n_px - 1u);
+    *last = (uint16_t)((*last >> 8) | (*last << 8));
+  }
+}
+
+static void px_swap_invert(uint8_t* px, uint32_t n_px)
+{
+  uint32_t* w = (uint32_t*)px;
+  const uint32_t n_w = n_px / 2u;
+  uint32_t i = 0;
+  for (; i + 2 <= n_w; i += 2) {
+    const uint32_t a = w[i], b = w[i + 1];
+    w[i]     = ~(((a >> 8) & 0x00FF00FFu) | ((a << 8) & 0xFF00FF00u));
+    w[i + 1] = ~(((b >> 8) & 0x00FF00FFu) | ((b << 8) & 0xFF00FF00u));
+  }
+  for (; i < n_w; ++i) {
+    const uint32_t v = w[i];
+    w[i] = ~(((v >> 8) & 0x00FF00FFu) | ((v << 8) & 0xFF00FF00u));
+  }
+  if (n_px & 1u) {
+    uint16_t* last = (uint16_t*)px + (n_px - 1u);
+    *last = (uint16_t)~((*last >> 8) | (*last << 8));
+  }
+}
+
+static inline void px_to_panel(uint8_t* px, uint32_t n_px)
+{
+  switch (g_px_path) {
+    case ILI9488_PX_NATIVE:      break;
+    case ILI9488_PX_SWAP:        px_swap(px, n_px); break;
+    case ILI9488_PX_SWAP_INVERT: px_swap_invert(px, n_px); break;
+  }
+}
+
+// RGB565-kleur -> uint16 in geheugen zoals de bus hem moet sturen
+static inline uint16_t color_to_panel(uint16_t c)
+{
+  if (g_px_path == ILI9488_PX_SWAP_INVERT) c = (uint16_t)~c;
+  return (uint16_t)((c >> 8) | (c << 8));
+}
+
+#if ILI9488_BUS_GPIO
+// =========================
+// Bus: GPIO (digitalWrite per bit)
+// =========================
+static const int lcd_data_pins[8] = {
+  LCD_D0, LCD_D1, LCD_D2, LCD_D3,
+  LCD_D4, LCD_D5, LCD_D6, LCD_D7
+};
+
+static inline void lcd_busWrite(uint8_t v)
+{
+  for (int i = 0; i < 8; i++) {
+    digitalWrite(lcd_data_pins[i], (v >> i) & 0x01);
+  }
+}
+
+static inline void lcd_pulseWR()
+{
+  digitalWrite(LCD_WR, LOW);
+  __asm__ __volatile__("nop\nnop\nnop\nnop\nnop\n");
+  digitalWrite(LCD_WR, HIGH);
+}
+
+static void bus_init()
+{
+  for (int i = 0; i < 8; i++) {
+    pinMode(lcd_data_pins[i], OUTPUT);
+    digitalWrite(lcd_data_pins[i], LOW);
+  }
+  pinMode(LCD_CS, OUTPUT);
+  pinMode(LCD_RS, OUTPUT);
+  pinMode(LCD_WR, OUTPUT);
+  digitalWrite(LCD_CS, HIGH);
+  digitalWrite(LCD_RS, HIGH);
+  digitalWrite(LCD_WR, HIGH);
+}
+
+// Zoals de oorspronkelijke driver: CS en RS per byte
+static void bus_cmd(uint8_t cmd, const uint8_t* param, uint32_t len)
+{
+  digitalWrite(LCD_RS, LOW);
+  digitalWrite(LCD_CS, LOW);
+  lcd_busWrite(cmd);
+  lcd_pulseWR();
+  digitalWrite(LCD_CS, HIGH);
+  for (uint32_t i = 0; i < len; i++) {
+    digitalWrite(LCD_RS, HIGH);
+    digitalWrite(LCD_CS, LOW);
+    lcd_busWrite(param[i]);
+    lcd_pulseWR();
+    digitalWrite(LCD_CS, HIGH);
+  }
+}
+
+// Synchroon: geeft false (geen ISR die het einde meldt)
+static bool bus_color(uint8_t cmd, const void* data, uint32_t bytes)
+{
+  bus_cmd(cmd, (const uint8_t*)data, bytes);
+  return false;
+}
+
+static void bus_wait() {}
+
+#else
+// =========================
+// Bus: LCD_CAM i80 + DMA (esp_lcd)
+// =========================
+static esp_lcd_i80_bus_handle_t  g_bus = nullptr;
+static esp_lcd_panel_io_handle_t g_io = nullptr;
+static SemaphoreHandle_t         g_done = nullptr;   // geteld: één give per kleur-transfer
+static uint32_t                  g_pending = 0;      // kleur-transfers in de wachtrij
+
+static constexpr size_t TRANS_QUEUE_DEPTH = 10;
+
+// Transfers eindigen in volgorde; een async push staat altijd alleen in de wachtrij.
+// De ISR is niet IRAM-safe (standaard esp_lcd): tijdens flash-schrijven wordt hij
+// uitgesteld, dus de done-callback mag code uit flash aanroepen.
+static bool IRAM_ATTR on_color_done(esp_lcd_panel_io_handle_t io, void* user_data, void* event_data)
+{
+  (void)io; (void)user_data; (void)event_data;
+  async_done();
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(g_done, &woken);
+  return woken == pdTRUE;
+}
+
+static void bus_init()
+{
+  g_done = xSemaphoreCreateCounting(TRANS_QUEUE_DEPTH, 0);
+
+  esp_lcd_i80_bus_config_t bc;
+  memset(&bc, 0, sizeof(bc));
+  bc.dc_gpio_num = LCD_RS;
+  bc.wr_gpio_num = LCD_WR;
+  const int data_pins[8] = { LCD_D0, LCD_D1, LCD_D2, LCD_D3, LCD_D4, LCD_D5, LCD_D6, LCD_D7 };
+  for (int i = 0; i < 8; i++) bc.data_gpio_nums[i] = data_pins[i];
+  bc.bus_width = 8;
+  bc.max_transfer_bytes = ILI9488_MAX_TRANSFER;
+  bc.psram_trans_align = 64;   // draw buffers in PSRAM (zie display.cpp)
+  bc.sram_trans_align = 4;
+  esp_err_t err = esp_lcd_new_i80_bus(&bc, &g_bus);
+  if (err != ESP_OK) {
+    Serial.printf("ili9488: i80 bus fout %d\n", (int)err);
+    return;
+  }
+
+  esp_lcd_panel_io_i80_config_t ic;
+  memset(&ic, 0, sizeof(ic));
+  ic.cs_gpio_num = LCD_CS;
+  ic.pclk_hz = ILI9488_PCLK_HZ;
+  ic.trans_queue_depth = TRANS_QUEUE_DEPTH;
+  ic.on_color_trans_done = on_color_done;
+  ic.lcd_cmd_bits = 8;
+  ic.lcd_param_bits = 8;
+  ic.dc_levels.dc_idle_level = 0;
+  ic.dc_levels.dc_cmd_level = 0;
+  ic.dc_levels.dc_dummy_level = 0;
+  ic.dc_levels.dc_data_level = 1;
+  err = esp_lcd_new_panel_io_i80(g_bus, &ic, &g_io);
+  if (err != ESP_OK) {
+    Serial.printf("ili9488: i80 panel io fout %d\n", (int)err);
+    g_io = nullptr;
+  }
+}
+
+static void bus_wait()
+{
+  while (g_pending) {
+    xSemaphoreTake(g_done, portMAX_DELAY);
+    g_pending--;
+  }
+}
+
+// Commando + parameters: esp_lcd wacht zelf tot lopende kleur-transfers klaar zijn
+static void bus_cmd(uint8_t cmd, const uint8_t* param, uint32_t len)
+{
+  if (!g_io) return;
+  esp_lcd_panel_io_tx_param(g_io, cmd, len ? param : nullptr, len);
+}
+
+// Commando + pixeldata als één DMA-transactie (CS laag over het geheel). Keert
+// terug zodra de transfer in de wachtrij staat (true: de ISR meldt het einde);
+// bus_wait() wacht op het einde. Data in PSRAM eerst uit de cache terugschrijven,
+// de DMA leest het fysieke geheugen.
+static bool bus_color(uint8_t cmd, const void* data, uint32_t bytes)
+{
+  if (!g_io) return false;
+  if (g_pending == TRANS_QUEUE_DEPTH) {
+    xSemaphoreTake(g_done, portMAX_DELAY);
+    g_pending--;
+  }
+  if (esp_ptr_external_ram(data)) Cache_WriteBack_Addr((uint32_t)(uintptr_t)data, bytes);
+  if (esp_lcd_panel_io_tx_color(g_io, cmd, data, bytes) != ESP_OK) return false;
+  g_pending++;
+  return true;
+}
+#endif
+
+// =========================
+// Paneel
+// =========================
+static inline void lcd_writeCommand(uint8_t cmd)
+{
+  bus_cmd(cmd, nullptr, 0);
+}
+
+static inline void lcd_writeCommand1(uint8_t cmd, uint8_t data)
+{
+  bus_cmd(cmd, &data, 1);
+}
+
+void ili9488_set_rotation(uint8_t r)
+{
+  uint8_t madctl = 0;
+
+  switch (r & 3) {
+    case 0: // portret
+      madctl = 0x48;  // MX | BGR
+      break;
+    case 1: // landscape (90°)
+      madctl = 0x28;  // MV | BGR
+      break;
+    case 2: // portret 180°
+      madctl = 0x88;  // MY | BGR
+      break;
+    case 3: // landscape 180°
+      madctl = 0xE8;  // MX | MY | MV | BGR
+      break;
+  }
+
+  g_rotation = r & 3;
+  lcd_writeCommand1(0x36, madctl);
+}
+
+void ili9488_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+  const uint16_t x2 = x + w - 1;
+  const uint16_t y2 = y + h - 1;
+
+  // Column address set
+  const uint8_t caset[4] = { (uint8_t)(x >> 8), (uint8_t)(x & 0xFF), (uint8_t)(x2 >> 8), (uint8_t)(x2 & 0xFF) };
+  bus_cmd(0x2A, caset, 4);
+
+  // Page address set
+  const uint8_t paset[4] = { (uint8_t)(y >> 8), (uint8_t)(y & 0xFF), (uint8_t)(y2 >> 8), (uint8_t)(y2 & 0xFF) };
+  bus_cmd(0x2B, paset, 4);
+
+  // RAMWR volgt met de pixels (bus_color)
+}
+
+void ili9488_init()
+{
+  bus_init();
+
+#if (LCD_RST >= 0)
+  pinMode(LCD_RST, OUTPUT);
+  digitalWrite(LCD_RST, LOW);
+  delay(10);
+  digitalWrite(LCD_RST, HIGH);
+  delay(120);
+#else
+  // RST hard aan 3V3
+  delay(120);
+#endif
+
+  // Software reset
+  lcd_writeCommand(0x01);
+  delay(120);
+
+  // Sleep out
+  lcd_writeCommand(0x11);
+  delay(120);
+
+  // 16-bit pixel formaat RGB565
+  lcd_writeCommand1(0x3A, 0x55);
+
+  // Inversie volgens het pixelpad (paneel toont zonder INVON geïnverteerd)
+  ili9488_set_pixel_path(g_px_path);
+
+  // Display on
+  lcd_writeCommand(0x29);
+  delay(20);
+
+  ili9488_set_rotation(1);
+}
+
+void ili9488_set_pixel_path(Ili9488PixelPath path)
+{
+  g_px_path = path;
+  lcd_writeCommand(path == ILI9488_PX_SWAP_INVERT ? 0x20 : 0x21);   // INVOFF / INVON
+}
+
+Ili9488PixelPath ili9488_get_pixel_path()
+{
+  return g_px_path;
+}
+
+void ili9488_fill_screen(uint16_t color)
+{
+  const uint16_t w = (g_rotation & 1) ? ILI9488_HEIGHT : ILI9488_WIDTH;
+  const uint16_t h = (g_rotation & 1) ? ILI9488_WIDTH : ILI9488_HEIGHT;
+
+  // Eén strook van FILL_LINES regels, herhaald verstuurd: RAMWR, dan RAMWRC (0x3C)
+  static constexpr uint16_t FILL_LINES = 20;
+  const uint32_t strip_px = (uint32_t)w * FILL_LINES;
+  uint16_t* strip = (uint16_t*)heap_caps_aligned_alloc(32, strip_px * 2u, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (!strip) {
+    Serial.println("ili9488: fill buffer alloc failed");
+    return;
+  }
+  const uint16_t c = color_to_panel(color);
+  for (uint32_t i = 0; i < strip_px; i++) strip[i] = c;
+
+  ili9488_set_window(0, 0, w, h);
+  for (uint16_t y = 0; y < h; y += FILL_LINES) {
+    const uint16_t lines = (h - y < FILL_LINES) ? (h - y) : FILL_LINES;
+    bus_color(y == 0 ? 0x2C : 0x3C, strip, (uint32_t)w * lines * 2u);
+  }
+  bus_wait();
+  heap_caps_free(strip);
+}
+
+void ili9488_push_rect_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                             uint8_t* px, uint32_t stride_px)
+{
+  // Vorige push is klaar (LVGL flusht pas na flush_ready); tellers bijwerken
+  bus_wait();
+
+  const int64_t t0 = esp_timer_get_time();
+  const uint32_t total = (uint32_t)w * h;
+  const bool contiguous = (stride_px == w) || (h == 1);
+
+  if (contiguous) px_to_panel(px, total);
+  else for (uint16_t r = 0; r < h; ++r) px_to_panel(px + (size_t)r * stride_px * 2u, w);
+  ili9488_set_window(x, y, w, h);
+
+  g_stats.n_push++;
+  g_stats.bytes += total * 2u;
+  g_async_left = contiguous ? 1u : h;
+  g_async_t0 = esp_timer_get_time();
+  if (contiguous) {
+    if (!bus_color(0x2C, px, total * 2u)) async_done();
+  } else {
+    // Regel voor regel: RAMWR, dan RAMWRC; het venster loopt door
+    for (uint16_t r = 0; r < h; ++r) {
+      if (!bus_color(r == 0 ? 0x2C : 0x3C, px + (size_t)r * stride_px * 2u, (uint32_t)w * 2u)) async_done();
+    }
+  }
+
+  g_stats.cpu_us += (uint32_t)(esp_timer_get_time() - t0);
+}
+
+void ili9488_push_pixels_async(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* px_map)
+{
+  ili9488_push_rect_async(x, y, w, h, px_map, w);
+}
+
+void ili9488_push_pixels(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* px_map)
+{
+  ili9488_push_pixels_async(x, y, w, h, px_map);
+  ili9488_wait_idle();
+}
+
+void ili9488_set_done_cb(Ili9488DoneCb cb, void* ctx)
+{
+  g_done_ctx = ctx;
+  g_done_cb = cb;
+}
+
+void ili9488_wait_idle()
+{
+  const int64_t t0 = esp_timer_get_time();
+  bus_wait();
+  g_stats.wait_us += (uint32_t)(esp_timer_get_time() - t0);
+}
+
+void ili9488_get_stats(Ili9488Stats* out)
+{
+  *out = g_stats;
+}
+
+void ili9488_bench()
+{
+  const int64_t t0 = esp_timer_get_time();
+  ili9488_fill_screen(0x0000);
+  const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+  const double bytes = (double)ILI9488_WIDTH * ILI9488_HEIGHT * 2.0;
+  Serial.printf("ili9488: full-screen fill %.2f ms, %.2f MB/s (%s)\n",
+                us * 1e-3, us ? bytes / us : 0.0,
+                ILI9488_BUS_GPIO ? "GPIO digitalWrite" : "i80 DMA");
+
+  // Per pixelpad: alleen de kernel, en een volledig scherm in stroken (kernel + bus)
+  const uint16_t w = (g_rotation & 1) ? ILI9488_HEIGHT : ILI9488_WIDTH;
+  const uint16_t h = (g_rotation & 1) ? ILI9488_WIDTH : ILI9488_HEIGHT;
+  static constexpr uint16_t STRIP_LINES = 20;
+  static constexpr int KERNEL_REPS = 20;
+  const uint32_t strip_px = (uint32_t)w * STRIP_LINES;
+  uint8_t* strip = (uint8_t*)heap_caps_aligned_alloc(32, strip_px * 2u, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (!strip) return;
+  memset(strip, 0, strip_px * 2u);
+
+  static const char* const NAMES[] = { "native", "swap", "swap+invert" };
+  const Ili9488PixelPath keep = g_px_path;
+  for (int p = ILI9488_PX_NATIVE; p <= ILI9488_PX_SWAP_INVERT; ++p) {
+    ili9488_set_pixel_path((Ili9488PixelPath)p);
+
+    const int64_t k0 = esp_timer_get_time();
+    for (int r = 0; r < KERNEL_REPS; ++r) px_to_panel(strip, strip_px);
+    const uint32_t k_us = (uint32_t)(esp_timer_get_time() - k0);
+
+    const int64_t p0 = esp_timer_get_time();
+    for (uint16_t y = 0; y < h; y += STRIP_LINES) ili9488_push_pixels(0, y, w, STRIP_LINES, strip);
+    const uint32_t p_us = (uint32_t)(esp_timer_get_time() - p0);
+
+    char kernel[16] = "-";
+    if (p != ILI9488_PX_NATIVE && k_us) snprintf(kernel, sizeof(kernel), "%.1f", (double)strip_px * 2.0 * KERNEL_REPS / k_us);
+    Serial.printf("ili9488: pad %-11s kernel %6s B/us, push %.2f B/us (%.2f ms/scherm)\n",
+                  NAMES[p], kernel, p_us ? bytes / p_us : 0.0, p_us * 1e-3);
+  }
+  ili9488_set_pixel_path(keep);
+  ili9488_fill_screen(0x0000);
+  heap_caps_free(strip);
+}
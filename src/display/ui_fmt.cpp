@@ -0,0 +1,159 @@
+// display/ui_fmt.cpp
+#include "display/ui_fmt.h"
+
+// Milli per eenheid van het laatste getoonde cijfer, per aantal decimalen
+static const uint32_t STEP[4] = { 1000u, 100u, 10u, 1u };
+static const uint32_t POW10[4] = { 1u, 10u, 100u, 1000u };
+
+// Schrijver met vaste grens; laat altijd plek voor '\0'
+struct FmtOut
+{
+  char* p;
+  char* end;
+};
+
+static inline void put_c(FmtOut& o, char c)
+{
+  if (o.p < o.end) *o.p++ = c;
+}
+
+static inline void put_s(FmtOut& o, const char* s)
+{
+  if (!s) return;
+  while (*s && o.p < o.end) *o.p++ = *s++;
+}
+
+// Decimaal, links aangevuld met nullen tot min_digits
+static void put_u(FmtOut& o, uint32_t v, uint8_t min_digits)
+{
+  char tmp[10];
+  uint8_t n = 0;
+  do {
+    tmp[n++] = (char)('0' + v % 10u);
+    v /= 10u;
+  } while (v);
+  while (n < min_digits && n < sizeof(tmp)) tmp[n++] = '0';
+  while (n) put_c(o, tmp[--n]);
+}
+
+static inline size_t finish(char* out, FmtOut& o)
+{
+  *o.p = 0;
+  return (size_t)(o.p - out);
+}
+
+int32_t ui_milli(float v)
+{
+  const float x = v * 1000.0f;
+  if (!(x > -2147483520.0f)) return (x != x) ? 0 : INT32_MIN;   // ook NaN
+  if (x >= 2147483520.0f) return INT32_MAX;
+  return (int32_t)(x < 0.0f ? x - 0.5f : x + 0.5f);
+}
+
+int32_t ui_fmt_key(const UiFmt& f, int32_t milli)
+{
+  const uint8_t d = f.decimals > 3 ? 3 : f.decimals;
+  const uint32_t step = STEP[d];
+  // |milli| als uint32: INT32_MIN past dan ook
+  const uint32_t a = milli < 0 ? 0u - (uint32_t)milli : (uint32_t)milli;
+  const uint32_t q = (a + step / 2u) / step;
+  return milli < 0 ? -(int32_t)q : (int32_t)q;
+}
+
+size_t ui_fmt_fixed(char* out, size_t cap, const UiFmt& f, int32_t milli)
+{
+  if (!out || cap == 0) return 0;
+  FmtOut o = { out, out + cap - 1 };
+  const uint8_t d = f.decimals > 3 ? 3 : f.decimals;
+
+  const int32_t q = ui_fmt_key(f, milli);
+  const uint32_t a = q < 0 ? 0u - (uint32_t)q : (uint32_t)q;
+
+  put_s(o, f.prefix);
+  if (q < 0) put_c(o, '-');
+  put_u(o, a / POW10[d], 1);
+  if (d) {
+    put_c(o, '.');
+    put_u(o, a % POW10[d], d);
+  }
+  put_s(o, f.unit);
+  return finish(out, o);
+}
+
+size_t ui_fmt_mmss(char* out, size_t cap, const char* prefix, uint32_t sec)
+{
+  if (!out || cap == 0) return 0;
+  FmtOut o = { out, out + cap - 1 };
+  put_s(o, prefix);
+  put_u(o, sec / 60u, 2);
+  put_c(o, ':');
+  put_u(o, sec % 60u, 2);
+  return finish(out, o);
+}
+
+size_t ui_fmt_uint(char* out, size_t cap, const char* prefix, uint32_t v)
+{
+  if (!out || cap == 0) return 0;
+  FmtOut o = { out, out + cap - 1 };
+  put_s(o, prefix);
+  put_u(o, v, 1);
+  return finish(out, o);
+}
+
+#if DISPLAY_FMT_BENCH
+// =========================
+// Target-benchmark
+// =========================
+#include <Arduino.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const int FMT_BENCH_N = 2000;
+
+// Resultaat via volatile, anders kan de compiler de lus weglaten
+static volatile uint32_t g_sink = 0;
+
+static uint32_t bench_ns(uint32_t cycles)
+{
+  const uint32_t mhz = ESP.getCpuFreqMHz() ? ESP.getCpuFreqMHz() : 240;
+  return (uint32_t)((uint64_t)cycles * 1000u / mhz / FMT_BENCH_N);
+}
+
+void ui_fmt_bench()
+{
+  static const UiFmt F = { "Voltage:\n", 2, " V" };
+  char b[UI_FMT_MAX];
+
+  // Zelfde waarden voor beide: 0..19.99 V in stappen van 10 mV
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < FMT_BENCH_N; ++i) g_sink += ui_fmt_fixed(b, sizeof(b), F, i * 10);
+  const uint32_t c_fixed = ESP.getCycleCount() - t0;
+  const UBaseType_t hwm_fmt = uxTaskGetStackHighWaterMark(NULL);
+
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < FMT_BENCH_N; ++i) g_sink += ui_fmt_mmss(b, sizeof(b), "runtime:\n", (uint32_t)i * 7u);
+  const uint32_t c_mmss = ESP.getCycleCount() - t0;
+
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < FMT_BENCH_N; ++i) {
+    const float v = (float)i * 0.01f;   // zoals het model vroeger: float -> double -> printf
+    g_sink += (uint32_t)snprintf(b, sizeof(b), "Voltage:\n%.2f V", (double)v);
+  }
+  const uint32_t c_printf = ESP.getCycleCount() - t0;
+  const UBaseType_t hwm_printf = uxTaskGetStackHighWaterMark(NULL);
+
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < FMT_BENCH_N; ++i) {
+    const uint32_t s = (uint32_t)i * 7u;
+    g_sink += (uint32_t)snprintf(b, sizeof(b), "runtime:\n%02lu:%02lu", (unsigned long)(s / 60u), (unsigned long)(s % 60u));
+  }
+  const uint32_t c_printf_mmss = ESP.getCycleCount() - t0;
+
+  Serial.printf("ui_fmt bench (%d conversies): fixed %u ns, snprintf %%.2f %u ns | mm:ss %u ns, snprintf %u ns\n",
+                FMT_BENCH_N, (unsigned)bench_ns(c_fixed), (unsigned)bench_ns(c_printf),
+                (unsigned)bench_ns(c_mmss), (unsigned)bench_ns(c_printf_mmss));
+  Serial.printf("ui_fmt bench: stack vrij (high water) na ui_fmt %u B, na snprintf %u B\n",
+                (unsigned)hwm_fmt, (unsigned)hwm_printf);
+}
+#endif // DISPLAY_FMT_BENCH
@@ -3,6 +3,8 @@
 #include <Arduino.h>
 #include <lvgl.h>
 
+#include "display/ui_fmt.h"
+
 // --- UI color palette ---
 #define UI_COL_BG              0x000000   // global background
 #define UI_COL_TEXT            0xEDBE0E   // main text (yellow)
@@ -167,9 +169,72 @@ static void set_btn_style(lv_obj_t* btn, lv_obj_t* lbl, bool highlight)
     }
 }
 
+// =========================
+// Diffing updates
+// =========================
+// lv_label_set_text invalideert het label altijd, ook bij dezelfde tekst, en
+// lv_chart_refresh de hele chart. De ui*_update-functies lopen 20x per seconde:
+// per widget onthouden we de getoonde waarde (gekwantiseerd op de resolutie van
+// de weergave) en de getoonde tekst, en raken LVGL alleen bij een echte wijziging.
+// Caches worden in ui*_create gereset (nieuwe widgets).
+//
+// De tekst staat in de cache zelf: ui_fmt schrijft er direct in en het label
+// verwijst ernaar (lv_label_set_text_static), dus geen kopie en geen heap. De key
+// is de waarde op weergaveresolutie (ui_fmt_key): gelijke key = gelijke tekst.
+struct UiLabelCache
+{
+    bool    valid;
+    int32_t key;
+    char    text[UI_FMT_MAX];
+};
+
+static void ui_label_fixed(lv_obj_t* obj, UiLabelCache& c, const UiFmt& f, int32_t milli)
+{
+    if (!obj) return;
+    const int32_t key = ui_fmt_key(f, milli);
+    if (c.valid && c.key == key) return;   // niet eens formatteren
+
+    ui_fmt_fixed(c.text, sizeof(c.text), f, milli);
+    c.valid = true;
+    c.key = key;
+    lv_label_set_text_static(obj, c.text);
+}
+
+static void ui_label_mmss(lv_obj_t* obj, UiLabelCache& c, const char* prefix, uint32_t sec)
+{
+    if (!obj) return;
+    if (c.valid && c.key == (int32_t)sec) return;
+
+    ui_fmt_mmss(c.text, sizeof(c.text), prefix, sec);
+    c.valid = true;
+    c.key = (int32_t)sec;
+    lv_label_set_text_static(obj, c.text);
+}
+
+// Vaste teksten (literals) per toestand
+static void ui_label_const(lv_obj_t* obj, UiLabelCache& c, int32_t key, const char* text)
+{
+    if (!obj) return;
+    if (c.valid && c.key == key) return;
+
+    c.valid = true;
+    c.key = key;
+    lv_label_set_text_static(obj, text);
+}
+
+// Formaten van de meetlabels
+static const UiFmt FMT_UI1_V        = { "voltage:\n", 2, nullptr };
+static const UiFmt FMT_UI1_A        = { "ampere:\n", 2, nullptr };
+static const UiFmt FMT_UI1_CAP      = { "capacity:\n", 2, " mAh" };
+static const UiFmt FMT_UI1_NOM_V    = { "Nominal voltage:\n", 2, " V" };
+static const UiFmt FMT_UI1_BTN_CAP  = { "Capacity\n", 2, " mAh" };
+static const UiFmt FMT_VOLTAGE      = { "Voltage:\n", 2, nullptr };
+static const UiFmt FMT_AMPERE       = { "Ampere:\n", 2, nullptr };
+
 // ---------- UI1: Emulate / laadcurve-scherm ----------
 
 // pointers bewaren voor later gebruik / updates
+static lv_obj_t* ui1_scr               = nullptr;
 static lv_obj_t* ui1_chart             = nullptr;
 static lv_chart_series_t* ui1_series   = nullptr;
 
@@ -194,6 +259,15 @@ static lv_obj_t* ui1_btn_reset         = nullptr;
 static lv_obj_t* ui1_btn_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 static lv_obj_t* ui1_lbl_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 
+// Laatst getoond (zie Diffing updates)
+struct UI1Cache
+{
+    bool         chart_valid;
+    int16_t      chart[32];
+    UiLabelCache v_meas, i_meas, runtime, capacity, state, nominal_v, btn_capacity;
+};
+static UI1Cache ui1_cache;
+
 static lv_obj_t* make_btn(lv_obj_t* parent, const char* txt)
 {
     lv_obj_t* btn = lv_btn_create(parent);
@@ -223,8 +297,11 @@ static lv_obj_t* make_btn(lv_obj_t* parent, const char* txt)
 
 void ui1_create()
 {
+    if (ui1_scr) return;   // één keer bouwen, daarna alleen ui1_load
+
     lv_obj_t* scr = lv_obj_create(NULL);
-    lv_scr_load(scr);
+    ui1_scr = scr;
+    memset(&ui1_cache, 0, sizeof(ui1_cache));
 
 
     overlay_ensure_created();
@@ -343,64 +420,41 @@ void ui1_create()
 
 void ui1_update(const DisplayModel& m)
 {
-    // curve -> chart
+    UI1Cache& c = ui1_cache;
+
+    // curve -> chart: alleen gewijzigde punten, refresh alleen bij een wijziging
     if (ui1_chart && ui1_series) {
-        lv_chart_set_point_count(ui1_chart, 32);
+        bool changed = false;
         for (int i = 0; i < 32; ++i) {
             int v = 0;
             if (i < m.ui1.curve_len) v = m.ui1.curve[i];
             if (v < 0) v = 0;
             if (v > 100) v = 100;
+            if (c.chart_valid && c.chart[i] == v) continue;
+            c.chart[i] = (int16_t)v;
             lv_chart_set_value_by_id(ui1_chart, ui1_series, i, v);
+            changed = true;
         }
-        lv_chart_refresh(ui1_chart);
+        c.chart_valid = true;
+        if (changed) lv_chart_refresh(ui1_chart);
     }
 
-    if (ui1_label_v_meas) {
-        char b[32];
-        snprintf(b, sizeof(b), "voltage:\n%.2f", (double)m.ui1.voltage_val);
-        lv_label_set_text(ui1_label_v_meas, b);
-    }
-    if (ui1_label_i_meas) {
-        char b[32];
-        snprintf(b, sizeof(b), "ampere:\n%.2f", (double)m.ui1.current_val);
-        lv_label_set_text(ui1_label_i_meas, b);
-    }
-    if (ui1_label_runtime) {
-        uint32_t total = m.ui1.runtime_sec;
-        uint32_t mm = total / 60;
-        uint32_t ss = total % 60;
-
-        char b[32];
-        snprintf(b, sizeof(b), "runtime:\n%02lu:%02lu", (unsigned long)mm, (unsigned long)ss);
-        lv_label_set_text(ui1_label_runtime, b);
-    }
-
-    if (ui1_label_capacity) {
-        char b[40];
-        snprintf(b, sizeof(b), "capacity:\n%.2f mAh", (double)m.ui1.capacity_val);
-        lv_label_set_text(ui1_label_capacity, b);
-    }
-    if (ui1_label_state) {
-        lv_label_set_text(ui1_label_state, m.ui1.state_load ? "state:\nload" : "state:\nunload");
-    }
+    ui_label_fixed(ui1_label_v_meas, c.v_meas, FMT_UI1_V, m.ui1.voltage_mv);
+    ui_label_fixed(ui1_label_i_meas, c.i_meas, FMT_UI1_A, m.ui1.current_ma);
+    ui_label_mmss(ui1_label_runtime, c.runtime, "runtime:\n", m.ui1.runtime_sec);
+    ui_label_fixed(ui1_label_capacity, c.capacity, FMT_UI1_CAP, m.ui1.capacity_m);
+    ui_label_const(ui1_label_state, c.state, (int32_t)m.ui1.state_load,
+                   m.ui1.state_load ? "state:\nload" : "state:\nunload");
 
     // softkey tekst: nominal voltage + capacity knop
-    if (ui1_lbl_arr[2]) {
-        char b[40];
-        snprintf(b, sizeof(b), "Nominal voltage:\n%.2f V", (double)m.ui1.nominal_v_val);
-        lv_label_set_text(ui1_lbl_arr[2], b);
-    }
-    if (ui1_lbl_arr[3]) {
-        char b[40];
-        snprintf(b, sizeof(b), "Capacity\n%.2f mAh", (double)m.ui1.btn_capacity_val);
-        lv_label_set_text(ui1_lbl_arr[3], b);
-    }
+    ui_label_fixed(ui1_lbl_arr[2], c.nominal_v, FMT_UI1_NOM_V, m.ui1.nominal_mv);
+    ui_label_fixed(ui1_lbl_arr[3], c.btn_capacity, FMT_UI1_BTN_CAP, m.ui1.btn_capacity_m);
 }
 
 
 // ================= UI2: Constant source (gauge) =================
 
+static lv_obj_t* ui2_scr             = nullptr;
 static lv_obj_t* ui2_arc             = nullptr;
 static lv_obj_t* ui2_label_voltage   = nullptr;
 static lv_obj_t* ui2_label_ampere    = nullptr;
@@ -414,6 +468,9 @@ static lv_obj_t* ui2_btn_reset         = nullptr;
 static lv_obj_t* ui2_btn_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 static lv_obj_t* ui2_lbl_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 
+struct UI2Cache { UiLabelCache voltage, ampere; };
+static UI2Cache ui2_cache;
+
 static lv_obj_t* ui2_make_btn(lv_obj_t* parent, const char* txt)
 {
     lv_obj_t* btn = lv_btn_create(parent);
@@ -443,8 +500,11 @@ static lv_obj_t* ui2_make_btn(lv_obj_t* parent, const char* txt)
 
 void ui2_create()
 {
+    if (ui2_scr) return;   // één keer bouwen, daarna alleen ui2_load
+
     lv_obj_t* scr = lv_obj_create(NULL);
-    lv_scr_load(scr);
+    ui2_scr = scr;
+    memset(&ui2_cache, 0, sizeof(ui2_cache));
 
 
     overlay_ensure_created();
@@ -479,7 +539,7 @@ void ui2_create()
 
     ui2_btn_voltage       = ui2_make_btn(sidebar, "Voltage");
     ui2_btn_current_limit = ui2_make_btn(sidebar, "current limit");
-    ui2_btn_empty3        = ui2_make_btn(sidebar, "");
+    ui2_btn_empty3        = ui2_make_btn(sidebar, "Autotune");
     ui2_btn_empty4        = ui2_make_btn(sidebar, "");
     ui2_btn_reset         = ui2_make_btn(sidebar, "Reset");
 
@@ -530,29 +590,23 @@ void ui2_create()
 
 void ui2_update(const DisplayModel& m)
 {
-    float vmax = (m.ui2.vmax <= 0.001f) ? 1.0f : m.ui2.vmax;
+    const int32_t vmax = (m.ui2.vmax_mv <= 1) ? 1000 : m.ui2.vmax_mv;
 
-    int pct = (int)((m.ui2.set_voltage / vmax) * 100.0f + 0.5f);
+    int pct = (int)(((int64_t)m.ui2.set_mv * 100 + vmax / 2) / vmax);
     if (pct < 0) pct = 0;
     if (pct > 100) pct = 100;
 
+    // lv_arc_set_value doet zelf niets bij dezelfde waarde
     if (ui2_arc) lv_arc_set_value(ui2_arc, pct);
 
-    if (ui2_label_voltage) {
-        char b[32];
-        snprintf(b, sizeof(b), "Voltage:\n%.2f", (double)m.ui2.set_voltage);
-        lv_label_set_text(ui2_label_voltage, b);
-    }
-    if (ui2_label_ampere) {
-        char b[32];
-        snprintf(b, sizeof(b), "Ampere:\n%.2f", (double)m.ui2.meas_ampere);
-        lv_label_set_text(ui2_label_ampere, b);
-    }
+    ui_label_fixed(ui2_label_voltage, ui2_cache.voltage, FMT_VOLTAGE, m.ui2.set_mv);
+    ui_label_fixed(ui2_label_ampere, ui2_cache.ampere, FMT_AMPERE, m.ui2.meas_ma);
 }
 
 
 // ================= UI3: Constant sink (gauge) =================
 
+static lv_obj_t* ui3_scr             = nullptr;
 static lv_obj_t* ui3_arc             = nullptr;
 static lv_obj_t* ui3_label_ampere    = nullptr;
 static lv_obj_t* ui3_label_voltage   = nullptr;
@@ -566,6 +620,9 @@ static lv_obj_t* ui3_btn_reset         = nullptr;
 static lv_obj_t* ui3_btn_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 static lv_obj_t* ui3_lbl_arr[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 
+struct UI3Cache { UiLabelCache ampere, voltage; };
+static UI3Cache ui3_cache;
+
 static lv_obj_t* ui3_make_btn(lv_obj_t* parent, const char* txt)
 {
     lv_obj_t* btn = lv_btn_create(parent);
@@ -595,8 +652,11 @@ static lv_obj_t* ui3_make_btn(lv_obj_t* parent, const char* txt)
 
 void ui3_create()
 {
+    if (ui3_scr) return;   // één keer bouwen, daarna alleen ui3_load
+
     lv_obj_t* scr = lv_obj_create(NULL);
-    lv_scr_load(scr);
+    ui3_scr = scr;
+    memset(&ui3_cache, 0, sizeof(ui3_cache));
 
 
     overlay_ensure_created();
@@ -631,7 +691,7 @@ void ui3_create()
 
     ui3_btn_ampere = ui3_make_btn(sidebar, "Ampere");
     ui3_btn_vlimit = ui3_make_btn(sidebar, "voltage limit");
-    ui3_btn_empty3 = ui3_make_btn(sidebar, "");
+    ui3_btn_empty3 = ui3_make_btn(sidebar, "Autotune");
     ui3_btn_empty4 = ui3_make_btn(sidebar, "");
     ui3_btn_reset  = ui3_make_btn(sidebar, "Reset");
 
@@ -682,25 +742,16 @@ void ui3_create()
 
 void ui3_update(const DisplayModel& m)
 {
-    float imax = (m.ui3.imax <= 0.001f) ? 1.0f : m.ui3.imax;
+    const int32_t imax = (m.ui3.imax_ma <= 1) ? 1000 : m.ui3.imax_ma;
 
-    int pct = (int)((m.ui3.set_ampere / imax) * 100.0f + 0.5f);
+    int pct = (int)(((int64_t)m.ui3.set_ma * 100 + imax / 2) / imax);
     if (pct < 0) pct = 0;
     if (pct > 100) pct = 100;
 
     if (ui3_arc) lv_arc_set_value(ui3_arc, pct);
 
-    if (ui3_label_ampere) {
-        char b[32];
-        snprintf(b, sizeof(b), "Ampere:\n%.2f", (double)m.ui3.set_ampere);
-        lv_label_set_text(ui3_label_ampere, b);
-    }
-
-    if (ui3_label_voltage) {
-        char b[32];
-        snprintf(b, sizeof(b), "Voltage:\n%.2f", (double)m.ui3.meas_voltage);
-        lv_label_set_text(ui3_label_voltage, b);
-    }
+    ui_label_fixed(ui3_label_ampere, ui3_cache.ampere, FMT_AMPERE, m.ui3.set_ma);
+    ui_label_fixed(ui3_label_voltage, ui3_cache.voltage, FMT_VOLTAGE, m.ui3.meas_mv);
 }
 
 
@@ -725,7 +776,13 @@ void ui1_set_softkey_highlight(uint8_t key_index, bool on) { softkey_set(key_ind
 void ui2_set_softkey_highlight(uint8_t key_index, bool on) { softkey_set(key_index, on, ui2_btn_arr, ui2_lbl_arr); }
 void ui3_set_softkey_highlight(uint8_t key_index, bool on) { softkey_set(key_index, on, ui3_btn_arr, ui3_lbl_arr); }
 
-void ui1_set_softkey_text(uint8_t key_index, const char* text) { softkey_text(key_index, text, ui1_lbl_arr); }
+void ui1_set_softkey_text(uint8_t key_index, const char* text)
+{
+    softkey_text(key_index, text, ui1_lbl_arr);
+    // knop 3/4 worden ook door ui1_update gezet: cache ongeldig
+    if (key_index == 3) ui1_cache.nominal_v.valid = false;
+    if (key_index == 4) ui1_cache.btn_capacity.valid = false;
+}
 void ui2_set_softkey_text(uint8_t key_index, const char* text) { softkey_text(key_index, text, ui2_lbl_arr); }
 void ui3_set_softkey_text(uint8_t key_index, const char* text) { softkey_text(key_index, text, ui3_lbl_arr); }
 
@@ -760,3 +817,26 @@ void ui3_softkey_set_active(int idx, bool active)
 void ui1_softkey_clear_all() { clear_all(ui1_btn_arr, ui1_lbl_arr); }
 void ui2_softkey_clear_all() { clear_all(ui2_btn_arr, ui2_lbl_arr); }
 void ui3_softkey_clear_all() { clear_all(ui3_btn_arr, ui3_lbl_arr); }
+
+
+// =========================
+// Schermen wisselen
+// =========================
+// Alle drie de schermen blijven bestaan; een wissel is alleen lv_screen_load
+// (geen allocatie, geen layout). De caches en label-teksten blijven geldig, dus
+// na terugkeer ververst ui*_update alleen wat intussen veranderd is.
+void ui_screens_init()
+{
+    ui1_create();
+    ui2_create();
+    ui3_create();
+
+    // Flex-layout van de sidebars nu uitrekenen, niet bij de eerste wissel
+    lv_obj_update_layout(ui1_scr);
+    lv_obj_update_layout(ui2_scr);
+    lv_obj_update_layout(ui3_scr);
+}
+
+void ui1_load() { ui1_create(); lv_screen_load(ui1_scr); }
+void ui2_load() { ui2_create(); lv_screen_load(ui2_scr); }
+void ui3_load() { ui3_create(); lv_screen_load(ui3_scr); }
@@ -0,0 +1,173 @@
+// emulate/emulate.cpp
+#include "emulate/emulate.h"
+#include "system/crc.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+static float clamp01(float v)
+{
+    if (v < 0.0f) return 0.0f;
+    if (v > 1.0f) return 1.0f;
+    return v;
+}
+
+void emu_default_curves(CurveData* c)
+{
+    if (!c) return;
+    c->len = CURVE_LEN;
+
+    // Realistische (ruwe) ontlaadcurves, genormaliseerd naar 0..100% van volle spanning.
+    // X-as: capaciteit / SOC van 100% -> 0% (links->rechts).
+    // Dit zijn "typische vormen" en geen datasheet-garanties.
+
+    // Curve 0: Li-ion (NMC/18650) - snelle init drop, lange plateau, eind-sag
+    const int16_t liion[CURVE_LEN] = {
+        100,99,98,97,96,95,95,94,
+        94,93,93,92,92,91,91,90,
+        89,88,87,86,85,84,82,80,
+        78,76,73,68,60,48,30,10
+    };
+
+    // Curve 1: LiFePO4 - zeer vlak plateau rond ~3.3V, daarna snelle drop
+    const int16_t lifepo4[CURVE_LEN] = {
+        100,99,99,98,98,97,97,96,
+        96,96,95,95,95,94,94,94,
+        93,93,93,92,92,92,91,90,
+        88,85,80,70,55,38,20,8
+    };
+
+    // Curve 2: Lead-acid - meer lineaire sag
+    const int16_t leadacid[CURVE_LEN] = {
+        100,99,98,97,96,95,94,93,
+        92,91,90,89,88,87,86,85,
+        84,83,82,81,80,79,78,76,
+        74,72,70,67,62,54,42,28
+    };
+
+    memcpy(c->curve0, liion, sizeof(liion));
+    memcpy(c->curve1, lifepo4, sizeof(lifepo4));
+    memcpy(c->curve2, leadacid, sizeof(leadacid));
+}
+
+void emu_params_from_curves(EmuParams* p, const CurveData* curves, uint8_t curve_id,
+                            float nominal_voltage, float capacity_mAh)
+{
+    if (!p || !curves) return;
+    memset(p, 0, sizeof(*p));
+
+    const int16_t* src = curves->curve0;
+    if (curve_id == 1) src = curves->curve1;
+    else if (curve_id == 2) src = curves->curve2;
+
+    p->curve           = src;
+    p->curve_len       = (curves->len > 0 && curves->len <= CURVE_LEN) ? curves->len : CURVE_LEN;
+    p->curve_unit      = 0.01f;
+    p->nominal_voltage = nominal_voltage;
+    p->capacity_mAh    = capacity_mAh;
+
+    // Typische 18650-achtige waarden; worden later per model overschreven.
+    p->r0_ohm   = 0.05f;
+    p->r1_ohm   = 0.02f;
+    p->c1_f     = 1000.0f;
+    p->v_cutoff = 0.0f;
+}
+
+bool emu_model_validate(const EmuModelBlob* m)
+{
+    if (!m) return false;
+    if (m->magic != EMU_MODEL_MAGIC || m->version != EMU_MODEL_VERSION) return false;
+    if (m->curve_len != CURVE_LEN) return false;
+    if (!(m->nominal_voltage > 0.0f) || !(m->capacity_mAh > 0.0f)) return false;
+    if (m->r0_ohm < 0.0f || m->r1_ohm < 0.0f || m->c1_f < 0.0f) return false;
+    return m->crc32 == crc32_ieee(m, offsetof(EmuModelBlob, crc32));
+}
+
+void emu_model_seal(EmuModelBlob* m)
+{
+    if (!m) return;
+    m->crc32 = crc32_ieee(m, offsetof(EmuModelBlob, crc32));
+}
+
+bool emu_params_from_model(EmuParams* p, const EmuModelBlob* m)
+{
+    if (!p || !emu_model_validate(m)) return false;
+    memset(p, 0, sizeof(*p));
+
+    p->curve           = m->curve;
+    p->curve_len       = m->curve_len;
+    p->curve_unit      = EMU_MODEL_CURVE_UNIT;
+    p->nominal_voltage = m->nominal_voltage;
+    p->capacity_mAh    = m->capacity_mAh;
+    p->r0_ohm          = m->r0_ohm;
+    p->r1_ohm          = m->r1_ohm;
+    p->c1_f            = m->c1_f;
+    p->v_cutoff        = 0.0f;
+    return true;
+}
+
+float emu_soc_from_start_index(uint8_t start_index, uint16_t curve_len)
+{
+    if (curve_len < 2) return 1.0f;
+    if (start_index > curve_len - 1) start_index = (uint8_t)(curve_len - 1);
+    return 1.0f - (float)start_index / (float)(curve_len - 1);
+}
+
+void emu_init(EmuState* s, const EmuParams* p, float soc0)
+{
+    if (!s || !p) return;
+    memset(s, 0, sizeof(*s));
+    s->soc     = clamp01(soc0);
+    s->soc_acc = s->soc;
+    s->v_term  = emu_ocv(p, s->soc);
+    s->empty  = (s->soc <= 0.0f);
+}
+
+float emu_ocv(const EmuParams* p, float soc)
+{
+    if (!p || !p->curve || p->curve_len < 2) return 0.0f;
+
+    // x-as van de curve loopt van SOC 100% (index 0) naar 0% (laatste index)
+    const float x = (1.0f - clamp01(soc)) * (float)(p->curve_len - 1);
+    int i = (int)x;
+    if (i >= p->curve_len - 1) i = p->curve_len - 2;
+    const float f = x - (float)i;
+
+    const float pct = (float)p->curve[i] + f * (float)(p->curve[i + 1] - p->curve[i]);
+    return p->nominal_voltage * pct * p->curve_unit;
+}
+
+float emu_step(EmuState* s, const EmuParams* p, float i_load_a, float dt_s)
+{
+    if (!s || !p) return 0.0f;
+
+    // Coulomb counting (in double, zie EmuState)
+    const double cap_ah = (double)p->capacity_mAh * 0.001;
+    const double dq_ah  = (double)i_load_a * (double)dt_s * (1.0 / 3600.0);
+    if (cap_ah > 0.0) {
+        double soc = s->soc_acc - dq_ah / cap_ah;
+        if (soc < 0.0) soc = 0.0;
+        if (soc > 1.0) soc = 1.0;
+        s->soc_acc = soc;
+        s->soc     = (float)soc;
+    }
+    s->ah_acc += dq_ah;
+    s->ah_out  = (float)s->ah_acc;
+
+    // RC-tak (exacte discretisatie, stabiel voor elke dt)
+    if (p->r1_ohm > 0.0f && p->c1_f > 0.0f) {
+        const float a = expf(-dt_s / (p->r1_ohm * p->c1_f));
+        s->v_rc = a * s->v_rc + (1.0f - a) * p->r1_ohm * i_load_a;
+    } else {
+        s->v_rc = 0.0f;
+    }
+
+    s->v_term  = emu_ocv(p, s->soc) - p->r0_ohm * i_load_a - s->v_rc;
+    if (s->v_term < 0.0f) s->v_term = 0.0f;
+    s->wh_acc += (double)s->v_term * dq_ah;
+    s->wh_out  = (float)s->wh_acc;
+
+    s->empty = (s->soc_acc <= 0.0) || (s->v_term < p->v_cutoff);
+    return s->v_term;
+}
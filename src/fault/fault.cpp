@@ -0,0 +1,166 @@
+// fault/fault.cpp
+#include "fault/fault.h"
+
+#include <string.h>
+
+// =========================
+// Tabel
+// =========================
+namespace {
+
+constexpr FaultDef kDefs[FID_COUNT] = {
+    //  bit              klasse                 on_count on_ms off_ms  naam
+    { FAULT_OV,        FAULT_CLASS_SHUTDOWN,  2,        0,   100,  "OV"        },
+    { FAULT_OC,        FAULT_CLASS_SHUTDOWN,  2,        0,   100,  "OC"        },
+    { FAULT_OT,        FAULT_CLASS_SHUTDOWN,  1,      200,  5000,  "OT"        },
+    { FAULT_OT_DERATE, FAULT_CLASS_DERATE,    1,      500,  5000,  "OT_DERATE" },
+    { FAULT_HW,        FAULT_CLASS_SHUTDOWN,  1,        0,     0,  "HW"        },
+    { FAULT_COMM,      FAULT_CLASS_SHUTDOWN,  1,      100,   500,  "COMM"      },
+    { FAULT_SD,        FAULT_CLASS_WARN,      1,     1000,  1000,  "SD"        },
+};
+
+constexpr uint32_t class_bits(FaultClass cls, int i)
+{
+    return i >= FID_COUNT ? 0u : ((kDefs[i].cls == cls ? kDefs[i].bit : 0u) | class_bits(cls, i + 1));
+}
+
+constexpr bool defs_ok(int i)
+{
+    return i >= FID_COUNT ? true : (kDefs[i].bit != 0 && kDefs[i].on_count >= 1 && defs_ok(i + 1));
+}
+
+static_assert(sizeof(kDefs) / sizeof(kDefs[0]) == FID_COUNT, "fault-tabel: rij per FaultId");
+static_assert(defs_ok(0), "fault-tabel: bit en on_count verplicht");
+static_assert(class_bits(FAULT_CLASS_SHUTDOWN, 0) == FAULT_SHUTDOWN_BITS,
+              "FAULT_SHUTDOWN_BITS loopt niet gelijk met de fault-tabel");
+
+// Meetgrenzen
+constexpr uint32_t MEAS_IDS = (1u << FID_OV) | (1u << FID_OC) | (1u << FID_OT) | (1u << FID_OT_DERATE);
+
+} // namespace
+
+const FaultDef* fm_def(FaultId id)
+{
+    return ((unsigned)id < FID_COUNT) ? &kDefs[id] : nullptr;
+}
+
+void fm_limits_default(FaultLimits* lim)
+{
+    if (!lim) return;
+    lim->v_ov       = 16.0f;   // boven CTRL_SOURCE_V_FULL        <-- AANPASSEN
+    lim->i_oc       = 10.5f;   // boven CTRL_SINK_I_FULL          <-- AANPASSEN
+    lim->t_derate   = 75.0f;   // koellichaam sink                <-- AANPASSEN
+    lim->t_shutdown = 90.0f;
+}
+
+void fm_init(FaultManager* fm)
+{
+    if (!fm) return;
+    memset(fm, 0, sizeof(*fm));
+}
+
+uint32_t fm_measure_raw(const FaultLimits* lim, const MeasurementData* m)
+{
+    if (!lim || !m) return 0;
+    uint32_t raw = 0;
+    if (m->v_out > lim->v_ov) raw |= 1u << FID_OV;
+    if (m->i_source > lim->i_oc || m->i_sink > lim->i_oc) raw |= 1u << FID_OC;
+    if (m->temp_sink_c > lim->t_shutdown) raw |= 1u << FID_OT;
+    if (m->temp_sink_c > lim->t_derate) raw |= 1u << FID_OT_DERATE;
+    return raw & MEAS_IDS;
+}
+
+void fm_update(FaultManager* fm, uint32_t raw, uint32_t events, const uint32_t* t_first_us,
+               uint32_t t_us, FaultOutput* out)
+{
+    if (!fm || !out) return;
+    memset(out, 0, sizeof(*out));
+    if (t_us == 0) t_us = 1;   // 0 = "geen tijd"
+    raw |= events;
+
+    for (int id = 0; id < FID_COUNT; ++id)
+    {
+        const FaultDef& d = kDefs[id];
+        const uint32_t b = 1u << id;
+
+        if (raw & b) {
+            if (fm->t_raw_us[id] == 0) {
+                const uint32_t t0 = (t_first_us && t_first_us[id]) ? t_first_us[id] : t_us;
+                fm->t_raw_us[id] = t0 ? t0 : 1;
+            }
+            if (fm->count[id] < 255) fm->count[id]++;
+            fm->t_clear_us[id] = 0;
+
+            if (!(fm->asserted & b)) {
+                const int32_t held = (int32_t)(t_us - fm->t_raw_us[id]);
+                const uint32_t held_us = held > 0 ? (uint32_t)held : 0u;
+                // Een event staat maar één evaluatie aan: geen persistentie
+                const bool persisted = fm->count[id] >= d.on_count && held_us >= (uint32_t)d.on_ms * 1000u;
+                if ((events & b) || persisted) {
+                    fm->asserted |= b;
+                    fm->react_pending |= b;
+                    fm->t_detect_us[id] = fm->t_raw_us[id];
+                    fm->t_assert_us[id] = t_us;
+                    out->set_bits |= d.bit;
+                    if (d.cls == FAULT_CLASS_SHUTDOWN) out->latch_bits |= d.bit;
+                }
+            }
+        } else {
+            fm->count[id] = 0;
+            fm->t_raw_us[id] = 0;
+            if (fm->asserted & b) {
+                if (fm->t_clear_us[id] == 0) fm->t_clear_us[id] = t_us;
+                if ((uint32_t)(t_us - fm->t_clear_us[id]) >= (uint32_t)d.off_ms * 1000u) {
+                    fm->asserted &= ~b;
+                    fm->t_clear_us[id] = 0;
+                    out->clear_bits |= d.bit;
+                }
+            }
+        }
+
+        if (fm->asserted & b) {
+            if (d.cls == FAULT_CLASS_SHUTDOWN) out->shutdown = true;
+        }
+    }
+
+    out->duty_cap = 1.0f;
+    for (int id = 0; id < FID_COUNT; ++id)
+        if ((fm->asserted & (1u << id)) && kDefs[id].cls == FAULT_CLASS_DERATE) out->duty_cap = FAULT_DERATE_DUTY;
+}
+
+void fm_reacted(FaultManager* fm, uint32_t t_us)
+{
+    if (!fm || !fm->react_pending) return;
+
+    for (int id = 0; id < FID_COUNT; ++id)
+    {
+        const uint32_t b = 1u << id;
+        if (!(fm->react_pending & b)) continue;
+
+        FaultRecord& r = fm->ring[fm->n_records % FAULT_RING_LEN];
+        r.id          = (uint8_t)id;
+        r.cls         = (uint8_t)kDefs[id].cls;
+        r.reserved    = 0;
+        r.t_detect_us = fm->t_detect_us[id];
+        r.t_assert_us = fm->t_assert_us[id];
+        r.t_react_us  = t_us;
+        fm->n_records++;
+
+        const uint32_t lat = t_us - r.t_detect_us;
+        fm->n_class[r.cls]++;
+        if (lat > fm->max_react_us[r.cls]) fm->max_react_us[r.cls] = lat;
+    }
+    fm->react_pending = 0;
+}
+
+uint32_t fm_worst_case_us(FaultId id, const FaultTiming* timing)
+{
+    const FaultDef* d = fm_def(id);
+    if (!d || !timing || timing->sample_period_us == 0) return 0;
+
+    const uint32_t ts = timing->sample_period_us;
+    const uint32_t k_count = (uint32_t)d->on_count - 1u;
+    const uint32_t k_ms = ((uint32_t)d->on_ms * 1000u + ts - 1u) / ts;
+    const uint32_t k = k_count > k_ms ? k_count : k_ms;
+    return ts * (1u + k) + timing->ctrl_latency_us + timing->act_latency_us;
+}
@@ -0,0 +1,154 @@
+// fault/fault_runtime.cpp
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "fault/fault.h"
+#include "actuation/actuation.h"
+#include "statemachine/statemachine.h"
+#include "system/system.h"
+
+// =========================
+// State
+// =========================
+// Alleen ControlTask evalueert; de ring wordt onder g_fm_mux gekopieerd.
+static FaultManager g_fm;
+static FaultLimits  g_lim;
+static bool         g_fm_init = false;
+static portMUX_TYPE g_fm_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Meldingen uit andere tasks (FaultId-masks) + tijdstip van de melding
+static std::atomic<uint32_t> g_reported(0);
+static std::atomic<uint32_t> g_pulses(0);
+static std::atomic<uint32_t> g_report_t_us[FID_COUNT];
+
+static const char* const CLASS_NAMES[FAULT_CLASS_COUNT] = { "shutdown", "derate", "warn" };
+
+static inline uint32_t now_us(void) { return (uint32_t)esp_timer_get_time(); }
+
+extern "C" void fault_report(FaultId id, bool active)
+{
+    if ((unsigned)id >= FID_COUNT) return;
+    const uint32_t b = 1u << id;
+    if (active) {
+        if (!(g_reported.load(std::memory_order_relaxed) & b)) g_report_t_us[id].store(now_us(), std::memory_order_relaxed);
+        g_reported.fetch_or(b, std::memory_order_release);
+    } else {
+        g_reported.fetch_and(~b, std::memory_order_release);
+    }
+}
+
+extern "C" void fault_report_event(FaultId id)
+{
+    if ((unsigned)id >= FID_COUNT) return;
+    g_report_t_us[id].store(now_us(), std::memory_order_relaxed);
+    g_pulses.fetch_or(1u << id, std::memory_order_release);
+}
+
+// =========================
+// ControlTask
+// =========================
+extern "C" void fault_tick(const SystemSnapshot* s, FaultOutput* out)
+{
+    if (!s || !out) return;
+    if (!g_fm_init) {
+        fm_init(&g_fm);
+        fm_limits_default(&g_lim);
+        g_fm_init = true;
+    }
+
+    const uint32_t raw_meas = (s->meas.t_us != 0) ? fm_measure_raw(&g_lim, &s->meas) : 0u;
+    const uint32_t events = g_pulses.exchange(0, std::memory_order_acq_rel);
+    uint32_t raw_rep = g_reported.load(std::memory_order_acquire) | events;
+
+    // I2C-uitgangen (rpot/relais) niet geschreven: zelfde klasse als een I2C-melding
+    if (s->apply.apply_error_flags & (APPLY_I2C_ERR_RPOT | APPLY_I2C_ERR_MODE_SW)) raw_rep |= 1u << FID_COMM;
+
+    uint32_t t_first[FID_COUNT];
+    for (int id = 0; id < FID_COUNT; ++id) {
+        const uint32_t b = 1u << id;
+        if (raw_meas & b)     t_first[id] = s->meas.t_us;
+        else if (raw_rep & b) t_first[id] = g_report_t_us[id].load(std::memory_order_relaxed);
+        else                  t_first[id] = 0;
+    }
+
+    portENTER_CRITICAL(&g_fm_mux);
+    fm_update(&g_fm, raw_meas | raw_rep, events, t_first, now_us(), out);
+    portEXIT_CRITICAL(&g_fm_mux);
+
+    if (!(out->set_bits | out->clear_bits)) return;
+
+    if (out->latch_bits) system_latch_fault_bits(out->latch_bits);
+    if (out->set_bits & ~out->latch_bits) system_set_fault_bits(out->set_bits & ~out->latch_bits);
+    if (out->clear_bits) system_clear_fault_bits(out->clear_bits);
+    if ((out->set_bits | out->clear_bits) & FAULT_SHUTDOWN_BITS) sm_post(SM_EV_FAULT);
+
+    for (int id = 0; id < FID_COUNT; ++id) {
+        const FaultDef* d = fm_def((FaultId)id);
+        if ((out->set_bits | out->clear_bits) & d->bit)
+            Serial.printf("fault: %s %s (%s)\n", d->name,
+                          (out->set_bits & d->bit) ? "actief" : "weg", CLASS_NAMES[d->cls]);
+    }
+}
+
+extern "C" void fault_reacted(void)
+{
+    if (!g_fm.react_pending) return;
+    portENTER_CRITICAL(&g_fm_mux);
+    fm_reacted(&g_fm, now_us());
+    portEXIT_CRITICAL(&g_fm_mux);
+}
+
+// =========================
+// Diagnose
+// =========================
+extern "C" int fault_get_records(FaultRecord* out, int max)
+{
+    if (!out || max <= 0) return 0;
+    portENTER_CRITICAL(&g_fm_mux);
+    const uint32_t n_total = g_fm.n_records;
+    int n = (n_total < (uint32_t)FAULT_RING_LEN) ? (int)n_total : FAULT_RING_LEN;
+    if (n > max) n = max;
+    for (int i = 0; i < n; ++i) out[i] = g_fm.ring[(n_total - 1u - (uint32_t)i) % FAULT_RING_LEN];
+    portEXIT_CRITICAL(&g_fm_mux);
+    return n;
+}
+
+extern "C" bool fault_print_worst_case(void)
+{
+    // Tact pas na het eerste afgesloten actuation-venster bekend
+    ActuationStats st;
+    actuation_get_stats(&st);
+    if (st.cycles == 0 || st.pwm_latency_us_max == 0) return false;
+
+    FaultTiming tm;
+    tm.sample_period_us = 1000;
+    tm.ctrl_latency_us  = 200;
+    tm.act_latency_us   = st.pwm_latency_us_max;
+
+    Serial.printf("fault: worst case reactie (Ts %u us, Tctrl %u us, Tact %u us)\n",
+                  (unsigned)tm.sample_period_us, (unsigned)tm.ctrl_latency_us, (unsigned)tm.act_latency_us);
+    for (int id = 0; id < FID_COUNT; ++id) {
+        const FaultDef* d = fm_def((FaultId)id);
+        Serial.printf("  %-10s %-8s on %u/%u ms off %u ms  -> %.1f ms\n",
+                      d->name, CLASS_NAMES[d->cls], (unsigned)d->on_count, (unsigned)d->on_ms,
+                      (unsigned)d->off_ms, fm_worst_case_us((FaultId)id, &tm) * 1e-3);
+    }
+
+    // Alleen de tellers kopiëren (draait op een kleine stack)
+    uint32_t n_class[FAULT_CLASS_COUNT];
+    uint32_t max_react_us[FAULT_CLASS_COUNT];
+    portENTER_CRITICAL(&g_fm_mux);
+    memcpy(n_class, g_fm.n_class, sizeof(n_class));
+    memcpy(max_react_us, g_fm.max_react_us, sizeof(max_react_us));
+    portEXIT_CRITICAL(&g_fm_mux);
+    for (int c = 0; c < FAULT_CLASS_COUNT; ++c) {
+        if (n_class[c] == 0) continue;
+        Serial.printf("  gemeten %-8s: %u asserts, max detectie->reactie %.2f ms\n",
+                      CLASS_NAMES[c], (unsigned)n_class[c], max_react_us[c] * 1e-3);
+    }
+    return true;
+}
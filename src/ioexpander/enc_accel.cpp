@@ -0,0 +1,60 @@
+// ioexpander/enc_accel.cpp
+#include "ioexpander/enc_accel.h"
+
+#include <string.h>
+
+void enc_accel_default(EncAccelConfig* cfg)
+{
+    if (!cfg) return;
+    cfg->v_lo    = 8.0f;    // rustig draaien: 1 stap per detent
+    cfg->v_scale = 4.0f;    // 30 det/s ~ x31, 50 det/s ~ x111, 80 det/s ~ x325
+    cfg->idle_s  = 0.25f;
+}
+
+void enc_accel_reset(EncAccel* a, int32_t detents, uint32_t t_us)
+{
+    if (!a) return;
+    memset(a, 0, sizeof(*a));
+    a->last_detents = detents;
+    a->last_t_us = t_us;
+}
+
+float enc_accel_multiplier(const EncAccel* a, const EncAccelConfig* cfg, uint32_t max_mult)
+{
+    if (!a || !cfg || max_mult <= 1 || a->v <= cfg->v_lo) return 1.0f;
+    const float x = (a->v - cfg->v_lo) / cfg->v_scale;
+    const float m = 1.0f + x * x;
+    return (m > (float)max_mult) ? (float)max_mult : m;
+}
+
+int32_t enc_accel_update(EncAccel* a, const EncAccelConfig* cfg,
+                         int32_t detents, uint32_t t_detent_us, uint32_t max_mult)
+{
+    if (!a || !cfg) return 0;
+
+    const int32_t d = detents - a->last_detents;
+    if (d == 0) return 0;
+    a->last_detents = detents;
+
+    const int8_t dir = (d > 0) ? 1 : -1;
+    const float dt = (float)(uint32_t)(t_detent_us - a->last_t_us) * 1e-6f;
+    a->last_t_us = t_detent_us;
+
+    if (!a->valid || dir != a->dir || dt > cfg->idle_s || dt <= 0.0f) {
+        // Eerste detent na stilstand of omkeren: langzaam beginnen
+        a->v = 0.0f;
+        a->frac = 0.0f;
+    } else {
+        // Snel omhoog, rustig omlaag (een korte hapering breekt de versnelling niet)
+        const float n = (float)(d > 0 ? d : -d);
+        const float v_inst = n / dt;
+        a->v = (v_inst > a->v) ? v_inst : a->v + 0.5f * (v_inst - a->v);
+    }
+    a->dir = dir;
+    a->valid = true;
+
+    const float steps = (float)d * enc_accel_multiplier(a, cfg, max_mult) + a->frac;
+    const int32_t out = (int32_t)steps;   // afkappen richting 0
+    a->frac = steps - (float)out;
+    return out;
+}
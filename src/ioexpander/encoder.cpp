@@ -0,0 +1,122 @@
+// ioexpander/encoder.cpp
+#include <Arduino.h>
+#include <atomic>
+
+#include "driver/pcnt.h"
+#include "esp_timer.h"
+
+#include "ioexpander/encoder.h"
+#include "ioexpander/ioexpander.h"
+#include "system/pins.h"
+
+// =========================
+// Pinnen / PCNT
+// =========================
+// A/B: PIN_ENC_A / PIN_ENC_B in system/pins.h
+
+static constexpr pcnt_unit_t ENC_UNIT = PCNT_UNIT_0;
+
+// Glitchfilter in APB-klokken (max 1023 = 12.8 us @ 80 MHz). Contactdender die
+// langer duurt heft zichzelf op bij x4-decodering (+1/-1 op hetzelfde kanaal).
+static constexpr uint16_t ENC_FILTER_APB = 1023;
+
+// =========================
+// Teller (lock-free)
+// =========================
+// Detents + tijdstempel worden in de ISR bijgewerkt; consumenten lezen met een
+// sequence (oneven = ISR bezig) zodat teller en tijd bij elkaar horen.
+static std::atomic<uint32_t> g_seq(0);
+static std::atomic<int32_t>  g_detents(0);
+static std::atomic<uint32_t> g_t_last_us(0);
+
+static void IRAM_ATTR enc_publish(int32_t d)
+{
+    g_seq.fetch_add(1, std::memory_order_acq_rel);
+    g_detents.fetch_add(d, std::memory_order_relaxed);
+    g_t_last_us.store((uint32_t)esp_timer_get_time(), std::memory_order_relaxed);
+    g_seq.fetch_add(1, std::memory_order_acq_rel);
+}
+
+static void IRAM_ATTR enc_isr(void* arg)
+{
+    (void)arg;
+    uint32_t status = 0;
+    pcnt_get_event_status(ENC_UNIT, &status);
+
+    int32_t d = 0;
+    if (status & PCNT_EVT_THRES_0) d = 1;
+    else if (status & PCNT_EVT_THRES_1) d = -1;
+    if (d == 0) return;
+
+    // Terug naar 0: de volgende detent is weer +-ENC_COUNTS_PER_DETENT vanaf hier
+    pcnt_counter_clear(ENC_UNIT);
+    enc_publish(d);
+    io_event_notify_from_isr();
+}
+
+extern "C" void encoder_init(void)
+{
+    // Kanaal 0: tel op A, richting uit B; kanaal 1: tel op B, richting uit A -> x4
+    pcnt_config_t c = {};
+    c.unit           = ENC_UNIT;
+    c.counter_h_lim  = 2 * ENC_COUNTS_PER_DETENT;
+    c.counter_l_lim  = -2 * ENC_COUNTS_PER_DETENT;
+
+    c.channel        = PCNT_CHANNEL_0;
+    c.pulse_gpio_num = PIN_ENC_A;
+    c.ctrl_gpio_num  = PIN_ENC_B;
+    c.pos_mode       = PCNT_COUNT_DEC;
+    c.neg_mode       = PCNT_COUNT_INC;
+    c.lctrl_mode     = PCNT_MODE_REVERSE;
+    c.hctrl_mode     = PCNT_MODE_KEEP;
+    pcnt_unit_config(&c);
+
+    c.channel        = PCNT_CHANNEL_1;
+    c.pulse_gpio_num = PIN_ENC_B;
+    c.ctrl_gpio_num  = PIN_ENC_A;
+    c.pos_mode       = PCNT_COUNT_INC;
+    c.neg_mode       = PCNT_COUNT_DEC;
+    pcnt_unit_config(&c);
+
+    pcnt_set_filter_value(ENC_UNIT, ENC_FILTER_APB);
+    pcnt_filter_enable(ENC_UNIT);
+
+    pcnt_set_event_value(ENC_UNIT, PCNT_EVT_THRES_0, ENC_COUNTS_PER_DETENT);
+    pcnt_set_event_value(ENC_UNIT, PCNT_EVT_THRES_1, -ENC_COUNTS_PER_DETENT);
+    pcnt_event_enable(ENC_UNIT, PCNT_EVT_THRES_0);
+    pcnt_event_enable(ENC_UNIT, PCNT_EVT_THRES_1);
+
+    pcnt_counter_pause(ENC_UNIT);
+    pcnt_counter_clear(ENC_UNIT);
+
+    pcnt_isr_service_install(0);
+    pcnt_isr_handler_add(ENC_UNIT, enc_isr, nullptr);
+    pcnt_counter_resume(ENC_UNIT);
+
+    Serial.printf("encoder: PCNT unit %d, filter %u APB, %d tellen/detent\n",
+                  (int)ENC_UNIT, (unsigned)ENC_FILTER_APB, ENC_COUNTS_PER_DETENT);
+}
+
+extern "C" int32_t encoder_detents(uint32_t* t_last_us)
+{
+    uint32_t s1, s2;
+    int32_t d;
+    uint32_t t;
+    do {
+        s1 = g_seq.load(std::memory_order_acquire);
+        d  = g_detents.load(std::memory_order_relaxed);
+        t  = g_t_last_us.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s2 = g_seq.load(std::memory_order_relaxed);
+    } while ((s1 & 1u) || s1 != s2);
+
+    if (t_last_us) *t_last_us = t;
+    return d;
+}
+
+extern "C" void encoder_inject(int32_t detents)
+{
+    // Niet gelijktijdig met de ISR op een andere core gebruiken (alleen testharnas)
+    enc_publish(detents);
+    io_event_notify();
+}
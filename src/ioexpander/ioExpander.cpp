@@ -0,0 +1,398 @@
+// ioexpander/ioExpander.cpp
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "system/system.h"
+#include "system/pins.h"
+#include "ioexpander/ioexpander.h"
+#include "ioexpander/encoder.h"
+#include "fault/fault.h"
+
+// =========================
+// AW9523 (zelfde chip als de backlight, 0x58)
+// =========================
+static constexpr uint8_t AW_ADDR       = 0x58;
+static constexpr uint8_t AW_REG_IN_P0  = 0x00;   // lezen wist de interrupt
+static constexpr uint8_t AW_REG_CFG_P0 = 0x04;   // 1 = input
+static constexpr uint8_t AW_REG_INT_P0 = 0x06;   // 0 = interrupt aan
+
+// INTN-pin: PIN_IOX_INT in system/pins.h (-1 = pollen)
+
+// Knoppen: expanderpin (0..7 = P0, 8..15 = P1) -> bit in buttons_raw_bits. Actief laag.
+// AANPASSEN aan het schema; P0_0..5 zijn de backlight-LED's.
+struct ButtonMap
+{
+    uint8_t pin;
+    uint8_t bit;
+    bool    long_press;   // CLICK/LONG i.p.v. alleen PRESS/RELEASE
+};
+
+static const ButtonMap BUTTONS[] = {
+    { 8, 0, false}, { 9, 1, false}, {10, 2, false}, {11, 3, false},   // mode / start-stop
+    {12, 4, false}, {13, 5, false}, {14, 6, false}, {15, 7, false},   // soft-keys 1..4
+    { 6, 8, false},                                                   // soft-key 5
+    { 7, 10, true},                                                   // encoder-knop
+};
+static constexpr int N_BUTTONS = (int)(sizeof(BUTTONS) / sizeof(BUTTONS[0]));
+
+// Virtuele bit in buttons_raw_bits zolang de encoder-knop lang ingedrukt is
+static constexpr uint32_t BTN_ENC_LONG_BIT = 11;
+
+static constexpr uint32_t IO_HEALTH_MS = 1000;  // config controleren (AW9523 reset door backlight init)
+
+// =========================
+// Event queue (lock-free, 1 producer, N consumenten)
+// =========================
+// Elke slot heeft een sequence (index+1 als hij geldig is, 0 tijdens schrijven).
+// Consumenten lezen seqlock-stijl: seq, data, seq opnieuw.
+static constexpr uint32_t IO_QUEUE_LEN = 32;    // macht van 2
+
+struct IoSlot
+{
+    std::atomic<uint32_t> seq;
+    IoEvent ev;
+};
+
+static IoSlot                g_slots[IO_QUEUE_LEN];
+static std::atomic<uint32_t> g_head(0);
+
+static constexpr int IO_MAX_SUBSCRIBERS = 4;
+static TaskHandle_t          g_subs[IO_MAX_SUBSCRIBERS];
+static std::atomic<int>      g_n_subs(0);
+static portMUX_TYPE          g_subs_mux = portMUX_INITIALIZER_UNLOCKED;
+
+extern "C" void io_event_push(const IoEvent* ev)
+{
+    if (!ev) return;
+    const uint32_t idx = g_head.load(std::memory_order_relaxed);
+    IoSlot& s = g_slots[idx & (IO_QUEUE_LEN - 1)];
+
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.ev = *ev;
+    s.seq.store(idx + 1, std::memory_order_release);
+    g_head.store(idx + 1, std::memory_order_release);
+
+    io_event_notify();
+}
+
+extern "C" void io_event_notify(void)
+{
+    const int n = g_n_subs.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) xTaskNotifyGive(g_subs[i]);
+}
+
+extern "C" void IRAM_ATTR io_event_notify_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    const int n = g_n_subs.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) vTaskNotifyGiveFromISR(g_subs[i], &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+extern "C" void io_event_cursor_init(IoEventCursor* c)
+{
+    if (!c) return;
+    c->next = g_head.load(std::memory_order_acquire);
+    c->lost = 0;
+}
+
+extern "C" bool io_event_pop(IoEventCursor* c, IoEvent* out)
+{
+    if (!c || !out) return false;
+
+    for (;;) {
+        const uint32_t head = g_head.load(std::memory_order_acquire);
+        if (c->next == head) return false;
+
+        // Te ver achter: oudste events zijn overschreven
+        if (head - c->next > IO_QUEUE_LEN) {
+            c->lost += head - c->next - IO_QUEUE_LEN;
+            c->next = head - IO_QUEUE_LEN;
+        }
+
+        const IoSlot& s = g_slots[c->next & (IO_QUEUE_LEN - 1)];
+        const uint32_t s1 = s.seq.load(std::memory_order_acquire);
+        IoEvent ev = s.ev;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t s2 = s.seq.load(std::memory_order_relaxed);
+
+        if (s1 == c->next + 1 && s2 == s1) {
+            *out = ev;
+            c->next++;
+            return true;
+        }
+        // Tijdens het lezen overschreven: opnieuw met de nieuwe head
+        c->lost++;
+        c->next++;
+    }
+}
+
+extern "C" bool io_event_pending(const IoEventCursor* c)
+{
+    return c && c->next != g_head.load(std::memory_order_acquire);
+}
+
+extern "C" bool io_event_subscribe(TaskHandle_t task)
+{
+    if (!task) return false;
+
+    // Abonnees melden zich tegelijk aan vanaf beide cores (statemachine, display):
+    // slot kiezen, vullen en publiceren onder één lock. Lezers (ook de ISR) zien
+    // g_n_subs pas na het vullen van het slot.
+    bool ok = false;
+    portENTER_CRITICAL(&g_subs_mux);
+    const int n = g_n_subs.load(std::memory_order_relaxed);
+    if (n < IO_MAX_SUBSCRIBERS) {
+        g_subs[n] = task;
+        g_n_subs.store(n + 1, std::memory_order_release);
+        ok = true;
+    }
+    portEXIT_CRITICAL(&g_subs_mux);
+    return ok;
+}
+
+// =========================
+// Interrupt
+// =========================
+static TaskHandle_t          g_io_task = nullptr;
+static std::atomic<uint32_t> g_isr_t_us(0);
+static std::atomic<bool>     g_isr_pending(false);
+
+static void IRAM_ATTR iox_isr()
+{
+    // Tijd van de eerste flank sinds de laatste uitlezing
+    if (!g_isr_pending.exchange(true)) g_isr_t_us.store((uint32_t)esp_timer_get_time());
+
+    BaseType_t woken = pdFALSE;
+    if (g_io_task) vTaskNotifyGiveFromISR(g_io_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// =========================
+// AW9523 helpers
+// =========================
+static bool aw_read(uint8_t reg, uint8_t* buf, uint8_t n)
+{
+    system_lock_i2c();
+    Wire.beginTransmission(AW_ADDR);
+    Wire.write(reg);
+    bool ok = (Wire.endTransmission(false) == 0) && (Wire.requestFrom(AW_ADDR, n) == n);
+    for (uint8_t i = 0; ok && i < n; ++i) buf[i] = (uint8_t)Wire.read();
+    system_unlock_i2c();
+    return ok;
+}
+
+static bool aw_write(uint8_t reg, uint8_t v)
+{
+    system_lock_i2c();
+    Wire.beginTransmission(AW_ADDR);
+    Wire.write(reg);
+    Wire.write(v);
+    const bool ok = (Wire.endTransmission() == 0);
+    system_unlock_i2c();
+    return ok;
+}
+
+static uint16_t button_pin_mask()
+{
+    uint16_t m = 0;
+    for (int i = 0; i < N_BUTTONS; ++i) m |= (uint16_t)(1u << BUTTONS[i].pin);
+    return m;
+}
+
+// Knoppinnen als input met interrupt; de rest (backlight) ongemoeid laten.
+// Geeft false als de expander niet antwoordt. Schrijft alleen als het nodig is.
+static bool aw_ensure_config()
+{
+    const uint16_t m = button_pin_mask();
+    uint8_t cfg[2], ien[2];
+    if (!aw_read(AW_REG_CFG_P0, cfg, 2) || !aw_read(AW_REG_INT_P0, ien, 2)) return false;
+
+    bool ok = true;
+    for (int p = 0; p < 2; ++p) {
+        const uint8_t mp = (uint8_t)(m >> (8 * p));
+        if ((cfg[p] & mp) != mp) ok &= aw_write((uint8_t)(AW_REG_CFG_P0 + p), (uint8_t)(cfg[p] | mp));
+        if ((ien[p] & mp) != 0)  ok &= aw_write((uint8_t)(AW_REG_INT_P0 + p), (uint8_t)(ien[p] & ~mp));
+    }
+    return ok;
+}
+
+// =========================
+// Debounce / long-press FSM
+// =========================
+// Flank wordt meteen gemeld (laagste latency); daarna negeert de knop
+// IO_DEBOUNCE_MS lang veranderingen (dender) en neemt daarna de stabiele stand.
+enum class BtnState : uint8_t { UP, DOWN_LOCK, DOWN, UP_LOCK };
+
+struct Button
+{
+    BtnState state;
+    bool     long_fired;
+    uint32_t t_edge_us;   // tijdstip laatste gemelde flank
+    uint32_t t_lock_ms;   // einde lockout / begin ingedrukt
+};
+
+static Button g_btn[N_BUTTONS];
+static uint32_t g_raw_bits = 0;   // debounced stand voor IOShared
+
+static void emit(uint8_t bit, IoEventType type, uint32_t t_us)
+{
+    IoEvent ev;
+    ev.t_us = t_us;
+    ev.button = bit;
+    ev.type = (uint8_t)type;
+    ev.reserved = 0;
+    io_event_push(&ev);
+}
+
+// Verwerkt de actuele pinstand; geeft de eerstvolgende deadline (ms, 0 = geen).
+static uint32_t fsm_update(uint16_t pins_down, uint32_t now_ms, uint32_t t_edge_us, uint32_t* changed)
+{
+    uint32_t deadline = 0;
+    auto want = [&](uint32_t t) { if (deadline == 0 || (int32_t)(t - deadline) < 0) deadline = t; };
+
+    for (int i = 0; i < N_BUTTONS; ++i) {
+        const ButtonMap& map = BUTTONS[i];
+        Button& b = g_btn[i];
+        const bool down = (pins_down >> map.pin) & 1u;
+        const uint32_t bit = 1u << map.bit;
+
+        switch (b.state)
+        {
+            case BtnState::UP:
+                if (down) {
+                    b.state = BtnState::DOWN_LOCK;
+                    b.long_fired = false;
+                    b.t_edge_us = t_edge_us;
+                    b.t_lock_ms = now_ms;
+                    g_raw_bits |= bit;
+                    *changed |= bit;
+                    emit(map.bit, IO_EVT_PRESS, t_edge_us);
+                }
+                break;
+
+            case BtnState::DOWN_LOCK:
+                if ((uint32_t)(now_ms - b.t_lock_ms) >= IO_DEBOUNCE_MS) b.state = BtnState::DOWN;
+                else { want(b.t_lock_ms + IO_DEBOUNCE_MS); break; }
+                // fallthrough: meteen de stabiele stand beoordelen
+            case BtnState::DOWN:
+                if (!down) {
+                    b.state = BtnState::UP_LOCK;
+                    b.t_lock_ms = now_ms;
+                    g_raw_bits &= ~bit;
+                    *changed |= bit;
+                    emit(map.bit, IO_EVT_RELEASE, t_edge_us);
+                    if (map.long_press && !b.long_fired) emit(map.bit, IO_EVT_CLICK, t_edge_us);
+                    if (map.long_press) g_raw_bits &= ~(1u << BTN_ENC_LONG_BIT);
+                    want(now_ms + IO_DEBOUNCE_MS);
+                } else if (map.long_press && !b.long_fired) {
+                    const uint32_t t_long = b.t_lock_ms + IO_LONG_PRESS_MS;
+                    if ((int32_t)(now_ms - t_long) >= 0) {
+                        b.long_fired = true;
+                        g_raw_bits |= (1u << BTN_ENC_LONG_BIT);
+                        *changed |= (1u << BTN_ENC_LONG_BIT);
+                        emit(map.bit, IO_EVT_LONG, (uint32_t)esp_timer_get_time());
+                    } else {
+                        want(t_long);
+                    }
+                }
+                break;
+
+            case BtnState::UP_LOCK:
+                if ((uint32_t)(now_ms - b.t_lock_ms) >= IO_DEBOUNCE_MS) {
+                    b.state = BtnState::UP;
+                    // Na de lockout al weer ingedrukt: als nieuwe druk behandelen
+                    if (down) {
+                        b.state = BtnState::DOWN_LOCK;
+                        b.long_fired = false;
+                        b.t_lock_ms = now_ms;
+                        g_raw_bits |= bit;
+                        *changed |= bit;
+                        emit(map.bit, IO_EVT_PRESS, t_edge_us);
+                        want(now_ms + IO_DEBOUNCE_MS);
+                    }
+                } else {
+                    want(b.t_lock_ms + IO_DEBOUNCE_MS);
+                }
+                break;
+        }
+    }
+    return deadline;
+}
+
+// =========================
+// Task
+// =========================
+extern "C" void ioExpanderTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    g_io_task = xTaskGetCurrentTaskHandle();
+    memset(g_btn, 0, sizeof(g_btn));
+
+    encoder_init();
+
+    bool cfg_ok = aw_ensure_config();
+    if (!cfg_ok) Serial.println("ioexpander: AW9523 config FOUT");
+
+    const bool use_int = (PIN_IOX_INT >= 0);
+    if (use_int) {
+        pinMode(PIN_IOX_INT, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(PIN_IOX_INT), iox_isr, FALLING);
+    }
+
+    uint32_t deadline_ms = 0;
+    uint32_t last_health_ms = millis();
+
+    for (;;)
+    {
+        // Slapen tot interrupt, debounce/long-press deadline of health check.
+        // Zonder INT-lijn: pollen op de debouncetijd.
+        const uint32_t now0 = millis();
+        uint32_t wait_ms = use_int ? IO_HEALTH_MS : IO_DEBOUNCE_MS;
+        if (deadline_ms != 0) {
+            const int32_t d = (int32_t)(deadline_ms - now0);
+            wait_ms = (d <= 0) ? 0 : ((uint32_t)d < wait_ms ? (uint32_t)d : wait_ms);
+        }
+        if (wait_ms > 0) {
+            const TickType_t ticks = pdMS_TO_TICKS(wait_ms);
+            ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+        }
+
+        // Flanktijd: uit de ISR, anders nu (timeout/poll)
+        uint32_t t_edge_us = (uint32_t)esp_timer_get_time();
+        if (g_isr_pending.exchange(false)) t_edge_us = g_isr_t_us.load();
+
+        uint8_t in[2];
+        // Fault manager debounced (persistentie) en latcht
+        if (!aw_read(AW_REG_IN_P0, in, 2)) {
+            fault_report(FID_COMM, true);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            continue;
+        }
+        fault_report(FID_COMM, false);
+        const uint16_t pins_down = (uint16_t)~((uint16_t)in[0] | ((uint16_t)in[1] << 8));
+
+        uint32_t changed = 0;
+        deadline_ms = fsm_update(pins_down, millis(), t_edge_us, &changed);
+
+        if (changed) {
+            // IOShared blijft de debounced stand tonen (status, legacy consumenten)
+            system_io_set_buttons(g_raw_bits, changed);
+        }
+
+        const uint32_t now_ms = millis();
+        if ((uint32_t)(now_ms - last_health_ms) >= IO_HEALTH_MS) {
+            last_health_ms = now_ms;
+            const bool ok = aw_ensure_config();
+            if (ok != cfg_ok) Serial.printf("ioexpander: AW9523 config %s\n", ok ? "hersteld" : "FOUT");
+            cfg_ok = ok;
+        }
+    }
+}
@@ -0,0 +1,424 @@
+// log/log.cpp
+#include "log/log.h"
+#include "system/crc.h"
+
+#include <string.h>
+
+static_assert(sizeof(LogRecord) == 24, "LogRecord: vaste 24 bytes op schijf");
+static_assert(sizeof(LogBlockHeader) == 32, "LogBlockHeader: vaste 32 bytes op schijf");
+static_assert((LOG_RING_LEN & (LOG_RING_LEN - 1u)) == 0, "LOG_RING_LEN: macht van 2");
+static_assert(LOG_BLOCK_SIZE % 512u == 0, "LOG_BLOCK_SIZE: veelvoud van de SD-sector");
+static_assert(LOG_BLOCK_PAYLOAD <= 0xFFFFu, "payload_bytes is 16 bit");
+static_assert((LOG_INDEX_STRIDE - 1u) * sizeof(LogIndexEntry) <= LOG_BLOCK_PAYLOAD, "index past niet in één blok");
+
+// Eén schrijver per teller (producer of consumer); de ander leest alleen.
+static inline void inc(uint32_t* p) { __atomic_store_n(p, *p + 1u, __ATOMIC_RELAXED); }
+static inline uint32_t ld(const uint32_t* p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+
+// =========================
+// Ring (SPSC)
+// =========================
+void log_ring_init(LogRing* r, LogRecord* storage, LogPolicy policy)
+{
+    if (!r) return;
+    memset(r, 0, sizeof(*r));
+    r->buf = storage;
+    r->policy = (uint8_t)policy;
+    r->decim = 1;
+}
+
+uint32_t log_ring_fill(const LogRing* r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+bool log_ring_push(LogRing* r, const LogRecord* rec)
+{
+    const uint32_t head = r->head;
+    const uint32_t fill = head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if (fill > r->fill_max) __atomic_store_n(&r->fill_max, fill, __ATOMIC_RELAXED);
+    inc(&r->n_pushed);
+
+    // Hysterese: aan boven HIGH, uit onder LOW
+    uint8_t bp = r->backpressure;
+    if (!bp && fill >= LOG_RING_HIGH) bp = 1;
+    else if (bp && fill <= LOG_RING_LOW) bp = 0;
+    if (bp != r->backpressure) __atomic_store_n(&r->backpressure, bp, __ATOMIC_RELAXED);
+
+    uint8_t decim = 1;
+    if (bp && r->policy == LOG_POLICY_DECIMATE)
+        decim = (fill >= LOG_RING_LEN / 8u * 7u) ? 8 : (fill >= LOG_RING_LEN / 4u * 3u) ? 4 : 2;
+    r->decim = decim;
+
+    // decim_phase = overgeslagen samples sinds het vorige record
+    if (r->decim_phase + 1u < decim) {
+        r->decim_phase++;
+        inc(&r->n_decimated);
+        return false;
+    }
+    const uint8_t span = (uint8_t)(r->decim_phase + 1u);
+    r->decim_phase = 0;
+
+    if (fill >= LOG_RING_LEN) {
+        inc(&r->n_dropped);
+        return false;
+    }
+
+    LogRecord* slot = &r->buf[head & (LOG_RING_LEN - 1u)];
+    *slot = *rec;
+    slot->decim = span;
+    __atomic_store_n(&r->head, head + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t log_ring_pop(LogRing* r, LogRecord* dst, uint32_t max)
+{
+    const uint32_t tail = r->tail;
+    uint32_t n = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+    if (n > max) n = max;
+    if (n == 0) return 0;
+
+    // Hoogstens twee stukken (wrap)
+    const uint32_t i0 = tail & (LOG_RING_LEN - 1u);
+    const uint32_t n0 = (n < LOG_RING_LEN - i0) ? n : LOG_RING_LEN - i0;
+    memcpy(dst, &r->buf[i0], n0 * sizeof(LogRecord));
+    if (n > n0) memcpy(dst + n0, &r->buf[0], (n - n0) * sizeof(LogRecord));
+
+    __atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+const LogRecord* log_ring_peek(const LogRing* r, uint32_t* n)
+{
+    const uint32_t tail = r->tail;
+    const uint32_t avail = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+    const uint32_t i0 = tail & (LOG_RING_LEN - 1u);
+    *n = (avail < LOG_RING_LEN - i0) ? avail : LOG_RING_LEN - i0;
+    return &r->buf[i0];
+}
+
+void log_ring_consume(LogRing* r, uint32_t n)
+{
+    if (n) __atomic_store_n(&r->tail, r->tail + n, __ATOMIC_RELEASE);
+}
+
+// =========================
+// Codec
+// =========================
+static inline uint32_t zz32(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzz32(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1u); }
+
+static inline uint8_t* put_varint(uint8_t* p, uint64_t v)
+{
+    while (v >= 0x80u) { *p++ = (uint8_t)(v | 0x80u); v >>= 7; }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static inline bool get_varint(const uint8_t** pp, const uint8_t* end, uint64_t* out)
+{
+    const uint8_t* p = *pp;
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        const uint8_t c = *p++;
+        v |= (uint64_t)(c & 0x7Fu) << shift;
+        if (!(c & 0x80u)) { *pp = p; *out = v; return true; }
+    }
+    return false;
+}
+
+// Afronden en begrenzen (±1e9) zodat een delta altijd in int32 past
+static inline int32_t quant(float x, float scale)
+{
+    const float y = x * scale;
+    if (!(y < 1.0e9f)) return 1000000000;    // ook NaN
+    if (!(y > -1.0e9f)) return -1000000000;
+    return (int32_t)(y >= 0.0f ? y + 0.5f : y - 0.5f);
+}
+
+static const float kScale[4] = { LOG_Q_V, LOG_Q_I, LOG_Q_I, LOG_Q_T };
+
+void log_enc_reset(LogEncoder* e)
+{
+    memset(e, 0, sizeof(*e));
+    e->keyframe = 1;
+}
+
+uint32_t log_enc_record(LogEncoder* e, const LogRecord* rec, uint8_t* dst)
+{
+    uint8_t* p = dst;
+    const int32_t q[4] = {
+        quant(rec->v_out, LOG_Q_V), quant(rec->i_sink, LOG_Q_I),
+        quant(rec->i_source, LOG_Q_I), quant(rec->temp_sink_c, LOG_Q_T),
+    };
+
+    if (e->keyframe) {
+        memcpy(p, &rec->t_us, 4);   // little endian (ESP32 en x86)
+        p += 4;
+        p = put_varint(p, rec->meas_flags);
+        *p++ = rec->decim;
+        for (int k = 0; k < 4; ++k) p = put_varint(p, zz32(q[k]));
+        e->dt_us = 0;
+        e->keyframe = 0;
+    } else {
+        const int32_t dt = (int32_t)(rec->t_us - e->t_us);
+        const int64_t ddt = (int64_t)dt - (int64_t)e->dt_us;
+        const uint64_t zt = ((uint64_t)ddt << 1) ^ (uint64_t)(ddt >> 63);
+        const bool extra = rec->meas_flags != e->flags || rec->decim != e->decim;
+        p = put_varint(p, (zt << 1) | (extra ? 1u : 0u));
+        if (extra) {
+            p = put_varint(p, rec->meas_flags);
+            *p++ = rec->decim;
+        }
+        for (int k = 0; k < 4; ++k) p = put_varint(p, zz32(q[k] - e->q[k]));
+        e->dt_us = dt;
+    }
+
+    e->t_us = rec->t_us;
+    e->flags = rec->meas_flags;
+    e->decim = rec->decim;
+    for (int k = 0; k < 4; ++k) e->q[k] = q[k];
+    return (uint32_t)(p - dst);
+}
+
+// =========================
+// Batcher
+// =========================
+static void open_reset(LogBatcher* b)
+{
+    b->n_rec = 0;
+    b->enc_off = (uint16_t)sizeof(LogBlockHeader);
+    log_enc_reset(&b->enc);
+}
+
+void log_batch_init(LogBatcher* b, uint8_t* buf0, uint8_t* buf1)
+{
+    if (!b) return;
+    memset(b, 0, sizeof(*b));
+    b->buf[0] = buf0;
+    b->buf[1] = buf1;
+    open_reset(b);
+}
+
+void log_batch_reset(LogBatcher* b)
+{
+    if (!b) return;
+    b->n_blocks = 0;
+    b->block_seq = 0;
+    b->n_records = 0;
+    b->n_index = 0;
+    b->stalled = 0;
+    open_reset(b);
+}
+
+static inline uint8_t* open_block(LogBatcher* b)
+{
+    return b->buf[b->fill_idx] + b->n_blocks * LOG_BLOCK_SIZE;
+}
+
+static void finish_block(LogBatcher* b, const LogRing* r, uint8_t type, uint16_t n, uint32_t payload, uint32_t t_first)
+{
+    uint8_t* blk = open_block(b);
+
+    LogBlockHeader h;
+    h.magic         = LOG_BLOCK_MAGIC;
+    h.seq           = b->block_seq++;
+    h.n_records     = n;
+    h.payload_bytes = (uint16_t)payload;
+    h.type          = type;
+    h.version       = LOG_BLOCK_VERSION;
+    h.reserved      = 0;
+    h.n_dropped     = ld(&r->n_dropped);
+    h.n_decimated   = ld(&r->n_decimated);
+    h.t_first_us    = t_first;
+    h.crc32         = crc32_ieee(blk + sizeof(LogBlockHeader), payload);
+    memcpy(blk, &h, sizeof(h));
+
+    memset(blk + sizeof(LogBlockHeader) + payload, 0, LOG_BLOCK_PAYLOAD - payload);
+    b->n_blocks++;
+}
+
+static void close_block(LogBatcher* b, const LogRing* r)
+{
+    LogIndexEntry& e = b->index[b->n_index++];
+    e.seq          = b->block_seq;
+    e.t_first_us   = b->t_first_us;
+    e.t_last_us    = b->t_last_us;
+    e.first_record = b->n_records;
+
+    b->n_records += b->n_rec;
+    finish_block(b, r, LOG_BLOCK_DATA, b->n_rec, b->enc_off - sizeof(LogBlockHeader), b->t_first_us);
+    open_reset(b);
+}
+
+// Indexblok op vaste posities (seq % STRIDE == STRIDE - 1)
+static inline bool index_due(const LogBatcher* b)
+{
+    return b->n_rec == 0 && (b->block_seq % LOG_INDEX_STRIDE) == LOG_INDEX_STRIDE - 1u;
+}
+
+static void write_index(LogBatcher* b, const LogRing* r)
+{
+    const uint32_t payload = b->n_index * (uint32_t)sizeof(LogIndexEntry);
+    memcpy(open_block(b) + sizeof(LogBlockHeader), b->index, payload);
+    finish_block(b, r, LOG_BLOCK_INDEX, (uint16_t)b->n_index,
+                 payload, b->n_index ? b->index[0].t_first_us : 0);
+    b->n_index = 0;
+}
+
+// Vulbuffer naar de schrijver als de andere vrij is; anders -1.
+static int hand_over(LogBatcher* b)
+{
+    const uint8_t other = b->fill_idx ^ 1u;
+    if (__atomic_load_n(&b->busy[other], __ATOMIC_ACQUIRE)) {
+        if (!b->stalled) { b->stalled = 1; b->n_stalled++; }
+        return -1;
+    }
+    b->stalled = 0;
+
+    const int ready = b->fill_idx;
+    __atomic_store_n(&b->busy[ready], 1, __ATOMIC_RELEASE);
+    b->fill_idx = other;
+    b->n_blocks = 0;
+    return ready;
+}
+
+int log_batch_drain(LogBatcher* b, LogRing* r)
+{
+    if (!b || !r) return -1;
+
+    for (;;)
+    {
+        // Volle buffer die nog niet weg kon: records blijven in de ring
+        if (b->n_blocks == LOG_BATCH_BLOCKS) return hand_over(b);
+        if (index_due(b)) { write_index(b, r); continue; }
+
+        uint32_t n;
+        const LogRecord* src = log_ring_peek(r, &n);
+        if (n == 0) return -1;   // ring leeg
+
+        // Direct uit de ring coderen (geen kopie)
+        uint8_t* blk = open_block(b);
+        uint32_t used = 0;
+        while (used < n && b->enc_off + LOG_REC_MAX_BYTES <= LOG_BLOCK_SIZE) {
+            if (b->n_rec == 0) b->t_first_us = src[used].t_us;
+            b->t_last_us = src[used].t_us;
+            b->enc_off = (uint16_t)(b->enc_off + log_enc_record(&b->enc, &src[used], blk + b->enc_off));
+            b->n_rec++;
+            used++;
+        }
+        log_ring_consume(r, used);
+
+        if (b->enc_off + LOG_REC_MAX_BYTES > LOG_BLOCK_SIZE) close_block(b, r);
+    }
+}
+
+int log_batch_flush(LogBatcher* b, LogRing* r, uint32_t* out_bytes)
+{
+    if (out_bytes) *out_bytes = 0;
+    if (!b || !r) return -1;
+
+    // Andere buffer nog bij de schrijver: open blok niet half afsluiten (kost
+    // capaciteit precies tijdens een stall)
+    if (__atomic_load_n(&b->busy[b->fill_idx ^ 1u], __ATOMIC_ACQUIRE)) return -1;
+
+    if (b->n_rec > 0 && b->n_blocks < LOG_BATCH_BLOCKS) close_block(b, r);
+    if (b->n_blocks == 0) return -1;
+
+    const uint32_t bytes = b->n_blocks * LOG_BLOCK_SIZE;
+    const int idx = hand_over(b);
+    if (idx >= 0 && out_bytes) *out_bytes = bytes;
+    return idx;
+}
+
+void log_batch_release(LogBatcher* b, int idx)
+{
+    if (!b || idx < 0 || idx > 1) return;
+    __atomic_store_n(&b->busy[idx], 0, __ATOMIC_RELEASE);
+}
+
+// =========================
+// Lezen
+// =========================
+bool log_block_check(const uint8_t* block)
+{
+    if (!block) return false;
+    LogBlockHeader h;
+    memcpy(&h, block, sizeof(h));
+    if (h.magic != LOG_BLOCK_MAGIC || h.version != LOG_BLOCK_VERSION) return false;
+    if (h.type > LOG_BLOCK_INDEX || h.payload_bytes > LOG_BLOCK_PAYLOAD) return false;
+    return crc32_ieee(block + sizeof(LogBlockHeader), h.payload_bytes) == h.crc32;
+}
+
+int log_block_decode(const uint8_t* block, LogRecord* out, uint32_t max)
+{
+    if (!log_block_check(block) || !out) return -1;
+    LogBlockHeader h;
+    memcpy(&h, block, sizeof(h));
+    if (h.type != LOG_BLOCK_DATA || h.n_records > max) return -1;
+
+    const uint8_t* p = block + sizeof(LogBlockHeader);
+    const uint8_t* end = p + h.payload_bytes;
+
+    uint32_t t = 0;
+    int32_t dt = 0;
+    int32_t q[4] = { 0, 0, 0, 0 };
+    uint16_t flags = 0;
+    uint8_t decim = 1;
+    uint64_t v;
+
+    for (uint32_t i = 0; i < h.n_records; ++i)
+    {
+        if (i == 0) {
+            if (end - p < 4) return -1;
+            memcpy(&t, p, 4);
+            p += 4;
+            if (!get_varint(&p, end, &v) || p >= end) return -1;
+            flags = (uint16_t)v;
+            decim = *p++;
+            for (int k = 0; k < 4; ++k) {
+                if (!get_varint(&p, end, &v)) return -1;
+                q[k] = unzz32((uint32_t)v);
+            }
+        } else {
+            if (!get_varint(&p, end, &v)) return -1;
+            const uint64_t zt = v >> 1;
+            const int64_t ddt = (int64_t)(zt >> 1) ^ -(int64_t)(zt & 1u);
+            if (v & 1u) {
+                if (!get_varint(&p, end, &v) || p >= end) return -1;
+                flags = (uint16_t)v;
+                decim = *p++;
+            }
+            for (int k = 0; k < 4; ++k) {
+                if (!get_varint(&p, end, &v)) return -1;
+                q[k] += unzz32((uint32_t)v);
+            }
+            dt = (int32_t)((int64_t)dt + ddt);
+            t += (uint32_t)dt;
+        }
+
+        LogRecord& r = out[i];
+        r.t_us        = t;
+        r.v_out       = (float)q[0] / kScale[0];
+        r.i_sink      = (float)q[1] / kScale[1];
+        r.i_source    = (float)q[2] / kScale[2];
+        r.temp_sink_c = (float)q[3] / kScale[3];
+        r.meas_flags  = flags;
+        r.decim       = decim;
+        r.reserved    = 0;
+    }
+    return (int)h.n_records;
+}
+
+int log_block_index(const uint8_t* block, LogIndexEntry* out, uint32_t max)
+{
+    if (!log_block_check(block) || !out) return -1;
+    LogBlockHeader h;
+    memcpy(&h, block, sizeof(h));
+    if (h.type != LOG_BLOCK_INDEX || h.n_records > max ||
+        h.payload_bytes != h.n_records * sizeof(LogIndexEntry)) return -1;
+    memcpy(out, block + sizeof(LogBlockHeader), h.payload_bytes);
+    return (int)h.n_records;
+}
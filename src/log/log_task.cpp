@@ -0,0 +1,279 @@
+// log/log_task.cpp
+#include <Arduino.h>
+#include <SPI.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+
+#include "log/log.h"
+#include "fault/fault.h"
+#include "system/system.h"
+#include "system/pins.h"
+
+// =========================
+// SD-kaart (SPI)
+// =========================
+// FSPI is bezet door de ADS8684 (measure.cpp); de kaart zit op HSPI.
+// Pinnen: PIN_SD_* in system/pins.h.
+static constexpr uint32_t SD_SPI_HZ = 20000000;
+
+static SPIClass SPI_SD(HSPI);
+static File g_file;
+
+// =========================
+// Timing
+// =========================
+static constexpr uint32_t LOG_WAKE_EVERY   = 64;     // records tussen notifies naar logTask
+static constexpr uint32_t LOG_POLL_MS      = 100;    // logTask ook zonder notify
+static constexpr uint32_t LOG_FLUSH_MS     = 2000;   // deels gevulde buffer + File.flush
+static constexpr uint32_t LOG_CFG_MS       = 250;    // cfg.logging_enabled opnieuw lezen
+static constexpr uint32_t LOG_RETRY_MS     = 5000;   // kaart opnieuw proberen
+static constexpr uint32_t LOG_STATS_MS     = 60000;  // statistiekregel op Serial
+
+// =========================
+// State
+// =========================
+static LogRecord  g_ring_buf[LOG_RING_LEN];
+static LogRing    g_ring;
+static LogBatcher g_batch;
+
+// Producer schrijft alleen als er een open bestand is
+static volatile bool g_enabled = false;
+static TaskHandle_t volatile g_log_task = nullptr;
+
+typedef struct
+{
+    int8_t   idx;     // buffer
+    uint8_t  sync;    // File.flush() na het schrijven
+    uint32_t bytes;
+} WriteJob;
+
+static QueueHandle_t g_write_queue = nullptr;
+
+static volatile uint32_t g_write_us_max = 0;
+static volatile uint32_t g_write_errors = 0;
+static volatile bool     g_card_ok = false;
+
+// Coderen in logTask (cycli / records), voor de cycli per sample
+static uint64_t g_enc_cycles = 0;
+static uint32_t g_enc_records = 0;
+
+// =========================
+// Producer (measureTask)
+// =========================
+extern "C" void log_measurement(const MeasurementData* m)
+{
+    if (!g_enabled || !m) return;
+
+    LogRecord rec;
+    rec.t_us        = m->t_us;
+    rec.v_out       = m->v_out;
+    rec.i_sink      = m->i_sink;
+    rec.i_source    = m->i_source;
+    rec.temp_sink_c = m->temp_sink_c;
+    rec.meas_flags  = (uint16_t)m->meas_flags;
+    rec.decim       = 1;
+    rec.reserved    = 0;
+    log_ring_push(&g_ring, &rec);
+
+    TaskHandle_t t = g_log_task;
+    if (t && (g_ring.n_pushed % LOG_WAKE_EVERY) == 0) xTaskNotifyGive(t);
+}
+
+extern "C" void log_set_policy(LogPolicy policy)
+{
+    __atomic_store_n(&g_ring.policy, (uint8_t)policy, __ATOMIC_RELAXED);
+}
+
+extern "C" void log_get_stats(LogStats* out)
+{
+    if (!out) return;
+    out->n_pushed     = __atomic_load_n(&g_ring.n_pushed, __ATOMIC_RELAXED);
+    out->n_dropped    = __atomic_load_n(&g_ring.n_dropped, __ATOMIC_RELAXED);
+    out->n_decimated  = __atomic_load_n(&g_ring.n_decimated, __ATOMIC_RELAXED);
+    out->fill_max     = __atomic_load_n(&g_ring.fill_max, __ATOMIC_RELAXED);
+    out->n_blocks     = g_batch.block_seq;
+    out->n_records    = g_batch.n_records;
+    out->enc_cyc_per_rec = g_enc_records ? (uint32_t)(g_enc_cycles / g_enc_records) : 0;
+    out->n_stalled    = g_batch.n_stalled;
+    out->write_us_max = g_write_us_max;
+    out->write_errors = g_write_errors;
+    out->card_ok      = g_card_ok;
+}
+
+// =========================
+// SD
+// =========================
+static bool sd_open(void)
+{
+    // Na een schrijffout: oude handle weg, opnieuw mounten
+    if (g_file) g_file.close();
+    SD.end();
+
+    SPI_SD.begin(PIN_SD_SCLK, PIN_SD_MISO, PIN_SD_MOSI, PIN_SD_CS);
+    if (!SD.begin(PIN_SD_CS, SPI_SD, SD_SPI_HZ)) {
+        Serial.println("log: geen SD-kaart");
+        return false;
+    }
+
+    // Eerste vrije /logNNNN.sbl
+    char path[16];
+    for (unsigned n = 0; n < 10000; ++n) {
+        snprintf(path, sizeof(path), "/log%04u.sbl", n);
+        if (!SD.exists(path)) break;
+    }
+    g_file = SD.open(path, FILE_WRITE);
+    if (!g_file) {
+        Serial.printf("log: %s niet te openen\n", path);
+        SD.end();
+        return false;
+    }
+
+    Serial.printf("log: %s (%u B blokken, delta/varint, index per %u blokken)\n",
+                  path, (unsigned)LOG_BLOCK_SIZE, (unsigned)LOG_INDEX_STRIDE);
+    return true;
+}
+
+// Schrijft volle buffers; blokkeert alleen zichzelf als de kaart hangt.
+static void sdWriterTask(void* pv)
+{
+    (void)pv;
+    WriteJob job;
+    for (;;)
+    {
+        if (xQueueReceive(g_write_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        const int64_t t0 = esp_timer_get_time();
+        // Buffer is sector-aligned: FATFS schrijft hele sectoren direct, zonder eigen kopie
+        const size_t n = g_file.write(g_batch.buf[job.idx], job.bytes);
+        if (job.sync && n == job.bytes) g_file.flush();
+        const uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+        if (dt > g_write_us_max) g_write_us_max = dt;
+        if (n != job.bytes) {
+            // Kaart weg of vol: logTask mount opnieuw zodra beide buffers terug zijn
+            g_write_errors = g_write_errors + 1;
+            g_card_ok = false;
+            fault_report(FID_SD, true);
+        } else {
+            fault_report(FID_SD, false);
+        }
+
+        log_batch_release(&g_batch, job.idx);
+        // logTask kan nu weer legen (buffer vrij)
+        TaskHandle_t t = g_log_task;
+        if (t) xTaskNotifyGive(t);
+    }
+}
+
+static void submit(int idx, uint32_t bytes, bool sync)
+{
+    WriteJob job;
+    job.idx = (int8_t)idx;
+    job.sync = sync ? 1 : 0;
+    job.bytes = bytes;
+    // Hoogstens twee jobs tegelijk (twee buffers): past altijd in de queue
+    xQueueSend(g_write_queue, &job, 0);
+}
+
+// =========================
+// Task
+// =========================
+extern "C" void logTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    uint8_t* b0 = (uint8_t*)heap_caps_aligned_alloc(32, LOG_BATCH_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    uint8_t* b1 = (uint8_t*)heap_caps_aligned_alloc(32, LOG_BATCH_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!b0 || !b1) {
+        Serial.println("log: ERROR buffer alloc failed");
+        fault_report(FID_SD, true);
+        vTaskDelete(nullptr);
+        return;
+    }
+
+    log_ring_init(&g_ring, g_ring_buf, LOG_POLICY_DECIMATE);
+    log_batch_init(&g_batch, b0, b1);
+
+    g_write_queue = xQueueCreate(2, sizeof(WriteJob));
+    g_log_task = xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(sdWriterTask, "LOG_SD", 4096, nullptr, 1, nullptr, 0);
+
+    bool want = false;
+    bool bp_shown = false;
+    uint32_t t_cfg = 0, t_flush = millis(), t_retry = 0, t_stats = millis();
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_POLL_MS));
+        const uint32_t now = millis();
+
+        if (now - t_cfg >= LOG_CFG_MS) {
+            t_cfg = now;
+            SystemSnapshot s;
+            system_read_snapshot(&s);
+            want = s.cfg.logging_enabled;
+        }
+
+        // Kaart openen / opnieuw proberen (niet terwijl de schrijver nog een buffer heeft)
+        const bool writer_idle = !g_batch.busy[0] && !g_batch.busy[1];
+        if (want && !g_card_ok && writer_idle && (t_retry == 0 || now - t_retry >= LOG_RETRY_MS)) {
+            t_retry = now;
+            g_card_ok = sd_open();
+            fault_report(FID_SD, !g_card_ok);
+            // Nieuw bestand begint op blok 0 (index-posities = bestandsoffsets)
+            if (g_card_ok) log_batch_reset(&g_batch);
+        } else if (!want && !g_card_ok) {
+            fault_report(FID_SD, false);   // loggen uit: geen kaart is geen fout
+        }
+        g_enabled = want && g_card_ok;
+
+        int idx;
+        const uint32_t tail0 = g_ring.tail;
+        const uint32_t c0 = ESP.getCycleCount();
+        while ((idx = log_batch_drain(&g_batch, &g_ring)) >= 0) {
+            if (g_card_ok) submit(idx, LOG_BATCH_BYTES, false);
+            else           log_batch_release(&g_batch, idx);   // kaart weg: weggooien, ring blijft vrij
+        }
+        if (g_ring.tail != tail0) {
+            g_enc_cycles += ESP.getCycleCount() - c0;
+            g_enc_records += g_ring.tail - tail0;
+        }
+
+        // Deels gevulde buffer periodiek wegschrijven (en bij uitzetten)
+        if (g_card_ok && (now - t_flush >= LOG_FLUSH_MS || (!g_enabled && log_ring_fill(&g_ring) == 0))) {
+            uint32_t bytes;
+            idx = log_batch_flush(&g_batch, &g_ring, &bytes);
+            if (idx >= 0) submit(idx, bytes, true);
+            if (idx >= 0 || g_batch.n_blocks == 0) t_flush = now;
+        }
+
+        // Backpressure van de producer naar SystemStatus (niet vanuit measureTask: geen extra lock daar)
+        const bool bp = g_enabled && __atomic_load_n(&g_ring.backpressure, __ATOMIC_RELAXED) != 0;
+        if (bp != bp_shown) {
+            bp_shown = bp;
+            if (bp) system_set_status_flag(STATUS_LOG_BACKPRESSURE);
+            else    system_clear_status_flag(STATUS_LOG_BACKPRESSURE);
+
+            LogStats st;
+            log_get_stats(&st);
+            Serial.printf("log: backpressure %s (vulling max %u/%u, gedropt %u, gedecimeerd %u, write max %u us)\n",
+                          bp ? "aan" : "uit", (unsigned)st.fill_max, (unsigned)LOG_RING_LEN,
+                          (unsigned)st.n_dropped, (unsigned)st.n_decimated, (unsigned)st.write_us_max);
+        }
+
+        if (g_enabled && now - t_stats >= LOG_STATS_MS) {
+            t_stats = now;
+            LogStats st;
+            log_get_stats(&st);
+            const float bpr = st.n_records ? (float)st.n_blocks * LOG_BLOCK_SIZE / st.n_records : 0.0f;
+            Serial.printf("log: %u records, %.2f B/record (x%.1f t.o.v. %u B), %u cycli/record\n",
+                          (unsigned)st.n_records, bpr, bpr > 0.0f ? sizeof(LogRecord) / bpr : 0.0f,
+                          (unsigned)sizeof(LogRecord), (unsigned)st.enc_cyc_per_rec);
+        }
+    }
+}
@@ -4,9 +4,14 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 
 #include "system/system.h"
+#include "system/pins.h"
 #include "display/display.h"
+#include "ioexpander/ioexpander.h"
+#include "ioexpander/encoder.h"
+#include "statemachine/statemachine.h"
 
 // Zelfde mapping als in display.cpp
 static constexpr uint32_t BTN_SOFT_1    = (1u << 4);
@@ -17,38 +22,33 @@ static constexpr uint32_t BTN_SOFT_5    = (1u << 8);
 static constexpr uint32_t BTN_ENC_PRESS = (1u << 10);
 static constexpr uint32_t BTN_ENC_LONG  = (1u << 11);
 
-static void simulate_set_raw(uint32_t mask, bool down)
+// Zelfde events als ioExpanderTask (die draait niet in deze test)
+static void simulate_event(uint8_t button, IoEventType type)
 {
-  SystemSnapshot s;
-  system_read_snapshot(&s);
-
-  IOShared io = s.io;
-  const bool was = (io.buttons_raw_bits & mask) != 0;
-
-  if (down) io.buttons_raw_bits |= mask; else io.buttons_raw_bits &= ~mask;
-
-  // Changed bit alleen zetten als er daadwerkelijk een flank is
-  const bool now = down;
-  if (was != now) io.buttons_changed_bits |= mask;
-
-  system_write_io_shared(&io);
+  IoEvent ev;
+  ev.t_us = (uint32_t)esp_timer_get_time();
+  ev.button = button;
+  ev.type = (uint8_t)type;
+  ev.reserved = 0;
+  io_event_push(&ev);
 }
 
 static void simulate_press(uint32_t mask, uint32_t hold_ms = 50)
 {
-  simulate_set_raw(mask, true);
+  const bool enc = (mask == BTN_ENC_PRESS || mask == BTN_ENC_LONG);
+  const uint8_t button = enc ? 10 : (uint8_t)__builtin_ctz(mask);
+
+  simulate_event(button, IO_EVT_PRESS);
   vTaskDelay(pdMS_TO_TICKS(hold_ms));
-  simulate_set_raw(mask, false);
+  if (enc && hold_ms >= IO_LONG_PRESS_MS) simulate_event(button, IO_EVT_LONG);
+  simulate_event(button, IO_EVT_RELEASE);
+  if (enc && hold_ms < IO_LONG_PRESS_MS) simulate_event(button, IO_EVT_CLICK);
 }
 
 static void simulate_encoder_delta(int32_t steps)
 {
-  SystemSnapshot s;
-  system_read_snapshot(&s);
-
-  IOShared io = s.io;
-  io.enc_delta_accum += steps;
-  system_write_io_shared(&io);
+  // Zelfde pad als de PCNT-ISR (teller + tijdstempel + notify)
+  encoder_inject(steps);
 }
 
 static void simulateUiTask(void* pv)
@@ -61,11 +61,9 @@ static void simulateUiTask(void* pv)
     SystemSnapshot s;
     system_read_snapshot(&s);
 
-    SystemStatus st = s.status;
-    st.state = SYS_STATE_CONFIG;
-    st.mode_current = POWER_MODE_EMULATE;
-    st.mode_pending = POWER_MODE_EMULATE;
-    system_write_status(&st);
+    // State blijft CONFIG (default); alleen statemachineTask wijzigt hem
+    system_request_mode(POWER_MODE_EMULATE);
+    system_complete_mode_switch(POWER_MODE_EMULATE);
 
     UIShared ui = s.ui;
     ui.active_screen = UI_SCREEN_EMULATE;
@@ -108,6 +106,15 @@ static void simulateUiTask(void* pv)
   // 4) Reset
   simulate_press(BTN_SOFT_5);
 
+  vTaskDelay(pdMS_TO_TICKS(1500));
+
+  // 5) State machine: armeren, starten, stoppen (knop 0 = run, knop 1 = stop)
+  simulate_event(0, IO_EVT_PRESS);
+  vTaskDelay(pdMS_TO_TICKS(500));
+  simulate_event(0, IO_EVT_PRESS);
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  simulate_event(1, IO_EVT_PRESS);
+
   // Herhaal langzaam
   for (;;)
   {
@@ -129,7 +136,7 @@ void setup()
   Serial.println("=== BOOT ===");
 
   // I2C init (1x)
-  Wire.begin(21, 19);
+  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
   Wire.setClock(400000);
 
   system_init();
@@ -143,6 +150,15 @@ void setup()
       nullptr,
       1);
 
+  xTaskCreatePinnedToCore(
+      statemachineTask,
+      "STATEMACHINE_TASK",
+      3072,
+      nullptr,
+      3,
+      nullptr,
+      0);
+
   xTaskCreatePinnedToCore(
       simulateUiTask,
       "SIM_UI_TASK",
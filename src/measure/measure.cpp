@@ -7,25 +7,19 @@
 #include "esp_timer.h"
 
 #include "system/system.h"
+#include "system/pins.h"
 #include "measure/measure.h"
-
-// =========================
-// ADS8684 pinmapping (uit jouw schema)
-// =========================
-static constexpr int PIN_ADS_SCLK  = 38;
-static constexpr int PIN_ADS_MISO  = 39;
-static constexpr int PIN_ADS_MOSI  = 40;
-static constexpr int PIN_ADS_CS    = 41;
-
-// ADS_RESET: in je schema is er een netlabel "ADS_RESET" naar ESP32.
-// Vul hier de juiste GPIO in zodra je hem zeker weet.
-static constexpr int PIN_ADS_RESET = -1; // <-- AANPASSEN indien nodig
+#include "log/log.h"
+#include "telemetry/telemetry.h"
 
 // =========================
 // ADS8684 SPI
 // =========================
 static SPIClass SPI_ADS(FSPI);
 
+// Consumer van de meetstroom (ControlTask draait op dezelfde 1 kHz)
+static volatile TaskHandle_t g_notify_task = nullptr;
+
 // ADS8684 werkt typisch in SPI MODE1.
 // Clock: begin conservatief (bijv. 5-10MHz) tot alles stabiel is.
 static SPISettings ADS_SPI_SETTINGS(
@@ -84,6 +78,11 @@ static bool ads_read_channel_voltage(uint8_t ch, float* v_adc)
 // =========================
 // Task
 // =========================
+extern "C" void measure_set_notify_task(TaskHandle_t task)
+{
+    g_notify_task = task;
+}
+
 extern "C" void measureTask(void* pvParameters)
 {
     (void)pvParameters;
@@ -131,6 +130,11 @@ extern "C" void measureTask(void* pvParameters)
 
         // ===== WRITE =====
         system_write_measurement(&m);
+        log_measurement(&m);         // lock-free ring, wacht nooit
+        telemetry_measurement(&m);   // idem (USB-CDC, alleen met host)
+
+        TaskHandle_t consumer = g_notify_task;
+        if (consumer) xTaskNotifyGive(consumer);
 
         // ===== 1kHz pacing =====
         vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1));
@@ -0,0 +1,247 @@
+// statemachine/statemachine.cpp
+#include "statemachine/statemachine.h"
+
+#include <string.h>
+
+// =========================
+// Context voor guards en acties
+// =========================
+namespace {
+
+struct SmContext
+{
+    const SmInputs* in;
+    SmEffects*      out;
+};
+
+typedef bool (*SmGuard)(const SmContext&);
+typedef void (*SmAction)(SmContext&);
+
+// =========================
+// Guards
+// =========================
+bool g_always(const SmContext&) { return true; }
+
+bool g_no_fault(const SmContext& c)
+{
+    return ((c.in->fault_current_bits | c.in->fault_latched_bits) & SM_FAULT_SHUTDOWN_MASK) == 0;
+}
+
+// Actief of nog niet bevestigd
+bool g_shutdown_fault(const SmContext& c)
+{
+    return !g_no_fault(c);
+}
+
+bool g_faults_gone(const SmContext& c)
+{
+    return (c.in->fault_current_bits & SM_FAULT_SHUTDOWN_MASK) == 0;
+}
+
+// Niet armeren tijdens een edit (waarde nog niet bevestigd)
+bool g_can_arm(const SmContext& c)
+{
+    return g_no_fault(c) && (c.in->ui_event_flags & UI_EVT_EDIT_STARTED) == 0;
+}
+
+// Alleen starten als de gevraagde mode ook de actieve is
+bool g_can_start(const SmContext& c)
+{
+    return g_no_fault(c) &&
+           c.in->mode_current == c.in->mode_pending &&
+           (c.in->status_flags & STATUS_MODE_SWITCH_PENDING) == 0;
+}
+
+// =========================
+// Acties
+// =========================
+void a_reject(SmContext& c) { c.out->rejected = true; }
+
+void a_clear_latched(SmContext& c) { c.out->clear_latched_bits |= c.in->fault_latched_bits; }
+
+void enter_active(SmContext& c) { c.out->set_status_flags |= STATUS_CONTROL_ENABLED; }
+void exit_active(SmContext& c)  { c.out->clear_status_flags |= STATUS_CONTROL_ENABLED; }
+
+// Actieve faults blijven staan tot ze bevestigd zijn (STOP in ERROR)
+void a_latch(SmContext& c)
+{
+    c.out->latch_fault_bits |= c.in->fault_current_bits & SM_FAULT_SHUTDOWN_MASK;
+}
+
+void enter_error(SmContext& c)
+{
+    a_latch(c);
+    c.out->ui_error = 1;
+}
+
+void exit_error(SmContext& c) { c.out->ui_error = -1; }
+
+// =========================
+// Tabellen
+// =========================
+constexpr int8_t SM_STAY = -1;   // intern: geen exit/entry
+constexpr int SM_MAX_ALTS = 2;
+
+struct SmAlt
+{
+    SmGuard  guard;    // nullptr = niet ingevuld
+    int8_t   to;       // SystemState of SM_STAY
+    SmAction action;   // transitie-actie (na exit, voor entry)
+};
+
+struct SmCell
+{
+    SmAlt alt[SM_MAX_ALTS];
+};
+
+struct SmStateActions
+{
+    SmAction entry;
+    SmAction exit;
+};
+
+constexpr int8_t S_CONFIG = SYS_STATE_CONFIG;
+constexpr int8_t S_READY  = SYS_STATE_READY;
+constexpr int8_t S_ACTIVE = SYS_STATE_ACTIVE;
+constexpr int8_t S_ERROR  = SYS_STATE_ERROR;
+
+constexpr SmCell kTable[SM_STATE_COUNT][SM_EV_COUNT] = {
+    // CONFIG
+    {
+        /* RUN   */ {{ { g_can_arm,        S_READY,  nullptr }, { g_always, SM_STAY, a_reject } }},
+        /* STOP  */ {{ { g_always,         SM_STAY,  nullptr } }},
+        /* FAULT */ {{ { g_shutdown_fault, S_ERROR,  nullptr }, { g_always, SM_STAY, nullptr } }},
+    },
+    // READY
+    {
+        /* RUN   */ {{ { g_can_start,      S_ACTIVE, nullptr }, { g_always, SM_STAY, a_reject } }},
+        /* STOP  */ {{ { g_always,         S_CONFIG, nullptr } }},
+        /* FAULT */ {{ { g_shutdown_fault, S_ERROR,  nullptr }, { g_always, SM_STAY, nullptr } }},
+    },
+    // ACTIVE
+    {
+        /* RUN   */ {{ { g_always,         S_READY,  nullptr } }},
+        /* STOP  */ {{ { g_always,         S_CONFIG, nullptr } }},
+        /* FAULT */ {{ { g_shutdown_fault, S_ERROR,  nullptr }, { g_always, SM_STAY, nullptr } }},
+    },
+    // ERROR
+    {
+        /* RUN   */ {{ { g_always,         SM_STAY,  a_reject } }},
+        /* STOP  */ {{ { g_faults_gone,    S_CONFIG, a_clear_latched }, { g_always, SM_STAY, a_reject } }},
+        /* FAULT */ {{ { g_always,         SM_STAY,  a_latch } }},   // nieuwe bits ook latchen
+    },
+};
+
+constexpr SmStateActions kStateActions[SM_STATE_COUNT] = {
+    /* CONFIG */ { nullptr,      nullptr },
+    /* READY  */ { nullptr,      nullptr },
+    /* ACTIVE */ { enter_active, exit_active },
+    /* ERROR  */ { enter_error,  exit_error },
+};
+
+// =========================
+// Statische controle
+// =========================
+// Elke (state, event) heeft een ingevuld eerste alternatief, eindigt op een
+// "always"-guard (dus altijd een uitkomst) en verwijst naar een bestaande state.
+constexpr bool alt_target_ok(const SmAlt& a)
+{
+    return a.guard == nullptr || a.to == SM_STAY || (a.to >= 0 && a.to < SM_STATE_COUNT);
+}
+
+constexpr bool alts_ok(const SmCell& c, int i, bool seen_always)
+{
+    return i >= SM_MAX_ALTS ? seen_always
+         : (c.alt[i].guard == nullptr) ? (seen_always && (i + 1 >= SM_MAX_ALTS || c.alt[i + 1].guard == nullptr))
+                                       && alts_ok(c, i + 1, seen_always)
+         : (!seen_always && alt_target_ok(c.alt[i]) && alts_ok(c, i + 1, c.alt[i].guard == &g_always));
+}
+
+constexpr bool table_ok(int i)
+{
+    return i >= SM_STATE_COUNT * SM_EV_COUNT
+         ? true
+         : alts_ok(kTable[i / SM_EV_COUNT][i % SM_EV_COUNT], 0, false) && table_ok(i + 1);
+}
+
+static_assert(SM_STATE_COUNT == SYS_STATE_ERROR + 1, "SM_STATE_COUNT loopt niet gelijk met SystemState");
+static_assert(sizeof(kTable) / sizeof(kTable[0]) == SM_STATE_COUNT, "transitietabel: rij per state");
+static_assert(table_ok(0), "transitietabel: niet elke (state, event) is afgehandeld");
+
+} // namespace
+
+// =========================
+// API
+// =========================
+void sm_init(SmMachine* m, SystemState initial)
+{
+    if (!m) return;
+    memset(m, 0, sizeof(*m));
+    m->state = initial;
+}
+
+bool sm_dispatch(SmMachine* m, SmEvent ev, const SmInputs* in, SmEffects* out)
+{
+    if (!m || !in || !out) return false;
+    memset(out, 0, sizeof(*out));
+    if ((unsigned)ev >= SM_EV_COUNT || (unsigned)m->state >= SM_STATE_COUNT) return false;
+
+    m->n_dispatch++;
+
+    SmContext c = { in, out };
+    const SmCell& cell = kTable[m->state][ev];
+
+    // Eerste guard die waar is; de tabel garandeert een "always" als laatste
+    const SmAlt* hit = nullptr;
+    for (int i = 0; i < SM_MAX_ALTS && cell.alt[i].guard; ++i) {
+        if (cell.alt[i].guard(c)) { hit = &cell.alt[i]; break; }
+    }
+    if (!hit) return false;
+
+    bool changed = false;
+    if (hit->to == SM_STAY || hit->to == (int8_t)m->state) {
+        if (hit->action) hit->action(c);
+    } else {
+        if (kStateActions[m->state].exit) kStateActions[m->state].exit(c);
+        if (hit->action) hit->action(c);
+        m->state = (SystemState)hit->to;
+        if (kStateActions[m->state].entry) kStateActions[m->state].entry(c);
+        m->n_transitions++;
+        changed = true;
+    }
+
+    if (out->rejected) m->n_rejected++;
+    return changed;
+}
+
+void sm_inputs_from_snapshot(SmInputs* in, const SystemSnapshot* s)
+{
+    if (!in || !s) return;
+    in->fault_current_bits = s->status.fault_current_bits;
+    in->fault_latched_bits = s->status.fault_latched_bits;
+    in->status_flags       = s->status.status_flags;
+    in->ui_event_flags     = s->ui_events.flags;
+    in->mode_current       = s->status.mode_current;
+    in->mode_pending       = s->status.mode_pending;
+}
+
+const char* sm_state_name(SystemState st)
+{
+    switch (st) {
+        case SYS_STATE_CONFIG: return "CONFIG";
+        case SYS_STATE_READY:  return "READY";
+        case SYS_STATE_ACTIVE: return "ACTIVE";
+        case SYS_STATE_ERROR:  return "ERROR";
+        default:               return "?";
+    }
+}
+
+const char* sm_event_name(SmEvent ev)
+{
+    switch (ev) {
+        case SM_EV_RUN:   return "RUN";
+        case SM_EV_STOP:  return "STOP";
+        case SM_EV_FAULT: return "FAULT";
+        default:          return "?";
+    }
+}
@@ -0,0 +1,127 @@
+// statemachine/statemachine_task.cpp
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "statemachine/statemachine.h"
+#include "ioexpander/ioexpander.h"
+#include "system/system.h"
+
+// =========================
+// Queue / task
+// =========================
+static constexpr int SM_QUEUE_LEN = 16;
+
+// Knoppen (IoEvent.button) die de state machine bedient
+static constexpr uint8_t SM_BTN_RUN  = 0;
+static constexpr uint8_t SM_BTN_STOP = 1;
+
+static QueueHandle_t volatile g_sm_queue = nullptr;
+static TaskHandle_t  volatile g_sm_task  = nullptr;
+
+static SmMachine g_sm;
+
+// Dispatchtijd (CPU-cycli incl. snapshot en toepassen), voor de worst case
+static uint32_t g_disp_max_cyc = 0;
+
+extern "C" bool sm_post(SmEvent ev)
+{
+    QueueHandle_t q = g_sm_queue;
+    TaskHandle_t t = g_sm_task;
+    if (!q || !t) return false;
+
+    const uint8_t e = (uint8_t)ev;
+    if (xQueueSend(q, &e, 0) != pdTRUE) return false;
+    xTaskNotifyGive(t);
+    return true;
+}
+
+// Scherm van voor de fout, terug na bevestiging
+static UiScreen g_screen_before_error = UI_SCREEN_EMULATE;
+
+static void apply_effects(const SmEffects& fx, const SystemSnapshot& s)
+{
+    if (fx.ui_error > 0) {
+        if (s.ui.active_screen != UI_SCREEN_ERROR) g_screen_before_error = s.ui.active_screen;
+        system_set_ui_screen(UI_SCREEN_ERROR);
+    } else if (fx.ui_error < 0) {
+        system_set_ui_screen(g_screen_before_error);
+    }
+
+    if (fx.latch_fault_bits)   system_latch_fault_bits(fx.latch_fault_bits);
+    if (fx.clear_latched_bits) system_clear_latched_fault_bits(fx.clear_latched_bits);
+    if (fx.set_status_flags)   system_set_status_flag(fx.set_status_flags);
+    if (fx.clear_status_flags) system_clear_status_flag(fx.clear_status_flags);
+}
+
+static void dispatch(SmEvent ev)
+{
+    const uint32_t c0 = ESP.getCycleCount();
+
+    SystemSnapshot s;
+    system_read_snapshot(&s);
+
+    SmInputs in;
+    sm_inputs_from_snapshot(&in, &s);
+
+    const SystemState from = g_sm.state;
+    SmEffects fx;
+    const bool changed = sm_dispatch(&g_sm, ev, &in, &fx);
+
+    // Volgorde: eerst uitgang/flags, dan de state (consumenten zien nooit ACTIVE
+    // zonder STATUS_CONTROL_ENABLED)
+    apply_effects(fx, s);
+    if (changed) system_set_state(g_sm.state);
+
+    const uint32_t cyc = ESP.getCycleCount() - c0;
+    if (cyc > g_disp_max_cyc) g_disp_max_cyc = cyc;
+
+    if (changed) {
+        Serial.printf("sm: %s -> %s (%s), %u cycli (max %u)\n",
+                      sm_state_name(from), sm_state_name(g_sm.state), sm_event_name(ev),
+                      (unsigned)cyc, (unsigned)g_disp_max_cyc);
+    } else if (fx.rejected) {
+        Serial.printf("sm: %s geweigerd in %s (faults 0x%02x/0x%02x)\n",
+                      sm_event_name(ev), sm_state_name(from),
+                      (unsigned)in.fault_current_bits, (unsigned)in.fault_latched_bits);
+    }
+}
+
+void statemachineTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    SystemSnapshot s;
+    system_read_snapshot(&s);
+    sm_init(&g_sm, s.status.state);
+
+    IoEventCursor cursor;
+    io_event_cursor_init(&cursor);
+
+    g_sm_queue = xQueueCreate(SM_QUEUE_LEN, sizeof(uint8_t));
+    g_sm_task  = xTaskGetCurrentTaskHandle();
+    io_event_subscribe(g_sm_task);
+
+    // Faults die al voor de start stonden
+    sm_post(SM_EV_FAULT);
+
+    Serial.printf("sm: gestart in %s\n", sm_state_name(g_sm.state));
+
+    for (;;)
+    {
+        // Geen periode: alleen wakker op sm_post of een knop-event
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint8_t e;
+        while (xQueueReceive(g_sm_queue, &e, 0) == pdTRUE) dispatch((SmEvent)e);
+
+        IoEvent ev;
+        while (io_event_pop(&cursor, &ev)) {
+            if (ev.type != IO_EVT_PRESS) continue;
+            if (ev.button == SM_BTN_RUN) dispatch(SM_EV_RUN);
+            else if (ev.button == SM_BTN_STOP) dispatch(SM_EV_STOP);
+        }
+    }
+}
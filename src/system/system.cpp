@@ -1,10 +1,12 @@
 // system/system.cpp
 #include "system/system.h"
+#include "emulate/emulate.h"
 
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "esp_timer.h"
 
 // interne opslag
@@ -12,42 +14,45 @@ static SystemData g_sys;
 static SemaphoreHandle_t g_data_mutex = nullptr;
 static SemaphoreHandle_t g_i2c_mutex  = nullptr;
 
+// =========================
+// Wijzigingsnotificatie
+// =========================
+static constexpr int SYS_MAX_SUBSCRIBERS = 4;
+
+struct SysSubscriber
+{
+    TaskHandle_t task;
+    uint32_t     mask;
+    uint32_t     pending;   // gewijzigde delen sinds system_take_changes
+};
+
+static SysSubscriber g_subs[SYS_MAX_SUBSCRIBERS];
+static int           g_n_subs = 0;
+
+// Afsluiting van elke schrijffunctie (lock is genomen): seq ophogen, bij abonnees
+// noteren wat er veranderde en pas na de unlock notificeren (de abonnee leest
+// meteen een snapshot, dan hoeft hij niet op de mutex te wachten).
+static void changed_unlock(uint32_t what)
+{
+    g_sys.seq++;
+
+    TaskHandle_t wake[SYS_MAX_SUBSCRIBERS];
+    int n = 0;
+    for (int i = 0; i < g_n_subs; ++i) {
+        SysSubscriber& sub = g_subs[i];
+        if (!(sub.mask & what)) continue;
+        if (sub.pending == 0) wake[n++] = sub.task;   // alleen de eerste wijziging
+        sub.pending |= what & sub.mask;
+    }
+    system_unlock_data();
+
+    for (int i = 0; i < n; ++i) xTaskNotifyGive(wake[i]);
+}
+
 static void init_default_curves(CurveData* c)
 {
-    if (!c) return;
-    c->len = CURVE_LEN;
-
-    // Realistische (ruwe) ontlaadcurves, genormaliseerd naar 0..100% van volle spanning.
-    // X-as: capaciteit / SOC van 100% -> 0% (links->rechts).
-    // Dit zijn "typische vormen" en geen datasheet-garanties.
-
-    // Curve 0: Li-ion (NMC/18650) - snelle init drop, lange plateau, eind-sag
-    const int16_t liion[CURVE_LEN] = {
-        100,99,98,97,96,95,95,94,
-        94,93,93,92,92,91,91,90,
-        89,88,87,86,85,84,82,80,
-        78,76,73,68,60,48,30,10
-    };
-
-    // Curve 1: LiFePO4 - zeer vlak plateau rond ~3.3V, daarna snelle drop
-    const int16_t lifepo4[CURVE_LEN] = {
-        100,99,99,98,98,97,97,96,
-        96,96,95,95,95,94,94,94,
-        93,93,93,92,92,92,91,90,
-        88,85,80,70,55,38,20,8
-    };
-
-    // Curve 2: Lead-acid - meer lineaire sag
-    const int16_t leadacid[CURVE_LEN] = {
-        100,99,98,97,96,95,94,93,
-        92,91,90,89,88,87,86,85,
-        84,83,82,81,80,79,78,76,
-        74,72,70,67,62,54,42,28
-    };
-
-    memcpy(c->curve0, liion, sizeof(liion));
-    memcpy(c->curve1, lifepo4, sizeof(lifepo4));
-    memcpy(c->curve2, leadacid, sizeof(leadacid));
+    // Curvetabellen staan in de emulatie-engine (ook gebruikt door de host tools)
+    emu_default_curves(c);
 }
 
 void system_init(void)
@@ -82,6 +87,8 @@ void system_init(void)
     g_sys.status.mode_current = POWER_MODE_EMULATE;
     g_sys.status.mode_pending = POWER_MODE_EMULATE;
 
+    g_sys.cfg.logging_enabled = true;   // logTask schrijft naar SD als er een kaart is
+
     g_sys.seq = 0;
     system_unlock_data();
 }
@@ -100,8 +107,7 @@ void system_write_measurement(const MeasurementData* meas)
     if (!meas) return;
     system_lock_data();
     g_sys.meas = *meas;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_MEAS);
 }
 
 void system_write_control(const ControlData* ctrl)
@@ -109,8 +115,7 @@ void system_write_control(const ControlData* ctrl)
     if (!ctrl) return;
     system_lock_data();
     g_sys.control = *ctrl;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_CONTROL);
 }
 
 void system_write_apply_status(const ApplyStatus* apply)
@@ -118,8 +123,7 @@ void system_write_apply_status(const ApplyStatus* apply)
     if (!apply) return;
     system_lock_data();
     g_sys.apply = *apply;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_CONTROL);
 }
 
 void system_write_config(const ConfigData* cfg)
@@ -127,8 +131,7 @@ void system_write_config(const ConfigData* cfg)
     if (!cfg) return;
     system_lock_data();
     g_sys.cfg = *cfg;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_CONFIG);
 }
 
 void system_write_status(const SystemStatus* status)
@@ -136,8 +139,7 @@ void system_write_status(const SystemStatus* status)
     if (!status) return;
     system_lock_data();
     g_sys.status = *status;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_write_io_shared(const IOShared* io)
@@ -145,8 +147,7 @@ void system_write_io_shared(const IOShared* io)
     if (!io) return;
     system_lock_data();
     g_sys.io = *io;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_IO);
 }
 
 void system_write_curves(const CurveData* curves)
@@ -154,8 +155,7 @@ void system_write_curves(const CurveData* curves)
     if (!curves) return;
     system_lock_data();
     g_sys.curves = *curves;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_CURVES);
 }
 
 void system_write_ui_shared(const UIShared* ui)
@@ -163,8 +163,7 @@ void system_write_ui_shared(const UIShared* ui)
     if (!ui) return;
     system_lock_data();
     g_sys.ui = *ui;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_UI);
 }
 
 void system_write_ui_events(const UIEvents* ev)
@@ -172,32 +171,67 @@ void system_write_ui_events(const UIEvents* ev)
     if (!ev) return;
     system_lock_data();
     g_sys.ui_events = *ev;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_UI);
+}
+
+void system_set_ui_screen(UiScreen screen)
+{
+    system_lock_data();
+    g_sys.ui.active_screen = screen;
+    changed_unlock(SYS_CHG_UI);
+}
+
+void system_set_state(SystemState state)
+{
+    system_lock_data();
+    g_sys.status.state = state;
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_set_status_flag(uint32_t flag_bits)
 {
     system_lock_data();
     g_sys.status.status_flags |= flag_bits;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_clear_status_flag(uint32_t flag_bits)
 {
     system_lock_data();
     g_sys.status.status_flags &= ~flag_bits;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
+}
+
+void system_request_mode(PowerMode mode)
+{
+    system_lock_data();
+    g_sys.status.mode_pending = mode;
+    if (mode != g_sys.status.mode_current) g_sys.status.status_flags |= STATUS_MODE_SWITCH_PENDING;
+    else g_sys.status.status_flags &= ~STATUS_MODE_SWITCH_PENDING;
+    changed_unlock(SYS_CHG_STATUS);
+}
+
+void system_complete_mode_switch(PowerMode mode)
+{
+    system_lock_data();
+    g_sys.status.mode_current = mode;
+    // Tijdens de wissel kan al een volgende mode gevraagd zijn
+    if (g_sys.status.mode_pending == mode) g_sys.status.status_flags &= ~STATUS_MODE_SWITCH_PENDING;
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_set_fault_bits(uint32_t fault_bits)
 {
     system_lock_data();
     g_sys.status.fault_current_bits |= fault_bits;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
+}
+
+void system_clear_fault_bits(uint32_t fault_bits)
+{
+    system_lock_data();
+    g_sys.status.fault_current_bits &= ~fault_bits;
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_latch_fault_bits(uint32_t fault_bits)
@@ -205,32 +239,36 @@ void system_latch_fault_bits(uint32_t fault_bits)
     system_lock_data();
     g_sys.status.fault_current_bits |= fault_bits;
     g_sys.status.fault_latched_bits |= fault_bits;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
 }
 
 void system_clear_latched_fault_bits(uint32_t fault_bits)
 {
     system_lock_data();
     g_sys.status.fault_latched_bits &= ~fault_bits;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_STATUS);
+}
+
+void system_io_set_buttons(uint32_t raw_bits, uint32_t changed_bits)
+{
+    system_lock_data();
+    g_sys.io.buttons_raw_bits = raw_bits;
+    g_sys.io.buttons_changed_bits |= changed_bits;
+    changed_unlock(SYS_CHG_IO);
 }
 
 void system_io_clear_buttons_changed(uint32_t mask)
 {
     system_lock_data();
     g_sys.io.buttons_changed_bits &= ~mask;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_IO);
 }
 
 void system_io_clear_enc_delta(void)
 {
     system_lock_data();
     g_sys.io.enc_delta_accum = 0;
-    g_sys.seq++;
-    system_unlock_data();
+    changed_unlock(SYS_CHG_IO);
 }
 
 void system_lock_data(void)
@@ -252,3 +290,37 @@ void system_unlock_i2c(void)
 {
     if (g_i2c_mutex) xSemaphoreGive(g_i2c_mutex);
 }
+
+int system_subscribe_changes(void* task, uint32_t mask)
+{
+    if (!task || !mask) return -1;
+    system_lock_data();
+    int id = -1;
+    if (g_n_subs < SYS_MAX_SUBSCRIBERS) {
+        id = g_n_subs++;
+        g_subs[id].task = (TaskHandle_t)task;
+        g_subs[id].mask = mask;
+        g_subs[id].pending = 0;
+    }
+    system_unlock_data();
+    return id;
+}
+
+uint32_t system_peek_changes(int id)
+{
+    if (id < 0 || id >= SYS_MAX_SUBSCRIBERS) return 0;
+    system_lock_data();
+    const uint32_t p = g_subs[id].pending;
+    system_unlock_data();
+    return p;
+}
+
+uint32_t system_take_changes(int id)
+{
+    if (id < 0 || id >= SYS_MAX_SUBSCRIBERS) return 0;
+    system_lock_data();
+    const uint32_t p = g_subs[id].pending;
+    g_subs[id].pending = 0;
+    system_unlock_data();
+    return p;
+}
@@ -0,0 +1,374 @@
+// telemetry/telemetry.cpp
+#include "telemetry/telemetry.h"
+#include "system/crc.h"
+
+#include <string.h>
+
+static_assert(sizeof(TlmFrameHeader) == 4, "TlmFrameHeader: 4 bytes op de lijn");
+static_assert(sizeof(TlmConfig) == 4, "TlmConfig: 4 bytes op de lijn");
+static_assert((TLM_SAMPLE_RING_LEN & (TLM_SAMPLE_RING_LEN - 1u)) == 0, "TLM_SAMPLE_RING_LEN: macht van 2");
+static_assert((TLM_TX_LEN & (TLM_TX_LEN - 1u)) == 0, "TLM_TX_LEN: macht van 2");
+static_assert(TLM_TX_LEN >= 2u * TLM_WIRE_MAX, "TX-ring moet minstens twee frames houden");
+static_assert(TLM_MAX_PER_FRAME <= 0xFFu, "n is 8 bit");
+
+// Eén schrijver per teller; de ander leest alleen.
+static inline void inc(uint32_t* p) { __atomic_store_n(p, *p + 1u, __ATOMIC_RELAXED); }
+static inline uint32_t ld(const uint32_t* p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+
+// TlmConfig <-> één woord
+static inline uint32_t cfg_pack(const TlmConfig* c)
+{
+    return (uint32_t)c->ch_mask | ((uint32_t)c->per_frame << 8) | ((uint32_t)c->decim << 16);
+}
+
+static inline void cfg_unpack(uint32_t w, TlmConfig* c)
+{
+    c->ch_mask   = (uint8_t)(w & 0xFFu);
+    c->per_frame = (uint8_t)((w >> 8) & 0xFFu);
+    c->decim     = (uint16_t)(w >> 16);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint32_t get_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// =========================
+// COBS
+// =========================
+uint32_t tlm_cobs_encode(const uint8_t* src, uint32_t len, uint8_t* dst)
+{
+    uint32_t code_idx = 0, out = 1;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < len; ++i) {
+        if (src[i] == 0) {
+            dst[code_idx] = code;
+            code_idx = out++;
+            code = 1;
+        } else {
+            dst[out++] = src[i];
+            if (++code == 0xFFu) {
+                dst[code_idx] = code;
+                code_idx = out++;
+                code = 1;
+            }
+        }
+    }
+    dst[code_idx] = code;
+    return out;
+}
+
+int tlm_cobs_decode(const uint8_t* src, uint32_t len, uint8_t* dst, uint32_t max)
+{
+    uint32_t i = 0, o = 0;
+    while (i < len) {
+        const uint8_t code = src[i++];
+        if (code == 0) return -1;
+        for (uint8_t k = 1; k < code; ++k) {
+            if (i >= len || o >= max || src[i] == 0) return -1;
+            dst[o++] = src[i++];
+        }
+        if (code != 0xFFu && i < len) {
+            if (o >= max) return -1;
+            dst[o++] = 0;
+        }
+    }
+    return (int)o;
+}
+
+// frame[0..len) + crc -> COBS + 0x00. frame moet 4 bytes ruimte achter len hebben.
+static uint32_t seal(uint8_t* frame, uint32_t len, uint8_t* wire)
+{
+    put_u32(frame + len, crc32_ieee(frame, len));
+    const uint32_t n = tlm_cobs_encode(frame, len + 4u, wire);
+    wire[n] = 0;
+    return n + 1u;
+}
+
+uint32_t tlm_frame_wire(uint8_t type, uint16_t seq, const void* payload, uint32_t len, uint8_t* wire)
+{
+    uint8_t frame[TLM_FRAME_MAX];
+    if (len + sizeof(TlmFrameHeader) + 4u > TLM_FRAME_MAX) return 0;
+
+    TlmFrameHeader h;
+    h.type = type;
+    h.version = TLM_VERSION;
+    h.seq = seq;
+    memcpy(frame, &h, sizeof(h));
+    if (len) memcpy(frame + sizeof(h), payload, len);
+    return seal(frame, sizeof(h) + len, wire);
+}
+
+// =========================
+// TX-ring (bytes)
+// =========================
+static uint32_t tx_fill(const TlmByteRing* r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+// Alles of niets: een half frame op de lijn is erger dan een gemist frame.
+static bool tx_write(TlmByteRing* r, const uint8_t* src, uint32_t n)
+{
+    const uint32_t head = r->head;
+    if (TLM_TX_LEN - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)) < n) return false;
+
+    const uint32_t off = head & (TLM_TX_LEN - 1u);
+    const uint32_t first = (n < TLM_TX_LEN - off) ? n : TLM_TX_LEN - off;
+    memcpy(r->buf + off, src, first);
+    if (n > first) memcpy(r->buf, src + first, n - first);
+    __atomic_store_n(&r->head, head + n, __ATOMIC_RELEASE);
+    return true;
+}
+
+const uint8_t* tlm_tx_peek(const TlmTx* t, uint32_t* n)
+{
+    const uint32_t tail = t->tx.tail;
+    const uint32_t fill = __atomic_load_n(&t->tx.head, __ATOMIC_ACQUIRE) - tail;
+    const uint32_t off = tail & (TLM_TX_LEN - 1u);
+    const uint32_t to_end = TLM_TX_LEN - off;
+    *n = (fill < to_end) ? fill : to_end;
+    return t->tx.buf + off;
+}
+
+void tlm_tx_consume(TlmTx* t, uint32_t n)
+{
+    __atomic_store_n(&t->tx.tail, t->tx.tail + n, __ATOMIC_RELEASE);
+}
+
+// =========================
+// Zender
+// =========================
+void tlm_tx_init(TlmTx* t, TlmSample* samples, uint8_t* tx_buf, const TlmConfig* cfg)
+{
+    if (!t) return;
+    memset(t, 0, sizeof(*t));
+    t->samples.buf = samples;
+    t->tx.buf = tx_buf;
+    tlm_set_config(t, cfg);
+}
+
+void tlm_set_config(TlmTx* t, const TlmConfig* cfg)
+{
+    TlmConfig c = *cfg;
+    c.ch_mask &= TLM_CH_ALL;
+    if (c.per_frame < 1u) c.per_frame = 1;
+    if (c.per_frame > TLM_MAX_PER_FRAME) c.per_frame = TLM_MAX_PER_FRAME;
+    if (c.decim < 1u) c.decim = 1;
+    __atomic_store_n(&t->samples.cfg, cfg_pack(&c), __ATOMIC_RELAXED);
+}
+
+void tlm_get_config(const TlmTx* t, TlmConfig* out)
+{
+    cfg_unpack(ld(&t->samples.cfg), out);
+}
+
+bool tlm_push(TlmTx* t, const TlmSample* s)
+{
+    TlmSampleRing* r = &t->samples;
+    inc(&r->n_offered);
+
+    const uint32_t cfg = ld(&r->cfg);
+    if ((cfg & 0xFFu) == 0) return false;   // stream uit
+
+    const uint32_t decim = cfg >> 16;
+    if (++r->decim_phase < decim) {
+        inc(&r->n_decimated);
+        return false;
+    }
+    r->decim_phase = 0;
+
+    const uint32_t head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= TLM_SAMPLE_RING_LEN) {
+        inc(&r->n_drops);
+        return false;
+    }
+    r->buf[head & (TLM_SAMPLE_RING_LEN - 1u)] = *s;
+    __atomic_store_n(&r->head, head + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Payload na de header: ch_mask, n, decim
+static constexpr uint32_t SAMPLES_HDR = sizeof(TlmFrameHeader) + 4u;
+
+static void frame_begin(TlmTx* t, uint32_t now_ms)
+{
+    TlmConfig c;
+    tlm_get_config(t, &c);
+    t->frame_mask  = c.ch_mask;
+    t->frame_per   = c.per_frame;
+    t->frame_decim = c.decim;
+    t->frame_n     = 0;
+    t->frame_len   = SAMPLES_HDR;
+    t->frame_t0_ms = now_ms;
+}
+
+static void frame_add(TlmTx* t, const TlmSample* s)
+{
+    uint8_t* p = t->frame + t->frame_len;
+    const uint8_t m = t->frame_mask;
+    put_u32(p, s->t_us); p += 4;
+    if (m & TLM_CH_V_OUT)    { memcpy(p, &s->v_out, 4); p += 4; }
+    if (m & TLM_CH_I_SINK)   { memcpy(p, &s->i_sink, 4); p += 4; }
+    if (m & TLM_CH_I_SOURCE) { memcpy(p, &s->i_source, 4); p += 4; }
+    if (m & TLM_CH_TEMP)     { memcpy(p, &s->temp_sink_c, 4); p += 4; }
+    if (m & TLM_CH_FLAGS)    { put_u32(p, s->meas_flags); p += 4; }
+    t->frame_len = (uint32_t)(p - t->frame);
+    t->frame_n++;
+}
+
+static void frame_close(TlmTx* t)
+{
+    TlmFrameHeader h;
+    h.type = TLM_FRAME_SAMPLES;
+    h.version = TLM_VERSION;
+    h.seq = t->seq++;
+    memcpy(t->frame, &h, sizeof(h));
+    t->frame[4] = t->frame_mask;
+    t->frame[5] = t->frame_n;
+    memcpy(t->frame + 6, &t->frame_decim, 2);
+
+    uint8_t wire[TLM_WIRE_MAX];
+    const uint32_t n = seal(t->frame, t->frame_len, wire);
+    if (tx_write(&t->tx, wire, n)) {
+        t->n_frames++;
+        t->n_samples += t->frame_n;
+        t->tx_bytes += n;
+    } else {
+        t->n_frame_drops++;
+    }
+    t->frame_n = 0;
+}
+
+uint32_t tlm_pump(TlmTx* t, uint32_t now_ms, uint32_t flush_ms)
+{
+    TlmSampleRing* r = &t->samples;
+    uint32_t tail = r->tail;
+    const uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    while (tail != head) {
+        if (t->frame_n == 0) {
+            // Host leest niet bij: samples in de ring laten in plaats van frames te
+            // coderen die toch niet passen. Loopt de ring vol, dan dropt de producer.
+            if (TLM_TX_LEN - tx_fill(&t->tx) < TLM_WIRE_MAX) break;
+            frame_begin(t, now_ms);
+        }
+        frame_add(t, &r->buf[tail & (TLM_SAMPLE_RING_LEN - 1u)]);
+        ++tail;
+        if (t->frame_n >= t->frame_per) {
+            // Slot vrijgeven voor het (dure) sluiten: de producer heeft meer ruimte
+            __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+            frame_close(t);
+        }
+    }
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+    if (t->frame_n && now_ms - t->frame_t0_ms >= flush_ms) frame_close(t);
+    return tx_fill(&t->tx);
+}
+
+void tlm_get_status(const TlmTx* t, TlmStatus* out)
+{
+    out->n_offered     = ld(&t->samples.n_offered);
+    out->n_decimated   = ld(&t->samples.n_decimated);
+    out->n_ring_drops  = ld(&t->samples.n_drops);
+    out->n_samples     = t->n_samples;
+    out->n_frames      = t->n_frames;
+    out->n_frame_drops = t->n_frame_drops;
+    out->tx_bytes      = t->tx_bytes;
+    tlm_get_config(t, &out->cfg);
+}
+
+bool tlm_send_status(TlmTx* t)
+{
+    TlmStatus st;
+    tlm_get_status(t, &st);
+
+    uint8_t wire[TLM_WIRE_MAX];
+    const uint32_t n = tlm_frame_wire(TLM_FRAME_STATUS, t->seq++, &st, sizeof(st), wire);
+    if (!tx_write(&t->tx, wire, n)) {
+        t->n_frame_drops++;
+        return false;
+    }
+    t->tx_bytes += n;
+    return true;
+}
+
+// =========================
+// Ontvanger
+// =========================
+void tlm_parser_init(TlmParser* p)
+{
+    if (!p) return;
+    memset(p, 0, sizeof(*p));
+}
+
+bool tlm_parser_feed(TlmParser* p, uint8_t b)
+{
+    if (b != 0) {
+        if (p->wire_len >= TLM_WIRE_MAX) p->overflow = true;
+        else p->wire[p->wire_len++] = b;
+        return false;
+    }
+
+    // Frame-einde
+    const uint32_t wl = p->wire_len;
+    const bool overflow = p->overflow;
+    p->wire_len = 0;
+    p->overflow = false;
+    if (wl == 0) return false;   // losse 0x00 (resync)
+    if (overflow) {
+        p->n_bad++;
+        return false;
+    }
+
+    const int n = tlm_cobs_decode(p->wire, wl, p->frame, TLM_FRAME_MAX);
+    if (n < (int)(sizeof(TlmFrameHeader) + 4u) ||
+        crc32_ieee(p->frame, (uint32_t)n - 4u) != get_u32(p->frame + n - 4)) {
+        p->n_bad++;
+        return false;
+    }
+
+    TlmFrameHeader h;
+    memcpy(&h, p->frame, sizeof(h));
+    if (h.version != TLM_VERSION) {
+        p->n_bad++;
+        return false;
+    }
+
+    // seq telt ook gedropte frames: een gat is verlies (op de lijn of in de TX-ring)
+    if (p->have_seq) p->n_lost += (uint16_t)(h.seq - p->last_seq - 1u);
+    p->have_seq = true;
+    p->last_seq = h.seq;
+
+    p->n_frames++;
+    p->frame_len = (uint32_t)n;
+    return true;
+}
+
+int tlm_frame_samples(const uint8_t* frame, uint32_t len, TlmSample* out, uint32_t max,
+                      uint8_t* ch_mask, uint16_t* decim)
+{
+    if (len < SAMPLES_HDR + 4u || frame[0] != TLM_FRAME_SAMPLES) return -1;
+
+    const uint8_t m = frame[4];
+    const uint32_t n = frame[5];
+    uint16_t d;
+    memcpy(&d, frame + 6, 2);
+
+    const uint32_t per = 4u + 4u * (uint32_t)__builtin_popcount(m);
+    if (SAMPLES_HDR + n * per + 4u != len || n > max) return -1;
+
+    const uint8_t* p = frame + SAMPLES_HDR;
+    for (uint32_t i = 0; i < n; ++i) {
+        TlmSample& s = out[i];
+        memset(&s, 0, sizeof(s));
+        s.t_us = get_u32(p); p += 4;
+        if (m & TLM_CH_V_OUT)    { memcpy(&s.v_out, p, 4); p += 4; }
+        if (m & TLM_CH_I_SINK)   { memcpy(&s.i_sink, p, 4); p += 4; }
+        if (m & TLM_CH_I_SOURCE) { memcpy(&s.i_source, p, 4); p += 4; }
+        if (m & TLM_CH_TEMP)     { memcpy(&s.temp_sink_c, p, 4); p += 4; }
+        if (m & TLM_CH_FLAGS)    { s.meas_flags = get_u32(p); p += 4; }
+    }
+    if (ch_mask) *ch_mask = m;
+    if (decim) *decim = d;
+    return (int)n;
+}
@@ -0,0 +1,167 @@
+// telemetry/telemetry_task.cpp
+#include <Arduino.h>
+#include <HWCDC.h>
+#include <esp_heap_caps.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "telemetry/telemetry.h"
+
+// =========================
+// USB
+// =========================
+// Native USB van de S3 (USB-Serial-JTAG, ARDUINO_USB_MODE=1). Serial blijft de
+// UART voor tekst-diagnose; USBSerial draagt alleen frames. D-/D+ liggen vast op
+// GPIO19/20; I2C SCL en LCD_WR zitten daarom op andere pinnen (system/pins.h). Het controller-FIFO
+// is 64 bytes; de HWCDC-driver vult het uit zijn eigen TX-buffer in de ISR.
+static constexpr size_t   USB_TX_BUF = 4096;
+static constexpr size_t   USB_RX_BUF = 256;
+
+// =========================
+// Timing
+// =========================
+static constexpr uint32_t TLM_WAKE_EVERY  = 16;      // samples tussen notifies
+static constexpr uint32_t TLM_POLL_MS     = 10;
+static constexpr uint32_t TLM_FLUSH_MS    = 50;      // deels gevuld frame (lage rates / hoge decimatie)
+static constexpr uint32_t TLM_STATUS_MS   = 1000;    // STATUS-frame naar de host
+static constexpr uint32_t TLM_STATS_MS    = 10000;   // regel op Serial
+
+// =========================
+// State
+// =========================
+static TlmSample g_samples[TLM_SAMPLE_RING_LEN];
+static TlmTx     g_tx;
+static TlmParser g_rx;
+
+// Producer schrijft alleen als er een host is
+static volatile bool g_streaming = false;
+static TaskHandle_t volatile g_tlm_task = nullptr;
+
+// =========================
+// Producer (measureTask)
+// =========================
+extern "C" void telemetry_measurement(const MeasurementData* m)
+{
+    if (!g_streaming || !m) return;
+
+    TlmSample s;
+    s.t_us        = m->t_us;
+    s.v_out       = m->v_out;
+    s.i_sink      = m->i_sink;
+    s.i_source    = m->i_source;
+    s.temp_sink_c = m->temp_sink_c;
+    s.meas_flags  = m->meas_flags;
+    if (!tlm_push(&g_tx, &s)) return;
+
+    TaskHandle_t t = g_tlm_task;
+    if (t && (g_tx.samples.head % TLM_WAKE_EVERY) == 0) xTaskNotifyGive(t);
+}
+
+extern "C" void telemetry_get_status(TlmStatus* out)
+{
+    if (!out) return;
+    tlm_get_status(&g_tx, out);
+}
+
+// =========================
+// Task
+// =========================
+static void handle_frame(const TlmParser* p)
+{
+    TlmFrameHeader h;
+    memcpy(&h, p->frame, sizeof(h));
+    if (h.type != TLM_FRAME_CONFIG || p->frame_len != sizeof(h) + sizeof(TlmConfig) + 4u) return;
+
+    TlmConfig c;
+    memcpy(&c, p->frame + sizeof(h), sizeof(c));
+    tlm_set_config(&g_tx, &c);
+    tlm_get_config(&g_tx, &c);
+    Serial.printf("tlm: kanalen 0x%02X, %u per frame, decimatie %u\n",
+                  (unsigned)c.ch_mask, (unsigned)c.per_frame, (unsigned)c.decim);
+}
+
+extern "C" void telemetryTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    // TX-ring in intern, DMA-geschikt RAM: de USB-driver leest eruit zonder cache-misses op PSRAM
+    uint8_t* tx_buf = (uint8_t*)heap_caps_aligned_alloc(32, TLM_TX_LEN, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!tx_buf) {
+        Serial.println("tlm: ERROR buffer alloc failed");
+        vTaskDelete(nullptr);
+        return;
+    }
+
+    TlmConfig cfg;
+    cfg.ch_mask   = TLM_CH_V_OUT | TLM_CH_I_SINK | TLM_CH_I_SOURCE | TLM_CH_TEMP;
+    cfg.per_frame = TLM_MAX_PER_FRAME;
+    cfg.decim     = 1;
+    tlm_tx_init(&g_tx, g_samples, tx_buf, &cfg);
+    tlm_parser_init(&g_rx);
+
+    USBSerial.setTxBufferSize(USB_TX_BUF);
+    USBSerial.setRxBufferSize(USB_RX_BUF);
+    USBSerial.begin();
+    USBSerial.setTxTimeoutMs(0);   // nooit wachten op de host
+
+    g_tlm_task = xTaskGetCurrentTaskHandle();
+
+    uint32_t t_status = millis(), t_stats = millis();
+    uint32_t samples_prev = 0;
+    bool host_shown = false;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TLM_POLL_MS));
+        const uint32_t now = millis();
+
+        // Host -> device: CONFIG-frames
+        uint8_t in[64];
+        size_t n_in;
+        while ((n_in = USBSerial.read(in, sizeof(in))) > 0) {
+            for (size_t i = 0; i < n_in; ++i) {
+                if (tlm_parser_feed(&g_rx, in[i])) handle_frame(&g_rx);
+            }
+        }
+
+        const bool host = (bool)USBSerial;
+        g_streaming = host;
+        if (host != host_shown) {
+            host_shown = host;
+            Serial.printf("tlm: host %s\n", host ? "verbonden" : "weg");
+        }
+
+        tlm_pump(&g_tx, now, TLM_FLUSH_MS);
+        if (host && now - t_status >= TLM_STATUS_MS) {
+            t_status = now;
+            tlm_send_status(&g_tx);
+        }
+
+        // TX-ring -> USB, alleen wat de driver nu aanneemt
+        for (;;) {
+            uint32_t n;
+            const uint8_t* p = tlm_tx_peek(&g_tx, &n);
+            if (n == 0) break;
+            if (!host) {
+                tlm_tx_consume(&g_tx, n);   // geen host: oude frames niet bewaren
+                continue;
+            }
+            const size_t room = USBSerial.availableForWrite();
+            if (room == 0) break;
+            const size_t w = USBSerial.write(p, n < room ? n : room);
+            tlm_tx_consume(&g_tx, (uint32_t)w);
+            if (w < n) break;
+        }
+
+        if (host && now - t_stats >= TLM_STATS_MS) {
+            TlmStatus st;
+            tlm_get_status(&g_tx, &st);
+            Serial.printf("tlm: %u samples/s, %u frames gedropt, %u ring-drops\n",
+                          (unsigned)((st.n_samples - samples_prev) * 1000u / (now - t_stats)),
+                          (unsigned)st.n_frame_drops, (unsigned)st.n_ring_drops);
+            samples_prev = st.n_samples;
+            t_stats = now;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+// tools/aging_sim.cpp - cycle-aging simulatie van de emulatie-engine (host)
+//
+// Cycleert de geëmuleerde batterij (1C ontladen tot cutoff, 1C CC laden) met het
+// aging model erop, en print capaciteit/weerstand per N cycli.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/aging_sim.cpp src/emulate/emulate.cpp src/emulate/aging.cpp -o tools/build/aging_sim
+//
+// Gebruik:
+//   aging_sim [--chem 0|1|2] [--cycles N] [--dt S] [--temp C] [--crate C] [--every N]
+//   aging_sim --check                200 h standalone bij 1 ms: EFC, tijd, checkpoints
+//
+// Standaard dt = 1 ms, zoals emu_tick in de firmware (~0.4 s rekentijd per cyclus);
+// --dt 1 voor snelle lange runs.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "emulate/emulate.h"
+#include "emulate/aging.h"
+
+// aging_update alleen, 200 h bij 1 ms en 1C: EFC = 100, t_total = 720000 s en
+// een checkpoint per 600 s (zoals AGING_CKPT_MAX_S in control.cpp)
+static int check_standalone()
+{
+  const float dt = 0.001f;
+  const float cap_ah = 3.0f;
+  const double hours = 200.0;
+  const uint64_t n = (uint64_t)(hours * 3600.0 / dt + 0.5);
+
+  AgingParams ap;
+  aging_default_params(&ap, 0);
+  AgingState ag, saved;
+  aging_init(&ag);
+  saved = ag;
+
+  uint32_t ckpts = 0;
+  for (uint64_t k = 0; k < n; ++k) {
+    aging_update(&ag, &ap, 0.5f, cap_ah, 25.0f, dt, cap_ah);
+    if (aging_checkpoint_due(&ag, &saved, 1e9f, 600.0f)) {
+      saved = ag;
+      ckpts++;
+    }
+  }
+
+  const double efc_exp = hours / 2.0;   // 1C: 1 Ah/Ah per uur, 2 per cyclus
+  const double t_exp = hours * 3600.0;
+  const uint32_t ck_exp = (uint32_t)(t_exp / 600.0);
+  const bool ok = fabs(ag.efc - efc_exp) < 1e-3 * efc_exp && fabs(ag.t_total_s - t_exp) < 1.0 &&
+                  (ckpts == ck_exp || ckpts + 1 == ck_exp);
+  printf("200 h bij 1 ms: EFC %.4f (verwacht %.1f), t_total %.1f s (verwacht %.0f), %u checkpoints (verwacht %u) %s\n",
+         ag.efc, efc_exp, ag.t_total_s, t_exp, ckpts, ck_exp, ok ? "OK" : "FOUT");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc >= 2 && !strcmp(argv[1], "--check")) return check_standalone();
+
+  int chem = 0;
+  int cycles = 100;
+  int every = 10;
+  float dt = 0.001f;
+  float temp_c = 25.0f;
+  float c_rate = 1.0f;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--chem")) chem = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--cycles")) cycles = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--dt")) dt = strtof(argv[i + 1], nullptr);
+    else if (!strcmp(argv[i], "--temp")) temp_c = strtof(argv[i + 1], nullptr);
+    else if (!strcmp(argv[i], "--crate")) c_rate = strtof(argv[i + 1], nullptr);
+    else if (!strcmp(argv[i], "--every")) every = atoi(argv[i + 1]);
+    else {
+      fprintf(stderr, "onbekende optie %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (every <= 0) every = 1;
+
+  CurveData curves;
+  emu_default_curves(&curves);
+
+  EmuParams base;
+  emu_params_from_curves(&base, &curves, (uint8_t)chem, 4.2f, 3000.0f);
+  base.v_cutoff = 0.7f * 4.2f;
+
+  AgingParams ap;
+  aging_default_params(&ap, (uint8_t)chem);
+
+  AgingState ag;
+  aging_init(&ag);
+
+  const float cap_ah = base.capacity_mAh * 0.001f;
+  const float i_c = c_rate * cap_ah;
+
+  printf("%7s %8s %9s %8s %8s %10s\n", "cycle", "EFC", "Ah_meas", "Q_fact", "R_fact", "t_eff[d]");
+
+  EmuParams ep;
+  EmuState es;
+  uint64_t steps = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+
+  for (int c = 1; c <= cycles; ++c) {
+    aging_apply(&ag, &base, &ep);
+    emu_init(&es, &ep, 1.0f);
+
+    // Ontladen tot cutoff
+    while (!es.empty) {
+      emu_step(&es, &ep, i_c, dt);
+      aging_update(&ag, &ap, es.soc, i_c, temp_c, dt, cap_ah);
+      ++steps;
+    }
+    const float ah_meas = es.ah_out;
+
+    // CC laden tot vol (geen CV-fase in het model)
+    while (es.soc < 0.999f) {
+      emu_step(&es, &ep, -i_c, dt);
+      aging_update(&ag, &ap, es.soc, -i_c, temp_c, dt, cap_ah);
+      ++steps;
+    }
+
+    if (c % every == 0 || c == 1)
+      printf("%7d %8.1f %9.4f %8.4f %8.4f %10.2f\n", c, (double)ag.efc, (double)ah_meas,
+             (double)ag.capacity_factor, (double)ag.resistance_factor, ag.t_eff_s / 86400.0);
+  }
+
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  // Checkpoint round-trip (zelfde blob als de firmware naar NVS schrijft)
+  aging_seal(&ag);
+  printf("checkpoint %zu bytes, crc %s\n", sizeof(AgingState), aging_verify(&ag) ? "OK" : "FOUT");
+  printf("%d cycli, %llu stappen in %.3f s (%.1f Msteps/s)\n", cycles, (unsigned long long)steps, secs,
+         secs > 0 ? (double)steps / secs * 1e-6 : 0.0);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// tools/autotune_sim.cpp - relay-feedback autotune tegen het plant model (host)
+//
+// Draait src/control/autotune.cpp op dezelfde werkpunten als ControlTask, tegen
+// tools/sim/plant.h, en controleert daarna de gesloten lus met de gevonden gains
+// (sprong van 90% naar 100% van het werkpunt). De gesloten lus is dezelfde PI als
+// regulate() in control.cpp: feedforward sp / full, integrator vanaf 0 (zoals na
+// een modewissel) en anti-windup door niet te integreren in verzadiging.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude -Itools tools/autotune_sim.cpp src/control/autotune.cpp -o tools/build/autotune_sim
+//
+// De plant is werkpuntafhankelijk (MLCC DC-bias, MOSFET-gm; zie sim/plant.h), zodat
+// Ku/Pu per werkpunt verschillen zoals de gain schedule in control.cpp veronderstelt.
+//
+// Exit code 0 als alle werkpunten convergeren en de stapresponsie binnen de grenzen
+// blijft: ingeschakeld binnen 2% en hooguit 20% overshoot (van de stapgrootte).
+
+#include <math.h>
+#include <stdio.h>
+
+#include "control/autotune.h"
+#include "sim/plant.h"
+
+static constexpr float DT = 0.001f; // 1 kHz, zelfde als measureTask
+
+struct OpPoint
+{
+  bool  sink;
+  float op;
+};
+
+// Moet overeenkomen met de werkpunten in control.cpp
+static const OpPoint OPS[] = {
+  {false, 2.0f}, {false, 5.0f}, {false, 10.0f},
+  {true,  0.5f}, {true,  2.0f}, {true,  5.0f},
+};
+
+static float plant_meas(PlantState& ps, const PlantParams& pp, bool sink, float duty)
+{
+  // Source: lichte last van 0.2 A; sink: DUT van 5 V
+  return sink ? plant_step_sink(ps, pp, duty, 5.0f)
+              : plant_step_source(ps, pp, duty, 0.2f);
+}
+
+int main()
+{
+  PlantParams pp;
+  pp.c_bias_v = 5.0f;
+  pp.gm_ref_a = 2.0f;
+  int failures = 0;
+
+  printf("%-6s %6s | %8s %8s %8s %8s | %6s | %7s %7s\n",
+         "loop", "op", "Ku", "Pu[ms]", "kp", "ki", "t[s]", "ovs[%]", "ts[ms]");
+
+  for (const OpPoint& o : OPS) {
+    PlantState ps;
+    plant_init(ps, pp, DT);
+
+    const float full = o.sink ? pp.i_sink_max : pp.v_supply;   // CTRL_SINK_I_FULL / CTRL_SOURCE_V_FULL
+
+    AutotuneConfig cfg{};
+    cfg.setpoint      = o.op;
+    cfg.u_bias        = o.op / full;
+    cfg.relay_d       = 0.05f;
+    cfg.hysteresis    = 0.002f * full;
+    cfg.settle_cycles = 2;
+    cfg.cycles        = 6;
+    cfg.timeout_s     = 3.0f;
+
+    // Eerst naar het werkpunt (open loop op de bias), zoals ControlTask ook doet
+    float meas = 0.0f;
+    for (int k = 0; k < 200; ++k) meas = plant_meas(ps, pp, o.sink, cfg.u_bias);
+
+    AutotuneState at;
+    autotune_start(&at, &cfg);
+    while (at.status == AT_RUNNING) {
+      const float u = autotune_step(&at, meas, DT);
+      meas = plant_meas(ps, pp, o.sink, u);
+    }
+
+    if (at.status != AT_DONE) {
+      printf("%-6s %6.2f | FAILED na %.3f s\n", o.sink ? "sink" : "source", o.op, at.t_s);
+      ++failures;
+      continue;
+    }
+
+    // Gesloten lus: stap van 90% naar 100% van het werkpunt
+    SimPI pi;
+    pi.kp = at.result.kp;
+    pi.ki = at.result.ki;
+    pi.integ = 0.0f;
+    plant_init(ps, pp, DT);
+    const float sp0 = 0.9f * o.op;
+    for (int k = 0; k < 500; ++k) meas = plant_meas(ps, pp, o.sink, pi.step(sp0, meas, DT, sp0 / full));
+
+    float peak = meas;
+    int settle_k = -1;
+    for (int k = 0; k < 2000; ++k) {
+      meas = plant_meas(ps, pp, o.sink, pi.step(o.op, meas, DT, o.op / full));
+      if (meas > peak) peak = meas;
+      const bool in_band = fabsf(meas - o.op) < 0.02f * o.op;
+      if (!in_band) settle_k = -1;
+      else if (settle_k < 0) settle_k = k;
+    }
+    const float ovs = (peak - o.op) / (0.1f * o.op) * 100.0f;
+
+    printf("%-6s %6.2f | %8.3f %8.2f %8.4f %8.3f | %6.3f | %7.1f %7d\n",
+           o.sink ? "sink" : "source", o.op, at.result.ku, at.result.pu_s * 1e3f,
+           at.result.kp, at.result.ki, at.t_s, ovs, settle_k);
+
+    if (settle_k < 0 || ovs > 20.0f) ++failures;
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,409 @@
+// tools/batch_sim.cpp - parameter-sweep batch simulator (host)
+//
+// Draait de emulatie-engine (src/emulate) + het plant model (tools/sim/plant.h)
+// voor elke combinatie uit een sweep-spec, parallel op alle cores.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/batch_sim.cpp src/emulate/emulate.cpp -o tools/build/batch_sim
+//
+// Gebruik:
+//   batch_sim <sweep.txt> <out.sbc> [-j threads]
+//   batch_sim --check               engine bij dt = 1 ms tegen analytische CC-ontlading
+//
+// Sweep-spec (één sleutel per regel, waarden komma-gescheiden, '#' = commentaar):
+//   chemistry    = 0,1,2             # curve_id (0 Li-ion, 1 LiFePO4, 2 lood-zuur)
+//   nominal_v    = 4.2
+//   capacity_mAh = 500,1000,3000
+//   start_soc    = 1.0,0.8,0.5
+//   load         = cc:0.5, pulse:2.0/0.577/4.615, res:10
+//   cutoff_pct   = 70               # % van nominale spanning
+//   max_time_s   = 36000
+//   dt_s         = 0.001
+//
+// Load profielen:
+//   cc:<A>                          constante stroom
+//   pulse:<A>/<t_on_ms>/<period_ms> pulstrein (bv. GSM burst), 0 A buiten de puls
+//   res:<ohm>                       weerstand
+//
+// Uitvoer: .sbc kolombestand (zie tools/common/columnar.h), één rij per simulatie.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "emulate/emulate.h"
+#include "sim/plant.h"
+#include "common/columnar.h"
+#include "common/thread_pool.h"
+
+// ---------------- Sweep spec ----------------
+enum class LoadKind : uint8_t { CC = 0, PULSE = 1, RES = 2 };
+
+struct LoadProfile
+{
+  LoadKind kind = LoadKind::CC;
+  float a = 0.0f;      // CC: A, PULSE: A, RES: ohm
+  float t_on_s = 0.0f;
+  float period_s = 0.0f;
+  std::string text;
+};
+
+struct SweepSpec
+{
+  std::vector<int>   chemistry{0};
+  std::vector<float> nominal_v{4.2f};
+  std::vector<float> capacity_mAh{3000.0f};
+  std::vector<float> start_soc{1.0f};
+  std::vector<LoadProfile> loads;
+  float cutoff_pct = 70.0f;
+  float max_time_s = 36000.0f;
+  float dt_s = 0.001f;
+};
+
+static std::string trim(const std::string& s)
+{
+  size_t b = s.find_first_not_of(" \t\r\n");
+  size_t e = s.find_last_not_of(" \t\r\n");
+  return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+}
+
+static std::vector<std::string> split(const std::string& s, char sep)
+{
+  std::vector<std::string> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, sep)) {
+    item = trim(item);
+    if (!item.empty()) out.push_back(item);
+  }
+  return out;
+}
+
+static bool parse_load(const std::string& txt, LoadProfile& lp)
+{
+  lp.text = txt;
+  const size_t colon = txt.find(':');
+  if (colon == std::string::npos) return false;
+  const std::string kind = txt.substr(0, colon);
+  const std::vector<std::string> args = split(txt.substr(colon + 1), '/');
+
+  if (kind == "cc" && args.size() == 1) {
+    lp.kind = LoadKind::CC;
+    lp.a = strtof(args[0].c_str(), nullptr);
+    return true;
+  }
+  if (kind == "pulse" && args.size() == 3) {
+    lp.kind = LoadKind::PULSE;
+    lp.a = strtof(args[0].c_str(), nullptr);
+    lp.t_on_s = strtof(args[1].c_str(), nullptr) * 0.001f;
+    lp.period_s = strtof(args[2].c_str(), nullptr) * 0.001f;
+    return lp.period_s > 0.0f;
+  }
+  if (kind == "res" && args.size() == 1) {
+    lp.kind = LoadKind::RES;
+    lp.a = strtof(args[0].c_str(), nullptr);
+    return lp.a > 0.0f;
+  }
+  return false;
+}
+
+template <typename T>
+static std::vector<T> parse_list(const std::string& v)
+{
+  std::vector<T> out;
+  for (const auto& s : split(v, ',')) out.push_back((T)strtod(s.c_str(), nullptr));
+  return out;
+}
+
+static bool load_spec(const char* path, SweepSpec& spec)
+{
+  std::ifstream f(path);
+  if (!f) {
+    fprintf(stderr, "kan sweep-spec niet openen: %s\n", path);
+    return false;
+  }
+
+  std::string line;
+  int lineno = 0;
+  while (std::getline(f, line)) {
+    ++lineno;
+    const size_t hash = line.find('#');
+    if (hash != std::string::npos) line.resize(hash);
+    line = trim(line);
+    if (line.empty()) continue;
+
+    const size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+      fprintf(stderr, "%s:%d: verwacht 'key = waarden'\n", path, lineno);
+      return false;
+    }
+    const std::string key = trim(line.substr(0, eq));
+    const std::string val = trim(line.substr(eq + 1));
+
+    if (key == "chemistry") spec.chemistry = parse_list<int>(val);
+    else if (key == "nominal_v") spec.nominal_v = parse_list<float>(val);
+    else if (key == "capacity_mAh") spec.capacity_mAh = parse_list<float>(val);
+    else if (key == "start_soc") spec.start_soc = parse_list<float>(val);
+    else if (key == "cutoff_pct") spec.cutoff_pct = strtof(val.c_str(), nullptr);
+    else if (key == "max_time_s") spec.max_time_s = strtof(val.c_str(), nullptr);
+    else if (key == "dt_s") spec.dt_s = strtof(val.c_str(), nullptr);
+    else if (key == "load") {
+      spec.loads.clear();
+      for (const auto& s : split(val, ',')) {
+        LoadProfile lp;
+        if (!parse_load(s, lp)) {
+          fprintf(stderr, "%s:%d: ongeldig load profiel '%s'\n", path, lineno, s.c_str());
+          return false;
+        }
+        spec.loads.push_back(lp);
+      }
+    } else {
+      fprintf(stderr, "%s:%d: onbekende sleutel '%s'\n", path, lineno, key.c_str());
+      return false;
+    }
+  }
+
+  if (spec.loads.empty()) {
+    LoadProfile lp;
+    parse_load("cc:1.0", lp);
+    spec.loads.push_back(lp);
+  }
+  if (spec.dt_s <= 0.0f) spec.dt_s = 0.001f;
+  return true;
+}
+
+// ---------------- Simulatie ----------------
+struct SimCase
+{
+  int chemistry;
+  float nominal_v;
+  float capacity_mAh;
+  float start_soc;
+  uint16_t load_idx;
+};
+
+struct SimResult
+{
+  float runtime_s = 0.0f;
+  float ah = 0.0f;
+  float wh = 0.0f;
+  float v_min = 0.0f;
+  float v_end = 0.0f;
+  float soc_end = 0.0f;
+  uint64_t steps = 0;
+};
+
+// t in double: een float-tijd die elke ms met dt ophoogt loopt na ~8000 s achter
+static inline float load_current(const LoadProfile& lp, double t, float v_out)
+{
+  switch (lp.kind) {
+    case LoadKind::CC:    return (v_out > 0.0f) ? lp.a : 0.0f;
+    case LoadKind::PULSE: return (fmod(t, (double)lp.period_s) < (double)lp.t_on_s) ? lp.a : 0.0f;
+    case LoadKind::RES:   return v_out / lp.a;
+  }
+  return 0.0f;
+}
+
+static SimResult run_case(const SimCase& c, const SweepSpec& spec, const CurveData& curves)
+{
+  EmuParams ep;
+  emu_params_from_curves(&ep, &curves, (uint8_t)c.chemistry, c.nominal_v, c.capacity_mAh);
+  ep.v_cutoff = c.nominal_v * spec.cutoff_pct * 0.01f;
+
+  EmuState es;
+  emu_init(&es, &ep, c.start_soc);
+
+  const float dt = spec.dt_s;
+  PlantParams pp;
+  PlantState ps;
+  plant_init(ps, pp, dt);
+
+  SimPI pi;
+  const LoadProfile& lp = spec.loads[c.load_idx];
+
+  SimResult r;
+  r.v_min = es.v_term;
+
+  // Start met de uitgang al op de OCV (voorkomt een opstart-transient in v_min)
+  ps.v_int = ps.v_out = es.v_term;
+  for (int k = 0; k < PLANT_MAX_DELAY; ++k) ps.v_hist[k] = es.v_term;
+  pi.integ = es.v_term / pp.v_supply;
+
+  const uint64_t max_steps = (uint64_t)(spec.max_time_s / dt);
+  float v_meas = es.v_term;
+  uint64_t k = 0;
+
+  for (; k < max_steps; ++k) {
+    const double t = (double)k * dt;
+    // Batterij-emulatie: de loop regelt de uitgang naar de geëmuleerde klemspanning
+    const float duty   = pi.step(es.v_term, v_meas, dt);
+    const float i_load = load_current(lp, t, ps.v_out);
+    v_meas = plant_step_source(ps, pp, duty, i_load);
+    emu_step(&es, &ep, i_load, dt);
+
+    if (ps.v_out < r.v_min) r.v_min = ps.v_out;
+    if (es.empty) { ++k; break; }
+  }
+
+  r.runtime_s = (float)((double)k * dt);
+  r.ah = es.ah_out;
+  r.wh = es.wh_out;
+  r.v_end = ps.v_out;
+  r.soc_end = es.soc;
+  r.steps = k;
+  return r;
+}
+
+// ---------------- Controle ----------------
+// Engine alleen (geen plant, geen cutoff) bij dt = 1 ms en constante stroom:
+// ah = I t / 3600, soc = soc0 - ah / cap, leeg op t = soc0 cap / I. Plus de
+// pulstijdbasis aan het eind van een lange run.
+static int check_engine()
+{
+  struct CcCase { float i_a; float cap_mAh; double t_end_s; };
+  static const CcCase CASES[] = {
+    { 0.1f, 3000.0f, 72000.0 },   // niet leeg binnen t_end
+    { 0.5f, 3000.0f, 30000.0 },   // leeg op 21600 s
+    { 2.0f,  500.0f,  3600.0 },   // leeg op 900 s
+  };
+  const float dt = 0.001f;
+  int fail = 0;
+
+  CurveData curves;
+  emu_default_curves(&curves);
+
+  for (const CcCase& c : CASES) {
+    EmuParams ep;
+    emu_params_from_curves(&ep, &curves, 0, 4.2f, c.cap_mAh);
+    EmuState es;
+    emu_init(&es, &ep, 1.0f);
+
+    const uint64_t n = (uint64_t)llround(c.t_end_s / dt);
+    uint64_t k = 0;
+    for (; k < n && !es.empty; ++k) emu_step(&es, &ep, c.i_a, dt);
+
+    const double t = (double)k * dt;
+    const double cap_ah = c.cap_mAh * 1e-3;
+    const double t_empty = cap_ah * 3600.0 / c.i_a;
+    const double ah_exp = c.i_a * (t < t_empty ? t : t_empty) / 3600.0;
+    const double soc_exp = t < t_empty ? 1.0 - ah_exp / cap_ah : 0.0;
+
+    bool ok = fabs(es.ah_out - ah_exp) <= 1e-5 * ah_exp && fabs(es.soc - soc_exp) <= 1e-5;
+    if (t_empty < c.t_end_s) ok = ok && es.empty && fabs(t - t_empty) <= 2.0 * dt;
+    else ok = ok && !es.empty;
+    printf("cc %.1f A / %.0f mAh: t %.3f s, ah %.6f (verwacht %.6f), soc %.6f (verwacht %.6f) %s\n",
+           c.i_a, c.cap_mAh, t, es.ah_out, ah_exp, es.soc, soc_exp, ok ? "OK" : "FOUT");
+    if (!ok) fail++;
+  }
+
+  // Pulsprofiel na 72000 s: aan-stappen over 100 periodes. Met dt = 1 ms vallen
+  // er 0 of 1 samples in een puls van 0.577 ms, dus de duty wijkt af van
+  // t_on / period; verwacht is wat hetzelfde raster oplevert in long double.
+  // Tolerantie: 1 sample op het hele venster (tijdbasis mag niet verlopen).
+  LoadProfile lp;
+  parse_load("pulse:2.0/0.577/4.615", lp);
+  const uint64_t k0 = (uint64_t)llround(72000.0 / dt);
+  const uint64_t n_win = (uint64_t)llround(100.0 * lp.period_s / dt);
+  uint64_t on = 0, on_exp = 0;
+  for (uint64_t k = k0; k < k0 + n_win; ++k) {
+    on += load_current(lp, (double)k * dt, 1.0f) > 0.0f;
+    on_exp += fmodl((long double)k * dt, (long double)lp.period_s) < (long double)lp.t_on_s;
+  }
+  const double duty = (double)on / (double)n_win;
+  const double duty_exp = (double)on_exp / (double)n_win;
+  const bool ok = (on > on_exp ? on - on_exp : on_exp - on) <= 1;
+  printf("puls na 72000 s: duty %.4f (verwacht %.4f op dt-raster, nominaal %.4f) %s\n",
+         duty, duty_exp, lp.t_on_s / lp.period_s, ok ? "OK" : "FOUT");
+  if (!ok) fail++;
+
+  return fail ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc >= 2 && strcmp(argv[1], "--check") == 0) return check_engine();
+  if (argc < 3) {
+    fprintf(stderr, "gebruik: %s <sweep.txt> <out.sbc> [-j threads] | --check\n", argv[0]);
+    return 2;
+  }
+
+  unsigned threads = 0;
+  for (int i = 3; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "-j") == 0) threads = (unsigned)atoi(argv[i + 1]);
+  }
+
+  SweepSpec spec;
+  if (!load_spec(argv[1], spec)) return 1;
+
+  CurveData curves;
+  emu_default_curves(&curves);
+
+  // Cartesisch product van alle sweep-assen
+  std::vector<SimCase> cases;
+  for (int chem : spec.chemistry)
+    for (float nv : spec.nominal_v)
+      for (float cap : spec.capacity_mAh)
+        for (float soc : spec.start_soc)
+          for (size_t li = 0; li < spec.loads.size(); ++li)
+            cases.push_back(SimCase{chem, nv, cap, soc, (uint16_t)li});
+
+  ColumnarTable tab;
+  const size_t c_chem = tab.add_column("chemistry", COL_U8);
+  const size_t c_nv   = tab.add_column("nominal_v", COL_F32);
+  const size_t c_cap  = tab.add_column("capacity_mAh", COL_F32);
+  const size_t c_soc0 = tab.add_column("start_soc", COL_F32);
+  const size_t c_load = tab.add_column("load_idx", COL_U16);
+  const size_t c_rt   = tab.add_column("runtime_s", COL_F32);
+  const size_t c_ah   = tab.add_column("ah", COL_F32);
+  const size_t c_wh   = tab.add_column("wh", COL_F32);
+  const size_t c_vmin = tab.add_column("v_min", COL_F32);
+  const size_t c_vend = tab.add_column("v_end", COL_F32);
+  const size_t c_socE = tab.add_column("soc_end", COL_F32);
+  const size_t c_step = tab.add_column("steps", COL_U64);
+  tab.resize(cases.size());
+
+  WorkStealingPool pool(threads);
+  std::atomic<uint64_t> total_steps{0};
+
+  const auto t0 = std::chrono::steady_clock::now();
+  pool.parallel_for(cases.size(), 1, [&](size_t i) {
+    const SimCase& c = cases[i];
+    const SimResult r = run_case(c, spec, curves);
+
+    tab.set<uint8_t>(c_chem, i, (uint8_t)c.chemistry);
+    tab.set<float>(c_nv, i, c.nominal_v);
+    tab.set<float>(c_cap, i, c.capacity_mAh);
+    tab.set<float>(c_soc0, i, c.start_soc);
+    tab.set<uint16_t>(c_load, i, c.load_idx);
+    tab.set<float>(c_rt, i, r.runtime_s);
+    tab.set<float>(c_ah, i, r.ah);
+    tab.set<float>(c_wh, i, r.wh);
+    tab.set<float>(c_vmin, i, r.v_min);
+    tab.set<float>(c_vend, i, r.v_end);
+    tab.set<float>(c_socE, i, r.soc_end);
+    tab.set<uint64_t>(c_step, i, r.steps);
+    total_steps.fetch_add(r.steps, std::memory_order_relaxed);
+  });
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  if (!tab.write(argv[2])) {
+    fprintf(stderr, "schrijven naar %s mislukt\n", argv[2]);
+    return 1;
+  }
+
+  for (size_t i = 0; i < spec.loads.size(); ++i)
+    printf("load[%zu] = %s\n", i, spec.loads[i].text.c_str());
+
+  printf("%zu simulaties, %u threads, %.3f s\n", cases.size(), pool.size(), secs);
+  printf("%.1f sims/s, %.2f Msteps/s\n",
+         secs > 0 ? (double)cases.size() / secs : 0.0,
+         secs > 0 ? (double)total_steps.load() / secs * 1e-6 : 0.0);
+  return 0;
+}
@@ -0,0 +1,186 @@
+// tools/common/columnar.h - compact kolom-gebaseerd uitvoerformaat (.sbc)
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+// =========================
+// Bestandsformaat (little endian)
+// =========================
+//
+//   char     magic[4]  = "SBC1"
+//   uint32_t n_cols
+//   uint64_t n_rows
+//   per kolom: char name[24] (nul-terminated), uint8_t type, uint8_t pad[7]
+//   daarna per kolom de n_rows waarden achter elkaar (kolom 0, kolom 1, ...)
+//
+// Eén kolom is één aaneengesloten array, zodat een reader (numpy.fromfile,
+// pandas, of een mmap) een kolom zonder parsing kan inlezen.
+//
+// ColumnarTable houdt alles in het geheugen; ColumnarFile schrijft rechtstreeks
+// naar het bestand als het aantal rijen vooraf bekend is (uitvoer groter dan RAM).
+
+enum ColType : uint8_t
+{
+  COL_U8  = 0,
+  COL_U16 = 1,
+  COL_U32 = 2,
+  COL_I32 = 3,
+  COL_F32 = 4,
+  COL_F64 = 5,
+  COL_U64 = 6,
+};
+
+static inline size_t col_type_size(ColType t)
+{
+  switch (t) {
+    case COL_U8:  return 1;
+    case COL_U16: return 2;
+    case COL_U32: return 4;
+    case COL_I32: return 4;
+    case COL_F32: return 4;
+    case COL_F64: return 8;
+    case COL_U64: return 8;
+  }
+  return 0;
+}
+
+class ColumnarTable
+{
+public:
+  // Voegt een kolom toe; geeft de index terug.
+  size_t add_column(const char* name, ColType type)
+  {
+    Column c;
+    strncpy(c.name, name, sizeof(c.name) - 1);
+    c.type = type;
+    cols_.push_back(c);
+    return cols_.size() - 1;
+  }
+
+  void resize(uint64_t rows)
+  {
+    rows_ = rows;
+    for (auto& c : cols_) c.data.assign(rows * col_type_size(c.type), 0);
+  }
+
+  uint64_t rows() const { return rows_; }
+
+  // Thread-safe zolang verschillende threads verschillende rijen schrijven.
+  template <typename T>
+  void set(size_t col, uint64_t row, T v)
+  {
+    memcpy(&cols_[col].data[row * sizeof(T)], &v, sizeof(T));
+  }
+
+  bool write(const char* path) const
+  {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    const uint32_t n_cols = (uint32_t)cols_.size();
+    bool ok = fwrite("SBC1", 1, 4, f) == 4;
+    ok &= fwrite(&n_cols, sizeof(n_cols), 1, f) == 1;
+    ok &= fwrite(&rows_, sizeof(rows_), 1, f) == 1;
+
+    for (const auto& c : cols_) {
+      uint8_t pad[8] = {c.type, 0, 0, 0, 0, 0, 0, 0};
+      ok &= fwrite(c.name, 1, sizeof(c.name), f) == sizeof(c.name);
+      ok &= fwrite(pad, 1, sizeof(pad), f) == sizeof(pad);
+    }
+    for (const auto& c : cols_) {
+      if (!c.data.empty()) ok &= fwrite(c.data.data(), 1, c.data.size(), f) == c.data.size();
+    }
+
+    ok &= fclose(f) == 0;
+    return ok;
+  }
+
+private:
+  struct Column
+  {
+    char name[24] = {};
+    ColType type = COL_U8;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<Column> cols_;
+  uint64_t rows_ = 0;
+};
+
+class ColumnarFile
+{
+public:
+  ColumnarFile() = default;
+  ColumnarFile(const ColumnarFile&) = delete;
+  ColumnarFile& operator=(const ColumnarFile&) = delete;
+  ~ColumnarFile() { close(); }
+
+  size_t add_column(const char* name, ColType type)
+  {
+    Column c;
+    strncpy(c.name, name, sizeof(c.name) - 1);
+    c.type = type;
+    cols_.push_back(c);
+    return cols_.size() - 1;
+  }
+
+  // Header schrijven en het bestand op de volle grootte zetten.
+  bool create(const char* path, uint64_t rows)
+  {
+    close();
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) return false;
+
+    std::vector<uint8_t> hdr;
+    const uint32_t n_cols = (uint32_t)cols_.size();
+    hdr.insert(hdr.end(), "SBC1", "SBC1" + 4);
+    hdr.insert(hdr.end(), (const uint8_t*)&n_cols, (const uint8_t*)&n_cols + sizeof(n_cols));
+    hdr.insert(hdr.end(), (const uint8_t*)&rows, (const uint8_t*)&rows + sizeof(rows));
+    for (const auto& c : cols_) {
+      uint8_t pad[8] = {c.type, 0, 0, 0, 0, 0, 0, 0};
+      hdr.insert(hdr.end(), c.name, c.name + sizeof(c.name));
+      hdr.insert(hdr.end(), pad, pad + sizeof(pad));
+    }
+
+    uint64_t off = hdr.size();
+    for (auto& c : cols_) {
+      c.offset = off;
+      off += rows * col_type_size(c.type);
+    }
+    return pwrite(fd_, hdr.data(), hdr.size(), 0) == (ssize_t)hdr.size() && ftruncate(fd_, (off_t)off) == 0;
+  }
+
+  // n waarden vanaf rij row0. Thread-safe zolang threads verschillende rijen schrijven.
+  bool write_rows(size_t col, uint64_t row0, const void* data, uint64_t n)
+  {
+    const size_t sz = col_type_size(cols_[col].type);
+    const size_t len = (size_t)(n * sz);
+    return pwrite(fd_, data, len, (off_t)(cols_[col].offset + row0 * sz)) == (ssize_t)len;
+  }
+
+  bool close()
+  {
+    if (fd_ < 0) return true;
+    const bool ok = ::close(fd_) == 0;
+    fd_ = -1;
+    return ok;
+  }
+
+private:
+  struct Column
+  {
+    char name[24] = {};
+    ColType type = COL_U8;
+    uint64_t offset = 0;
+  };
+
+  std::vector<Column> cols_;
+  int fd_ = -1;
+};
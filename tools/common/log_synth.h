@@ -0,0 +1,40 @@
+// tools/common/log_synth.h - deterministisch meetsignaal voor de log-tools
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include "log/log.h"
+
+// Sample i van een 1 kHz-meting zoals measureTask die levert: een Li-ion-cel die
+// langzaam leegloopt onder een pulsbelasting, met ADC-ruis van een paar LSB
+// (ADS8684: ~1.7 mV op v_out, ~0.26 mA op de stromen). Volledig bepaald door i,
+// zodat een lezer elk gedecodeerd record tegen het origineel kan toetsen.
+static inline uint32_t synth_hash(uint64_t i)
+{
+  uint64_t x = i * 0x9E3779B97F4A7C15ull;
+  x ^= x >> 31; x *= 0xBF58476D1CE4E5B9ull; x ^= x >> 29;
+  return (uint32_t)x;
+}
+
+static inline void synth_record(uint64_t i, uint32_t period_us, LogRecord* r)
+{
+  const uint32_t h = synth_hash(i);
+  const float n0 = (float)((int)(h & 7u) - 3);           // LSB-ruis
+  const float n1 = (float)((int)((h >> 3) & 7u) - 3);
+  const float n2 = (float)((int)((h >> 6) & 3u) - 1);
+  const float n3 = (float)((int)((h >> 8) & 3u) - 1);
+
+  const double t_s = (double)i * period_us * 1e-6;
+  const bool pulse = (i % 4615u) < 577u;                  // GSM-achtige burst
+  const float i_load = pulse ? 2.0f : 0.1f;
+
+  r->t_us        = (uint32_t)(i * period_us);
+  r->i_sink      = i_load + n1 * 0.00026f;
+  r->v_out       = 4.15f - (float)(t_s * 1e-4) - 0.08f * i_load + n0 * 0.0017f;
+  r->i_source    = n2 * 0.00026f;
+  r->temp_sink_c = 30.0f + 10.0f * (float)(1.0 - exp(-t_s / 600.0)) + n3 * 0.02f;
+  r->meas_flags  = MEAS_ADC_OK;
+  r->decim       = 1;
+  r->reserved    = 0;
+}
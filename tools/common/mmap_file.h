@@ -0,0 +1,55 @@
+// tools/common/mmap_file.h - read-only mmap van een bestand (POSIX)
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { close(); }
+
+  bool open(const char* path)
+  {
+    close();
+    fd_ = ::open(path, O_RDONLY);
+    if (fd_ < 0) return false;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) { close(); return false; }
+    size_ = (size_t)st.st_size;
+    if (size_ == 0) return true;
+
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) { close(); return false; }
+    data_ = (const uint8_t*)p;
+
+    // Sequentieel lezen: kernel read-ahead agressief laten werken
+    madvise(p, size_, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  void close()
+  {
+    if (data_) munmap((void*)data_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    data_ = nullptr;
+    size_ = 0;
+    fd_ = -1;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  int fd_ = -1;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
@@ -0,0 +1,139 @@
+// tools/common/thread_pool.h - work-stealing thread pool voor de host tools
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =========================
+// WorkStealingPool
+// =========================
+//
+// Elke worker heeft een eigen deque. Een worker pakt werk vooraan uit zijn eigen
+// deque; als die leeg is steelt hij achteraan bij een andere worker. Zo blijven
+// alle cores bezig, ook als taken sterk in duur verschillen (korte/lange sims).
+
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(unsigned n_threads = 0)
+  {
+    if (n_threads == 0) n_threads = std::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+
+    queues_.reserve(n_threads);
+    for (unsigned i = 0; i < n_threads; ++i) queues_.emplace_back(new Queue());
+    for (unsigned i = 0; i < n_threads; ++i) threads_.emplace_back([this, i] { worker(i); });
+  }
+
+  ~WorkStealingPool()
+  {
+    wait();
+    {
+      std::lock_guard<std::mutex> lk(idle_mtx_);
+      stop_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& t : threads_) t.join();
+  }
+
+  unsigned size() const { return (unsigned)queues_.size(); }
+
+  // Round-robin over de worker queues.
+  void submit(Task t)
+  {
+    const unsigned q = next_.fetch_add(1, std::memory_order_relaxed) % size();
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+    {
+      std::lock_guard<std::mutex> lk(queues_[q]->mtx);
+      queues_[q]->tasks.push_back(std::move(t));
+    }
+    idle_cv_.notify_one();
+  }
+
+  // Blokkeert tot alle ingediende taken klaar zijn.
+  void wait()
+  {
+    std::unique_lock<std::mutex> lk(idle_mtx_);
+    done_cv_.wait(lk, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+  }
+
+  // Splitst [0, n) in blokken van grain en verdeelt die over de pool.
+  template <typename F>
+  void parallel_for(size_t n, size_t grain, F fn)
+  {
+    if (grain == 0) grain = 1;
+    for (size_t b = 0; b < n; b += grain) {
+      const size_t e = (b + grain < n) ? b + grain : n;
+      submit([fn, b, e] { for (size_t i = b; i < e; ++i) fn(i); });
+    }
+    wait();
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+  };
+
+  bool pop_local(unsigned i, Task& out)
+  {
+    std::lock_guard<std::mutex> lk(queues_[i]->mtx);
+    if (queues_[i]->tasks.empty()) return false;
+    out = std::move(queues_[i]->tasks.front());
+    queues_[i]->tasks.pop_front();
+    return true;
+  }
+
+  bool steal(unsigned self, Task& out)
+  {
+    const unsigned n = size();
+    for (unsigned k = 1; k < n; ++k) {
+      const unsigned v = (self + k) % n;
+      std::lock_guard<std::mutex> lk(queues_[v]->mtx);
+      if (queues_[v]->tasks.empty()) continue;
+      out = std::move(queues_[v]->tasks.back());
+      queues_[v]->tasks.pop_back();
+      return true;
+    }
+    return false;
+  }
+
+  void worker(unsigned i)
+  {
+    for (;;) {
+      Task t;
+      if (pop_local(i, t) || steal(i, t)) {
+        t();
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          std::lock_guard<std::mutex> lk(idle_mtx_);
+          done_cv_.notify_all();
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lk(idle_mtx_);
+      if (stop_) return;
+      idle_cv_.wait_for(lk, std::chrono::milliseconds(2));
+      if (stop_ && pending_.load(std::memory_order_acquire) == 0) return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<unsigned> next_{0};
+  std::atomic<size_t> pending_{0};
+
+  std::mutex idle_mtx_;
+  std::condition_variable idle_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+};
@@ -0,0 +1,99 @@
+// tools/common/tlm_host.h - ontvanger voor de USB-CDC telemetrie (host)
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "telemetry/telemetry.h"
+
+// Seriële poort (of pty) in raw mode openen. De baudrate doet niets voor USB-CDC
+// maar sommige drivers willen er een. Geeft de fd of -1.
+static inline int tlm_open_port(const char* path)
+{
+  const int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 1;   // read() keert na 100 ms terug
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+// CONFIG-frame naar het device
+static inline bool tlm_send_config(int fd, const TlmConfig& cfg, uint16_t seq = 0)
+{
+  uint8_t wire[TLM_WIRE_MAX];
+  const uint32_t n = tlm_frame_wire(TLM_FRAME_CONFIG, seq, &cfg, sizeof(cfg), wire);
+  return n && write(fd, wire, n) == (ssize_t)n;
+}
+
+// Bytes in, samples en status uit. Verlies (seq-gaten) en kapotte frames worden
+// geteld in parser(); de laatste STATUS van het device staat in status().
+class TlmReceiver
+{
+public:
+  TlmReceiver() { tlm_parser_init(&p_); }
+
+  // on_samples(const TlmSample* s, int n, uint8_t ch_mask, uint16_t decim)
+  template <typename F>
+  void feed(const uint8_t* data, size_t n, F on_samples)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      if (!tlm_parser_feed(&p_, data[i])) continue;
+
+      const uint8_t type = p_.frame[0];
+      if (type == TLM_FRAME_SAMPLES) {
+        uint8_t mask;
+        uint16_t decim;
+        const int k = tlm_frame_samples(p_.frame, p_.frame_len, buf_, TLM_MAX_PER_FRAME, &mask, &decim);
+        if (k < 0) { n_malformed_++; continue; }
+        n_samples_ += (uint64_t)k;
+        on_samples(buf_, k, mask, decim);
+      } else if (type == TLM_FRAME_STATUS && p_.frame_len == sizeof(TlmFrameHeader) + sizeof(TlmStatus) + 4u) {
+        memcpy(&status_, p_.frame + sizeof(TlmFrameHeader), sizeof(status_));
+        have_status_ = true;
+      }
+    }
+  }
+
+  const TlmParser& parser() const { return p_; }
+  uint64_t samples() const { return n_samples_; }
+  uint32_t malformed() const { return n_malformed_; }
+  bool has_status() const { return have_status_; }
+  const TlmStatus& status() const { return status_; }
+
+private:
+  TlmParser p_;
+  TlmSample buf_[TLM_MAX_PER_FRAME];
+  uint64_t  n_samples_ = 0;
+  uint32_t  n_malformed_ = 0;
+  TlmStatus status_ = {};
+  bool      have_status_ = false;
+};
+
+// t_us (32 bit, loopt na 71 minuten over) -> us sinds het eerste sample
+class TlmClock
+{
+public:
+  uint64_t unwrap(uint32_t t_us)
+  {
+    if (!have_) { have_ = true; last_ = t_us; return 0; }
+    t64_ += (uint32_t)(t_us - last_);
+    last_ = t_us;
+    return t64_;
+  }
+
+private:
+  bool have_ = false;
+  uint32_t last_ = 0;
+  uint64_t t64_ = 0;
+};
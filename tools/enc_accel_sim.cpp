@@ -0,0 +1,264 @@
+// tools/enc_accel_sim.cpp - encoder-versnelling tegen een PCNT-model (host)
+//
+// Genereert quadratuur-pulstreinen (A/B, 4 flanken per detent) met contactdender,
+// voert ze door een model van de PCNT (x4 decodering, glitchfilter, threshold
+// +-4 met clear in de ISR) en leest de detent-teller zoals de display-task: elke
+// 50 ms (of 10 ms) via src/ioexpander/enc_accel.cpp.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/enc_accel_sim.cpp src/ioexpander/enc_accel.cpp -o tools/build/enc_accel_sim
+//
+// Exit code 0 als alle scenario's slagen.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ioexpander/enc_accel.h"
+
+static constexpr int      COUNTS_PER_DETENT = 4;     // ENC_COUNTS_PER_DETENT
+static constexpr uint32_t FILTER_US         = 12;    // 1023 APB @ 80 MHz = 12.8 us
+
+// =========================
+// Pulstrein
+// =========================
+struct Edge
+{
+  uint64_t t_us;
+  uint8_t  ch;     // 0 = A, 1 = B
+  uint8_t  level;
+};
+
+struct Train
+{
+  std::vector<Edge> edges;
+  uint8_t a = 0, b = 0;
+  uint64_t t_end = 0;
+
+  void edge(uint64_t t, uint8_t ch, uint8_t level) { edges.push_back({t, ch, level}); }
+
+  // Eén detent = 4 flanken, gelijk verdeeld over period_us.
+  // bounce: per flank een paar glitches (<filter) en een dender-paar (>filter).
+  void detent(uint64_t t0, uint32_t period_us, int dir, bool bounce, uint32_t& rng)
+  {
+    // Gray-volgorde vooruit: 00 -> 10 -> 11 -> 01 -> 00 (A leidt)
+    for (int k = 0; k < 4; ++k) {
+      const uint64_t t = t0 + (uint64_t)period_us * (uint64_t)k / 4u;
+      uint8_t ch;
+      if (dir > 0) ch = (k % 2 == 0) ? 0 : 1;
+      else         ch = (k % 2 == 0) ? 1 : 0;
+      uint8_t& lv = ch ? b : a;
+
+      if (bounce) {
+        rng = rng * 1664525u + 1013904223u;
+        const uint32_t g = 2 + (rng >> 24) % 8;          // 2..9 us glitch
+        edge(t, ch, (uint8_t)!lv);
+        edge(t + g, ch, lv);
+        rng = rng * 1664525u + 1013904223u;
+        const uint32_t d = 30 + (rng >> 24) % 150;       // 30..179 us dender
+        edge(t + 20, ch, (uint8_t)!lv);
+        edge(t + 20 + d, ch, lv);
+        edge(t + 40 + d, ch, (uint8_t)!lv);
+      } else {
+        edge(t, ch, (uint8_t)!lv);
+      }
+      lv = (uint8_t)!lv;
+    }
+    t_end = t0 + period_us;
+  }
+
+  void finish() { std::stable_sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) { return x.t_us < y.t_us; }); }
+};
+
+// =========================
+// PCNT-model
+// =========================
+struct Pcnt
+{
+  uint8_t  a = 0, b = 0;   // gefilterde niveaus
+  int      count = 0;
+  int32_t  detents = 0;
+  uint32_t t_last_us = 0;
+
+  void apply(const Edge& e)
+  {
+    uint8_t& lv = e.ch ? b : a;
+    if (lv == e.level) return;
+    lv = e.level;
+
+    // Kanaal 0: tel op A, richting uit B; kanaal 1: tel op B, richting uit A
+    int d;
+    if (e.ch == 0) d = (e.level != b) ? 1 : -1;
+    else           d = (e.level == a) ? 1 : -1;
+    count += d;
+
+    if (count >= COUNTS_PER_DETENT)       { count = 0; detents++; t_last_us = (uint32_t)e.t_us; }
+    else if (count <= -COUNTS_PER_DETENT) { count = 0; detents--; t_last_us = (uint32_t)e.t_us; }
+  }
+};
+
+// Glitchfilter: een flank telt pas als het niveau FILTER_US stabiel blijft.
+static std::vector<Edge> pcnt_filter(const std::vector<Edge>& in, uint32_t* rejected)
+{
+  std::vector<Edge> out;
+  out.reserve(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    uint64_t next = UINT64_MAX;
+    for (size_t j = i + 1; j < in.size(); ++j)
+      if (in[j].ch == in[i].ch) { next = in[j].t_us; break; }
+    if (next - in[i].t_us < FILTER_US) { (*rejected)++; continue; }
+    Edge e = in[i];
+    e.t_us += FILTER_US;   // filtervertraging
+    out.push_back(e);
+  }
+  return out;
+}
+
+// =========================
+// Consument (display-task)
+// =========================
+struct RunResult
+{
+  int32_t  detents = 0;
+  int64_t  steps = 0;
+  int32_t  max_poll_steps = 0;
+  uint32_t polls_with_steps = 0;
+  uint32_t rejected = 0;
+  bool     all_unit = true;     // elke niet-nul poll was precies +-1
+  double   t_reach_s = -1.0;    // tijd tot target_steps (optioneel)
+};
+
+static RunResult run(Train& tr, uint32_t poll_us, uint32_t max_mult, int64_t target_steps = 0)
+{
+  tr.finish();
+  RunResult r;
+  std::vector<Edge> f = pcnt_filter(tr.edges, &r.rejected);
+
+  EncAccelConfig cfg;
+  enc_accel_default(&cfg);
+  EncAccel acc;
+  enc_accel_reset(&acc, 0, 0);
+
+  Pcnt p;
+  size_t ei = 0;
+  const uint64_t t_stop = tr.t_end + 2 * (uint64_t)poll_us + 100000;
+  for (uint64_t t = poll_us; t <= t_stop; t += poll_us) {
+    while (ei < f.size() && f[ei].t_us <= t) p.apply(f[ei++]);
+    const int32_t s = enc_accel_update(&acc, &cfg, p.detents, p.t_last_us, max_mult);
+    if (s != 0) {
+      r.polls_with_steps++;
+      if (abs(s) != 1) r.all_unit = false;
+      r.max_poll_steps = std::max(r.max_poll_steps, abs(s));
+    }
+    r.steps += s;
+    if (target_steps && r.t_reach_s < 0.0 && r.steps >= target_steps) r.t_reach_s = (double)t * 1e-6;
+  }
+  r.detents = p.detents;
+  return r;
+}
+
+static int g_fail = 0;
+
+static void check(bool ok, const char* what)
+{
+  printf("  %-52s %s\n", what, ok ? "OK" : "FAIL");
+  if (!ok) g_fail++;
+}
+
+int main()
+{
+  uint32_t rng = 12345;
+
+  // 1) Losse detents (langzaam): precies één stap per detent, ook met dender
+  for (uint32_t poll_ms : {50u, 10u}) {
+    for (uint32_t gap_ms : {300u, 150u}) {
+      Train tr;
+      for (int i = 0; i < 20; ++i) tr.detent((uint64_t)i * gap_ms * 1000u + 1000u, 20000u, +1, true, rng);
+      RunResult r = run(tr, poll_ms * 1000u, 1000);
+      printf("slow: poll %2u ms, gap %3u ms: detents %d, steps %lld, max/poll %d, %u glitches gefilterd\n",
+             (unsigned)poll_ms, (unsigned)gap_ms, (int)r.detents, (long long)r.steps,
+             (int)r.max_poll_steps, (unsigned)r.rejected);
+      check(r.detents == 20 && r.steps == 20 && r.all_unit, "20 detents -> 20 stappen van 1");
+    }
+  }
+
+  // 2) Dender zonder draaien: pulsen op één kanaal mogen niets tellen
+  {
+    Train tr;
+    for (int i = 0; i < 50; ++i) {
+      const uint64_t t = 1000u + (uint64_t)i * 5000u;
+      tr.edge(t, 0, 1); tr.edge(t + 5, 0, 0);        // onder filter
+      tr.edge(t + 100, 0, 1); tr.edge(t + 400, 0, 0); // boven filter, netto 0
+    }
+    tr.t_end = 300000;
+    RunResult r = run(tr, 50000u, 1000);
+    printf("bounce: detents %d, steps %lld, %u glitches gefilterd\n",
+           (int)r.detents, (long long)r.steps, (unsigned)r.rejected);
+    check(r.detents == 0 && r.steps == 0, "dender op A alleen -> 0 detents");
+  }
+
+  // 3) Snel draaien en omkeren: eerste detent terug is exact -1
+  {
+    Train tr;
+    uint64_t t = 1000;
+    for (int i = 0; i < 40; ++i) { tr.detent(t, 25000u, +1, true, rng); t += 25000u; }   // 40 det/s
+    t += 30000u;
+    tr.detent(t, 20000u, -1, true, rng);
+    RunResult fwd;
+    {
+      Train f2 = tr;
+      f2.edges.erase(std::remove_if(f2.edges.begin(), f2.edges.end(),
+                                    [&](const Edge& e) { return e.t_us >= t; }), f2.edges.end());
+      f2.t_end = t;
+      fwd = run(f2, 50000u, 10);
+    }
+    RunResult all = run(tr, 50000u, 10);
+    printf("reverse: vooruit %lld stappen (%d detents), na omkeren %lld\n",
+           (long long)fwd.steps, (int)fwd.detents, (long long)(all.steps - fwd.steps));
+    check(fwd.steps > 40, "snel draaien versnelt (max x10)");
+    check(all.steps - fwd.steps == -1, "omkeren -> exact -1");
+  }
+
+  // 4) Poll-rate onafhankelijk: tijdstempels uit de ISR, niet uit de poll
+  {
+    Train tr;
+    uint64_t t = 1000;
+    for (int i = 0; i < 60; ++i) { tr.detent(t, 20000u, +1, false, rng); t += 20000u; }  // 50 det/s
+    Train tr2 = tr;
+    RunResult r50 = run(tr, 50000u, 1000);
+    RunResult r10 = run(tr2, 10000u, 1000);
+    const double ratio = (double)r10.steps / (double)r50.steps;
+    printf("poll rate: 50 ms -> %lld stappen, 10 ms -> %lld stappen (ratio %.3f)\n",
+           (long long)r50.steps, (long long)r10.steps, ratio);
+    check(ratio > 0.9 && ratio < 1.1, "50 ms vs 10 ms binnen 10%");
+  }
+
+  // 5) Capaciteit 0 -> 9999.9 (99999 stappen van 0.1): detents en tijd per snelheid
+  printf("\ncapaciteit 0 -> 9999.9 (max x1000):\n");
+  printf("  %8s %10s %10s %10s\n", "det/s", "detents", "tijd [s]", "mult");
+  double t_at_60 = -1.0;
+  for (uint32_t rate : {5u, 10u, 20u, 40u, 60u, 80u}) {
+    const int64_t target = 99999;
+    const uint32_t period = 1000000u / rate;
+    // Lang genoeg draaien; run() meldt wanneer het doel bereikt is
+    const int n = (rate <= 20) ? 110000 : 4000;
+    Train tr;
+    uint64_t t = 1000;
+    for (int i = 0; i < n; ++i) { tr.detent(t, period, +1, false, rng); t += period; }
+    RunResult r = run(tr, 50000u, 1000, target);
+    const double det_needed = (r.t_reach_s > 0.0) ? r.t_reach_s * rate : (double)n;
+    EncAccelConfig cfg; enc_accel_default(&cfg);
+    EncAccel a{}; a.v = (float)rate;
+    printf("  %8u %10.0f %10.1f %10.1f\n", (unsigned)rate, det_needed,
+           r.t_reach_s, (double)enc_accel_multiplier(&a, &cfg, 1000));
+    if (rate == 60) t_at_60 = r.t_reach_s;
+  }
+  check(t_at_60 > 0.0 && t_at_60 < 15.0, "volle schaal binnen 15 s bij 60 det/s");
+
+  printf("\n%s\n", g_fail ? "FAIL" : "alle scenario's OK");
+  return g_fail ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+// tools/fault_sim.cpp - reactietijden van de fault manager (host)
+//
+// Draait src/fault/fault.cpp zoals ControlTask: metingen elke Ts (1 ms), de
+// evaluatie Tctrl later, de PWM nog eens Tact later (beide willekeurig tot hun
+// maximum). Per fault worden duizenden starts met willekeurige fase gesimuleerd;
+// de gemeten tijd (fault ontstaat -> PWM aangepast) moet onder fm_worst_case_us
+// blijven en de ring-latency (detectie -> reactie) onder k*Ts + Tctrl (meting)
+// of Ts + k*Ts + Tctrl (fault_report).
+// Daarnaast: glitches korter dan debounce/persistentie mogen niet asserten, en de
+// keten fault -> state machine -> ERROR -> bevestiging wordt doorlopen.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/fault_sim.cpp src/fault/fault.cpp src/statemachine/statemachine.cpp -o tools/build/fault_sim
+//
+// Exit code 0 als alle controles slagen.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fault/fault.h"
+#include "statemachine/statemachine.h"
+
+static constexpr uint32_t TS_US    = 1000;
+static constexpr uint32_t TCTRL_US = 200;
+static constexpr uint32_t TACT_US  = 300;
+
+static const char* const CLASS_NAMES[FAULT_CLASS_COUNT] = { "shutdown", "derate", "warn" };
+
+static uint64_t g_rng = 0x2545F4914F6CDD1Dull;
+static uint32_t rnd(uint32_t n)
+{
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 7; g_rng ^= g_rng << 17;
+    return n ? (uint32_t)((g_rng >> 11) % n) : 0u;
+}
+
+static bool is_measured(FaultId id)
+{
+    return id == FID_OV || id == FID_OC || id == FID_OT || id == FID_OT_DERATE;
+}
+
+static int g_fail = 0;
+static void check(bool ok, const char* what)
+{
+    printf("  %-58s %s\n", what, ok ? "OK" : "FAIL");
+    if (!ok) g_fail++;
+}
+
+// Eén fault vanaf t0 (us) gedurende dur_us. Geeft de tijd tot de PWM-reactie
+// (0 = geen assert) en de door de ring gemeten latency.
+struct Trial
+{
+    uint32_t onset_to_pwm_us;
+    uint32_t ring_latency_us;
+    bool     asserted;
+    float    duty_cap;
+    bool     shutdown;
+};
+
+static Trial run_trial(FaultId id, uint32_t t0, uint32_t dur_us, uint32_t sim_us)
+{
+    FaultManager fm;
+    fm_init(&fm);
+    Trial r;
+    memset(&r, 0, sizeof(r));
+    r.duty_cap = 1.0f;
+
+    const uint32_t b = 1u << id;
+    const uint32_t base = 1000000;   // niet bij 0 beginnen (0 = "geen tijd")
+
+    for (uint32_t k = 0; k * TS_US < sim_us; ++k)
+    {
+        const uint32_t t_sample = k * TS_US;
+        const uint32_t t_eval   = t_sample + rnd(TCTRL_US + 1);
+
+        bool raw;
+        uint32_t t_first = 0;
+        if (is_measured(id)) {
+            raw = t_sample >= t0 && t_sample < t0 + dur_us;
+            t_first = base + t_sample;
+        } else {
+            raw = t_eval >= t0 && t0 + dur_us > t_eval;
+            t_first = base + t0;
+        }
+
+        uint32_t t_first_arr[FID_COUNT] = {};
+        t_first_arr[id] = t_first;
+
+        FaultOutput out;
+        fm_update(&fm, raw ? b : 0u, 0u, t_first_arr, base + t_eval, &out);
+        if (out.set_bits && !r.asserted) {
+            r.asserted = true;
+            fm_reacted(&fm, base + t_eval);   // control_publish in dezelfde stap
+            r.onset_to_pwm_us = t_eval + rnd(TACT_US + 1) - t0;
+            r.ring_latency_us = fm.ring[0].t_react_us - fm.ring[0].t_detect_us;
+            r.duty_cap = out.duty_cap;
+            r.shutdown = out.shutdown;
+        }
+    }
+    return r;
+}
+
+static void reaction_times(void)
+{
+    FaultTiming tm;
+    tm.sample_period_us = TS_US;
+    tm.ctrl_latency_us  = TCTRL_US;
+    tm.act_latency_us   = TACT_US;
+
+    printf("reactietijd (fault ontstaat -> PWM), Ts %u us, Tctrl <= %u us, Tact <= %u us:\n",
+           (unsigned)TS_US, (unsigned)TCTRL_US, (unsigned)TACT_US);
+    printf("  %-10s %-8s %9s %9s %9s %11s\n", "fault", "klasse", "gem [ms]", "max [ms]", "bound", "ring max");
+
+    const int N = 2000;
+    for (int id = 0; id < FID_COUNT; ++id)
+    {
+        const FaultDef* d = fm_def((FaultId)id);
+        const uint32_t bound = fm_worst_case_us((FaultId)id, &tm);
+        const uint32_t sim = bound + 5 * TS_US;
+        // Ring: meting -> k*Ts + Tctrl; melding (detectie = meldtijd) -> Ts + k*Ts + Tctrl
+        const uint32_t k_bound = bound - TACT_US - (is_measured((FaultId)id) ? TS_US : 0u);
+
+        uint64_t sum = 0;
+        uint32_t mx = 0, ring_mx = 0, n_ok = 0;
+        for (int i = 0; i < N; ++i) {
+            const uint32_t t0 = 3 * TS_US + rnd(TS_US);   // willekeurige fase t.o.v. de samples
+            const Trial t = run_trial((FaultId)id, t0, sim, sim + 3 * TS_US);
+            if (!t.asserted) continue;
+            n_ok++;
+            sum += t.onset_to_pwm_us;
+            if (t.onset_to_pwm_us > mx) mx = t.onset_to_pwm_us;
+            if (t.ring_latency_us > ring_mx) ring_mx = t.ring_latency_us;
+        }
+        printf("  %-10s %-8s %9.2f %9.2f %9.2f %11.2f\n", d->name, CLASS_NAMES[d->cls],
+               n_ok ? (double)sum / n_ok * 1e-3 : 0.0, mx * 1e-3, bound * 1e-3, ring_mx * 1e-3);
+
+        char what[96];
+        snprintf(what, sizeof(what), "%s: %d/%d asserts, max <= worst case, ring binnen grens",
+                 d->name, (int)n_ok, N);
+        check(n_ok == (uint32_t)N && mx <= bound && ring_mx <= k_bound, what);
+    }
+}
+
+static void debounce(void)
+{
+    printf("\ndebounce / persistentie:\n");
+    // Eén sample boven de grens (ADC-uitschieter): OV/OC hebben on_count 2
+    check(!run_trial(FID_OV, 5000, 1, 50000).asserted, "OV: glitch van 1 sample -> geen assert");
+    check(!run_trial(FID_OC, 5000, 1, 50000).asserted, "OC: glitch van 1 sample -> geen assert");
+    check(run_trial(FID_OC, 5000, 1500, 50000).asserted, "OC: 2 samples -> assert");
+    check(!run_trial(FID_OT, 5000, 150000, 400000).asserted, "OT: 150 ms (< 200 ms) -> geen assert");
+    check(!run_trial(FID_COMM, 5000, 80000, 300000).asserted, "COMM: 80 ms I2C-fout (< 100 ms) -> geen assert");
+
+    const Trial dr = run_trial(FID_OT_DERATE, 5000, 2000000, 1000000);
+    check(dr.asserted && !dr.shutdown && dr.duty_cap == FAULT_DERATE_DUTY, "OT_DERATE: duty begrensd, geen shutdown");
+    const Trial sd = run_trial(FID_SD, 5000, 3000000, 2000000);
+    check(sd.asserted && !sd.shutdown && sd.duty_cap == 1.0f, "SD: alleen waarschuwing");
+
+    // Uit-venster: OV 100 ms na verdwijnen pas weg
+    FaultManager fm;
+    fm_init(&fm);
+    FaultOutput out;
+    uint32_t t = 1000, t_clear = 0;
+    for (int k = 0; k < 5; ++k, t += TS_US) fm_update(&fm, 1u << FID_OV, 0u, nullptr, t, &out);
+    const uint32_t t_gone = t;
+    for (int k = 0; k < 300 && !t_clear; ++k, t += TS_US) {
+        fm_update(&fm, 0, 0u, nullptr, t, &out);
+        if (out.clear_bits & FAULT_OV) t_clear = t;
+    }
+    check(t_clear && (t_clear - t_gone) >= 100000u && (t_clear - t_gone) <= 101000u, "OV: current-bit pas na off_ms (100 ms) weg");
+
+    // fault_report_event: één evaluatie aan, ondanks on_ms 100 van COMM
+    fm_init(&fm);
+    t = 1000;
+    fm_update(&fm, 0, 1u << FID_COMM, nullptr, t, &out);
+    check((out.set_bits & FAULT_COMM) && (out.latch_bits & FAULT_COMM) && out.shutdown,
+          "COMM: fault_report_event -> direct assert + latch");
+    const uint32_t t_ev = t;
+    t_clear = 0;
+    for (int k = 0; k < 1000 && !t_clear; ++k) {
+        t += TS_US;
+        fm_update(&fm, 0, 0u, nullptr, t, &out);
+        if (out.clear_bits & FAULT_COMM) t_clear = t;
+    }
+    check(t_clear && (t_clear - t_ev) >= 500000u && (t_clear - t_ev) <= 501000u, "COMM: event na off_ms (500 ms) weg");
+}
+
+// Keten: fault -> SystemStatus -> state machine -> ERROR -> bevestigen
+static void chain(void)
+{
+    printf("\nketen met state machine:\n");
+    SystemStatus st;
+    memset(&st, 0, sizeof(st));
+    st.state = SYS_STATE_CONFIG;
+
+    SmMachine sm;
+    sm_init(&sm, st.state);
+    FaultManager fm;
+    fm_init(&fm);
+
+    auto post = [&](SmEvent ev) {
+        SmInputs in;
+        memset(&in, 0, sizeof(in));
+        in.fault_current_bits = st.fault_current_bits;
+        in.fault_latched_bits = st.fault_latched_bits;
+        in.status_flags = st.status_flags;
+        in.mode_current = st.mode_current;
+        in.mode_pending = st.mode_pending;
+        SmEffects fx;
+        if (sm_dispatch(&sm, ev, &in, &fx)) st.state = sm.state;
+        st.fault_latched_bits |= fx.latch_fault_bits;
+        st.fault_latched_bits &= ~fx.clear_latched_bits;
+        st.status_flags |= fx.set_status_flags;
+        st.status_flags &= ~fx.clear_status_flags;
+        return fx;
+    };
+    // Zelfde als fault_tick
+    auto tick = [&](uint32_t raw, uint32_t t_us) {
+        FaultOutput out;
+        fm_update(&fm, raw, 0u, nullptr, t_us, &out);
+        st.fault_current_bits |= out.set_bits;
+        st.fault_latched_bits |= out.latch_bits;
+        st.fault_current_bits &= ~out.clear_bits;
+        if ((out.set_bits | out.clear_bits) & FAULT_SHUTDOWN_BITS) post(SM_EV_FAULT);
+        return out;
+    };
+
+    post(SM_EV_RUN);
+    post(SM_EV_RUN);
+    check(st.state == SYS_STATE_ACTIVE, "CONFIG -> READY -> ACTIVE");
+
+    uint32_t t = 1000;
+    FaultOutput o = tick(1u << FID_OC, t += TS_US);
+    o = tick(1u << FID_OC, t += TS_US);
+    check(o.shutdown && st.state == SYS_STATE_ERROR && (st.fault_latched_bits & FAULT_OC),
+          "OC 2 samples -> shutdown, ERROR, latched");
+    check(!(st.status_flags & STATUS_CONTROL_ENABLED), "CONTROL_ENABLED weg");
+
+    post(SM_EV_STOP);
+    check(st.state == SYS_STATE_ERROR, "bevestigen terwijl OC actief -> blijft ERROR");
+
+    for (int k = 0; k < 150; ++k) tick(0, t += TS_US);
+    check(!(st.fault_current_bits & FAULT_OC) && (st.fault_latched_bits & FAULT_OC), "OC weg na off_ms, nog latched");
+    post(SM_EV_STOP);
+    check(st.state == SYS_STATE_CONFIG && st.fault_latched_bits == 0, "bevestigen -> CONFIG, latched gewist");
+
+    // Warn raakt de state niet
+    for (int k = 0; k < 1100; ++k) tick(1u << FID_SD, t += TS_US);
+    check(st.state == SYS_STATE_CONFIG && (st.fault_current_bits & FAULT_SD), "SD warn: state blijft CONFIG");
+}
+
+int main()
+{
+    reaction_times();
+    debounce();
+    chain();
+
+    printf("\n%s\n", g_fail ? "FAIL" : "alle controles OK");
+    return g_fail ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+// tools/fmt_bench.cpp - ui_fmt tegen snprintf (host)
+//
+// Draait src/display/ui_fmt.cpp zoals de firmware hem gebruikt:
+//   1. controle: ui_fmt_fixed geeft voor alle decimalen (0..3) en milli-waarden in
+//      [-range, range] dezelfde tekst als snprintf("%.*f", milli / 1000.0).
+//      Uitzondering zijn exacte halven (printf rondt de binaire double af, ui_fmt
+//      rondt de gehele waarde half van nul af) en "-0.00"; die worden geteld.
+//      ui_fmt_mmss en ui_fmt_uint tegen "%02lu:%02lu" en "%u", plus afkappen op cap.
+//   2. ns per conversie: ui_fmt_fixed / ui_fmt_mmss tegen snprintf met de formaten
+//      van de labels in ui_screens.cpp (float -> double -> %.2f).
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/fmt_bench.cpp src/display/ui_fmt.cpp -o tools/build/fmt_bench
+//
+// Gebruik:
+//   fmt_bench [-r range_milli] [-n conversies]   (standaard 200000 en 5M)
+//
+// Exit code 0 als alle controles slagen.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "display/ui_fmt.h"
+
+static volatile uint32_t g_sink = 0;
+
+static double now_s()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static int check_fixed(int32_t range)
+{
+  static const uint32_t STEP[4] = { 1000, 100, 10, 1 };
+  int fail = 0;
+  uint32_t ties = 0, neg_zero = 0, n = 0;
+  for (uint8_t d = 0; d <= 3; ++d) {
+    const UiFmt f = { "V:", d, " V" };
+    for (int32_t m = -range; m <= range; ++m) {
+      char a[UI_FMT_MAX], b[UI_FMT_MAX];
+      ui_fmt_fixed(a, sizeof(a), f, m);
+      snprintf(b, sizeof(b), "V:%.*f V", (int)d, m / 1000.0);
+      n++;
+      if (strcmp(a, b) == 0) continue;
+
+      const uint32_t am = (uint32_t)(m < 0 ? -m : m);
+      if (STEP[d] > 1 && am % STEP[d] == STEP[d] / 2) { ties++; continue; }
+      if (strncmp(b, "V:-0", 4) == 0 && strncmp(a, "V:0", 3) == 0) {
+        neg_zero++;
+        continue;
+      }
+      if (fail++ < 10) printf("  FOUT d=%u m=%d: ui_fmt \"%s\" snprintf \"%s\"\n", d, m, a, b);
+    }
+  }
+
+  // Uitersten
+  const UiFmt f2 = { nullptr, 2, nullptr };
+  char a[UI_FMT_MAX];
+  ui_fmt_fixed(a, sizeof(a), f2, INT32_MIN);
+  if (strcmp(a, "-2147483.65") != 0) { printf("  FOUT INT32_MIN: \"%s\"\n", a); fail++; }
+  ui_fmt_fixed(a, sizeof(a), f2, INT32_MAX);
+  if (strcmp(a, "2147483.65") != 0) { printf("  FOUT INT32_MAX: \"%s\"\n", a); fail++; }
+  if (ui_milli(1.005f) != 1005 || ui_milli(-2.5f) != -2500 || ui_milli(1e12f) != INT32_MAX ||
+      ui_milli(-1e12f) != INT32_MIN) {
+    printf("  FOUT ui_milli\n");
+    fail++;
+  }
+
+  printf("fixed: %u vergelijkingen, %u halven en %u keer -0 anders dan snprintf (verwacht), %d fouten\n",
+         n, ties, neg_zero, fail);
+  return fail;
+}
+
+static int check_other()
+{
+  int fail = 0;
+  char a[UI_FMT_MAX], b[UI_FMT_MAX];
+  for (uint32_t s = 0; s < 200000; s += 7) {
+    ui_fmt_mmss(a, sizeof(a), "runtime:\n", s);
+    snprintf(b, sizeof(b), "runtime:\n%02lu:%02lu", (unsigned long)(s / 60), (unsigned long)(s % 60));
+    if (strcmp(a, b) != 0 && fail++ < 10) printf("  FOUT mmss %u: \"%s\" \"%s\"\n", s, a, b);
+  }
+  static const uint32_t U[] = { 0, 1, 9, 10, 99, 65535, 4294967295u };
+  for (uint32_t v : U) {
+    ui_fmt_uint(a, sizeof(a), "Curve: ", v);
+    snprintf(b, sizeof(b), "Curve: %u", v);
+    if (strcmp(a, b) != 0 && fail++ < 10) printf("  FOUT uint %u: \"%s\" \"%s\"\n", v, a, b);
+  }
+
+  // Afkappen: zelfde als snprintf, altijd '\0'
+  const UiFmt f = { "capacity:\n", 2, " mAh" };
+  for (size_t cap = 1; cap < 24; ++cap) {
+    char t[32];
+    memset(t, 'x', sizeof(t));
+    const size_t n = ui_fmt_fixed(t, cap, f, 12345);
+    snprintf(b, cap, "capacity:\n%.2f mAh", 12.345);
+    if (strcmp(t, b) != 0 || n != strlen(t) || t[cap] != 'x') {
+      if (fail++ < 10) printf("  FOUT cap %zu: \"%s\" \"%s\"\n", cap, t, b);
+    }
+  }
+  printf("mmss/uint/afkappen: %d fouten\n", fail);
+  return fail;
+}
+
+static void bench(long n)
+{
+  char b[UI_FMT_MAX];
+  const UiFmt F = { "Voltage:\n", 2, " V" };
+
+  double t0 = now_s();
+  for (long i = 0; i < n; ++i) g_sink += (uint32_t)ui_fmt_fixed(b, sizeof(b), F, (int32_t)(i % 20000) * 10);
+  const double t_fixed = now_s() - t0;
+
+  t0 = now_s();
+  for (long i = 0; i < n; ++i) {
+    const float v = (float)(i % 20000) * 0.01f;
+    g_sink += (uint32_t)ui_fmt_fixed(b, sizeof(b), F, ui_milli(v));
+  }
+  const double t_fixed_f = now_s() - t0;
+
+  t0 = now_s();
+  for (long i = 0; i < n; ++i) {
+    const float v = (float)(i % 20000) * 0.01f;
+    g_sink += (uint32_t)snprintf(b, sizeof(b), "Voltage:\n%.2f V", (double)v);
+  }
+  const double t_printf = now_s() - t0;
+
+  t0 = now_s();
+  for (long i = 0; i < n; ++i) g_sink += (uint32_t)ui_fmt_mmss(b, sizeof(b), "runtime:\n", (uint32_t)(i % 360000));
+  const double t_mmss = now_s() - t0;
+
+  t0 = now_s();
+  for (long i = 0; i < n; ++i) {
+    const uint32_t s = (uint32_t)(i % 360000);
+    g_sink += (uint32_t)snprintf(b, sizeof(b), "runtime:\n%02lu:%02lu", (unsigned long)(s / 60), (unsigned long)(s % 60));
+  }
+  const double t_printf_mmss = now_s() - t0;
+
+  const double k = 1e9 / n;
+  printf("ns per conversie (%ld):\n", n);
+  printf("  ui_fmt_fixed %%.2f          %7.1f\n", t_fixed * k);
+  printf("  ui_fmt_fixed + ui_milli    %7.1f\n", t_fixed_f * k);
+  printf("  snprintf %%.2f (double)     %7.1f   (%.1fx)\n", t_printf * k, t_printf / t_fixed);
+  printf("  ui_fmt_mmss                %7.1f\n", t_mmss * k);
+  printf("  snprintf %%02lu:%%02lu        %7.1f   (%.1fx)\n", t_printf_mmss * k, t_printf_mmss / t_mmss);
+}
+
+int main(int argc, char** argv)
+{
+  int32_t range = 200000;
+  long n = 5000000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-r") && i + 1 < argc) range = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) n = atol(argv[++i]);
+    else {
+      fprintf(stderr, "gebruik: %s [-r range_milli] [-n conversies]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int fail = check_fixed(range) + check_other();
+  bench(n);
+  return fail ? 1 : 0;
+}
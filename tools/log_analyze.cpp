@@ -0,0 +1,776 @@
+// tools/log_analyze.cpp - sessie-analyse over veel binaire logs (.sbl) (host)
+//
+// Eén logbestand = één sessie (logTask opent per mount een nieuw /logNNNN.sbl).
+// Per sessie: capaciteit (Ah/Wh ontladen en geladen), inwendige weerstand uit
+// stroomstappen, min/max/percentielen van spanning, stroom en temperatuur,
+// gaten/drops en een fault-tijdlijn, als één samenvattende tabel.
+//
+// Werkwijze:
+//   - elk bestand wordt ge-mmapt en in chunks van CHUNK_BLOCKS blokken opgedeeld;
+//     alle chunks van alle bestanden gaan tegelijk in de pool (bestanden en chunks
+//     parallel, ook bij één groot bestand)
+//   - een chunk decodeert zijn blokken (elk blok begint met een keyframe) en
+//     reduceert naar een ChunkAcc: integralen, schuivende grootheden over paren
+//     opeenvolgende samples, sparse histogrammen, R-schattingen en de intervallen
+//     waarin een raw fault-conditie waar is
+//   - per bestand worden de chunks in volgorde samengevoegd (merge is associatief:
+//     het paar over de chunkgrens en een raw-interval dat over de grens loopt
+//     worden bij het samenvoegen afgehandeld)
+//
+// Fault-tijdlijn: per sample fm_measure_raw met fm_limits_default (dezelfde code
+// en grenzen als ControlTask), daarna de debounce/persistentie/off-tijd uit
+// fm_def() op de intervallen. Assert- en cleartijden zijn daarmee die van de
+// firmware op ±1 sample. Samples zonder MEAS_ADC_OK (of met SATURATED/RANGE_WARN)
+// staan als ADC in de tijdlijn.
+//
+// Inwendige weerstand: bij elke stap |di| >= R_STEP_A tussen twee samples binnen
+// R_STEP_MAX_US is R = -dv/di (i = i_sink - i_source, ontladen positief); de
+// mediaan van alle stappen staat in de tabel.
+//
+// Build:
+//   g++ -O3 -march=native -std=c++17 -pthread -Iinclude -Itools tools/log_analyze.cpp src/log/log.cpp src/fault/fault.cpp -o tools/build/log_analyze
+//
+// Gebruik:
+//   log_analyze <log.sbl...> [-j threads] [-o summary.csv] [--timeline] [--cold] [--truth truth.csv]
+//   log_analyze --synth <dir> [--gb G] [--files N]
+//
+//   --timeline  fault-tijdlijn per sessie onder de tabel
+//   --cold      page cache van de bestanden eerst leeggooien (posix_fadvise),
+//               zodat de doorvoer die van de schijf is
+//   --synth     synthetische logs (tools/common/log_synth.h, 1 kHz) van samen G GB
+//               (standaard 2) met ingespoten faults, plus <dir>/truth.csv
+//   --truth     resultaat toetsen aan truth.csv (exit code 1 bij een afwijking)
+//
+// Benchmark (synthetisch, meerdere GB):
+//   log_analyze --synth /tmp/sbl --gb 3 --files 12
+//   log_analyze /tmp/sbl/*.sbl --cold --truth /tmp/sbl/truth.csv
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "log/log.h"
+#include "fault/fault.h"
+#include "common/log_synth.h"
+#include "common/mmap_file.h"
+#include "common/thread_pool.h"
+
+static constexpr uint32_t CHUNK_BLOCKS   = 256;          // 1 MB, ~200k records
+static constexpr uint32_t GAP_US         = 20000;        // > 2.5x de grootste decimatiestap
+static constexpr uint32_t HOLD_MAX_US    = 5000000;      // integreren over gaten tot 5 s
+static constexpr float    R_STEP_A       = 0.2f;
+static constexpr uint32_t R_STEP_MAX_US  = 5000;
+static constexpr int      HEAD_N         = 8;            // sampletijden per interval voor de debounce
+
+// Histogrammen: bin = kwantisatiestap van de log (zie LOG_Q_*) of grover
+struct HistDef { double lo, step; uint32_t n; };
+static constexpr HistDef H_V = { -1.0,   0.001, 26000 };  // V, 1 mV
+static constexpr HistDef H_I = { -15.0,  0.001, 30000 };  // A, 1 mA
+static constexpr HistDef H_T = { -50.0,  0.01,  25000 };  // °C, 0.01 °C
+
+static inline uint32_t hist_bin(const HistDef& h, double v)
+{
+  const double b = (v - h.lo) / h.step + 0.5;
+  if (b <= 0.0) return 0;
+  if (b >= h.n - 1) return h.n - 1;
+  return (uint32_t)b;
+}
+
+// Tijdlijn-ids: de meetfaults uit fault.h + ADC
+enum { TL_OV, TL_OC, TL_OT, TL_OT_DERATE, TL_ADC, TL_COUNT };
+static const FaultId TL_FID[TL_ADC] = { FID_OV, FID_OC, FID_OT, FID_OT_DERATE };
+static const char* const TL_NAMES[TL_COUNT] = { "OV", "OC", "OT", "OT_DERATE", "ADC" };
+
+// =========================
+// Reductie
+// =========================
+struct Interval
+{
+  uint64_t t0, t1;          // us sinds het begin van de chunk (na merge: de sessie)
+  uint32_t n;
+  float    peak;
+  uint8_t  n_head;
+  uint64_t head[HEAD_N];    // tijden van de eerste samples
+};
+
+struct SparseHist { std::vector<std::pair<uint32_t, uint32_t>> bins; };
+
+struct ChunkAcc
+{
+  uint64_t n = 0;
+  uint32_t t_first_us = 0, t_last_us = 0;
+  uint64_t span_us = 0;     // t_last - t_first, uitgepakt
+  LogRecord first{}, last{};
+
+  double ah_dis = 0, ah_chg = 0, wh_dis = 0, wh_chg = 0;
+  uint32_t n_gaps = 0;
+  uint64_t gap_us = 0;
+
+  float v_min = INFINITY, v_max = -INFINITY;
+  float i_min = INFINITY, i_max = -INFINITY;
+  float t_min = INFINITY, t_max = -INFINITY;
+  SparseHist hv, hi, ht;
+  std::vector<float> r_est;
+
+  std::vector<Interval> iv[TL_COUNT];
+  bool on_first[TL_COUNT] = {};
+  bool on_last[TL_COUNT] = {};
+
+  uint32_t n_blocks = 0, n_index = 0, n_bad = 0;
+  uint32_t n_dropped = 0, n_decimated = 0;   // cumulatief, laatste blok
+};
+
+static inline float net_i(const LogRecord& r) { return r.i_sink - r.i_source; }
+
+// Paar opeenvolgende samples (p vóór c, dt ertussen)
+static inline void acc_pair(ChunkAcc& a, const LogRecord& p, const LogRecord& c, uint32_t dt)
+{
+  const float ip = net_i(p);
+  if (dt <= HOLD_MAX_US) {
+    const double ah = (double)ip * dt * (1.0 / 3.6e9);
+    const double wh = ah * p.v_out;
+    if (ip >= 0.0f) { a.ah_dis += ah; a.wh_dis += wh; }
+    else            { a.ah_chg -= ah; a.wh_chg -= wh; }
+  }
+  if (dt > GAP_US) { a.n_gaps++; a.gap_us += dt; }
+
+  const float di = net_i(c) - ip;
+  if (dt <= R_STEP_MAX_US && fabsf(di) >= R_STEP_A) {
+    const float r = -(c.v_out - p.v_out) / di;
+    if (r > 0.0f && r < 5.0f) a.r_est.push_back(r);
+  }
+}
+
+static inline void iv_add(ChunkAcc& a, int id, bool on, uint64_t t, float val)
+{
+  if (!on) return;
+  std::vector<Interval>& v = a.iv[id];
+  const bool cont = a.n > 0 && a.on_last[id];
+  if (!cont) {
+    Interval x{};
+    x.t0 = x.t1 = t;
+    x.peak = val;
+    v.push_back(x);
+  }
+  Interval& x = v.back();
+  x.t1 = t;
+  x.n++;
+  if (val > x.peak) x.peak = val;
+  if (x.n_head < HEAD_N) x.head[x.n_head++] = t;
+}
+
+// Raw fault-bits en ADC van één sample
+static inline uint32_t sample_raw(const FaultLimits& lim, const LogRecord& r)
+{
+  MeasurementData m;
+  m.t_us = r.t_us;
+  m.v_out = r.v_out;
+  m.i_sink = r.i_sink;
+  m.i_source = r.i_source;
+  m.temp_sink_c = r.temp_sink_c;
+  m.meas_flags = r.meas_flags;
+
+  const uint32_t f = fm_measure_raw(&lim, &m);
+  uint32_t raw = 0;
+  for (int k = 0; k < TL_ADC; ++k) if (f & (1u << TL_FID[k])) raw |= 1u << k;
+  if (!(r.meas_flags & MEAS_ADC_OK) || (r.meas_flags & (MEAS_ADC_SATURATED | MEAS_RANGE_WARN))) raw |= 1u << TL_ADC;
+  return raw;
+}
+
+static inline float tl_value(int id, const LogRecord& r)
+{
+  switch (id) {
+    case TL_OV: return r.v_out;
+    case TL_OC: return fmaxf(r.i_sink, r.i_source);
+    case TL_OT: case TL_OT_DERATE: return r.temp_sink_c;
+  }
+  return (float)r.meas_flags;
+}
+
+struct Scratch
+{
+  std::vector<LogRecord> rec;
+  std::vector<uint32_t> hv, hi, ht;
+  std::vector<uint32_t> used_v, used_i, used_t;   // aangeraakte bins (sparse maken zonder scan)
+  Scratch() : rec(LOG_BLOCK_PAYLOAD / 5u + 1u), hv(H_V.n), hi(H_I.n), ht(H_T.n) {}
+};
+
+static inline void hist_add(std::vector<uint32_t>& h, std::vector<uint32_t>& used, uint32_t b)
+{
+  if (h[b]++ == 0) used.push_back(b);
+}
+
+static void hist_take(std::vector<uint32_t>& h, std::vector<uint32_t>& used, SparseHist& out)
+{
+  out.bins.reserve(used.size());
+  for (uint32_t b : used) { out.bins.emplace_back(b, h[b]); h[b] = 0; }
+  used.clear();
+}
+
+static ChunkAcc run_chunk(const uint8_t* data, uint32_t b0, uint32_t b1, const FaultLimits& lim)
+{
+  thread_local Scratch s;
+  ChunkAcc a;
+  uint64_t t = 0;
+
+  for (uint32_t seq = b0; seq < b1; ++seq) {
+    const uint8_t* blk = data + (size_t)seq * LOG_BLOCK_SIZE;
+    LogBlockHeader h;
+    memcpy(&h, blk, sizeof(h));
+    if (h.magic == LOG_BLOCK_MAGIC && h.type == LOG_BLOCK_INDEX) { a.n_index++; continue; }
+
+    const int n = log_block_decode(blk, s.rec.data(), (uint32_t)s.rec.size());
+    if (n < 0) { a.n_bad++; continue; }
+    a.n_blocks++;
+    a.n_dropped = h.n_dropped;
+    a.n_decimated = h.n_decimated;
+
+    for (int k = 0; k < n; ++k) {
+      const LogRecord& r = s.rec[k];
+      if (a.n == 0) {
+        a.first = r;
+        a.t_first_us = r.t_us;
+      } else {
+        const uint32_t dt = r.t_us - a.last.t_us;
+        t += dt;
+        acc_pair(a, a.last, r, dt);
+      }
+
+      const float i = net_i(r);
+      a.v_min = fminf(a.v_min, r.v_out); a.v_max = fmaxf(a.v_max, r.v_out);
+      a.i_min = fminf(a.i_min, i);       a.i_max = fmaxf(a.i_max, i);
+      a.t_min = fminf(a.t_min, r.temp_sink_c); a.t_max = fmaxf(a.t_max, r.temp_sink_c);
+      hist_add(s.hv, s.used_v, hist_bin(H_V, r.v_out));
+      hist_add(s.hi, s.used_i, hist_bin(H_I, i));
+      hist_add(s.ht, s.used_t, hist_bin(H_T, r.temp_sink_c));
+
+      const uint32_t raw = sample_raw(lim, r);
+      if (raw || a.n == 0) {
+        for (int id = 0; id < TL_COUNT; ++id) {
+          const bool on = (raw >> id) & 1u;
+          iv_add(a, id, on, t, tl_value(id, r));
+          if (a.n == 0) a.on_first[id] = on;
+          a.on_last[id] = on;
+        }
+      } else {
+        for (int id = 0; id < TL_COUNT; ++id) a.on_last[id] = false;
+      }
+
+      a.last = r;
+      a.n++;
+    }
+  }
+  a.t_last_us = a.last.t_us;
+  a.span_us = t;
+  hist_take(s.hv, s.used_v, a.hv);
+  hist_take(s.hi, s.used_i, a.hi);
+  hist_take(s.ht, s.used_t, a.ht);
+  return a;
+}
+
+// =========================
+// Sessie (chunks in volgorde samenvoegen)
+// =========================
+struct Episode
+{
+  int      id;
+  uint64_t t_detect, t_assert, t_clear;   // us sinds de start; t_clear = UINT64_MAX: nog actief
+  float    peak;
+};
+
+struct Session
+{
+  std::string path;
+  size_t bytes = 0;
+  ChunkAcc acc;
+  std::vector<uint64_t> hv, hi, ht;
+  float r_median = NAN;
+  std::vector<Episode> episodes;
+  uint32_t transients[TL_COUNT] = {};
+  uint32_t asserts[TL_COUNT] = {};
+};
+
+static void merge(ChunkAcc& a, ChunkAcc& b)
+{
+  a.n_blocks += b.n_blocks; a.n_index += b.n_index; a.n_bad += b.n_bad;
+  if (b.n_blocks) { a.n_dropped = b.n_dropped; a.n_decimated = b.n_decimated; }
+  if (b.n == 0) return;
+  if (a.n == 0) {
+    const uint32_t nb = a.n_blocks, ni = a.n_index, nbad = a.n_bad;
+    a = std::move(b);
+    a.n_blocks = nb; a.n_index = ni; a.n_bad = nbad;
+    return;
+  }
+
+  const uint32_t dt = b.t_first_us - a.t_last_us;
+  const uint64_t off = a.span_us + dt;
+  acc_pair(a, a.last, b.first, dt);
+
+  a.ah_dis += b.ah_dis; a.ah_chg += b.ah_chg; a.wh_dis += b.wh_dis; a.wh_chg += b.wh_chg;
+  a.n_gaps += b.n_gaps; a.gap_us += b.gap_us;
+  a.v_min = fminf(a.v_min, b.v_min); a.v_max = fmaxf(a.v_max, b.v_max);
+  a.i_min = fminf(a.i_min, b.i_min); a.i_max = fmaxf(a.i_max, b.i_max);
+  a.t_min = fminf(a.t_min, b.t_min); a.t_max = fmaxf(a.t_max, b.t_max);
+  a.r_est.insert(a.r_est.end(), b.r_est.begin(), b.r_est.end());
+
+  for (int id = 0; id < TL_COUNT; ++id) {
+    size_t k = 0;
+    if (a.on_last[id] && b.on_first[id] && !b.iv[id].empty()) {
+      // Raw-interval loopt over de chunkgrens
+      Interval& x = a.iv[id].back();
+      const Interval& y = b.iv[id][0];
+      x.t1 = y.t1 + off;
+      x.n += y.n;
+      x.peak = fmaxf(x.peak, y.peak);
+      for (uint8_t j = 0; j < y.n_head && x.n_head < HEAD_N; ++j) x.head[x.n_head++] = y.head[j] + off;
+      k = 1;
+    }
+    for (; k < b.iv[id].size(); ++k) {
+      Interval y = b.iv[id][k];
+      y.t0 += off; y.t1 += off;
+      for (uint8_t j = 0; j < y.n_head; ++j) y.head[j] += off;
+      a.iv[id].push_back(y);
+    }
+    a.on_last[id] = b.on_last[id];
+  }
+
+  a.span_us = off + b.span_us;
+  a.t_last_us = b.t_last_us;
+  a.last = b.last;
+  a.n += b.n;
+}
+
+static void hist_dense(const SparseHist& s, std::vector<uint64_t>& d)
+{
+  for (const auto& b : s.bins) d[b.first] += b.second;
+}
+
+static double hist_pct(const std::vector<uint64_t>& h, const HistDef& d, uint64_t n, double p)
+{
+  if (n == 0) return NAN;
+  const uint64_t target = (uint64_t)ceil(p * n);
+  uint64_t cum = 0;
+  for (uint32_t b = 0; b < d.n; ++b) {
+    cum += h[b];
+    if (cum >= target && cum > 0) return d.lo + b * d.step;
+  }
+  return d.lo + (d.n - 1) * d.step;
+}
+
+// Debounce / persistentie / off-tijd van fm_update op de raw-intervallen
+static void build_timeline(Session& s)
+{
+  for (int id = 0; id < TL_COUNT; ++id) {
+    uint8_t on_count = 1;
+    uint64_t on_us = 0, off_us = 0;
+    if (id < TL_ADC) {
+      const FaultDef* d = fm_def(TL_FID[id]);
+      on_count = d->on_count;
+      on_us = (uint64_t)d->on_ms * 1000u;
+      off_us = (uint64_t)d->off_ms * 1000u;
+    }
+
+    bool active = false;
+    Episode e{};
+    uint64_t raw_end = 0;
+    for (const Interval& x : s.acc.iv[id]) {
+      if (active && x.t0 - raw_end < off_us) {
+        // Raw terug binnen de off-tijd: dezelfde episode
+        raw_end = x.t1;
+        e.peak = fmaxf(e.peak, x.peak);
+        continue;
+      }
+      if (active) {
+        e.t_clear = raw_end + off_us;
+        s.episodes.push_back(e);
+        active = false;
+      }
+
+      // Eerste sample waarop count >= on_count en held >= on_ms
+      uint64_t t_assert = UINT64_MAX;
+      for (uint8_t j = (uint8_t)(on_count - 1); j < x.n_head; ++j) {
+        if (x.head[j] - x.t0 >= on_us) { t_assert = x.head[j]; break; }
+      }
+      if (t_assert == UINT64_MAX && x.n >= on_count && x.t1 - x.t0 >= on_us) t_assert = x.t0 + on_us;
+
+      if (t_assert == UINT64_MAX) { s.transients[id]++; continue; }
+      active = true;
+      e = Episode{ id, x.t0, t_assert, UINT64_MAX, x.peak };
+      raw_end = x.t1;
+      s.asserts[id]++;
+    }
+    if (active) {
+      if (raw_end + off_us <= s.acc.span_us) e.t_clear = raw_end + off_us;
+      s.episodes.push_back(e);
+    }
+  }
+  std::sort(s.episodes.begin(), s.episodes.end(),
+            [](const Episode& a, const Episode& b) { return a.t_detect < b.t_detect; });
+}
+
+static void finish(Session& s, std::vector<ChunkAcc>& chunks)
+{
+  s.hv.assign(H_V.n, 0);
+  s.hi.assign(H_I.n, 0);
+  s.ht.assign(H_T.n, 0);
+  for (ChunkAcc& c : chunks) {
+    hist_dense(c.hv, s.hv);
+    hist_dense(c.hi, s.hi);
+    hist_dense(c.ht, s.ht);
+    c.hv.bins.clear(); c.hi.bins.clear(); c.ht.bins.clear();
+    merge(s.acc, c);
+  }
+  std::vector<float>& r = s.acc.r_est;
+  if (!r.empty()) {
+    std::nth_element(r.begin(), r.begin() + r.size() / 2, r.end());
+    s.r_median = r[r.size() / 2];
+  }
+  build_timeline(s);
+}
+
+// =========================
+// Uitvoer
+// =========================
+static const char* base_name(const std::string& p)
+{
+  const size_t k = p.find_last_of('/');
+  return p.c_str() + (k == std::string::npos ? 0 : k + 1);
+}
+
+static void print_table(const std::vector<Session>& ss)
+{
+  printf("%-14s %7s %10s %8s %8s %8s %9s %7s %7s %7s %7s %7s %6s %6s %6s %-10s %5s %7s\n",
+         "sessie", "uur", "records", "Ah_ont", "Wh_ont", "Ah_laad", "R0_mOhm", "Vmin", "Vp1", "Vp50", "Vp99", "Vmax",
+         "Imax", "Tp99", "Tmax", "faults", "gaten", "gedropt");
+  for (const Session& s : ss) {
+    const ChunkAcc& a = s.acc;
+    const uint64_t n = a.n;
+    char faults[32];
+    snprintf(faults, sizeof(faults), "%u/%u/%u/%u",
+             s.asserts[TL_OV], s.asserts[TL_OC], s.asserts[TL_OT], s.asserts[TL_OT_DERATE]);
+    printf("%-14s %7.2f %10llu %8.3f %8.3f %8.3f %9.1f %7.3f %7.3f %7.3f %7.3f %7.3f %6.2f %6.2f %6.2f %-10s %5u %7u\n",
+           base_name(s.path), a.span_us / 3.6e9, (unsigned long long)n, a.ah_dis, a.wh_dis, a.ah_chg,
+           s.r_median * 1e3, a.v_min, hist_pct(s.hv, H_V, n, 0.01), hist_pct(s.hv, H_V, n, 0.50),
+           hist_pct(s.hv, H_V, n, 0.99), a.v_max, a.i_max, hist_pct(s.ht, H_T, n, 0.99), a.t_max,
+           faults, a.n_gaps, a.n_dropped);
+  }
+  printf("(faults = asserts OV/OC/OT/OT_DERATE; gaten = dt > %u ms)\n", GAP_US / 1000);
+}
+
+static void print_timeline(const Session& s)
+{
+  printf("\n%s: %zu episodes", base_name(s.path), s.episodes.size());
+  for (int id = 0; id < TL_COUNT; ++id) {
+    if (s.transients[id]) printf(", %u x %s kort (geen assert)", s.transients[id], TL_NAMES[id]);
+  }
+  printf("\n");
+  for (const Episode& e : s.episodes) {
+    const char* cls = e.id < TL_ADC ? (fm_def(TL_FID[e.id])->cls == FAULT_CLASS_SHUTDOWN ? "shutdown" :
+                                       fm_def(TL_FID[e.id])->cls == FAULT_CLASS_DERATE ? "derate" : "warn")
+                                    : "meting";
+    printf("  %12.3f s  %-10s %-8s assert +%.1f ms", e.t_detect * 1e-6, TL_NAMES[e.id], cls,
+           (e.t_assert - e.t_detect) * 1e-3);
+    if (e.t_clear == UINT64_MAX) printf(", actief tot het einde");
+    else printf(", weg na %.3f s", (e.t_clear - e.t_detect) * 1e-6);
+    printf(", piek %.3f\n", e.peak);
+  }
+}
+
+static bool write_csv(const char* path, const std::vector<Session>& ss)
+{
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "file,hours,records,ah_dis,wh_dis,ah_chg,wh_chg,r0_ohm,r0_n,v_min,v_p1,v_p50,v_p99,v_max,"
+             "i_min,i_p1,i_p50,i_p99,i_max,t_min,t_p50,t_p99,t_max,ov,oc,ot,ot_derate,adc,gaps,gap_s,dropped,decimated,bad_blocks\n");
+  for (const Session& s : ss) {
+    const ChunkAcc& a = s.acc;
+    const uint64_t n = a.n;
+    fprintf(f, "%s,%.4f,%llu,%.6f,%.6f,%.6f,%.6f,%.6f,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,"
+               "%.4f,%.3f,%.3f,%.3f,%.4f,%.2f,%.2f,%.2f,%.2f,%u,%u,%u,%u,%u,%u,%.3f,%u,%u,%u\n",
+            s.path.c_str(), a.span_us / 3.6e9, (unsigned long long)n, a.ah_dis, a.wh_dis, a.ah_chg, a.wh_chg,
+            s.r_median, a.r_est.size(), a.v_min, hist_pct(s.hv, H_V, n, 0.01), hist_pct(s.hv, H_V, n, 0.5),
+            hist_pct(s.hv, H_V, n, 0.99), a.v_max, a.i_min, hist_pct(s.hi, H_I, n, 0.01),
+            hist_pct(s.hi, H_I, n, 0.5), hist_pct(s.hi, H_I, n, 0.99), a.i_max, a.t_min,
+            hist_pct(s.ht, H_T, n, 0.5), hist_pct(s.ht, H_T, n, 0.99), a.t_max,
+            s.asserts[TL_OV], s.asserts[TL_OC], s.asserts[TL_OT], s.asserts[TL_OT_DERATE], s.asserts[TL_ADC],
+            a.n_gaps, a.gap_us * 1e-6, a.n_dropped, a.n_decimated, a.n_bad);
+  }
+  return fclose(f) == 0;
+}
+
+// =========================
+// Synthetische logs
+// =========================
+struct Truth
+{
+  uint64_t records = 0;
+  double ah_dis = 0, wh_dis = 0, ah_chg = 0;
+  uint32_t asserts[TL_ADC] = {};
+};
+
+// Faults op vaste plekken (samples bij 1 kHz):
+//   n/5: 3 samples i_sink 11 A         -> OC assert (on_count 2)
+//   n/3: 150 ms 95 °C                  -> OT en OT_DERATE kort (on_ms 200/500)
+//   n/2: 700 ms 95 °C                  -> OT assert na 200 ms, OT_DERATE na 500 ms
+static void inject(uint64_t k, uint64_t n, LogRecord& r)
+{
+  if (k >= n / 5 && k < n / 5 + 3) r.i_sink = 11.0f;
+  if (k >= n / 3 && k < n / 3 + 150) r.temp_sink_c = 95.0f;
+  if (k >= n / 2 && k < n / 2 + 700) r.temp_sink_c = 95.0f;
+}
+
+static bool synth_file(const char* path, uint64_t i0, uint64_t n, Truth& tr)
+{
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+
+  std::vector<LogRecord> ring_buf(LOG_RING_LEN);
+  LogRing ring;
+  log_ring_init(&ring, ring_buf.data(), LOG_POLICY_DROP);
+  uint8_t* b0 = (uint8_t*)aligned_alloc(32, LOG_BATCH_BYTES);
+  uint8_t* b1 = (uint8_t*)aligned_alloc(32, LOG_BATCH_BYTES);
+  LogBatcher bat;
+  log_batch_init(&bat, b0, b1);
+
+  bool ok = true;
+  auto drain = [&] {
+    int idx;
+    while ((idx = log_batch_drain(&bat, &ring)) >= 0) {
+      ok &= fwrite(bat.buf[idx], 1, LOG_BATCH_BYTES, f) == LOG_BATCH_BYTES;
+      log_batch_release(&bat, idx);
+    }
+  };
+
+  LogRecord prev{};
+  for (uint64_t k = 0; k < n; ++k) {
+    LogRecord r;
+    synth_record(i0 + k, 1000, &r);
+    inject(k, n, r);
+
+    // Zelfde regel als acc_pair, op de ongekwantiseerde waarden
+    if (k) {
+      const float ip = net_i(prev);
+      const double ah = (double)ip * 1000u * (1.0 / 3.6e9);
+      if (ip >= 0.0f) { tr.ah_dis += ah; tr.wh_dis += ah * prev.v_out; }
+      else tr.ah_chg -= ah;
+    }
+    prev = r;
+
+    log_ring_push(&ring, &r);
+    if ((k & 255u) == 255u) drain();
+  }
+  drain();
+  uint32_t bytes;
+  const int idx = log_batch_flush(&bat, &ring, &bytes);
+  if (idx >= 0) {
+    ok &= fwrite(bat.buf[idx], 1, bytes, f) == bytes;
+    log_batch_release(&bat, idx);
+  }
+  ok &= fclose(f) == 0;
+  free(b0);
+  free(b1);
+
+  tr.records = n;
+  tr.asserts[TL_OC] = 1;
+  tr.asserts[TL_OT] = 1;
+  tr.asserts[TL_OT_DERATE] = 1;
+  return ok;
+}
+
+static int synth(const char* dir, double gb, unsigned n_files, unsigned threads)
+{
+  mkdir(dir, 0755);
+  const double bytes_per_rec = 5.12;   // tools/log_bench
+  const uint64_t per_file = (uint64_t)(gb * 1e9 / bytes_per_rec / n_files);
+
+  std::vector<Truth> truth(n_files);
+  std::vector<std::string> paths(n_files);
+  std::vector<char> ok(n_files, 0);
+  const auto t0 = std::chrono::steady_clock::now();
+  {
+    WorkStealingPool pool(threads);
+    pool.parallel_for(n_files, 1, [&](size_t k) {
+      char p[512];
+      snprintf(p, sizeof(p), "%s/log%04zu.sbl", dir, k);
+      paths[k] = p;
+      // Elke sessie een ander stuk van de ontlaadcurve
+      ok[k] = synth_file(p, (uint64_t)k * 3600000u, per_file, truth[k]);
+    });
+    pool.wait();
+  }
+  const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  char tp[512];
+  snprintf(tp, sizeof(tp), "%s/truth.csv", dir);
+  FILE* f = fopen(tp, "w");
+  if (!f) return 1;
+  fprintf(f, "file,records,ah_dis,wh_dis,ah_chg,r0_ohm,ov,oc,ot,ot_derate\n");
+  uint64_t total = 0;
+  for (unsigned k = 0; k < n_files; ++k) {
+    if (!ok[k]) { fprintf(stderr, "%s: schrijffout\n", paths[k].c_str()); return 1; }
+    const Truth& t = truth[k];
+    fprintf(f, "%s,%llu,%.9f,%.9f,%.9f,%.4f,%u,%u,%u,%u\n", base_name(paths[k]), (unsigned long long)t.records,
+            t.ah_dis, t.wh_dis, t.ah_chg, 0.08, t.asserts[TL_OV], t.asserts[TL_OC], t.asserts[TL_OT],
+            t.asserts[TL_OT_DERATE]);
+    struct stat st;
+    if (stat(paths[k].c_str(), &st) == 0) total += (uint64_t)st.st_size;
+  }
+  fclose(f);
+  printf("%u bestanden, %llu records per bestand (%.1f uur bij 1 kHz), %.2f GB in %.1f s -> %s\n",
+         n_files, (unsigned long long)per_file, per_file / 3.6e6, total / 1e9, dt, tp);
+  return 0;
+}
+
+static int check_truth(const char* path, const std::vector<Session>& ss)
+{
+  FILE* f = fopen(path, "r");
+  if (!f) { fprintf(stderr, "%s: niet te openen\n", path); return 1; }
+  std::map<std::string, const Session*> by_name;
+  for (const Session& s : ss) by_name[base_name(s.path)] = &s;
+
+  char line[512];
+  int fail = 0, n = 0;
+  double worst_ah = 0, worst_wh = 0, worst_r = 0;
+  if (!fgets(line, sizeof(line), f)) { fclose(f); return 1; }
+  while (fgets(line, sizeof(line), f)) {
+    char name[256];
+    unsigned long long rec;
+    double ah, wh, ahc, r0;
+    unsigned ov, oc, ot, otd;
+    if (sscanf(line, "%255[^,],%llu,%lf,%lf,%lf,%lf,%u,%u,%u,%u", name, &rec, &ah, &wh, &ahc, &r0,
+               &ov, &oc, &ot, &otd) != 10) continue;
+    auto it = by_name.find(name);
+    if (it == by_name.end()) continue;
+    const Session& s = *it->second;
+    ++n;
+
+    const double e_ah = fabs(s.acc.ah_dis - ah) / ah;
+    const double e_wh = fabs(s.acc.wh_dis - wh) / wh;
+    const double e_r = fabs(s.r_median - r0);
+    worst_ah = fmax(worst_ah, e_ah);
+    worst_wh = fmax(worst_wh, e_wh);
+    worst_r = fmax(worst_r, e_r);
+    const bool ok = s.acc.n == rec && e_ah < 1e-4 && e_wh < 1e-4 && e_r < 0.002 &&
+                    s.asserts[TL_OV] == ov && s.asserts[TL_OC] == oc && s.asserts[TL_OT] == ot &&
+                    s.asserts[TL_OT_DERATE] == otd && s.acc.n_bad == 0;
+    if (!ok) { printf("  %s: wijkt af van truth.csv\n", name); ++fail; }
+  }
+  fclose(f);
+  printf("truth: %d sessies, max fout Ah %.1e, Wh %.1e, R0 %.2f mOhm, faults exact: %s\n",
+         n, worst_ah, worst_wh, worst_r * 1e3, fail ? "FAIL" : "OK");
+  return (fail || n == 0) ? 1 : 0;
+}
+
+// =========================
+// main
+// =========================
+int main(int argc, char** argv)
+{
+  unsigned threads = 0;
+  for (int k = 1; k + 1 < argc; ++k) if (!strcmp(argv[k], "-j")) threads = (unsigned)atoi(argv[k + 1]);
+
+  if (argc >= 3 && !strcmp(argv[1], "--synth")) {
+    double gb = 2.0;
+    unsigned files = 8;
+    for (int k = 3; k + 1 < argc; ++k) {
+      if (!strcmp(argv[k], "--gb")) gb = atof(argv[k + 1]);
+      if (!strcmp(argv[k], "--files")) files = (unsigned)atoi(argv[k + 1]);
+    }
+    return synth(argv[2], gb, files ? files : 1, threads);
+  }
+
+  std::vector<std::string> paths;
+  const char* out_csv = nullptr;
+  const char* truth = nullptr;
+  bool timeline = false, cold = false;
+  for (int k = 1; k < argc; ++k) {
+    if (!strcmp(argv[k], "-j") && k + 1 < argc) ++k;
+    else if (!strcmp(argv[k], "-o") && k + 1 < argc) out_csv = argv[++k];
+    else if (!strcmp(argv[k], "--truth") && k + 1 < argc) truth = argv[++k];
+    else if (!strcmp(argv[k], "--timeline")) timeline = true;
+    else if (!strcmp(argv[k], "--cold")) cold = true;
+    else paths.push_back(argv[k]);
+  }
+  if (paths.empty()) {
+    fprintf(stderr, "gebruik: %s <log.sbl...> [-j threads] [-o summary.csv] [--timeline] [--cold] [--truth truth.csv]\n"
+                    "         %s --synth <dir> [--gb G] [--files N]\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  if (cold) {
+    for (const std::string& p : paths) {
+      const int fd = open(p.c_str(), O_RDONLY);
+      if (fd < 0) continue;
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+
+  const auto t0 = std::chrono::steady_clock::now();
+
+  const size_t n_files = paths.size();
+  std::vector<MappedFile> maps(n_files);
+  std::vector<Session> sessions(n_files);
+  std::vector<std::vector<ChunkAcc>> chunks(n_files);
+  FaultLimits lim;
+  fm_limits_default(&lim);
+
+  uint64_t total_bytes = 0;
+  {
+    WorkStealingPool pool(threads);
+    for (size_t fi = 0; fi < n_files; ++fi) {
+      sessions[fi].path = paths[fi];
+      if (!maps[fi].open(paths[fi].c_str())) {
+        fprintf(stderr, "%s: niet te openen\n", paths[fi].c_str());
+        continue;
+      }
+      sessions[fi].bytes = maps[fi].size();
+      total_bytes += maps[fi].size();
+
+      const uint32_t n_blocks = (uint32_t)(maps[fi].size() / LOG_BLOCK_SIZE);
+      const uint32_t n_chunks = (n_blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+      chunks[fi].resize(n_chunks);
+      const uint8_t* data = maps[fi].data();
+      for (uint32_t c = 0; c < n_chunks; ++c) {
+        const uint32_t b0 = c * CHUNK_BLOCKS;
+        const uint32_t b1 = std::min(n_blocks, b0 + CHUNK_BLOCKS);
+        ChunkAcc* out = &chunks[fi][c];
+        pool.submit([data, b0, b1, out, &lim] { *out = run_chunk(data, b0, b1, lim); });
+      }
+    }
+    pool.wait();
+
+    // Per sessie samenvoegen (bestanden parallel)
+    pool.parallel_for(n_files, 1, [&](size_t fi) { finish(sessions[fi], chunks[fi]); });
+    pool.wait();
+    threads = pool.size();
+  }
+
+  const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  uint64_t total_rec = 0;
+  for (const Session& s : sessions) total_rec += s.acc.n;
+
+  print_table(sessions);
+  if (timeline) for (const Session& s : sessions) print_timeline(s);
+
+  printf("\n%zu sessies, %.2f GB, %llu records in %.2f s: %.2f GB/s, %.0f M records/s (%u threads%s)\n",
+         n_files, total_bytes / 1e9, (unsigned long long)total_rec, dt, dt > 0 ? total_bytes / dt / 1e9 : 0.0,
+         dt > 0 ? total_rec / dt / 1e6 : 0.0, threads, cold ? ", koud" : "");
+
+  if (out_csv && !write_csv(out_csv, sessions)) {
+    fprintf(stderr, "%s: schrijffout\n", out_csv);
+    return 1;
+  }
+  if (truth) return check_truth(truth, sessions);
+  return 0;
+}
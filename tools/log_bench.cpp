@@ -0,0 +1,457 @@
+// tools/log_bench.cpp - log-pijplijn met een bestand als SD-kaart (host)
+//
+// Draait src/log/log.cpp met dezelfde rolverdeling als de firmware:
+//   producer-thread  = measureTask   (log_ring_push, nooit wachten)
+//   log-thread       = logTask       (log_batch_drain / log_batch_flush)
+//   writer-thread    = sdWriterTask  (write() van een hele buffer, optioneel stall)
+//
+// Scenario's:
+//   0. codec: LogEncoder / log_block_decode los op één core (cycli en bytes per
+//      record, compressieratio t.o.v. de ruwe 24 bytes)
+//   1. doorvoer: producer zonder pacing; bij een volle ring wacht alleen deze
+//      bench-producer (de firmware dropt dan). Geeft de sustained records/s.
+//   2. 1 kHz met kaart-stalls: de writer blijft stall_ms hangen; per policy wordt
+//      geteld wat gedropt/gedecimeerd wordt en hoe lang een push maximaal duurt.
+// Het signaal komt uit tools/common/log_synth.h. Na elke run wordt het bestand
+// teruggelezen: crc per blok, blokvolgorde, indexblokken, oplopende tijdstempels,
+// waarden binnen een halve kwantisatiestap en
+// geschreven + gedropt + gedecimeerd == aangeboden.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/log_bench.cpp src/log/log.cpp -o tools/build/log_bench
+//
+// Gebruik:
+//   log_bench [bestand] [-n records] [-s stall_ms] [-k]
+//   (standaard /tmp/log_bench.sbl, 20M records, stall 3500 ms)
+//   -k: bestand van de doorvoertest bewaren (invoer voor tools/log_decode); 20M
+//       records = 5.5 uur bij 1 kHz, t_us loopt daarin 4x over
+//
+// Exit code 0 als alle controles slagen.
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log/log.h"
+#include "common/log_synth.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles() { return __rdtsc(); }
+#else
+static inline uint64_t cycles() { return 0; }
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static int g_fail = 0;
+static void check(bool ok, const char* what)
+{
+    printf("  %-62s %s\n", what, ok ? "OK" : "FAIL");
+    if (!ok) g_fail++;
+}
+
+static inline uint64_t now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// =========================
+// Pijplijn
+// =========================
+struct Job { int idx; uint32_t bytes; bool sync; };
+
+struct RunCfg
+{
+    LogPolicy policy;
+    uint64_t  n_records;
+    uint32_t  period_us;      // tijdstempel-stap
+    bool      paced;          // false = zo snel mogelijk (doorvoer)
+    uint32_t  stall_ms;       // 0 = geen stall
+    uint32_t  stall_at_ms;    // writer hangt vanaf dit moment één keer
+};
+
+struct RunResult
+{
+    uint64_t pushed, accepted, dropped, decimated;
+    uint32_t fill_max, n_stalled;
+    double   secs;
+    uint64_t push_ns_max;
+    double   push_ns_avg;
+    uint64_t bytes_written;
+    double   drain_ns_per_rec;
+    bool     bp_seen;
+};
+
+static RunResult run(const char* path, const RunCfg& cfg)
+{
+    static LogRecord ring_buf[LOG_RING_LEN];
+    LogRing ring;
+    LogBatcher batch;
+    log_ring_init(&ring, ring_buf, cfg.policy);
+
+    uint8_t* b0 = nullptr;
+    uint8_t* b1 = nullptr;
+    if (posix_memalign((void**)&b0, LOG_BLOCK_SIZE, LOG_BATCH_BYTES) ||
+        posix_memalign((void**)&b1, LOG_BLOCK_SIZE, LOG_BATCH_BYTES)) {
+        fprintf(stderr, "geen geheugen\n");
+        exit(2);
+    }
+    log_batch_init(&batch, b0, b1);
+
+    // O_DIRECT waar het kan (aligned buffers, zoals de SD-kaart zonder cache)
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (fd < 0) fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { perror(path); exit(2); }
+
+    std::mutex mu;
+    std::condition_variable cv_write, cv_log;
+    std::deque<Job> jobs;
+    std::atomic<bool> prod_done(false), log_done(false);
+    std::atomic<uint32_t> log_kick(0);
+    std::atomic<uint64_t> bytes_written(0);
+    std::atomic<bool> bp_seen(false);
+    uint64_t drain_ns = 0, drained = 0;   // alleen de log-thread
+
+    const uint64_t t_start = now_ns();
+
+    // ---- writer (sdWriterTask) ----
+    std::thread writer([&] {
+        bool stalled_once = false;
+        for (;;) {
+            Job j;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv_write.wait(lk, [&] { return !jobs.empty() || log_done.load(); });
+                if (jobs.empty()) return;
+                j = jobs.front();
+                jobs.pop_front();
+            }
+            if (cfg.stall_ms && !stalled_once && (now_ns() - t_start) / 1000000u >= cfg.stall_at_ms) {
+                stalled_once = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(cfg.stall_ms));
+            }
+            const ssize_t n = write(fd, batch.buf[j.idx], j.bytes);
+            if (n != (ssize_t)j.bytes) { perror("write"); exit(2); }
+            if (j.sync) fdatasync(fd);
+            bytes_written += (uint64_t)n;
+            log_batch_release(&batch, j.idx);
+            log_kick++;
+            cv_log.notify_one();
+        }
+    });
+
+    // ---- logTask ----
+    std::thread logger([&] {
+        auto submit = [&](int idx, uint32_t bytes, bool sync) {
+            { std::lock_guard<std::mutex> lk(mu); jobs.push_back(Job{ idx, bytes, sync }); }
+            cv_write.notify_one();
+        };
+        uint64_t t_flush = now_ns();
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv_log.wait_for(lk, std::chrono::milliseconds(100), [&] { return log_kick.load() != 0; });
+                log_kick = 0;
+            }
+            if (ring.backpressure) bp_seen = true;
+
+            int idx;
+            const uint32_t tail0 = ring.tail;
+            const uint64_t a = now_ns();
+            while ((idx = log_batch_drain(&batch, &ring)) >= 0) submit(idx, LOG_BATCH_BYTES, false);
+            drain_ns += now_ns() - a;
+            drained += ring.tail - tail0;
+
+            const bool last = prod_done.load() && log_ring_fill(&ring) == 0;
+            if (last || now_ns() - t_flush >= 2000000000ull) {
+                uint32_t bytes;
+                idx = log_batch_flush(&batch, &ring, &bytes);
+                if (idx >= 0) submit(idx, bytes, true);
+                if (idx >= 0 || batch.n_blocks == 0) t_flush = now_ns();
+                if (last && batch.n_blocks == 0 && batch.n_rec == 0) break;
+            }
+        }
+        log_done = true;
+        cv_write.notify_one();
+    });
+
+    // ---- producer (measureTask) ----
+    uint64_t push_ns_max = 0, push_ns_sum = 0, accepted = 0;
+    {
+        LogRecord rec;
+        const uint64_t t0 = now_ns();
+        for (uint64_t i = 0; i < cfg.n_records; ++i) {
+            // Tijdstempel = index * periode: de terugleestest ziet elk gat
+            synth_record(i, cfg.period_us, &rec);
+
+            if (cfg.paced) {
+                const uint64_t due = t0 + i * (uint64_t)cfg.period_us * 1000u;
+                while (now_ns() < due) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            } else {
+                // Alleen in de doorvoertest: wachten tot er plek is (firmware dropt)
+                while (log_ring_fill(&ring) >= LOG_RING_LEN) std::this_thread::yield();
+            }
+
+            const uint64_t a = now_ns();
+            const bool ok = log_ring_push(&ring, &rec);
+            const uint64_t d = now_ns() - a;
+            if (d > push_ns_max) push_ns_max = d;
+            push_ns_sum += d;
+            accepted += ok ? 1u : 0u;
+
+            if ((ring.n_pushed % 64u) == 0) { log_kick++; cv_log.notify_one(); }
+        }
+        prod_done = true;
+        log_kick++;
+        cv_log.notify_one();
+    }
+
+    logger.join();
+    writer.join();
+    close(fd);
+
+    RunResult r;
+    r.secs          = (now_ns() - t_start) * 1e-9;
+    r.pushed        = ring.n_pushed;
+    r.accepted      = accepted;
+    r.dropped       = ring.n_dropped;
+    r.decimated     = ring.n_decimated;
+    r.fill_max      = ring.fill_max;
+    r.n_stalled     = batch.n_stalled;
+    r.push_ns_max   = push_ns_max;
+    r.push_ns_avg   = cfg.n_records ? (double)push_ns_sum / (double)cfg.n_records : 0.0;
+    r.bytes_written = bytes_written;
+    r.drain_ns_per_rec = drained ? (double)drain_ns / (double)drained : 0.0;
+    r.bp_seen       = bp_seen;
+    free(b0);
+    free(b1);
+    return r;
+}
+
+// =========================
+// Teruglezen
+// =========================
+struct ReadBack
+{
+    bool     ok;
+    uint64_t n_blocks, n_index_blocks, n_records, n_bad;
+    uint32_t last_dropped, last_decimated;
+    uint32_t max_gap_us;
+    double   max_err[4];   // in kwantisatiestappen
+};
+
+static ReadBack read_back(const char* path, uint32_t period_us)
+{
+    ReadBack rb;
+    memset(&rb, 0, sizeof(rb));
+    rb.ok = true;
+
+    FILE* f = fopen(path, "rb");
+    if (!f) { rb.ok = false; return rb; }
+
+    std::vector<uint8_t> blk(LOG_BLOCK_SIZE);
+    std::vector<LogRecord> rec(LOG_BLOCK_PAYLOAD);
+    std::vector<LogIndexEntry> seen;   // datablokken sinds het laatste indexblok
+    LogIndexEntry idx[LOG_INDEX_STRIDE];
+    const double scale[4] = { LOG_Q_V, LOG_Q_I, LOG_Q_I, LOG_Q_T };
+
+    uint32_t seq = 0;
+    bool have_prev = false;
+    uint32_t prev_t = 0;
+    uint64_t t64 = 0;   // t_us loopt na 71 minuten over
+    while (fread(blk.data(), 1, LOG_BLOCK_SIZE, f) == LOG_BLOCK_SIZE) {
+        if (!log_block_check(blk.data())) { rb.n_bad++; rb.ok = false; seq++; continue; }
+
+        LogBlockHeader h;
+        memcpy(&h, blk.data(), sizeof(h));
+        if (h.seq != seq++) rb.ok = false;
+        rb.last_dropped = h.n_dropped;
+        rb.last_decimated = h.n_decimated;
+
+        if (h.type == LOG_BLOCK_INDEX) {
+            // Vaste positie en precies de datablokken ervoor
+            const int n = log_block_index(blk.data(), idx, LOG_INDEX_STRIDE);
+            if ((h.seq % LOG_INDEX_STRIDE) != LOG_INDEX_STRIDE - 1u || n != (int)seen.size()) rb.ok = false;
+            for (int i = 0; i < n && i < (int)seen.size(); ++i)
+                if (memcmp(&idx[i], &seen[i], sizeof(LogIndexEntry)) != 0) rb.ok = false;
+            seen.clear();
+            rb.n_index_blocks++;
+            continue;
+        }
+
+        const int n = log_block_decode(blk.data(), rec.data(), (uint32_t)rec.size());
+        if (n <= 0) { rb.ok = false; continue; }
+        rb.n_blocks++;
+
+        LogIndexEntry e;
+        e.seq = h.seq;
+        e.t_first_us = rec[0].t_us;
+        e.t_last_us = rec[n - 1].t_us;
+        e.first_record = (uint32_t)rb.n_records;
+        seen.push_back(e);
+
+        for (int i = 0; i < n; ++i) {
+            const uint32_t t = rec[i].t_us;
+            if (have_prev) {
+                const uint32_t gap = t - prev_t;
+                if ((int32_t)gap <= 0) rb.ok = false;
+                if (gap > rb.max_gap_us) rb.max_gap_us = gap;
+                // Zonder gedropte records is het gat precies het aantal samples van het record
+                if (h.n_dropped == 0 && gap != period_us * rec[i].decim) rb.ok = false;
+                t64 += gap;
+            } else {
+                t64 = t;
+            }
+            prev_t = t;
+            have_prev = true;
+
+            // Waarde tegen het origineel
+            LogRecord ref;
+            synth_record(t64 / period_us, period_us, &ref);
+            const double got[4] = { rec[i].v_out, rec[i].i_sink, rec[i].i_source, rec[i].temp_sink_c };
+            const double want[4] = { ref.v_out, ref.i_sink, ref.i_source, ref.temp_sink_c };
+            for (int k = 0; k < 4; ++k) {
+                const double err = fabs(got[k] - want[k]) * scale[k];
+                if (err > rb.max_err[k]) rb.max_err[k] = err;
+            }
+        }
+        rb.n_records += (uint64_t)n;
+    }
+    fclose(f);
+
+    // Halve stap + float-afronding
+    for (int k = 0; k < 4; ++k) if (rb.max_err[k] > 0.51) rb.ok = false;
+    return rb;
+}
+
+// Alleen de codec, één core: cycli per record en bytes per record
+static void codec_bench(uint64_t n)
+{
+    printf("codec (%llu records, één core, signaal uit log_synth.h):\n", (unsigned long long)n);
+
+    std::vector<LogRecord> src((size_t)n);
+    for (uint64_t i = 0; i < n; ++i) synth_record(i, 1000, &src[(size_t)i]);
+
+    std::vector<uint8_t> out((size_t)n * LOG_REC_MAX_BYTES / 4 + LOG_BLOCK_SIZE);
+    std::vector<uint8_t> blk(LOG_BLOCK_SIZE);
+
+    // Zelfde blokindeling als de batcher: keyframe per blok, sluiten bij < LOG_REC_MAX_BYTES vrij
+    LogEncoder enc;
+    uint64_t bytes = 0, blocks = 0;
+    uint32_t off = sizeof(LogBlockHeader);
+    log_enc_reset(&enc);
+    const uint64_t c0 = cycles();
+    const uint64_t t0 = now_ns();
+    for (uint64_t i = 0; i < n; ++i) {
+        if (off + LOG_REC_MAX_BYTES > LOG_BLOCK_SIZE) { blocks++; off = sizeof(LogBlockHeader); log_enc_reset(&enc); }
+        const uint32_t b = log_enc_record(&enc, &src[(size_t)i], blk.data() + off);
+        off += b;
+        bytes += b;
+    }
+    const uint64_t t_ns = now_ns() - t0;
+    const uint64_t cyc = cycles() - c0;
+    blocks++;
+
+    const double file_bpr = (double)blocks * LOG_BLOCK_SIZE / (double)n;
+    printf("  payload %.2f B/record, met headers/padding %.2f B/record (+%.1f%% index)\n",
+           (double)bytes / n, file_bpr, 100.0 / LOG_INDEX_STRIDE);
+    printf("  compressie x%.2f t.o.v. %zu B ruw (%.1f MB/dag bij 1 kHz i.p.v. %.1f MB)\n",
+           sizeof(LogRecord) / file_bpr, sizeof(LogRecord),
+           file_bpr * 86400e3 / 1048576.0, sizeof(LogRecord) * 86400e3 / 1048576.0);
+    printf("  encode %.1f ns/record", (double)t_ns / n);
+    if (cyc) printf(", %.0f cycli/record (host TSC)", (double)cyc / n);
+    printf("\n");
+    check(sizeof(LogRecord) / file_bpr >= 3.0, "compressie >= 3x op een ruisig 1 kHz signaal");
+}
+
+static const char* policy_name(LogPolicy p) { return p == LOG_POLICY_DROP ? "drop" : "decimate"; }
+
+int main(int argc, char** argv)
+{
+    const char* path = "/tmp/log_bench.sbl";
+    uint64_t n_tp = 20000000;
+    uint32_t stall_ms = 3500;
+    bool keep = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-k")) { keep = true; continue; }
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) n_tp = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) stall_ms = (uint32_t)atoi(argv[++i]);
+        else path = argv[i];
+    }
+
+    printf("LogRecord %zu B, blok %u B (delta/varint, index per %u), buffer %u B, ring %u records\n\n",
+           sizeof(LogRecord), (unsigned)LOG_BLOCK_SIZE, (unsigned)LOG_INDEX_STRIDE,
+           (unsigned)LOG_BATCH_BYTES, (unsigned)LOG_RING_LEN);
+
+    // ---- 0. codec ----
+    codec_bench(2000000);
+    printf("\n");
+
+    // ---- 1. doorvoer ----
+    {
+        printf("doorvoer (%llu records, producer zonder pacing):\n", (unsigned long long)n_tp);
+        RunCfg cfg = { LOG_POLICY_DROP, n_tp, 1000, false, 0, 0 };
+        const RunResult r = run(path, cfg);
+        const ReadBack rb = read_back(path, 1000);
+        printf("  %.2f s, %.2f M records/s, %.1f MB/s naar bestand, push gem %.1f ns max %.1f us\n",
+               r.secs, r.pushed / r.secs * 1e-6, r.bytes_written / r.secs / 1048576.0,
+               r.push_ns_avg, r.push_ns_max * 1e-3);
+        printf("  vs. 1 kHz meetstroom: %.0fx marge; logTask %.1f ns/record, %.2f B/record in het bestand\n",
+               r.pushed / r.secs / 1000.0, r.drain_ns_per_rec, (double)r.bytes_written / r.pushed);
+        printf("  %llu datablokken, %llu indexblokken, max fout %.2f/%.2f/%.2f/%.2f stap\n",
+               (unsigned long long)rb.n_blocks, (unsigned long long)rb.n_index_blocks,
+               rb.max_err[0], rb.max_err[1], rb.max_err[2], rb.max_err[3]);
+        check(rb.ok && rb.n_records == n_tp && r.dropped == 0, "alle records terug: crc, volgorde, index, waarden");
+    }
+    if (keep) {
+        printf("  bewaard: %s\n", path);
+        return g_fail ? 1 : 0;
+    }
+
+    // ---- 2. 1 kHz met stall ----
+    // De eerste write komt pas als een buffer vol is (~1.6 s bij ~5 B/record); de
+    // stall raakt die write. Vangnet tot drops: vulbuffer + ring (~2.6 s bij drop,
+    // ~4.2 s met decimatie).
+    const uint32_t runtime_ms = stall_ms + 4000;
+    for (int p = 0; p < 2; ++p)
+    {
+        const LogPolicy pol = p == 0 ? LOG_POLICY_DROP : LOG_POLICY_DECIMATE;
+        printf("\n1 kHz, %u ms, kaart hangt %u ms bij de eerste write, policy %s:\n",
+               (unsigned)runtime_ms, (unsigned)stall_ms, policy_name(pol));
+        RunCfg cfg = { pol, runtime_ms, 1000, true, stall_ms, 0 };
+        const RunResult r = run(path, cfg);
+        const ReadBack rb = read_back(path, 1000);
+
+        printf("  aangeboden %llu, geschreven %llu, gedropt %llu, gedecimeerd %llu\n",
+               (unsigned long long)r.pushed, (unsigned long long)rb.n_records,
+               (unsigned long long)r.dropped, (unsigned long long)r.decimated);
+        printf("  ring max %u/%u, buffer bezet %u x, grootste gat %.1f ms, push max %.1f us\n",
+               (unsigned)r.fill_max, (unsigned)LOG_RING_LEN, (unsigned)r.n_stalled,
+               rb.max_gap_us * 1e-3, r.push_ns_max * 1e-3);
+
+        check(rb.ok, "bestand: crc, blokvolgorde, index, tijdstempels, waarden");
+        check(rb.n_records + r.dropped + r.decimated == r.pushed, "geschreven + gedropt + gedecimeerd == aangeboden");
+        check(rb.last_dropped == r.dropped && rb.last_decimated == r.decimated, "tellers in de laatste blokheader");
+        check(r.bp_seen, "backpressure gezet tijdens de stall");
+        // Producer wacht nooit: een push is een paar geheugenoperaties
+        check(r.push_ns_max < 200000u, "push nooit blokkerend (< 200 us, incl. host-scheduling)");
+        if (pol == LOG_POLICY_DECIMATE && stall_ms <= 3500)
+            check(r.dropped == 0 && rb.max_gap_us <= 8000u, "decimate: geen drops, gaten <= 8 samples");
+    }
+
+    unlink(path);
+    printf("\n%s\n", g_fail ? "FAIL" : "alle controles OK");
+    return g_fail ? 1 : 0;
+}
@@ -0,0 +1,379 @@
+// tools/log_decode.cpp - binaire log (.sbl) naar CSV of kolommen (.sbc) (host)
+//
+// Leest een log van logTask (formaat: include/log/log.h) via mmap en decodeert
+// de datablokken parallel op alle cores. Elk blok begint met een keyframe, dus
+// blokken zijn onafhankelijk; alleen de rij-offsets per blok moeten vooraf
+// bekend zijn (header n_records, prefix-som).
+//
+//   1. bloktabel: per datablok seq en t_first_us, uit de indexblokken (1 op 128
+//      blokken gelezen); strides zonder geldig indexblok via de blokheaders
+//   2. tijd: t_us loopt na 71.6 minuten over; de tabel wordt uitgepakt naar 64 bit
+//      (aanname: geen gat > 71 minuten tussen twee blokken)
+//   3. --from/--to: binary search in de tabel, alleen de geselecteerde blokken
+//      worden gelezen
+//   4. parallel: blok controleren (crc) en records tellen -> rij-offsets
+//   5. parallel: decoderen en schrijven. .sbc: pwrite per kolom op de eigen rijen
+//      (ColumnarFile, geen limiet door RAM). CSV: per groep blokken parallel
+//      formatteren, in volgorde wegschrijven.
+//
+// Beschadigde blokken (crc, magic) worden overgeslagen en geteld.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/log_decode.cpp src/log/log.cpp -o tools/build/log_decode
+//
+// Gebruik:
+//   log_decode <in.sbl> <out.csv|out.sbc> [-j threads] [--from s] [--to s]
+//   log_decode <in.sbl> --info
+//
+// --from/--to in seconden sinds het eerste record van het bestand.
+// tools/model_fit leest de .sbl zelf (via log.cpp); deze CSV is daar geen invoer.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "log/log.h"
+#include "common/columnar.h"
+#include "common/mmap_file.h"
+#include "common/thread_pool.h"
+
+// Records per datablok: elk record is minstens 5 bytes (zie log.h)
+static constexpr uint32_t MAX_BLOCK_RECORDS = LOG_BLOCK_PAYLOAD / 5u + 1u;
+
+// Blokken per CSV-groep (~800 records per blok -> ~40 MB tekst)
+static constexpr size_t CSV_GROUP_BLOCKS = 1024;
+
+struct BlockRef
+{
+  uint32_t seq;
+  uint32_t t_first_us;
+  uint64_t t0;          // t_first_us uitgepakt (us sinds het eerste blok)
+  uint32_t n_rows;      // rijen in de selectie (0 = beschadigd of buiten het venster)
+  uint64_t row0;
+};
+
+struct LogFile
+{
+  const uint8_t* data = nullptr;
+  uint32_t n_blocks = 0;
+  uint32_t n_index = 0;          // geldige indexblokken
+  uint32_t n_scanned = 0;        // datablokken zonder index (header gelezen)
+
+  const uint8_t* block(uint32_t seq) const { return data + (size_t)seq * LOG_BLOCK_SIZE; }
+  const LogBlockHeader* header(uint32_t seq) const { return (const LogBlockHeader*)block(seq); }
+};
+
+// =========================
+// Bloktabel
+// =========================
+static void build_table(LogFile& f, std::vector<BlockRef>& out)
+{
+  static LogIndexEntry ent[LOG_INDEX_STRIDE - 1u];
+
+  for (uint32_t s0 = 0; s0 < f.n_blocks; s0 += LOG_INDEX_STRIDE) {
+    const uint32_t p = s0 + LOG_INDEX_STRIDE - 1u;
+    const int n = (p < f.n_blocks) ? log_block_index(f.block(p), ent, LOG_INDEX_STRIDE - 1u) : -1;
+
+    if (n >= 0) {
+      f.n_index++;
+      for (int k = 0; k < n; ++k) out.push_back(BlockRef{ent[k].seq, ent[k].t_first_us, 0, 0, 0});
+      continue;
+    }
+
+    // Laatste (nog niet geïndexeerde) stride of beschadigd indexblok: headers lezen
+    const uint32_t end = std::min(p, f.n_blocks);
+    for (uint32_t seq = s0; seq < end; ++seq) {
+      const LogBlockHeader* h = f.header(seq);
+      if (h->magic != LOG_BLOCK_MAGIC || h->type != LOG_BLOCK_DATA || h->seq != seq) continue;
+      out.push_back(BlockRef{seq, h->t_first_us, 0, 0, 0});
+      f.n_scanned++;
+    }
+  }
+
+  // Uitpakken: verschil in uint32 rekent de wrap vanzelf goed
+  for (size_t j = 1; j < out.size(); ++j) {
+    out[j].t0 = out[j - 1].t0 + (uint32_t)(out[j].t_first_us - out[j - 1].t_first_us);
+  }
+}
+
+// =========================
+// Decoderen
+// =========================
+struct Window
+{
+  bool     active = false;
+  uint64_t from_us = 0;
+  uint64_t to_us = UINT64_MAX;
+};
+
+// Decodeert blok b; geeft het aantal records in het venster (compact naar voren
+// geschoven in rec) of -1. t64[i] = tijd sinds het eerste blok.
+static int decode_block(const LogFile& f, const BlockRef& b, const Window& w, LogRecord* rec, uint64_t* t64)
+{
+  const int n = log_block_decode(f.block(b.seq), rec, MAX_BLOCK_RECORDS);
+  if (n < 0) return -1;
+
+  int k = 0;
+  for (int i = 0; i < n; ++i) {
+    // Binnen een blok (< 71 minuten) is het verschil met t_first altijd goed
+    const uint64_t t = b.t0 + (uint32_t)(rec[i].t_us - b.t_first_us);
+    if (w.active && (t < w.from_us || t > w.to_us)) continue;
+    rec[k] = rec[i];
+    t64[k] = t;
+    ++k;
+  }
+  return k;
+}
+
+// Vaste komma uit een gekwantiseerde waarde: exact, geen printf
+static char* put_fixed(char* p, int64_t q, int decimals)
+{
+  static const int64_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  if (q < 0) { *p++ = '-'; q = -q; }
+  const int64_t ip = q / POW10[decimals];
+  int64_t fp = q % POW10[decimals];
+
+  char tmp[24];
+  int n = 0;
+  int64_t v = ip;
+  do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+  while (n) *p++ = tmp[--n];
+
+  if (decimals) {
+    *p++ = '.';
+    for (int d = decimals - 1; d >= 0; --d) { p[d] = (char)('0' + fp % 10); fp /= 10; }
+    p += decimals;
+  }
+  return p;
+}
+
+static void format_csv(const LogRecord* rec, const uint64_t* t64, int n, std::string& out)
+{
+  out.resize((size_t)n * 96);
+  char* p = &out[0];
+  for (int i = 0; i < n; ++i) {
+    const LogRecord& r = rec[i];
+    p = put_fixed(p, (int64_t)t64[i], 6);                  *p++ = ',';
+    p = put_fixed(p, r.t_us, 0);                           *p++ = ',';
+    p = put_fixed(p, llrintf(r.v_out * LOG_Q_V), 3);       *p++ = ',';
+    p = put_fixed(p, llrintf(r.i_sink * LOG_Q_I), 4);      *p++ = ',';
+    p = put_fixed(p, llrintf(r.i_source * LOG_Q_I), 4);    *p++ = ',';
+    p = put_fixed(p, llrintf(r.temp_sink_c * LOG_Q_T), 2); *p++ = ',';
+    p = put_fixed(p, r.meas_flags, 0);                     *p++ = ',';
+    p = put_fixed(p, r.decim, 0);                          *p++ = '\n';
+  }
+  out.resize((size_t)(p - &out[0]));
+}
+
+static bool ends_with(const char* s, const char* suffix)
+{
+  const size_t n = strlen(s), m = strlen(suffix);
+  return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+// =========================
+// --info
+// =========================
+static int info(const LogFile& f, const std::vector<BlockRef>& tab, size_t file_bytes)
+{
+  uint64_t n_rec = 0;
+  uint32_t n_bad = 0;
+  const LogBlockHeader* last = nullptr;
+  for (const BlockRef& b : tab) {
+    const LogBlockHeader* h = f.header(b.seq);
+    if (!log_block_check(f.block(b.seq))) { n_bad++; continue; }
+    n_rec += h->n_records;
+    last = h;
+  }
+
+  printf("%u blokken van %u B (%zu B bestand)\n", f.n_blocks, (unsigned)LOG_BLOCK_SIZE, file_bytes);
+  printf("  %zu datablokken (%u zonder index), %u indexblokken, %u beschadigd\n",
+         tab.size(), f.n_scanned, f.n_index, n_bad);
+  printf("  %llu records, %.2f B/record\n", (unsigned long long)n_rec,
+         n_rec ? (double)file_bytes / n_rec : 0.0);
+  if (!tab.empty()) {
+    printf("  tijdspan %.1f s (eerste blok t_us %u)\n", tab.back().t0 * 1e-6, tab.front().t_first_us);
+  }
+  if (last) {
+    printf("  gedropt %u, gedecimeerd %u (cumulatief, laatste blok)\n", last->n_dropped, last->n_decimated);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    fprintf(stderr, "gebruik: %s <in.sbl> <out.csv|out.sbc> [-j threads] [--from s] [--to s]\n"
+                    "         %s <in.sbl> --info\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  unsigned threads = 0;
+  Window w;
+  for (int i = 3; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "-j") == 0) threads = (unsigned)atoi(argv[i + 1]);
+    if (strcmp(argv[i], "--from") == 0) { w.active = true; w.from_us = (uint64_t)(atof(argv[i + 1]) * 1e6); }
+    if (strcmp(argv[i], "--to") == 0)   { w.active = true; w.to_us = (uint64_t)(atof(argv[i + 1]) * 1e6); }
+  }
+
+  MappedFile mf;
+  if (!mf.open(argv[1])) {
+    fprintf(stderr, "%s: niet te openen\n", argv[1]);
+    return 1;
+  }
+
+  const auto t_start = std::chrono::steady_clock::now();
+
+  LogFile f;
+  f.data = mf.data();
+  f.n_blocks = (uint32_t)(mf.size() / LOG_BLOCK_SIZE);
+
+  std::vector<BlockRef> tab;
+  build_table(f, tab);
+
+  if (strcmp(argv[2], "--info") == 0) return info(f, tab, mf.size());
+
+  // Selectie: laatste blok dat op of voor from begint t/m het laatste dat voor to begint
+  size_t j0 = 0, j1 = tab.size();
+  if (w.active) {
+    auto by_t0 = [](const BlockRef& b, uint64_t t) { return b.t0 <= t; };
+    j0 = (size_t)(std::lower_bound(tab.begin(), tab.end(), w.from_us, by_t0) - tab.begin());
+    if (j0 > 0) --j0;
+    j1 = (size_t)(std::lower_bound(tab.begin(), tab.end(), w.to_us, by_t0) - tab.begin());
+  }
+  std::vector<BlockRef> sel(tab.begin() + j0, tab.begin() + std::max(j0, j1));
+
+  WorkStealingPool pool(threads);
+
+  // Rijen per blok: header (geldig blok), randblokken van het venster decoderen
+  std::atomic<uint32_t> n_bad(0);
+  pool.parallel_for(sel.size(), 64, [&](size_t j) {
+    BlockRef& b = sel[j];
+    const bool edge = w.active && (j == 0 || j + 1 == sel.size());
+    if (edge) {
+      thread_local std::vector<LogRecord> rec(MAX_BLOCK_RECORDS);
+      thread_local std::vector<uint64_t> t64(MAX_BLOCK_RECORDS);
+      const int n = decode_block(f, b, w, rec.data(), t64.data());
+      b.n_rows = n > 0 ? (uint32_t)n : 0;
+      if (n < 0) n_bad++;
+    } else if (log_block_check(f.block(b.seq))) {
+      b.n_rows = f.header(b.seq)->n_records;
+    } else {
+      n_bad++;
+    }
+  });
+  pool.wait();
+
+  uint64_t n_rows = 0;
+  for (BlockRef& b : sel) { b.row0 = n_rows; n_rows += b.n_rows; }
+
+  std::atomic<bool> write_ok(true);
+  const char* out_path = argv[2];
+
+  if (ends_with(out_path, ".sbc")) {
+    ColumnarFile out;
+    const size_t c_ts    = out.add_column("t_s", COL_F64);
+    const size_t c_tus   = out.add_column("t_us", COL_U32);
+    const size_t c_v     = out.add_column("v_out", COL_F32);
+    const size_t c_isnk  = out.add_column("i_sink", COL_F32);
+    const size_t c_isrc  = out.add_column("i_source", COL_F32);
+    const size_t c_temp  = out.add_column("temp_sink_c", COL_F32);
+    const size_t c_flags = out.add_column("meas_flags", COL_U16);
+    const size_t c_decim = out.add_column("decim", COL_U8);
+    if (!out.create(out_path, n_rows)) {
+      fprintf(stderr, "%s: niet te schrijven\n", out_path);
+      return 1;
+    }
+
+    pool.parallel_for(sel.size(), 16, [&](size_t j) {
+      const BlockRef& b = sel[j];
+      if (b.n_rows == 0) return;
+
+      thread_local std::vector<LogRecord> rec(MAX_BLOCK_RECORDS);
+      thread_local std::vector<uint64_t> t64(MAX_BLOCK_RECORDS);
+      thread_local std::vector<double> ts(MAX_BLOCK_RECORDS);
+      thread_local std::vector<uint32_t> tus(MAX_BLOCK_RECORDS);
+      thread_local std::vector<float> v(MAX_BLOCK_RECORDS), isnk(MAX_BLOCK_RECORDS),
+                                      isrc(MAX_BLOCK_RECORDS), temp(MAX_BLOCK_RECORDS);
+      thread_local std::vector<uint16_t> flags(MAX_BLOCK_RECORDS);
+      thread_local std::vector<uint8_t> decim(MAX_BLOCK_RECORDS);
+
+      const int n = decode_block(f, b, w, rec.data(), t64.data());
+      if (n != (int)b.n_rows) { write_ok = false; return; }
+
+      for (int i = 0; i < n; ++i) {
+        ts[i]    = t64[i] * 1e-6;
+        tus[i]   = rec[i].t_us;
+        v[i]     = rec[i].v_out;
+        isnk[i]  = rec[i].i_sink;
+        isrc[i]  = rec[i].i_source;
+        temp[i]  = rec[i].temp_sink_c;
+        flags[i] = rec[i].meas_flags;
+        decim[i] = rec[i].decim;
+      }
+      bool ok = out.write_rows(c_ts, b.row0, ts.data(), n);
+      ok &= out.write_rows(c_tus, b.row0, tus.data(), n);
+      ok &= out.write_rows(c_v, b.row0, v.data(), n);
+      ok &= out.write_rows(c_isnk, b.row0, isnk.data(), n);
+      ok &= out.write_rows(c_isrc, b.row0, isrc.data(), n);
+      ok &= out.write_rows(c_temp, b.row0, temp.data(), n);
+      ok &= out.write_rows(c_flags, b.row0, flags.data(), n);
+      ok &= out.write_rows(c_decim, b.row0, decim.data(), n);
+      if (!ok) write_ok = false;
+    });
+    pool.wait();
+    if (!out.close()) write_ok = false;
+  } else {
+    FILE* out = fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "%s: niet te schrijven\n", out_path);
+      return 1;
+    }
+    static const char HDR[] = "t_s,t_us,v_out,i_sink,i_source,temp_sink_c,meas_flags,decim\n";
+    fwrite(HDR, 1, sizeof(HDR) - 1, out);
+
+    std::vector<std::string> text(CSV_GROUP_BLOCKS);
+    for (size_t g = 0; g < sel.size(); g += CSV_GROUP_BLOCKS) {
+      const size_t n_group = std::min(CSV_GROUP_BLOCKS, sel.size() - g);
+      pool.parallel_for(n_group, 8, [&](size_t k) {
+        const BlockRef& b = sel[g + k];
+        text[k].clear();
+        if (b.n_rows == 0) return;
+
+        thread_local std::vector<LogRecord> rec(MAX_BLOCK_RECORDS);
+        thread_local std::vector<uint64_t> t64(MAX_BLOCK_RECORDS);
+        const int n = decode_block(f, b, w, rec.data(), t64.data());
+        if (n != (int)b.n_rows) { write_ok = false; return; }
+        format_csv(rec.data(), t64.data(), n, text[k]);
+      });
+      pool.wait();
+
+      for (size_t k = 0; k < n_group; ++k) {
+        if (fwrite(text[k].data(), 1, text[k].size(), out) != text[k].size()) write_ok = false;
+      }
+    }
+    if (fclose(out) != 0) write_ok = false;
+  }
+
+  const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+  const double in_mb = (double)sel.size() * LOG_BLOCK_SIZE / 1e6;
+
+  printf("%zu/%zu datablokken (%u indexblokken, %u zonder index, %u beschadigd) -> %llu records in %s\n",
+         sel.size(), tab.size(), f.n_index, f.n_scanned, n_bad.load(),
+         (unsigned long long)n_rows, out_path);
+  printf("%.3f s, %.1f M records/s, %.0f MB/s gelezen, %u threads\n",
+         dt, dt > 0 ? n_rows / dt / 1e6 : 0.0, dt > 0 ? in_mb / dt : 0.0, pool.size());
+
+  if (!write_ok) {
+    fprintf(stderr, "%s: schrijffout\n", out_path);
+    return 1;
+  }
+  return 0;
+}
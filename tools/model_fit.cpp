@@ -0,0 +1,482 @@
+// tools/model_fit.cpp - offline model-identificatie uit gelogde ontlaaddata (host)
+//
+// Fit de OCV-curve en de RC-vervangingsschakeling (R0 + R1/C1) van de
+// emulatie-engine op een V/I/T-log, en schrijft een EmuModelBlob die de firmware
+// kan laden (emu_params_from_model / control_set_emu_model).
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/model_fit.cpp src/emulate/emulate.cpp src/log/log.cpp -o tools/build/model_fit
+//
+// Gebruik:
+//   model_fit <log.csv|log.sbl> <out.bin> [--header NAME out.h] [--capacity mAh]
+//             [--nominal V] [--fit-dt S] [-j threads]
+//   model_fit --synth <out.csv> [--rate HZ]      synthetische pulsontlading (bekende parameters)
+//
+// Invoer:
+//   .csv  t_s,v,i,temp_c   (i > 0 = ontladen; header-regel wordt overgeslagen)
+//   .sbl  binaire log van logTask (log/log.h), direct gedecodeerd met log.cpp;
+//         i = i_sink - i_source. De CSV van log_decode heeft andere kolommen en
+//         wordt geweigerd: geef de .sbl zelf op.
+//
+// Werkwijze:
+//   1. mmap + parallel parsen in chunks (regelgrenzen), parallel decimeren naar fit-dt
+//   2. SOC via coulomb counting (capaciteit = totale lading, of --capacity)
+//   3. kleinste kwadraten op het verschilmodel (OCV valt weg):
+//        -dv[k] = a*(-dv[k-1]) + b*di[k] + c*di[k-1] + e*i[k] + d
+//      (e*i + d vangen de OCV-helling op: dOCV is evenredig met de stroom) met dezelfde discretisatie als emu_step (v_rc[k] volgt i[k]):
+//        b = R0 + (1-a)*R1,  c = -a*R0
+//      => R0 = -c/a, R1 = (b - R0)/(1-a), tau = -dt/ln(a), C1 = tau/R1
+//   4. OCV(k) = v + R0*i + v_rc, gebind naar CURVE_LEN punten van SOC 100% -> 0%
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "emulate/emulate.h"
+#include "log/log.h"
+#include "common/mmap_file.h"
+#include "common/thread_pool.h"
+
+struct Trace
+{
+  std::vector<double> t;
+  std::vector<float> v, i, temp;
+
+  size_t size() const { return t.size(); }
+  void reserve(size_t n) { t.reserve(n); v.reserve(n); i.reserve(n); temp.reserve(n); }
+  void push(double ts, float vv, float ii, float tt) { t.push_back(ts); v.push_back(vv); i.push_back(ii); temp.push_back(tt); }
+};
+
+// ---------------- Parsing ----------------
+// Eenvoudige decimale parser: sneller dan strtod en genoeg voor logdata.
+static inline const char* parse_num(const char* p, const char* end, double& out)
+{
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) { neg = (*p == '-'); ++p; }
+
+  double v = 0.0;
+  bool any = false;
+  while (p < end && *p >= '0' && *p <= '9') { v = v * 10.0 + (*p - '0'); ++p; any = true; }
+  if (p < end && *p == '.') {
+    ++p;
+    double scale = 0.1;
+    while (p < end && *p >= '0' && *p <= '9') { v += (*p - '0') * scale; scale *= 0.1; ++p; any = true; }
+  }
+  if (any && p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool eneg = false;
+    if (p < end && (*p == '-' || *p == '+')) { eneg = (*p == '-'); ++p; }
+    int e = 0;
+    while (p < end && *p >= '0' && *p <= '9') { e = e * 10 + (*p - '0'); ++p; }
+    v *= pow(10.0, eneg ? -e : e);
+  }
+  out = neg ? -v : v;
+  return any ? p : nullptr;
+}
+
+static void parse_csv_chunk(const char* p, const char* end, Trace& out)
+{
+  out.reserve((size_t)(end - p) / 28);
+  while (p < end) {
+    const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+    if (!eol) eol = end;
+
+    double f[4];
+    const char* q = p;
+    int n = 0;
+    for (; n < 4; ++n) {
+      q = parse_num(q, eol, f[n]);
+      if (!q) break;
+      if (n < 3) {
+        if (q >= eol || *q != ',') { ++n; break; }
+        ++q;
+      }
+    }
+    if (n >= 3) out.push(f[0], (float)f[1], (float)f[2], n >= 4 ? (float)f[3] : 25.0f);
+    p = eol + 1;
+  }
+}
+
+// Records per datablok: elk record is minstens 5 bytes (zie log.h)
+static constexpr uint32_t SBL_MAX_RECORDS = LOG_BLOCK_PAYLOAD / 5u + 1u;
+
+static bool load_trace(const char* path, WorkStealingPool& pool, Trace& tr)
+{
+  MappedFile mf;
+  if (!mf.open(path)) {
+    fprintf(stderr, "kan %s niet openen\n", path);
+    return false;
+  }
+  const char* base = (const char*)mf.data();
+  const size_t size = mf.size();
+
+  const std::string sp(path);
+  const bool sbl = sp.size() > 4 && sp.compare(sp.size() - 4, 4, ".sbl") == 0;
+
+  if (sbl) {
+    // Datablokken zijn los te decoderen (keyframe per blok); index- en beschadigde
+    // blokken geven -1 en tellen niet mee. Eerst tellen, dan op de eigen rijen schrijven.
+    const uint8_t* blocks = (const uint8_t*)base;
+    const size_t n_blocks = size / LOG_BLOCK_SIZE;
+    std::vector<uint32_t> cnt(n_blocks, 0), t_last(n_blocks, 0);
+    pool.parallel_for(n_blocks, 16, [&](size_t j) {
+      thread_local std::vector<LogRecord> rec(SBL_MAX_RECORDS);
+      const int n = log_block_decode(blocks + j * LOG_BLOCK_SIZE, rec.data(), SBL_MAX_RECORDS);
+      if (n <= 0) return;
+      cnt[j] = (uint32_t)n;
+      t_last[j] = rec[n - 1].t_us;
+    });
+
+    std::vector<size_t> off(n_blocks + 1, 0);
+    for (size_t j = 0; j < n_blocks; ++j) off[j + 1] = off[j] + cnt[j];
+    const size_t n = off[n_blocks];
+    tr.t.resize(n); tr.v.resize(n); tr.i.resize(n); tr.temp.resize(n);
+
+    // t_us is 32-bit en loopt na ~71 min over: eerst per record delta, dan sequentieel optellen
+    pool.parallel_for(n_blocks, 16, [&](size_t j) {
+      if (!cnt[j]) return;
+      thread_local std::vector<LogRecord> rec(SBL_MAX_RECORDS);
+      log_block_decode(blocks + j * LOG_BLOCK_SIZE, rec.data(), SBL_MAX_RECORDS);
+
+      uint32_t prev = rec[0].t_us;   // eerste record van het bestand: delta 0
+      for (size_t p = j; p-- > 0;) {
+        if (cnt[p]) { prev = t_last[p]; break; }
+      }
+      for (uint32_t r = 0; r < cnt[j]; ++r) {
+        const size_t k = off[j] + r;
+        tr.v[k] = rec[r].v_out;
+        tr.i[k] = rec[r].i_sink - rec[r].i_source;
+        tr.temp[k] = rec[r].temp_sink_c;
+        tr.t[k] = (double)(uint32_t)(rec[r].t_us - prev) * 1e-6;
+        prev = rec[r].t_us;
+      }
+    });
+    for (size_t k = 1; k < n; ++k) tr.t[k] += tr.t[k - 1];
+    return n > 0;
+  }
+
+  static const char DECODE_HDR[] = "t_s,t_us,";
+  if (size >= sizeof(DECODE_HDR) - 1 && memcmp(base, DECODE_HDR, sizeof(DECODE_HDR) - 1) == 0) {
+    fprintf(stderr, "%s: CSV van log_decode (andere kolommen); geef de .sbl zelf op\n", path);
+    return false;
+  }
+
+  // CSV: chunkgrenzen naar de volgende regel schuiven
+  const size_t n_chunks = std::max<size_t>(1, std::min<size_t>(size / (1 << 20) + 1, pool.size() * 8));
+  std::vector<const char*> bounds(n_chunks + 1);
+  bounds[0] = base;
+  bounds[n_chunks] = base + size;
+  for (size_t c = 1; c < n_chunks; ++c) {
+    const char* b = base + size * c / n_chunks;
+    const char* nl = (const char*)memchr(b, '\n', (size_t)(base + size - b));
+    bounds[c] = nl ? nl + 1 : base + size;
+    if (bounds[c] < bounds[c - 1]) bounds[c] = bounds[c - 1];
+  }
+
+  std::vector<Trace> parts(n_chunks);
+  pool.parallel_for(n_chunks, 1, [&](size_t c) { parse_csv_chunk(bounds[c], bounds[c + 1], parts[c]); });
+
+  std::vector<size_t> off(n_chunks + 1, 0);
+  for (size_t c = 0; c < n_chunks; ++c) off[c + 1] = off[c] + parts[c].size();
+  tr.t.resize(off[n_chunks]); tr.v.resize(off[n_chunks]); tr.i.resize(off[n_chunks]); tr.temp.resize(off[n_chunks]);
+  pool.parallel_for(n_chunks, 1, [&](size_t c) {
+    std::copy(parts[c].t.begin(), parts[c].t.end(), tr.t.begin() + off[c]);
+    std::copy(parts[c].v.begin(), parts[c].v.end(), tr.v.begin() + off[c]);
+    std::copy(parts[c].i.begin(), parts[c].i.end(), tr.i.begin() + off[c]);
+    std::copy(parts[c].temp.begin(), parts[c].temp.end(), tr.temp.begin() + off[c]);
+  });
+  return tr.size() > 0;
+}
+
+// ---------------- Decimatie ----------------
+static Trace decimate(const Trace& in, size_t factor, WorkStealingPool& pool)
+{
+  if (factor <= 1) return in;
+  const size_t n = in.size() / factor;
+  Trace out;
+  out.t.resize(n); out.v.resize(n); out.i.resize(n); out.temp.resize(n);
+
+  pool.parallel_for(n, 4096, [&](size_t k) {
+    double sv = 0, si = 0, st = 0;
+    const size_t b = k * factor;
+    for (size_t j = b; j < b + factor; ++j) { sv += in.v[j]; si += in.i[j]; st += in.temp[j]; }
+    out.t[k] = in.t[b + factor - 1];
+    out.v[k] = (float)(sv / factor);
+    out.i[k] = (float)(si / factor);
+    out.temp[k] = (float)(st / factor);
+  });
+  return out;
+}
+
+// ---------------- Kleinste kwadraten ----------------
+static constexpr int NP = 5;
+
+struct Normal
+{
+  double A[NP][NP] = {};
+  double b[NP] = {};
+  size_t n = 0;
+
+  void add(const double x[NP], double y)
+  {
+    for (int r = 0; r < NP; ++r) {
+      for (int c = 0; c < NP; ++c) A[r][c] += x[r] * x[c];
+      b[r] += x[r] * y;
+    }
+    ++n;
+  }
+  void merge(const Normal& o)
+  {
+    for (int r = 0; r < NP; ++r) {
+      for (int c = 0; c < NP; ++c) A[r][c] += o.A[r][c];
+      b[r] += o.b[r];
+    }
+    n += o.n;
+  }
+};
+
+static bool solve(Normal ne, double th[NP])
+{
+  // Gauss-eliminatie met partiële pivotering
+  for (int c = 0; c < NP; ++c) {
+    int piv = c;
+    for (int r = c + 1; r < NP; ++r) if (fabs(ne.A[r][c]) > fabs(ne.A[piv][c])) piv = r;
+    if (fabs(ne.A[piv][c]) < 1e-18) return false;
+    if (piv != c) {
+      for (int k = 0; k < NP; ++k) std::swap(ne.A[c][k], ne.A[piv][k]);
+      std::swap(ne.b[c], ne.b[piv]);
+    }
+    for (int r = c + 1; r < NP; ++r) {
+      const double f = ne.A[r][c] / ne.A[c][c];
+      for (int k = c; k < NP; ++k) ne.A[r][k] -= f * ne.A[c][k];
+      ne.b[r] -= f * ne.b[c];
+    }
+  }
+  for (int r = NP - 1; r >= 0; --r) {
+    double s = ne.b[r];
+    for (int k = r + 1; k < NP; ++k) s -= ne.A[r][k] * th[k];
+    th[r] = s / ne.A[r][r];
+  }
+  return true;
+}
+
+// ---------------- Synthetische data ----------------
+static int synth(const char* path, double rate_hz)
+{
+  CurveData curves;
+  emu_default_curves(&curves);
+  EmuParams p;
+  emu_params_from_curves(&p, &curves, 0, 4.2f, 3000.0f);
+  p.r0_ohm = 0.045f;
+  p.r1_ohm = 0.030f;
+  p.c1_f = 800.0f;
+
+  EmuState s;
+  emu_init(&s, &p, 1.0f);
+
+  FILE* f = fopen(path, "w");
+  if (!f) return 1;
+  fprintf(f, "t_s,v,i,temp_c\n");
+
+  std::mt19937 rng(1);
+  std::normal_distribution<float> nv(0.0f, 0.001f), ni(0.0f, 0.001f);
+
+  const double dt = 1.0 / rate_hz;
+  size_t n = 0;
+  for (double t = 0.0; s.soc > 0.0f; t += dt, ++n) {
+    // 1 A basis, 3 A puls van 10 s elke 60 s
+    const float i = (fmod(t, 60.0) < 10.0) ? 3.0f : 1.0f;
+    emu_step(&s, &p, i, (float)dt);
+    fprintf(f, "%.4f,%.4f,%.4f,25.0\n", t, s.v_term + nv(rng), i + ni(rng));
+  }
+  fclose(f);
+  fprintf(stderr, "%zu samples, verwacht: R0=%.4f R1=%.4f C1=%.1f cap=%.0f mAh\n",
+          n, p.r0_ohm, p.r1_ohm, p.c1_f, p.capacity_mAh);
+  return 0;
+}
+
+// ---------------- Main ----------------
+int main(int argc, char** argv)
+{
+  if (argc >= 3 && !strcmp(argv[1], "--synth")) {
+    double rate = 100.0;
+    for (int k = 3; k + 1 < argc; ++k) if (!strcmp(argv[k], "--rate")) rate = atof(argv[k + 1]);
+    return synth(argv[2], rate);
+  }
+  if (argc < 3) {
+    fprintf(stderr, "gebruik: %s <log.csv|log.sbl> <out.bin> [--header NAME out.h] [--capacity mAh] "
+                    "[--nominal V] [--fit-dt S] [-j N]\n", argv[0]);
+    return 2;
+  }
+
+  const char* header_name = nullptr;
+  const char* header_path = nullptr;
+  double capacity_mAh = 0.0, nominal_v = 0.0, fit_dt = 1.0;
+  unsigned threads = 0;
+  for (int k = 3; k < argc; ++k) {
+    if (!strcmp(argv[k], "--header") && k + 2 < argc) { header_name = argv[k + 1]; header_path = argv[k + 2]; k += 2; }
+    else if (!strcmp(argv[k], "--capacity") && k + 1 < argc) capacity_mAh = atof(argv[++k]);
+    else if (!strcmp(argv[k], "--nominal") && k + 1 < argc) nominal_v = atof(argv[++k]);
+    else if (!strcmp(argv[k], "--fit-dt") && k + 1 < argc) fit_dt = atof(argv[++k]);
+    else if (!strcmp(argv[k], "-j") && k + 1 < argc) threads = (unsigned)atoi(argv[++k]);
+  }
+
+  WorkStealingPool pool(threads);
+  const auto t0 = std::chrono::steady_clock::now();
+
+  Trace raw;
+  if (!load_trace(argv[1], pool, raw) || raw.size() < 16) {
+    fprintf(stderr, "geen bruikbare samples in %s\n", argv[1]);
+    return 1;
+  }
+  const auto t_load = std::chrono::steady_clock::now();
+
+  const double dt_raw = (raw.t.back() - raw.t.front()) / (double)(raw.size() - 1);
+  size_t factor = (size_t)llround(fit_dt / dt_raw);
+  if (factor < 1) factor = 1;
+  const Trace tr = decimate(raw, factor, pool);
+  const size_t n = tr.size();
+  const double dt = dt_raw * (double)factor;
+
+  // Capaciteit = totale lading (log van vol naar leeg), tenzij opgegeven
+  std::vector<double> q(n, 0.0);
+  for (size_t k = 1; k < n; ++k) q[k] = q[k - 1] + 0.5 * (tr.i[k] + tr.i[k - 1]) * dt / 3600.0;
+  const double cap_ah = (capacity_mAh > 0.0) ? capacity_mAh * 1e-3 : q.back();
+  if (cap_ah <= 0.0) {
+    fprintf(stderr, "geen netto ontlading in de log\n");
+    return 1;
+  }
+
+  // Verschilmodel: parallel normaalvergelijkingen per blok, daarna reduceren
+  const size_t blk = 8192;
+  const size_t n_blk = (n + blk - 1) / blk;
+  std::vector<Normal> partial(n_blk);
+  pool.parallel_for(n_blk, 1, [&](size_t b) {
+    const size_t k0 = std::max<size_t>(2, b * blk);
+    const size_t k1 = std::min(n, (b + 1) * blk);
+    for (size_t k = k0; k < k1; ++k) {
+      const double y  = -(double)(tr.v[k] - tr.v[k - 1]);
+      const double x[NP] = {
+        -(double)(tr.v[k - 1] - tr.v[k - 2]),
+        (double)(tr.i[k] - tr.i[k - 1]),
+        (double)(tr.i[k - 1] - tr.i[k - 2]),
+        (double)tr.i[k],
+        1.0,
+      };
+      partial[b].add(x, y);
+    }
+  });
+  Normal ne;
+  for (const auto& p : partial) ne.merge(p);
+
+  double th[NP] = {};
+  if (!solve(ne, th) || th[0] <= 0.0 || th[0] >= 1.0) {
+    fprintf(stderr, "fit mislukt: te weinig stroomvariatie in de log (a=%.4f)\n", th[0]);
+    return 1;
+  }
+
+  const double a = th[0], b = th[1], c = th[2];
+  const double r0 = -c / a;
+  const double r1 = (b - r0) / (1.0 - a);
+  const double tau = -dt / log(a);
+  const double c1 = (r1 > 0.0) ? tau / r1 : 0.0;
+
+  // OCV reconstrueren en binnen naar CURVE_LEN punten (SOC 100% -> 0%)
+  const double alpha = exp(-dt / tau);
+  double v_rc = 0.0, temp_sum = 0.0;
+  std::vector<double> bin_sum(CURVE_LEN, 0.0);
+  std::vector<size_t> bin_n(CURVE_LEN, 0);
+  for (size_t k = 0; k < n; ++k) {
+    v_rc = alpha * v_rc + (1.0 - alpha) * r1 * tr.i[k];
+    const double ocv = tr.v[k] + r0 * tr.i[k] + v_rc;
+    const double soc = 1.0 - q[k] / cap_ah;
+    const long j = lround((1.0 - soc) * (CURVE_LEN - 1));
+    if (j >= 0 && j < CURVE_LEN) { bin_sum[j] += ocv; bin_n[j]++; }
+    temp_sum += tr.temp[k];
+  }
+
+  double ocv_pts[CURVE_LEN];
+  for (int j = 0; j < CURVE_LEN; ++j) ocv_pts[j] = bin_n[j] ? bin_sum[j] / bin_n[j] : NAN;
+  // Lege bins (log begon niet vol / eindigde niet leeg): lineair doortrekken
+  for (int j = 0; j < CURVE_LEN; ++j) {
+    if (!std::isnan(ocv_pts[j])) continue;
+    int lo = j - 1, hi = j + 1;
+    while (lo >= 0 && std::isnan(ocv_pts[lo])) --lo;
+    while (hi < CURVE_LEN && std::isnan(ocv_pts[hi])) ++hi;
+    if (lo >= 0 && hi < CURVE_LEN) ocv_pts[j] = ocv_pts[lo] + (ocv_pts[hi] - ocv_pts[lo]) * (j - lo) / (hi - lo);
+    else if (lo >= 0) ocv_pts[j] = ocv_pts[lo];
+    else if (hi < CURVE_LEN) ocv_pts[j] = ocv_pts[hi];
+    else ocv_pts[j] = 0.0;
+  }
+
+  EmuModelBlob m;
+  memset(&m, 0, sizeof(m));
+  m.magic = EMU_MODEL_MAGIC;
+  m.version = EMU_MODEL_VERSION;
+  m.curve_len = CURVE_LEN;
+  m.nominal_voltage = (float)(nominal_v > 0.0 ? nominal_v : ocv_pts[0]);
+  m.capacity_mAh = (float)(cap_ah * 1e3);
+  m.r0_ohm = (float)r0;
+  m.r1_ohm = (float)std::max(0.0, r1);
+  m.c1_f = (float)c1;
+  for (int j = 0; j < CURVE_LEN; ++j) {
+    const long u = lround(ocv_pts[j] / m.nominal_voltage / EMU_MODEL_CURVE_UNIT);
+    m.curve[j] = (int16_t)std::min(10000L, std::max(0L, u));
+  }
+  emu_model_seal(&m);
+
+  // Validatie: gefit model opnieuw simuleren op de gemeten stroom
+  EmuParams ep;
+  emu_params_from_model(&ep, &m);
+  EmuState es;
+  emu_init(&es, &ep, 1.0f - q[0] / cap_ah);
+  // De steile staart (SOC < 10%) apart: daar domineert de curve-resolutie
+  double se = 0.0, se_mid = 0.0;
+  size_t n_mid = 0;
+  for (size_t k = 1; k < n; ++k) {
+    const float v = emu_step(&es, &ep, tr.i[k], (float)dt);
+    const double e2 = (v - tr.v[k]) * (double)(v - tr.v[k]);
+    se += e2;
+    if (es.soc > 0.1f) { se_mid += e2; ++n_mid; }
+  }
+  const auto t_end = std::chrono::steady_clock::now();
+
+  FILE* f = fopen(argv[2], "wb");
+  if (!f || fwrite(&m, sizeof(m), 1, f) != 1) {
+    fprintf(stderr, "kan %s niet schrijven\n", argv[2]);
+    return 1;
+  }
+  fclose(f);
+
+  if (header_name) {
+    FILE* h = fopen(header_path, "w");
+    if (!h) return 1;
+    const uint8_t* b = (const uint8_t*)&m;
+    fprintf(h, "// gegenereerd door tools/model_fit uit %s\n#pragma once\n#include <stdint.h>\n\n", argv[1]);
+    fprintf(h, "alignas(4) static const uint8_t %s[%zu] = {", header_name, sizeof(m));
+    for (size_t k = 0; k < sizeof(m); ++k)
+      fprintf(h, "%s0x%02X%s", (k % 12 == 0) ? "\n  " : "", b[k], (k + 1 < sizeof(m)) ? "," : "");
+    fprintf(h, "\n};\n");
+    fclose(h);
+  }
+
+  printf("samples: %zu ruw, %zu na decimatie (dt=%.3f s), T_gem=%.1f C\n", raw.size(), n, dt, temp_sum / n);
+  printf("capaciteit: %.1f mAh, nominaal: %.3f V\n", m.capacity_mAh, m.nominal_voltage);
+  printf("R0=%.4f ohm  R1=%.4f ohm  C1=%.1f F  (tau=%.1f s)\n", r0, r1, c1, tau);
+  printf("curve [%%]:");
+  for (int j = 0; j < CURVE_LEN; ++j) printf("%s%.2f", j ? "," : " ", m.curve[j] * (EMU_MODEL_CURVE_UNIT * 100.0));
+  printf("\nRMS fout model vs log: %.2f mV (SOC > 10%%: %.2f mV)\n",
+         sqrt(se / (n - 1)) * 1e3, n_mid ? sqrt(se_mid / n_mid) * 1e3 : 0.0);
+  printf("tijd: laden %.3f s, fit %.3f s (%u threads)\n",
+         std::chrono::duration<double>(t_load - t0).count(),
+         std::chrono::duration<double>(t_end - t_load).count(), pool.size());
+  return 0;
+}
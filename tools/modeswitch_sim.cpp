@@ -0,0 +1,145 @@
+// tools/modeswitch_sim.cpp - mode-switch sequencer tegen het plant model (host)
+//
+// Draait src/control/modeswitch.cpp op de meetstroom (1 kHz) met het plant model
+// voor source en sink, een weerstandslast / DUT-bron en een relais dat pas na de
+// I2C-write (volgende actuatiecyclus) als toegepast gemeld wordt. Rapporteert de
+// fasetijden per wissel.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude -Itools tools/modeswitch_sim.cpp src/control/modeswitch.cpp -o tools/build/modeswitch_sim
+//
+// Exit code 0 als alle wissels slagen.
+
+#include <math.h>
+#include <stdio.h>
+
+#include "control/modeswitch.h"
+#include "sim/plant.h"
+
+static constexpr float DT       = 0.001f;
+static constexpr float R_LOAD   = 5.0f;    // last op de source-uitgang
+static constexpr float V_DUT    = 5.0f;    // DUT-bron in sink mode
+static constexpr float V_FULL   = 15.0f;   // CTRL_SOURCE_V_FULL
+static constexpr float I_FULL   = 10.0f;   // CTRL_SINK_I_FULL
+
+struct Rig
+{
+  PlantParams pp;
+  PlantState  src, snk;
+  SimPI       pi;
+  PowerMode   mode = POWER_MODE_SOURCE;   // mode_current
+  PowerMode   relay = POWER_MODE_SOURCE;  // fysieke relaisstand
+  PowerMode   applied = POWER_MODE_SOURCE;
+  float       duty = 0.0f;
+  float       v = 0.0f, i_src = 0.0f, i_snk = 0.0f;
+  float       sp_cmd = 0.0f;
+
+  void step_plant()
+  {
+    const bool src_on = (relay != POWER_MODE_SINK);
+    v = plant_step_source(src, pp, src_on ? duty : 0.0f, src_on ? v / R_LOAD : 0.0f);
+    i_src = src_on ? v / R_LOAD : 0.0f;
+    i_snk = plant_step_sink(snk, pp, src_on ? 0.0f : duty, src_on ? 0.0f : V_DUT);
+  }
+
+  float meas(PowerMode m) const { return (m == POWER_MODE_SINK) ? i_snk : v; }
+  float full(PowerMode m) const { return (m == POWER_MODE_SINK) ? I_FULL : V_FULL; }
+
+  float regulate(PowerMode m, float sp)
+  {
+    return pi.step(sp, meas(m), DT, sp / full(m));
+  }
+};
+
+static float target_of(PowerMode m, float source_v, float sink_a, float emu_v)
+{
+  return (m == POWER_MODE_SINK) ? sink_a : (m == POWER_MODE_SOURCE) ? source_v : emu_v;
+}
+
+int main()
+{
+  Rig rig;
+  plant_init(rig.src, rig.pp, DT);
+  plant_init(rig.snk, rig.pp, DT);
+  rig.pi.kp = 0.05f;
+  rig.pi.ki = 40.0f;
+
+  ModeSwitchConfig cfg;
+  ms_config_default(&cfg);
+
+  struct Step { PowerMode to; float source_v, sink_a, emu_v; };
+  const Step plan[] = {
+    {POWER_MODE_EMULATE, 10.0f, 2.0f, 3.7f},   // source 10 V -> emulate 3.7 V (geen relais)
+    {POWER_MODE_SINK,    10.0f, 2.0f, 3.7f},   // emulate -> sink 2 A
+    {POWER_MODE_SOURCE,   5.0f, 5.0f, 3.7f},   // sink -> source 5 V
+    {POWER_MODE_SINK,     5.0f, 5.0f, 3.7f},   // source -> sink 5 A
+    {POWER_MODE_EMULATE,  5.0f, 5.0f, 4.1f},   // sink -> emulate
+  };
+
+  // Inregelen op source 10 V
+  for (int k = 0; k < 200; ++k) {
+    rig.duty = rig.regulate(POWER_MODE_SOURCE, 10.0f);
+    rig.sp_cmd = 10.0f;
+    rig.step_plant();
+  }
+
+  printf("%-18s %8s %8s %8s %8s %8s  %s\n", "wissel", "down", "settle", "switch", "up", "totaal", "resultaat");
+  int failures = 0;
+  for (const Step& st : plan) {
+    ModeSwitch ms{};
+    const PowerMode from = rig.mode;
+    const bool relays = (from == POWER_MODE_SINK) != (st.to == POWER_MODE_SINK);
+    const float duty0 = rig.duty;
+    const float sp0 = relays ? 0.0f : rig.meas(st.to);
+    ms_start(&ms, &cfg, from, st.to, relays, duty0);
+
+    for (int k = 0; k < 2000 && ms_active(&ms); ++k) {
+      ModeSwitchInput in;
+      in.dt_s = DT;
+      in.i_abs = fmaxf(fabsf(rig.i_src), fabsf(rig.i_snk));
+      in.applied_mode = rig.applied;
+      in.track_err = fabsf(rig.sp_cmd - rig.meas(st.to)) / rig.full(st.to);
+
+      ms_step(&ms, &cfg, &in);
+
+      // Actuation: relais volgt één cyclus later en meldt het dan als toegepast
+      rig.relay = rig.applied;
+      rig.applied = ms_active(&ms) ? ms.relay_mode : st.to;
+
+      const float target = target_of(st.to, st.source_v, st.sink_a, st.emu_v);
+      switch (ms.phase) {
+        case MS_RAMP_DOWN: rig.duty = duty0 * ms.duty_scale; break;
+        case MS_SETTLE:
+        case MS_SWITCH:    rig.duty = 0.0f; break;
+        default: {
+          if (ms.reinit) rig.pi.integ = 0.0f;
+          const float ramp = (ms.phase == MS_RAMP_UP) ? ms.ramp : (ms.phase == MS_IDLE ? 1.0f : 0.0f);
+          rig.sp_cmd = sp0 + (target - sp0) * ramp;
+          rig.duty = rig.regulate(st.to, rig.sp_cmd);
+          break;
+        }
+      }
+      rig.step_plant();
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%d -> %d", (int)from, (int)st.to);
+    const bool ok = (ms.result == MS_RESULT_OK);
+    printf("%-18s %6.1fms %6.1fms %6.1fms %6.1fms %6.1fms  %s (%.3f -> %.3f)\n", name,
+           ms.phase_time_s[MS_RAMP_DOWN] * 1e3, ms.phase_time_s[MS_SETTLE] * 1e3,
+           ms.phase_time_s[MS_SWITCH] * 1e3,
+           (ms.phase_time_s[MS_REINIT] + ms.phase_time_s[MS_RAMP_UP]) * 1e3, ms.t_total_s * 1e3,
+           ok ? "OK" : "MISLUKT", sp0, rig.meas(st.to));
+    if (!ok) failures++;
+    rig.mode = ok ? st.to : from;
+
+    // Even doorregelen in de nieuwe mode
+    for (int k = 0; k < 100; ++k) {
+      rig.sp_cmd = target_of(rig.mode, st.source_v, st.sink_a, st.emu_v);
+      rig.duty = rig.regulate(rig.mode, rig.sp_cmd);
+      rig.step_plant();
+    }
+  }
+  printf("(modes: 0=source 1=sink 2=emulate)\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+// tools/profile_compile.cpp - CSV load-profiel -> binair sequencer-profiel (host)
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/profile_compile.cpp src/control/sequencer.cpp -o tools/build/profile_compile
+//
+// Gebruik:
+//   profile_compile <in.csv> <out.bin>              binair profiel (bv. voor een data-partitie)
+//   profile_compile <in.csv> <out.h> --header NAME  C-array voor in flash (const, geen RAM)
+//   profile_compile <in.csv> - --trace STEP_US      setpoint-trace naar stdout (controle)
+//   --tick US                                       regelperiode (standaard SEQ_TICK_US = 1000)
+//
+// CSV (één regel per segment, '#' = commentaar):
+//   mode,source|sink          verplicht, eerste regel
+//   step,<waarde>,<duur>      waarde in V (source) of A (sink)
+//   ramp,<waarde>,<duur>
+//   hold,,<duur>
+//   label,<naam>              markeert het volgende segment als loop-doel
+//   loop,<naam|index>,<n>     body n keer doorlopen (0 = eindeloos)
+//
+// Duur met eenheid: 500us, 4.5ms, 2s (zonder eenheid = ms).
+//
+// De firmware evalueert het profiel één keer per regelstap. Een step/ramp/hold
+// korter dan die periode wordt geweigerd (zou gealiast worden); een duur die geen
+// veelvoud van de periode is geeft een waarschuwing (flank tot 1 tick jitter).
+// --trace met STEP_US = de regelperiode laat zien wat de firmware echt afspeelt.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "control/sequencer.h"
+
+static std::string trim(const std::string& s)
+{
+  size_t b = s.find_first_not_of(" \t\r\n");
+  size_t e = s.find_last_not_of(" \t\r\n");
+  return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+}
+
+static std::vector<std::string> split_csv(const std::string& s)
+{
+  std::vector<std::string> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) out.push_back(trim(item));
+  return out;
+}
+
+static bool parse_duration_us(const std::string& s, uint32_t& out)
+{
+  char* end = nullptr;
+  const double v = strtod(s.c_str(), &end);
+  if (end == s.c_str() || v < 0) return false;
+
+  const std::string unit = trim(end);
+  double us = 0;
+  if (unit == "us") us = v;
+  else if (unit == "ms" || unit.empty()) us = v * 1e3;
+  else if (unit == "s") us = v * 1e6;
+  else return false;
+
+  if (us > 4294967295.0) return false;
+  out = (uint32_t)llround(us);
+  return true;
+}
+
+static bool parse_milli(const std::string& s, int32_t& out)
+{
+  char* end = nullptr;
+  const double v = strtod(s.c_str(), &end);
+  if (end == s.c_str() || fabs(v) > 2e6) return false;
+  out = (int32_t)llround(v * 1000.0);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    fprintf(stderr, "gebruik: %s <in.csv> <out> [--header NAME | --trace STEP_US] [--tick US]\n", argv[0]);
+    return 2;
+  }
+
+  const char* header_name = nullptr;
+  uint32_t trace_step_us = 0;
+  uint32_t tick_us = SEQ_TICK_US;
+  for (int i = 3; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "--header") == 0) header_name = argv[i + 1];
+    if (strcmp(argv[i], "--trace") == 0) trace_step_us = (uint32_t)atol(argv[i + 1]);
+    if (strcmp(argv[i], "--tick") == 0) tick_us = (uint32_t)atol(argv[i + 1]);
+  }
+  if (tick_us == 0) tick_us = 1;
+
+  std::ifstream in(argv[1]);
+  if (!in) {
+    fprintf(stderr, "kan %s niet openen\n", argv[1]);
+    return 1;
+  }
+
+  SeqHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = SEQ_MAGIC;
+  hdr.version = SEQ_VERSION;
+
+  std::vector<SeqSegment> segs;
+  std::map<std::string, uint16_t> labels;
+  bool have_mode = false;
+  uint8_t next_loop_id = 0;
+
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    const size_t hash = line.find('#');
+    if (hash != std::string::npos) line.resize(hash);
+    line = trim(line);
+    if (line.empty()) continue;
+
+    const std::vector<std::string> f = split_csv(line);
+    const std::string& kind = f[0];
+
+    auto fail = [&](const char* msg) {
+      fprintf(stderr, "%s:%d: %s\n", argv[1], lineno, msg);
+      return 1;
+    };
+
+    if (kind == "mode") {
+      if (f.size() != 2) return fail("verwacht: mode,source|sink");
+      if (f[1] == "source") hdr.mode = SEQ_MODE_SOURCE;
+      else if (f[1] == "sink") hdr.mode = SEQ_MODE_SINK;
+      else return fail("onbekende mode");
+      have_mode = true;
+      continue;
+    }
+    if (!have_mode) return fail("eerste regel moet 'mode,...' zijn");
+
+    if (kind == "label") {
+      if (f.size() != 2) return fail("verwacht: label,<naam>");
+      labels[f[1]] = (uint16_t)segs.size();
+      continue;
+    }
+
+    SeqSegment s;
+    memset(&s, 0, sizeof(s));
+
+    if (kind == "step" || kind == "ramp") {
+      if (f.size() != 3) return fail("verwacht: step|ramp,<waarde>,<duur>");
+      s.type = (kind == "step") ? SEQ_SEG_STEP : SEQ_SEG_RAMP;
+      if (!parse_milli(f[1], s.value)) return fail("ongeldige waarde");
+      if (!parse_duration_us(f[2], s.duration_us)) return fail("ongeldige duur");
+    } else if (kind == "hold") {
+      if (f.size() != 3) return fail("verwacht: hold,,<duur>");
+      s.type = SEQ_SEG_HOLD;
+      if (!parse_duration_us(f[2], s.duration_us)) return fail("ongeldige duur");
+    } else if (kind == "loop") {
+      if (f.size() != 3) return fail("verwacht: loop,<naam|index>,<n>");
+      if (next_loop_id >= SEQ_MAX_LOOPS) return fail("te veel loops");
+      s.type = SEQ_SEG_LOOP;
+      s.loop_id = next_loop_id++;
+      auto it = labels.find(f[1]);
+      s.aux = (it != labels.end()) ? it->second : (uint16_t)atoi(f[1].c_str());
+      s.value = atoi(f[2].c_str());
+    } else {
+      return fail("onbekend segment type");
+    }
+
+    if (s.type != SEQ_SEG_LOOP) {
+      if (s.duration_us < tick_us) return fail("segment korter dan de regelperiode (wordt gealiast)");
+      if (s.duration_us % tick_us)
+        fprintf(stderr, "%s:%d: let op: duur geen veelvoud van %u us, flank tot 1 tick verschoven\n",
+                argv[1], lineno, (unsigned)tick_us);
+    }
+
+    if (segs.size() >= 0xFFFF) return fail("te veel segmenten");
+    segs.push_back(s);
+  }
+
+  hdr.n_segments = (uint16_t)segs.size();
+  hdr.crc32 = seq_crc32(segs.data(), segs.size() * sizeof(SeqSegment));
+
+  std::vector<uint8_t> blob(sizeof(hdr) + segs.size() * sizeof(SeqSegment));
+  memcpy(blob.data(), &hdr, sizeof(hdr));
+  if (!segs.empty()) memcpy(blob.data() + sizeof(hdr), segs.data(), segs.size() * sizeof(SeqSegment));
+
+  if (!seq_validate(blob.data(), blob.size())) {
+    fprintf(stderr, "%s: profiel ongeldig (lege body in loop, loop vooruit, ...)\n", argv[1]);
+    return 1;
+  }
+
+  if (trace_step_us > 0) {
+    Sequencer sq;
+    seq_load(&sq, blob.data(), blob.size());
+    seq_start(&sq, 0, 0);
+    for (uint64_t t = 0; seq_running(&sq) && t < 3600ull * 1000000ull; t += trace_step_us) {
+      const int32_t v = seq_eval(&sq, (uint32_t)t);
+      printf("%llu,%.3f\n", (unsigned long long)t, v / 1000.0);
+    }
+    return 0;
+  }
+
+  FILE* out = fopen(argv[2], header_name ? "w" : "wb");
+  if (!out) {
+    fprintf(stderr, "kan %s niet schrijven\n", argv[2]);
+    return 1;
+  }
+
+  if (header_name) {
+    fprintf(out, "// %s - gegenereerd door tools/profile_compile uit %s\n#pragma once\n#include <stdint.h>\n\n",
+            argv[2], argv[1]);
+    fprintf(out, "alignas(4) static const uint8_t %s[%zu] = {", header_name, blob.size());
+    for (size_t i = 0; i < blob.size(); ++i)
+      fprintf(out, "%s0x%02X%s", (i % 12 == 0) ? "\n  " : "", blob[i], (i + 1 < blob.size()) ? "," : "");
+    fprintf(out, "\n};\n");
+  } else {
+    fwrite(blob.data(), 1, blob.size(), out);
+  }
+  fclose(out);
+
+  fprintf(stderr, "%u segmenten, %zu bytes\n", (unsigned)hdr.n_segments, blob.size());
+  return 0;
+}
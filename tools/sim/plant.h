@@ -0,0 +1,140 @@
+// tools/sim/plant.h - host model van de vermogenstrap (source + sink)
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// =========================
+// Plant model
+// =========================
+//
+// Source: duty -> uitgangsspanning via twee eerste-orde secties (LC-filter benadering)
+//         en een uitgangsweerstand.
+// Sink:   duty -> sinkstroom via twee eerste-orde secties, begrensd door de DUT spanning.
+// De meting loopt delay_samples achter (ADC + 1 kHz loop), net als op de hardware.
+//
+// Werkpuntafhankelijk (standaard uit, dan is het model lineair):
+//   c_bias_v  MLCC DC-bias: de filtercapaciteit en dus tau_v1 nemen af met de
+//             spanning, tau_v1 / (1 + v / c_bias_v)
+//   gm_ref_a  gm van de sink-MOSFET groeit met sqrt(I): tau_i1 * sqrt(gm_ref_a / i)
+// De DC-versterking blijft lineair, zodat feedforward sp / full blijft kloppen.
+
+struct PlantParams
+{
+  float v_supply     = 15.0f;   // V bij duty 1.0
+  float r_out_ohm    = 0.05f;   // uitgangsweerstand source
+  float tau_v1_s     = 1.0e-3f;
+  float tau_v2_s     = 0.3e-3f;
+
+  float i_sink_max   = 10.0f;   // A bij duty 1.0
+  float tau_i1_s     = 0.5e-3f;
+  float tau_i2_s     = 0.2e-3f;
+
+  int   delay_samples = 1;      // meetvertraging (max PLANT_MAX_DELAY)
+
+  float c_bias_v     = 0.0f;    // 0 = vaste tau_v1
+  float gm_ref_a     = 0.0f;    // 0 = vaste tau_i1
+};
+
+static constexpr int PLANT_MAX_DELAY = 16;
+
+struct PlantState
+{
+  // lag-coëfficiënten, door plant_init() berekend voor een vaste dt
+  float a_v1 = 1.0f, a_v2 = 1.0f, a_i1 = 1.0f, a_i2 = 1.0f;
+  float dt = 0.0f;
+  int   delay = 0;
+
+  float v_int  = 0.0f;
+  float v_out  = 0.0f;
+  float i_int  = 0.0f;
+  float i_sink = 0.0f;
+
+  float v_hist[PLANT_MAX_DELAY] = {};
+  float i_hist[PLANT_MAX_DELAY] = {};
+  int   head = 0;
+};
+
+static inline float plant_alpha(float tau, float dt)
+{
+  if (tau <= 0.0f) return 1.0f;
+  return 1.0f - expf(-dt / tau);
+}
+
+static inline void plant_init(PlantState& s, const PlantParams& p, float dt)
+{
+  s = PlantState();
+  s.dt   = dt;
+  s.a_v1 = plant_alpha(p.tau_v1_s, dt);
+  s.a_v2 = plant_alpha(p.tau_v2_s, dt);
+  s.a_i1 = plant_alpha(p.tau_i1_s, dt);
+  s.a_i2 = plant_alpha(p.tau_i2_s, dt);
+
+  s.delay = p.delay_samples;
+  if (s.delay < 0) s.delay = 0;
+  if (s.delay > PLANT_MAX_DELAY - 1) s.delay = PLANT_MAX_DELAY - 1;
+}
+
+// Source stap: i_load = stroom die de DUT trekt. Geeft gemeten (vertraagde) v_out.
+// Verwacht dat plant_init() met dezelfde dt is aangeroepen.
+static inline float plant_step_source(PlantState& s, const PlantParams& p,
+                                      float duty, float i_load)
+{
+  if (duty < 0.0f) duty = 0.0f;
+  if (duty > 1.0f) duty = 1.0f;
+
+  float a_v1 = s.a_v1;
+  if (p.c_bias_v > 0.0f) a_v1 = plant_alpha(p.tau_v1_s / (1.0f + s.v_out / p.c_bias_v), s.dt);
+
+  s.v_int += (duty * p.v_supply - s.v_int) * a_v1;
+  s.v_out += (s.v_int - p.r_out_ohm * i_load - s.v_out) * s.a_v2;
+  if (s.v_out < 0.0f) s.v_out = 0.0f;
+
+  s.v_hist[s.head] = s.v_out;
+  const float meas = s.v_hist[(s.head - s.delay + PLANT_MAX_DELAY) % PLANT_MAX_DELAY];
+  s.head = (s.head + 1) % PLANT_MAX_DELAY;
+  return meas;
+}
+
+// Sink stap: v_dut = spanning van de DUT (batterij/voeding). Geeft gemeten i_sink.
+static inline float plant_step_sink(PlantState& s, const PlantParams& p,
+                                    float duty, float v_dut)
+{
+  if (duty < 0.0f) duty = 0.0f;
+  if (duty > 1.0f) duty = 1.0f;
+
+  float target = duty * p.i_sink_max;
+  if (v_dut <= 0.0f) target = 0.0f;
+
+  float a_i1 = s.a_i1;
+  if (p.gm_ref_a > 0.0f) {
+    const float i = fmaxf(s.i_sink, 0.05f * p.gm_ref_a);
+    a_i1 = plant_alpha(p.tau_i1_s * sqrtf(p.gm_ref_a / i), s.dt);
+  }
+
+  s.i_int  += (target - s.i_int) * a_i1;
+  s.i_sink += (s.i_int - s.i_sink) * s.a_i2;
+
+  s.i_hist[s.head] = s.i_sink;
+  const float meas = s.i_hist[(s.head - s.delay + PLANT_MAX_DELAY) % PLANT_MAX_DELAY];
+  s.head = (s.head + 1) % PLANT_MAX_DELAY;
+  return meas;
+}
+
+// Simpele PI met anti-windup (host referentie, zelfde vorm als de firmware loop).
+struct SimPI
+{
+  float kp = 0.05f;
+  float ki = 40.0f;
+  float integ = 0.0f;
+
+  float step(float sp, float meas, float dt, float ff = 0.0f)
+  {
+    const float e = sp - meas;
+    float u = ff + kp * e + integ + ki * e * dt;
+    if (u > 1.0f) u = 1.0f;
+    else if (u < 0.0f) u = 0.0f;
+    else integ += ki * e * dt;
+    return u;
+  }
+};
@@ -0,0 +1,252 @@
+// tools/sm_fuzz.cpp - fuzz + benchmark van de systeem-state machine (host)
+//
+// 1) Exhaustief: elke state x event x (faults, latched, edit, modewissel) één
+//    dispatch, met de verwachte uitkomst uit een los geschreven referentie.
+// 2) Random: lange eventreeksen terwijl faults/edit/mode willekeurig wisselen
+//    (ook zonder FAULT-event, zoals een producer die te laat post); na elk event
+//    worden de invarianten op de toegepaste SystemStatus gecontroleerd.
+// 3) Benchmark: ns per sm_dispatch (gemiddeld en staart).
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude tools/sm_fuzz.cpp src/statemachine/statemachine.cpp -o tools/build/sm_fuzz
+//
+// Exit code 0 als alle controles slagen.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "statemachine/statemachine.h"
+
+static constexpr uint32_t SHUT = SM_FAULT_SHUTDOWN_MASK;
+
+// Zelfde volgorde als statemachine_task.cpp
+static void apply(SystemStatus& st, const SmEffects& fx, SystemState state, bool changed)
+{
+    st.fault_current_bits |= fx.latch_fault_bits;
+    st.fault_latched_bits |= fx.latch_fault_bits;
+    st.fault_latched_bits &= ~fx.clear_latched_bits;
+    st.status_flags |= fx.set_status_flags;
+    st.status_flags &= ~fx.clear_status_flags;
+    if (changed) st.state = state;
+}
+
+static SmInputs inputs_of(const SystemStatus& st, uint32_t ui_flags)
+{
+    SmInputs in;
+    in.fault_current_bits = st.fault_current_bits;
+    in.fault_latched_bits = st.fault_latched_bits;
+    in.status_flags       = st.status_flags;
+    in.ui_event_flags     = ui_flags;
+    in.mode_current       = st.mode_current;
+    in.mode_pending       = st.mode_pending;
+    return in;
+}
+
+// Referentie: verwachte volgende state, los van de tabel geschreven
+static SystemState expected(SystemState s, SmEvent ev, const SmInputs& in)
+{
+    const bool fault   = ((in.fault_current_bits | in.fault_latched_bits) & SHUT) != 0;
+    const bool active  = (in.fault_current_bits & SHUT) != 0;
+    const bool editing = (in.ui_event_flags & UI_EVT_EDIT_STARTED) != 0;
+    const bool settled = in.mode_current == in.mode_pending && !(in.status_flags & STATUS_MODE_SWITCH_PENDING);
+
+    if (s == SYS_STATE_ERROR) return (ev == SM_EV_STOP && !active) ? SYS_STATE_CONFIG : SYS_STATE_ERROR;
+    if (ev == SM_EV_FAULT) return fault ? SYS_STATE_ERROR : s;
+    if (ev == SM_EV_STOP) return SYS_STATE_CONFIG;
+    // RUN
+    switch (s) {
+        case SYS_STATE_CONFIG: return (!fault && !editing) ? SYS_STATE_READY : s;
+        case SYS_STATE_READY:  return (!fault && settled) ? SYS_STATE_ACTIVE : s;
+        case SYS_STATE_ACTIVE: return SYS_STATE_READY;
+        default:               return s;
+    }
+}
+
+static int g_fail = 0;
+static int g_fail_printed = 0;
+
+static void fail(const char* what, SystemState from, SmEvent ev, const SystemStatus& st)
+{
+    g_fail++;
+    if (g_fail_printed++ < 10)
+        printf("  FAIL %s: %s --%s--> %s (faults 0x%02x latched 0x%02x flags 0x%02x)\n",
+               what, sm_state_name(from), sm_event_name(ev), sm_state_name(st.state),
+               (unsigned)st.fault_current_bits, (unsigned)st.fault_latched_bits, (unsigned)st.status_flags);
+}
+
+// Invarianten na toepassen van één event
+static void check_step(SystemState from, SmEvent ev, const SmInputs& in, const SystemStatus& st,
+                       const SmEffects& fx, bool changed)
+{
+    const SystemState to = st.state;
+    if (to != expected(from, ev, in)) fail("uitkomst", from, ev, st);
+    if ((to == SYS_STATE_ACTIVE) != ((st.status_flags & STATUS_CONTROL_ENABLED) != 0))
+        fail("CONTROL_ENABLED <-> ACTIVE", from, ev, st);
+    // Zonder FAULT-event kan een nieuwe bit nog niet gelatcht zijn
+    if (to == SYS_STATE_ERROR && (changed || ev == SM_EV_FAULT) &&
+        (st.fault_current_bits & SHUT & ~st.fault_latched_bits))
+        fail("ERROR zonder latched fault", from, ev, st);
+    if (from == SYS_STATE_ERROR && to != SYS_STATE_ERROR && (st.fault_latched_bits & SHUT))
+        fail("ERROR verlaten met latched fault", from, ev, st);
+    const int ui_want = (to == SYS_STATE_ERROR && from != SYS_STATE_ERROR) ? 1
+                      : (from == SYS_STATE_ERROR && to != SYS_STATE_ERROR) ? -1 : 0;
+    if (fx.ui_error != ui_want) fail("UI_SCREEN_ERROR niet bij ERROR entry/exit", from, ev, st);
+    if (fx.rejected && changed) fail("geweigerd maar toch gewisseld", from, ev, st);
+    if (changed != (from != to)) fail("changed-vlag", from, ev, st);
+}
+
+static void exhaustive(void)
+{
+    const uint32_t fault_sets[] = { 0, FAULT_OV, FAULT_SD, FAULT_OV | FAULT_SD, FAULT_COMM | FAULT_HW };
+    uint32_t n = 0;
+
+    for (int s = 0; s < SM_STATE_COUNT; ++s)
+    for (int e = 0; e < SM_EV_COUNT; ++e)
+    for (uint32_t cur : fault_sets)
+    for (uint32_t lat : fault_sets)
+    for (int edit = 0; edit < 2; ++edit)
+    for (int settled = 0; settled < 2; ++settled)
+    {
+        SystemStatus st;
+        memset(&st, 0, sizeof(st));
+        st.state = (SystemState)s;
+        st.fault_current_bits = cur;
+        st.fault_latched_bits = lat | ((s == SYS_STATE_ERROR) ? (cur & SHUT) : 0);
+        st.status_flags = (s == SYS_STATE_ACTIVE) ? STATUS_CONTROL_ENABLED : 0;
+        st.mode_current = POWER_MODE_SOURCE;
+        st.mode_pending = settled ? POWER_MODE_SOURCE : POWER_MODE_SINK;
+        if (!settled) st.status_flags |= STATUS_MODE_SWITCH_PENDING;
+
+        SmMachine m;
+        sm_init(&m, st.state);
+        const SmInputs in = inputs_of(st, edit ? UI_EVT_EDIT_STARTED : UI_EVT_EDIT_CONFIRMED);
+        SmEffects fx;
+        const bool changed = sm_dispatch(&m, (SmEvent)e, &in, &fx);
+        apply(st, fx, m.state, changed);
+        check_step((SystemState)s, (SmEvent)e, in, st, fx, changed);
+        n++;
+    }
+    printf("exhaustief: %u combinaties\n", (unsigned)n);
+}
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 7; g_rng ^= g_rng << 17;
+    return (uint32_t)(g_rng >> 16);
+}
+
+static void random_walk(uint32_t n_events)
+{
+    SystemStatus st;
+    memset(&st, 0, sizeof(st));
+    st.state = SYS_STATE_CONFIG;
+    uint32_t ui = 0;
+
+    SmMachine m;
+    sm_init(&m, st.state);
+
+    uint32_t visits[SM_STATE_COUNT] = {};
+    uint32_t trans[SM_STATE_COUNT][SM_STATE_COUNT] = {};
+
+    for (uint32_t i = 0; i < n_events; ++i)
+    {
+        // Omgeving
+        const uint32_t r = rnd() % 100;
+        bool post_fault = false;
+        if (r < 4)       { st.fault_current_bits |= 1u << (rnd() % 6); post_fault = (rnd() % 4) != 0; }
+        else if (r < 10) { st.fault_current_bits = 0; post_fault = (rnd() % 2) != 0; }
+        else if (r < 16) { ui = (rnd() % 2) ? UI_EVT_EDIT_STARTED : UI_EVT_EDIT_CONFIRMED; }
+        else if (r < 22) { st.mode_pending = (PowerMode)(rnd() % 3);
+                           if (st.mode_pending != st.mode_current) st.status_flags |= STATUS_MODE_SWITCH_PENDING; }
+        else if (r < 30) { st.mode_current = st.mode_pending; st.status_flags &= ~STATUS_MODE_SWITCH_PENDING; }
+
+        SmEvent ev = post_fault ? SM_EV_FAULT : (SmEvent)(rnd() % SM_EV_COUNT);
+
+        const SystemState from = st.state;
+        const SmInputs in = inputs_of(st, ui);
+        SmEffects fx;
+        const bool changed = sm_dispatch(&m, ev, &in, &fx);
+        apply(st, fx, m.state, changed);
+        check_step(from, ev, in, st, fx, changed);
+
+        visits[st.state]++;
+        trans[from][st.state]++;
+    }
+
+    printf("random: %u events, %u transities, %u geweigerd\n",
+           (unsigned)m.n_dispatch, (unsigned)m.n_transitions, (unsigned)m.n_rejected);
+    printf("  %-8s", "van\\naar");
+    for (int t = 0; t < SM_STATE_COUNT; ++t) printf(" %9s", sm_state_name((SystemState)t));
+    printf("\n");
+    for (int f = 0; f < SM_STATE_COUNT; ++f) {
+        printf("  %-8s", sm_state_name((SystemState)f));
+        for (int t = 0; t < SM_STATE_COUNT; ++t) printf(" %9u", (unsigned)trans[f][t]);
+        printf("\n");
+    }
+    for (int s = 0; s < SM_STATE_COUNT; ++s)
+        if (visits[s] == 0) { printf("  FAIL state %s nooit bereikt\n", sm_state_name((SystemState)s)); g_fail++; }
+}
+
+static void bench(void)
+{
+    typedef std::chrono::steady_clock clk;
+    const uint32_t N = 20000000;
+
+    // Vooraf gegenereerde inputs: de meting bevat alleen de dispatch
+    const uint32_t K = 4096;
+    std::vector<SmInputs> ins(K);
+    std::vector<uint8_t> evs(K);
+    for (uint32_t i = 0; i < K; ++i) {
+        SystemStatus st;
+        memset(&st, 0, sizeof(st));
+        st.fault_current_bits = (rnd() % 8 == 0) ? FAULT_OV : 0;
+        st.fault_latched_bits = (rnd() % 8 == 0) ? FAULT_OT : 0;
+        st.mode_pending = (rnd() % 4 == 0) ? POWER_MODE_SINK : POWER_MODE_SOURCE;
+        ins[i] = inputs_of(st, (rnd() % 4 == 0) ? UI_EVT_EDIT_STARTED : 0);
+        evs[i] = (uint8_t)(rnd() % SM_EV_COUNT);
+    }
+
+    SmMachine m;
+    sm_init(&m, SYS_STATE_CONFIG);
+    SmEffects fx;
+    uint32_t sink = 0;
+
+    const clk::time_point t0 = clk::now();
+    for (uint32_t i = 0; i < N; ++i) {
+        const uint32_t k = i & (K - 1);
+        sink += sm_dispatch(&m, (SmEvent)evs[k], &ins[k], &fx) ? 1u : 0u;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count() / N;
+
+    // Staart: per aanroep getimed (inclusief klokoverhead)
+    const uint32_t M = 1000000;
+    std::vector<float> per(M);
+    for (uint32_t i = 0; i < M; ++i) {
+        const uint32_t k = i & (K - 1);
+        const clk::time_point a = clk::now();
+        sink += sm_dispatch(&m, (SmEvent)evs[k], &ins[k], &fx) ? 1u : 0u;
+        per[i] = (float)std::chrono::duration<double, std::nano>(clk::now() - a).count();
+    }
+    std::sort(per.begin(), per.end());
+
+    printf("bench: %.1f ns/dispatch gemiddeld (%u events, %u transities)\n",
+           ns, (unsigned)N, (unsigned)sink);
+    printf("  per aanroep incl. klok: p50 %.0f ns, p99.9 %.0f ns, max %.0f ns\n",
+           (double)per[M / 2], (double)per[(size_t)(M * 0.999)], (double)per[M - 1]);
+}
+
+int main()
+{
+    exhaustive();
+    random_walk(5000000);
+    bench();
+
+    printf("\n%s\n", g_fail ? "FAIL" : "alle controles OK");
+    return g_fail ? 1 : 0;
+}
@@ -0,0 +1,336 @@
+// tools/tlm_bench.cpp - USB-CDC telemetrie end-to-end over een pty (host)
+//
+// Draait src/telemetry/telemetry.cpp met dezelfde rolverdeling als de firmware,
+// met een pseudo-terminal als USB-kabel:
+//   producer-thread   = measureTask    (tlm_push, nooit wachten)
+//   device-thread     = telemetryTask  (CONFIG lezen, tlm_pump, STATUS, TX-ring
+//                                       niet-blokkerend naar de pty-master)
+//   host-thread       = tlm_cli        (tools/common/tlm_host.h op de pty-slave)
+// De host stuurt eerst een CONFIG-frame; het device past het toe voordat de
+// producer begint. Elk ontvangen sample wordt getoetst tegen het origineel uit
+// tools/common/log_synth.h (bit-exact, niet-gekozen kanalen 0, stap = decimatie).
+//
+// Scenario's:
+//   1. doorvoer, alle kanalen: producer zonder pacing (wacht alleen bij een volle
+//      samplering, de firmware dropt dan). Geeft de sustained samples/s end-to-end.
+//   2. doorvoer, één kanaal, en met decimatie 4 (via CONFIG)
+//   3. host leest 500 ms niet bij een 20 kHz producer: het device codeert geen
+//      frames meer die niet passen, de samplering loopt vol en de producer dropt.
+//      De host ziet precies die samples als gat in t_us, geen kapotte frames en
+//      geen seq-gaten; de producer wacht nooit.
+// Daarnaast: bytes per sample en wat dat betekent voor USB full-speed.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/tlm_bench.cpp src/telemetry/telemetry.cpp -o tools/build/tlm_bench
+//
+// Gebruik:
+//   tlm_bench [-n samples]     (standaard 2M per doorvoer-run)
+//
+// Exit code 0 als alle controles slagen.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "telemetry/telemetry.h"
+#include "common/log_synth.h"
+#include "common/tlm_host.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Aanname voor de projectie: netto CDC-doorvoer van de USB-Serial-JTAG (full speed)
+static constexpr double USB_FS_BYTES_PER_S = 1.0e6;
+
+static int g_fail = 0;
+static void check(bool ok, const char* what)
+{
+  printf("  %-58s %s\n", what, ok ? "OK" : "FAIL");
+  if (!ok) g_fail++;
+}
+
+static inline uint64_t now_us()
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void to_sample(uint64_t i, TlmSample* s)
+{
+  LogRecord r;
+  synth_record(i, 1, &r);   // t_us = i
+  s->t_us        = r.t_us;
+  s->v_out       = r.v_out;
+  s->i_sink      = r.i_sink;
+  s->i_source    = r.i_source;
+  s->temp_sink_c = r.temp_sink_c;
+  s->meas_flags  = r.meas_flags;
+}
+
+struct RunCfg
+{
+  TlmConfig cfg;
+  uint64_t  n_samples;     // aangeboden metingen
+  uint32_t  rate_hz;       // 0 = zo snel mogelijk
+  uint32_t  pause_at_ms;   // host leest niet vanaf hier ...
+  uint32_t  pause_ms;      // ... zo lang (0 = nooit)
+};
+
+struct RunResult
+{
+  TlmStatus dev;
+  uint64_t  rx_samples = 0;
+  uint32_t  rx_frames = 0, rx_lost = 0, rx_bad = 0;
+  uint32_t  rx_malformed = 0;
+  uint64_t  rx_missing = 0;       // samples in t_us-gaten
+  bool      values_ok = true;
+  double    seconds = 0.0;        // eerste tot laatste ontvangen sample
+  double    push_max_us = 0.0;
+};
+
+static RunResult run(const RunCfg& rc)
+{
+  RunResult res;
+
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("posix_openpt");
+    exit(1);
+  }
+  const int slave = tlm_open_port(ptsname(master));
+  if (slave < 0) {
+    perror("pty slave");
+    exit(1);
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  static TlmSample samples[TLM_SAMPLE_RING_LEN];
+  static uint8_t tx_buf[TLM_TX_LEN];
+  static TlmTx tx;
+  TlmConfig boot;
+  boot.ch_mask = TLM_CH_ALL;   // anders dan wat de host vraagt: CONFIG moet aankomen
+  boot.per_frame = TLM_MAX_PER_FRAME;
+  boot.decim = 1;
+  tlm_tx_init(&tx, samples, tx_buf, &boot);
+
+  std::atomic<bool> configured(false), producer_done(false), device_done(false);
+
+  // ---- device (telemetryTask) ----
+  std::thread device([&] {
+    TlmParser p;
+    tlm_parser_init(&p);
+    uint64_t t_status = now_us();
+    for (;;) {
+      uint8_t in[256];
+      const ssize_t n_in = read(master, in, sizeof(in));
+      for (ssize_t i = 0; i < n_in; ++i) {
+        if (!tlm_parser_feed(&p, in[i]) || p.frame[0] != TLM_FRAME_CONFIG) continue;
+        TlmConfig c;
+        memcpy(&c, p.frame + sizeof(TlmFrameHeader), sizeof(c));
+        tlm_set_config(&tx, &c);
+        configured = true;
+      }
+
+      const bool done = producer_done.load();
+      const uint64_t now = now_us();
+      tlm_pump(&tx, (uint32_t)(now / 1000u), done ? 0u : 50u);
+      if (configured && now - t_status >= 1000000u) {
+        t_status = now;
+        tlm_send_status(&tx);
+      }
+
+      bool progress = false;
+      for (;;) {
+        uint32_t n;
+        const uint8_t* buf = tlm_tx_peek(&tx, &n);
+        if (n == 0) break;
+        const ssize_t w = write(master, buf, n);
+        if (w <= 0) break;   // EAGAIN: "availableForWrite() == 0"
+        tlm_tx_consume(&tx, (uint32_t)w);
+        progress = true;
+      }
+
+      uint32_t pending;
+      tlm_tx_peek(&tx, &pending);
+      if (done && pending == 0 && tx.samples.head == tx.samples.tail && tx.frame_n == 0) break;
+      if (!progress) {
+        struct pollfd pfd = { master, (short)(pending ? POLLOUT : POLLIN), 0 };
+        poll(&pfd, 1, 1);
+      }
+    }
+    tlm_send_status(&tx);   // eindstand
+    uint32_t n;
+    const uint8_t* buf;
+    while ((buf = tlm_tx_peek(&tx, &n)), n > 0) {
+      const ssize_t w = write(master, buf, n);
+      if (w > 0) tlm_tx_consume(&tx, (uint32_t)w);
+      else std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    device_done = true;
+  });
+
+  // ---- host (tlm_cli) ----
+  std::thread host([&] {
+    tlm_send_config(slave, rc.cfg);
+
+    TlmReceiver rx;
+    bool have_prev = false;
+    uint32_t prev_t = 0;
+    uint64_t t_first = 0, t_last = 0;
+    bool paused = false;
+
+    auto on_samples = [&](const TlmSample* s, int n, uint8_t mask, uint16_t decim) {
+      if (mask != rc.cfg.ch_mask || decim != rc.cfg.decim) { res.values_ok = false; return; }
+      for (int i = 0; i < n; ++i) {
+        const uint32_t t = s[i].t_us;
+        if (have_prev) {
+          const uint32_t step = t - prev_t;
+          if (step % rc.cfg.decim || step == 0) res.values_ok = false;
+          else if (step != rc.cfg.decim) res.rx_missing += step / rc.cfg.decim - 1u;
+        }
+        prev_t = t;
+        have_prev = true;
+
+        TlmSample ref;
+        to_sample(t, &ref);
+        if ((mask & TLM_CH_V_OUT) ? s[i].v_out != ref.v_out : s[i].v_out != 0.0f) res.values_ok = false;
+        if ((mask & TLM_CH_I_SINK) ? s[i].i_sink != ref.i_sink : s[i].i_sink != 0.0f) res.values_ok = false;
+        if ((mask & TLM_CH_I_SOURCE) ? s[i].i_source != ref.i_source : s[i].i_source != 0.0f) res.values_ok = false;
+        if ((mask & TLM_CH_TEMP) ? s[i].temp_sink_c != ref.temp_sink_c : s[i].temp_sink_c != 0.0f) res.values_ok = false;
+        if ((mask & TLM_CH_FLAGS) ? s[i].meas_flags != ref.meas_flags : s[i].meas_flags != 0u) res.values_ok = false;
+      }
+      t_last = now_us();
+      if (!t_first) t_first = t_last;
+    };
+
+    uint8_t buf[16384];
+    for (;;) {
+      // Pauze: niets lezen, de pty en de TX-ring lopen vol
+      if (rc.pause_ms && !paused && t_first && now_us() - t_first >= rc.pause_at_ms * 1000ull) {
+        paused = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(rc.pause_ms));
+      }
+
+      const ssize_t n = read(slave, buf, sizeof(buf));   // VTIME: max 100 ms
+      if (n > 0) { rx.feed(buf, (size_t)n, on_samples); continue; }
+      if (device_done) {
+        // Laatste bytes: nog één keer leeg lezen
+        ssize_t m;
+        while ((m = read(slave, buf, sizeof(buf))) > 0) rx.feed(buf, (size_t)m, on_samples);
+        break;
+      }
+    }
+
+    res.dev = rx.status();
+    res.rx_samples = rx.samples();
+    res.rx_frames = rx.parser().n_frames;
+    res.rx_lost = rx.parser().n_lost;
+    res.rx_bad = rx.parser().n_bad;
+    res.rx_malformed = rx.malformed();
+    res.seconds = (t_last - t_first) * 1e-6;
+  });
+
+  // ---- producer (measureTask) ----
+  while (!configured) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  const uint64_t t0 = now_us();
+  for (uint64_t i = 0; i < rc.n_samples; ++i) {
+    TlmSample s;
+    to_sample(i, &s);
+
+    if (rc.rate_hz) {
+      const uint64_t due = t0 + i * 1000000ull / rc.rate_hz;
+      while (now_us() < due) { }
+    } else {
+      // Doorvoer-bench: wachten in plaats van droppen (de firmware dropt)
+      while (tx.samples.head - __atomic_load_n(&tx.samples.tail, __ATOMIC_ACQUIRE) >= TLM_SAMPLE_RING_LEN)
+        std::this_thread::yield();
+    }
+
+    const uint64_t a = now_us();
+    tlm_push(&tx, &s);
+    const double dt = (double)(now_us() - a);
+    if (dt > res.push_max_us) res.push_max_us = dt;
+  }
+  producer_done = true;
+
+  device.join();
+  host.join();
+  close(slave);
+  close(master);
+  return res;
+}
+
+static void report(const char* title, const RunCfg& rc, const RunResult& r)
+{
+  const double bps = r.dev.n_samples ? (double)r.dev.tx_bytes / r.dev.n_samples : 0.0;
+  printf("\n%s (kanalen 0x%02X, %u per frame, decimatie %u%s):\n", title, rc.cfg.ch_mask,
+         rc.cfg.per_frame, rc.cfg.decim, rc.rate_hz ? "" : ", zonder pacing");
+  printf("  %llu samples ontvangen in %.3f s: %.2f M samples/s end-to-end\n",
+         (unsigned long long)r.rx_samples, r.seconds, r.seconds > 0 ? r.rx_samples / r.seconds / 1e6 : 0.0);
+  printf("  %.1f B/sample op de lijn (incl. header, CRC, COBS) -> USB FS bij %.1f MB/s: %.0f samples/s\n",
+         bps, USB_FS_BYTES_PER_S / 1e6, bps > 0 ? USB_FS_BYTES_PER_S / bps : 0.0);
+  printf("  device: %u frames, %u gedropt, %u ring-drops, %u gedecimeerd | host: %u frames, %u verloren, %u kapot\n",
+         r.dev.n_frames, r.dev.n_frame_drops, r.dev.n_ring_drops, r.dev.n_decimated,
+         r.rx_frames, r.rx_lost, r.rx_bad);
+  printf("  push max %.1f us\n", r.push_max_us);
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t n = 2000000;
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (!strcmp(argv[i], "-n")) n = strtoull(argv[i + 1], nullptr, 10);
+  }
+
+  printf("TlmSample %zu B, frame max %u B (%u op de lijn), samplering %u, TX-ring %u B\n",
+         sizeof(TlmSample), (unsigned)TLM_FRAME_MAX, (unsigned)TLM_WIRE_MAX,
+         (unsigned)TLM_SAMPLE_RING_LEN, (unsigned)TLM_TX_LEN);
+
+  // 1. Doorvoer, alle kanalen
+  {
+    RunCfg rc = { { TLM_CH_ALL, TLM_MAX_PER_FRAME, 1 }, n, 0, 0, 0 };
+    const RunResult r = run(rc);
+    report("1. doorvoer", rc, r);
+    check(r.values_ok && r.rx_malformed == 0, "samples bit-exact, volgorde en stap");
+    check(r.rx_samples == n && r.dev.n_frame_drops == 0 && r.rx_lost == 0 && r.rx_bad == 0,
+          "alle samples aangekomen, geen verlies of kapotte frames");
+    check(r.rx_samples / r.seconds > 1000.0 * 20, "> 20x de 1 kHz meetstroom");
+  }
+
+  // 2. Eén kanaal, en decimatie via CONFIG
+  {
+    RunCfg rc = { { TLM_CH_V_OUT, TLM_MAX_PER_FRAME, 1 }, n, 0, 0, 0 };
+    const RunResult r = run(rc);
+    report("2a. één kanaal", rc, r);
+    check(r.values_ok && r.rx_samples == n && r.rx_lost == 0 && r.rx_bad == 0, "alle samples, alleen v_out");
+  }
+  {
+    RunCfg rc = { { TLM_CH_V_OUT | TLM_CH_TEMP, 8, 4 }, n, 0, 0, 0 };
+    const RunResult r = run(rc);
+    report("2b. decimatie", rc, r);
+    check(r.values_ok && r.rx_samples == n / 4 && r.dev.n_decimated == n - n / 4,
+          "1 op 4, stap 4 us, rest geteld als gedecimeerd");
+  }
+
+  // 3. Host leest niet: frames droppen in het device, producer wacht niet
+  {
+    RunCfg rc = { { TLM_CH_ALL, TLM_MAX_PER_FRAME, 1 }, 40000, 20000, 500, 500 };
+    const RunResult r = run(rc);
+    report("3. host pauzeert 500 ms (20 kHz)", rc, r);
+    printf("  host: %llu samples in t_us-gaten\n", (unsigned long long)r.rx_missing);
+    check(r.dev.n_ring_drops > 0 && r.rx_missing == r.dev.n_ring_drops, "gedropte samples == gaten in t_us bij de host");
+    check(r.dev.n_frame_drops == 0 && r.rx_lost == 0 && r.rx_bad == 0 && r.values_ok,
+          "geen frames gedropt of kapot, waarden bit-exact");
+    check(r.rx_samples + r.dev.n_ring_drops == rc.n_samples, "ontvangen + gedropt == aangeboden");
+    check(r.push_max_us < 1000.0, "push < 1 ms (nooit wachten op de host)");
+  }
+
+  printf("\n%s\n", g_fail ? "FAIL" : "alle controles OK");
+  return g_fail ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+// tools/tlm_cli.cpp - USB-CDC telemetrie opnemen en live tonen (host)
+//
+// Opent de native USB-poort van het device (Linux: /dev/ttyACM0), stuurt een
+// CONFIG-frame (kanalen, decimatie, samples per frame) en leest COBS-frames.
+// Per seconde een statusregel: samples/s, verloren en kapotte frames, en de
+// tellers uit het STATUS-frame van het device.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Iinclude -Itools tools/tlm_cli.cpp src/telemetry/telemetry.cpp -o tools/build/tlm_cli
+//
+// Gebruik:
+//   tlm_cli <poort> [-c v,isink,isrc,temp,flags] [-d decim] [-n per_frame]
+//           [-t seconden] [-o out.csv|out.sbc] [--plot]
+//
+//   -c      kanalen (standaard v,isink,isrc,temp)
+//   -o      opnemen; .sbc = kolommen (tools/common/columnar.h), anders CSV
+//   --plot  per seconde een stripchart van de laatste 60 s per kanaal (terminal)
+//
+// Stoppen met Ctrl-C; het uitvoerbestand wordt dan netjes afgesloten.
+
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "telemetry/telemetry.h"
+#include "common/columnar.h"
+#include "common/tlm_host.h"
+
+static volatile sig_atomic_t g_stop = 0;
+static void on_sigint(int) { g_stop = 1; }
+
+struct ChannelDef
+{
+  uint8_t     bit;
+  const char* key;    // voor -c
+  const char* name;   // kolomnaam
+};
+
+static const ChannelDef CHANNELS[TLM_N_CH] = {
+  { TLM_CH_V_OUT,    "v",     "v_out" },
+  { TLM_CH_I_SINK,   "isink", "i_sink" },
+  { TLM_CH_I_SOURCE, "isrc",  "i_source" },
+  { TLM_CH_TEMP,     "temp",  "temp_sink_c" },
+  { TLM_CH_FLAGS,    "flags", "meas_flags" },
+};
+
+static double channel_value(const TlmSample& s, uint8_t bit)
+{
+  switch (bit) {
+    case TLM_CH_V_OUT:    return s.v_out;
+    case TLM_CH_I_SINK:   return s.i_sink;
+    case TLM_CH_I_SOURCE: return s.i_source;
+    case TLM_CH_TEMP:     return s.temp_sink_c;
+    case TLM_CH_FLAGS:    return s.meas_flags;
+  }
+  return 0.0;
+}
+
+static bool parse_channels(const char* arg, uint8_t* mask)
+{
+  *mask = 0;
+  std::string s(arg);
+  size_t pos = 0;
+  while (pos <= s.size()) {
+    const size_t end = s.find(',', pos);
+    const std::string key = s.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    bool found = false;
+    for (const ChannelDef& c : CHANNELS) {
+      if (key == c.key) { *mask |= c.bit; found = true; }
+    }
+    if (!found) {
+      fprintf(stderr, "onbekend kanaal '%s'\n", key.c_str());
+      return false;
+    }
+    if (end == std::string::npos) break;
+    pos = end + 1;
+  }
+  return *mask != 0;
+}
+
+// =========================
+// Stripchart
+// =========================
+static constexpr size_t PLOT_SECONDS = 60;
+
+struct Strip
+{
+  double sum = 0.0, lo = INFINITY, hi = -INFINITY;   // lopende seconde
+  uint64_t n = 0;
+  std::vector<double> mean;                          // per seconde, laatste PLOT_SECONDS
+
+  void add(double v) { sum += v; lo = fmin(lo, v); hi = fmax(hi, v); ++n; }
+
+  void close_second()
+  {
+    mean.push_back(n ? sum / n : NAN);
+    if (mean.size() > PLOT_SECONDS) mean.erase(mean.begin());
+  }
+
+  void reset() { sum = 0.0; lo = INFINITY; hi = -INFINITY; n = 0; }
+};
+
+static void draw_plot(const std::vector<Strip>& strips, const std::vector<const ChannelDef*>& chans)
+{
+  static const char LEVELS[] = " _.-:=+*#%@";
+  if (isatty(STDOUT_FILENO)) printf("\033[H\033[J");
+
+  for (size_t k = 0; k < chans.size(); ++k) {
+    const Strip& s = strips[k];
+    double lo = INFINITY, hi = -INFINITY;
+    for (double v : s.mean) if (!isnan(v)) { lo = fmin(lo, v); hi = fmax(hi, v); }
+
+    char line[PLOT_SECONDS + 1];
+    size_t i = 0;
+    for (double v : s.mean) {
+      int lvl = 0;
+      if (!isnan(v)) lvl = (hi > lo) ? 1 + (int)((v - lo) / (hi - lo) * 9.0 + 0.5) : 5;
+      line[i++] = LEVELS[lvl];
+    }
+    line[i] = 0;
+    printf("%-12s %10.4f .. %10.4f |%-*s|\n", chans[k]->name, lo, hi, (int)PLOT_SECONDS, line);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "gebruik: %s <poort> [-c v,isink,isrc,temp,flags] [-d decim] [-n per_frame]\n"
+                    "           [-t seconden] [-o out.csv|out.sbc] [--plot]\n", argv[0]);
+    return 2;
+  }
+
+  TlmConfig cfg;
+  cfg.ch_mask = TLM_CH_V_OUT | TLM_CH_I_SINK | TLM_CH_I_SOURCE | TLM_CH_TEMP;
+  cfg.per_frame = TLM_MAX_PER_FRAME;
+  cfg.decim = 1;
+  double duration_s = 0.0;
+  const char* out_path = nullptr;
+  bool plot = false;
+
+  for (int i = 2; i < argc; ++i) {
+    const bool has_val = i + 1 < argc;
+    if (!strcmp(argv[i], "--plot")) plot = true;
+    else if (!strcmp(argv[i], "-c") && has_val) { if (!parse_channels(argv[++i], &cfg.ch_mask)) return 2; }
+    else if (!strcmp(argv[i], "-d") && has_val) cfg.decim = (uint16_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && has_val) cfg.per_frame = (uint8_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && has_val) duration_s = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && has_val) out_path = argv[++i];
+  }
+
+  const int fd = tlm_open_port(argv[1]);
+  if (fd < 0) {
+    fprintf(stderr, "%s: niet te openen\n", argv[1]);
+    return 1;
+  }
+  if (!tlm_send_config(fd, cfg)) {
+    fprintf(stderr, "%s: CONFIG niet verstuurd\n", argv[1]);
+    return 1;
+  }
+  signal(SIGINT, on_sigint);
+
+  std::vector<const ChannelDef*> chans;
+  for (const ChannelDef& c : CHANNELS) if (cfg.ch_mask & c.bit) chans.push_back(&c);
+
+  // Uitvoer
+  const bool sbc = out_path && strlen(out_path) > 4 && !strcmp(out_path + strlen(out_path) - 4, ".sbc");
+  FILE* csv = nullptr;
+  std::vector<double> col_t;
+  std::vector<uint32_t> col_tus;
+  std::vector<std::vector<float>> col_ch(chans.size());
+  if (out_path && !sbc) {
+    csv = fopen(out_path, "w");
+    if (!csv) {
+      fprintf(stderr, "%s: niet te schrijven\n", out_path);
+      return 1;
+    }
+    fprintf(csv, "t_s,t_us");
+    for (const ChannelDef* c : chans) fprintf(csv, ",%s", c->name);
+    fprintf(csv, "\n");
+  }
+
+  TlmReceiver rx;
+  TlmClock clock;
+  std::vector<Strip> strips(chans.size());
+  uint64_t n_other_mask = 0;
+
+  auto on_samples = [&](const TlmSample* s, int n, uint8_t mask, uint16_t decim) {
+    (void)decim;
+    // Frames van vóór de CONFIG (andere kanalen) niet mengen met de opname
+    if (mask != cfg.ch_mask) { n_other_mask += (uint64_t)n; return; }
+    for (int i = 0; i < n; ++i) {
+      const double t = clock.unwrap(s[i].t_us) * 1e-6;
+      for (size_t k = 0; k < chans.size(); ++k) strips[k].add(channel_value(s[i], chans[k]->bit));
+
+      if (csv) {
+        fprintf(csv, "%.6f,%u", t, s[i].t_us);
+        for (const ChannelDef* c : chans) {
+          if (c->bit == TLM_CH_FLAGS) fprintf(csv, ",%u", s[i].meas_flags);
+          else fprintf(csv, ",%.6g", channel_value(s[i], c->bit));
+        }
+        fprintf(csv, "\n");
+      } else if (sbc) {
+        col_t.push_back(t);
+        col_tus.push_back(s[i].t_us);
+        for (size_t k = 0; k < chans.size(); ++k) col_ch[k].push_back((float)channel_value(s[i], chans[k]->bit));
+      }
+    }
+  };
+
+  using Clock = std::chrono::steady_clock;
+  const auto t_start = Clock::now();
+  auto t_tick = t_start;
+  uint64_t samples_tick = 0;
+
+  uint8_t buf[4096];
+  while (!g_stop) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, 100) > 0) {
+      const ssize_t n = read(fd, buf, sizeof(buf));
+      if (n < 0) break;
+      if (n > 0) rx.feed(buf, (size_t)n, on_samples);
+    }
+
+    const auto now = Clock::now();
+    const double since_tick = std::chrono::duration<double>(now - t_tick).count();
+    if (since_tick >= 1.0) {
+      const TlmParser& p = rx.parser();
+      const double rate = (rx.samples() - samples_tick) / since_tick;
+      samples_tick = rx.samples();
+      t_tick = now;
+
+      if (plot) {
+        for (Strip& s : strips) { s.close_second(); s.reset(); }
+        draw_plot(strips, chans);
+      }
+      printf("%8.0f samples/s  frames %u  verloren %u  kapot %u", rate, p.n_frames, p.n_lost, p.n_bad);
+      if (rx.has_status()) {
+        const TlmStatus& st = rx.status();
+        printf("  | device: gedropt %u frames, %u ring, decimatie %u", st.n_frame_drops, st.n_ring_drops, st.cfg.decim);
+      }
+      printf("\n");
+      fflush(stdout);
+    }
+
+    if (duration_s > 0.0 && std::chrono::duration<double>(now - t_start).count() >= duration_s) break;
+  }
+  close(fd);
+
+  if (csv) fclose(csv);
+  if (sbc) {
+    ColumnarTable tab;
+    const size_t c_t = tab.add_column("t_s", COL_F64);
+    const size_t c_tus = tab.add_column("t_us", COL_U32);
+    std::vector<size_t> c_ch;
+    for (const ChannelDef* c : chans) c_ch.push_back(tab.add_column(c->name, COL_F32));
+    tab.resize(col_t.size());
+    for (size_t r = 0; r < col_t.size(); ++r) {
+      tab.set<double>(c_t, r, col_t[r]);
+      tab.set<uint32_t>(c_tus, r, col_tus[r]);
+      for (size_t k = 0; k < chans.size(); ++k) tab.set<float>(c_ch[k], r, col_ch[k][r]);
+    }
+    if (!tab.write(out_path)) {
+      fprintf(stderr, "%s: schrijffout\n", out_path);
+      return 1;
+    }
+  }
+
+  const TlmParser& p = rx.parser();
+  printf("%llu samples, %u frames, %u verloren, %u kapot", (unsigned long long)rx.samples(),
+         p.n_frames, p.n_lost, p.n_bad);
+  if (n_other_mask) printf(", %llu met andere kanalen overgeslagen", (unsigned long long)n_other_mask);
+  printf("%s%s\n", out_path ? " -> " : "", out_path ? out_path : "");
+  return 0;
+}